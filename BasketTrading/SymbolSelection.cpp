@@ -19,8 +19,8 @@
 #include <vector>
 #include <math.h>
 
-#include <TFHDF5TimeSeries/HDF5IterateGroups.h>
 #include <TFHDF5TimeSeries/HDF5TimeSeriesContainer.h>
+#include <TFHDF5TimeSeries/HDF5Catalog.h>
 
 #include <TFIndicators/Darvas.h>
 #include <TFIndicators/Pivots.h>
@@ -48,15 +48,23 @@ void SymbolSelection::Process( setInstrumentInfo_t& selected ) {
 
   std::cout << "Running" << std::endl;
 
-  ou::tf::HDF5IterateGroups groups;
-
-  groups.SetOnHandleObject( MakeDelegate( this, &SymbolSelection::ProcessGroupItem ) );
+  ou::tf::HDF5Catalog catalog( "/bar/86400/" );  // pre-filter on the summaries, open only the survivors
   try {
-    int result = groups.Start( "/bar/86400/" );
+    catalog.Load( m_dm );
   }
   catch (...) {
     std::cout << "ouch" << std::endl;
   }
+  for ( ou::tf::HDF5Catalog::vEntry_t::const_iterator iter = catalog.Entries().begin(); catalog.Entries().end() != iter; ++iter ) {
+    if ( Survives( *iter ) ) {
+      try {
+        ProcessGroupItem( iter->sPath, iter->sName );
+      }
+      catch (...) {
+        std::cout << "SymbolSelection::Process " << iter->sName << " problem" << std::endl;
+      }
+    }
+  }
 
 //  WrapUp10Percent(selected);
 //  WrapUpVolatility(selected);
@@ -94,6 +102,23 @@ public:
   operator double() { return m_dblSumOfPrices / m_nNumberOfValues; };
 };
 
+// conditions ProcessGroupItem needs, taken from the summary, so failing them doesn't need the bars
+bool SymbolSelection::Survives( const ou::tf::HDF5Catalog::Entry& entry ) const {
+  if ( !entry.bSummarised ) return true;  // unknown, is opened
+  if ( m_nMinPivotBars > entry.nCount ) return false;
+  const date dateLast( m_dtLast.date() );
+  if ( ( entry.dtFirst.date() > dateLast ) || ( entry.dtLast.date() < dateLast ) ) return false;  // no bar on the day
+  if ( entry.dtLast < m_dtEnd ) {
+    // the last bar is the last of the range, and the trailing days are the bars averaged
+    if ( ( 15.0 > entry.dblClose ) || ( 90.0 < entry.dblClose ) ) return false;
+    if ( ( m_nMinPivotBars == entry.nDays ) && ( 1000000.0 * m_nMinPivotBars >= entry.TrailingVolume() ) ) return false;
+  }
+  else {
+    if ( ( 15.0 > entry.dblMaxPrice ) || ( 90.0 < entry.dblMinPrice ) ) return false;
+  }
+  return true;
+}
+
 void SymbolSelection::ProcessGroupItem( const std::string& sObjectPath, const std::string& sObjectName ) {
 //  std::cout << sObjectName << std::endl;
   ou::tf::HDF5TimeSeriesContainer<ou::tf::Bar> barRepository( m_dm, sObjectPath );
@@ -23,6 +23,7 @@ using namespace boost::gregorian;
 
 #include <TFTimeSeries/TimeSeries.h>
 #include <TFHDF5TimeSeries/HDF5DataManager.h>
+#include <TFHDF5TimeSeries/HDF5Catalog.h>
 
 class SymbolSelection {
 public:
@@ -84,6 +85,7 @@ private:
 
   mapRankingPos_t m_mapMaxVolatility;
   
+  bool Survives( const ou::tf::HDF5Catalog::Entry& entry ) const;
   void ProcessGroupItem( const std::string& sObjectPath, const std::string& sObjectName );
 
   typedef ou::tf::Bars::const_iterator citer;
@@ -17,6 +17,8 @@
 
 #include "stdafx.h"
 
+#include <iostream>
+
 #include "IQFeedGetHistory.h"
 
 IMPLEMENT_APP(AppIQFeedGetHistory)
@@ -88,6 +90,8 @@ bool AppIQFeedGetHistory::OnInit() {
   vItems.push_back( new mi( "150 days", MakeDelegate( this, &AppIQFeedGetHistory::HandleMenuActionDays150 ) ) );
   vItems.push_back( new mi( "200 days", MakeDelegate( this, &AppIQFeedGetHistory::HandleMenuActionDays200 ) ) );
   vItems.push_back( new mi( "0 days", MakeDelegate( this, &AppIQFeedGetHistory::HandleMenuActionDays0 ) ) );
+  vItems.push_back( new mi( "Roll Up Trades To Bars", MakeDelegate( this, &AppIQFeedGetHistory::HandleMenuActionRollUp ) ) );
+  vItems.push_back( new mi( "Rebuild Dataset Index", MakeDelegate( this, &AppIQFeedGetHistory::HandleMenuActionRebuildIndex ) ) );
   m_pFrameMain->AddDynamicMenu( "Actions", vItems );
 
 
@@ -131,3 +135,33 @@ void AppIQFeedGetHistory::HandleMenuActionDays200( void ) {
 void AppIQFeedGetHistory::HandleMenuActionDays0( void ) {
   m_pWorker = new Worker( "", 0 );
 }
+
+void AppIQFeedGetHistory::HandleMenuActionRollUp( void ) {
+  // run when no download is in progress, the download writes to the same file
+  m_workerRollUp.Run( MakeDelegate( this, &AppIQFeedGetHistory::HandleRollUp ) );
+}
+
+void AppIQFeedGetHistory::HandleRollUp( void ) {
+  std::cout << "Rolling up trades ..." << std::endl;
+  ou::tf::HDF5BarRollup rollup;  // 60, 300, 3600, 86400 second bars under /rollup/, for the days before today
+  rollup.SetWorkers( boost::thread::hardware_concurrency() );
+  rollup.Run( "/" );
+  std::cout
+    << rollup.GetSymbolsRolled() << " of " << rollup.GetSymbols() << " symbols, "
+    << rollup.GetDaysRolled() << " days, " << rollup.GetTrades() << " trades, " << rollup.GetBars() << " bars, "
+    << rollup.GetFailed() << " failed, " << rollup.GetSeconds() << "s"
+    << std::endl;
+}
+
+void AppIQFeedGetHistory::HandleMenuActionRebuildIndex( void ) {
+  // once for a file without an index, after that the writes keep it up to date
+  m_workerIndex.Run( MakeDelegate( this, &AppIQFeedGetHistory::HandleRebuildIndex ) );
+}
+
+void AppIQFeedGetHistory::HandleRebuildIndex( void ) {
+  std::cout << "Rebuilding dataset index ..." << std::endl;
+  ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
+  ou::tf::HDF5PathIndex index( dm.GetFileName() );
+  index.Rebuild( dm );
+  std::cout << index.Size() << " datasets indexed." << std::endl;
+}
@@ -18,6 +18,8 @@
 
 #include <string>
 
+#include <OUCommon/Worker.h>
+
 #include <TFBitsNPieces/FrameWork01.h>
 
 // may need to inherit and add more functionality to the class:
@@ -28,6 +30,9 @@
 
 #include <TFIQFeed/LoadMktSymbols.h>
 
+#include <TFHDF5TimeSeries/HDF5BarRollup.h>
+#include <TFHDF5TimeSeries/HDF5PathIndex.h>
+
 #include "Worker.h"
 
 class AppIQFeedGetHistory:
@@ -41,6 +46,8 @@ private:
   ou::tf::PanelLogging* m_pPanelLogging;
 
   Worker* m_pWorker;
+  ou::action::Worker m_workerRollUp;
+  ou::action::Worker m_workerIndex;
 
   virtual bool OnInit();
   virtual int OnExit();
@@ -51,6 +58,10 @@ private:
   void HandleMenuActionDays150( void );
   void HandleMenuActionDays200( void );
   void HandleMenuActionDays0( void );
+  void HandleMenuActionRollUp( void );
+  void HandleRollUp( void );  // in m_workerRollUp
+  void HandleMenuActionRebuildIndex( void );
+  void HandleRebuildIndex( void );  // in m_workerIndex
 
 
 };
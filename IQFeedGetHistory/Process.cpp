@@ -22,6 +22,8 @@
 
 #include <TFHDF5TimeSeries/HDF5DataManager.h>
 #include <TFHDF5TimeSeries/HDF5WriteTimeSeries.h>
+#include <TFHDF5TimeSeries/HDF5Catalog.h>
+#include <TFHDF5TimeSeries/HDF5PathIndex.h>
 
 #include "Process.h"
 
@@ -33,8 +35,22 @@
 #pragma message( "** Note:  for msvc, compile in release mode, buffer checks make it slow in debug" )
 #endif
 
+namespace {
+  // the download is the source data, so it is flagged and reported, never dropped,
+  //   and the rules allow for options: a zero bid, zero size, and wide spreads are usual away from the money
+  ou::tf::TickCleaner::Rules DownloadRules( void ) {
+    ou::tf::TickCleaner::Rules rules;
+    rules.bDrop = false;
+    rules.dblBand = 1.0;  // prices doubling, or falling to nothing, within a block
+    rules.dblMaxSpreadFraction = 0.0;  // off
+    rules.nMinSize = 0;
+    return rules;
+  }
+}
+
 Process::Process( const std::string& sPrefixPath, size_t nDatums )
 : ou::tf::iqfeed::HistoryBulkQuery<Process>(), 
+  m_cleaner( DownloadRules() ),
   m_sPrefixPath( sPrefixPath ), m_nDatums( nDatums )
   //m_cntBars( 25 )
 //  m_cntBars( 0 ) // 2013/09/17
@@ -135,14 +151,22 @@ void Process::OnTicks( inherited_t::structResultTicks* ticks ) {
 
   ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RDWR );
 
+  ou::tf::TickCleaner::Report report;
+
   if ( 0 != ticks->trades.Size() ) {
     std::string sPath( "/optionables/trade/" + ticks->sSymbol );
+    ticks->trades.SetName( sPath );
+    m_cleaner.Clean( ticks->trades, report );
+    if ( 0 != report.nFlagged ) report.Emit( std::cout );
     ou::tf::HDF5WriteTimeSeries<ou::tf::Trades> wtst( dm );
     wtst.Write( sPath, &ticks->trades );
   }
 
   if ( 0 != ticks->quotes.Size() ) {
     std::string sPath( "/optionables/quote/" + ticks->sSymbol );
+    ticks->quotes.SetName( sPath );
+    m_cleaner.Clean( ticks->quotes, report );
+    if ( 0 != report.nFlagged ) report.Emit( std::cout );
     ou::tf::HDF5WriteTimeSeries<ou::tf::Quotes> wtsq( dm );
     wtsq.Write( sPath, &ticks->quotes );
   }
@@ -151,6 +175,17 @@ void Process::OnTicks( inherited_t::structResultTicks* ticks ) {
 }
 
 void Process::OnCompletion( void ) {
+  boost::mutex::scoped_lock lock( m_mutexProcessResults ); 
+  ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RDWR );
+  ou::tf::HDF5Catalog catalog( "/bar/86400/" );  // kept for the scanners, from the summaries the writes left
+  catalog.Build( dm );
+  catalog.Save( dm );
+  std::cout << "Catalog saved, " << catalog.Entries().size() << " series." << std::endl;
+  ou::tf::HDF5PathIndex index( dm.GetFileName() );
+  if ( index.Load() ) {  // the writes were journalled, fold them in, see HDF5PathIndex.h
+    index.Compact();
+    std::cout << "Dataset index compacted, " << index.Size() << " datasets." << std::endl;
+  }
   std::cout << "Downloads complete." << std::endl;
 }
 
@@ -30,6 +30,8 @@
 //#include <TFIQFeed/IQFeedInstrumentFile.h>
 #include <TFIQFeed/IQFeedHistoryBulkQuery.h>
 
+#include <TFTimeSeries/TickCleaner.h>
+
 class Process: 
   public ou::tf::iqfeed::HistoryBulkQuery<Process>
 {
@@ -68,6 +70,8 @@ private:
 
   boost::mutex m_mutexProcessResults;
 
+  ou::tf::TickCleaner m_cleaner;  // downloaded ticks are checked, flagged and reported, before they are written, under m_mutexProcessResults
+
   std::string m_sPrefixPath;
   const size_t m_nDatums;
 
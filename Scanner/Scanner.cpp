@@ -111,6 +111,21 @@ bool AppScanner::HandleCallBackUseGroup( s_t&, const std::string& sPath, const s
   return true;
 }
 
+// conditions HandleCallBackFilter needs, taken from the summary, so failing them doesn't need the bars
+bool AppScanner::HandleCallBackCatalog( s_t&, const ou::tf::HDF5Catalog::Entry& entry ) {
+  if ( m_nMinBarCount > entry.nCount ) return false;
+  const date dateLast( m_dtLast.date() );
+  if ( ( entry.dtFirst.date() > dateLast ) || ( entry.dtLast.date() < dateLast ) ) return false;  // no bar on the day
+  if ( 1000000.0 * m_nMinBarCount >= entry.nVolume ) return false;  // can't average over 1000000 across the range
+  if ( entry.dtLast < m_dtEnd ) {  // the last bar is the last of the range
+    if ( ( 12.0 > entry.dblClose ) || ( 90.0 < entry.dblClose ) ) return false;
+  }
+  else {
+    if ( ( 12.0 > entry.dblMaxPrice ) || ( 90.0 < entry.dblMinPrice ) ) return false;
+  }
+  return true;
+}
+
 bool AppScanner::HandleCallBackFilter( s_t& data, const std::string& sObject, ou::tf::Bars& bars ) {
 
   bool b( false );
@@ -204,6 +219,7 @@ void AppScanner::ScanBars( void ) {
     boost::phoenix::bind( &AppScanner::HandleCallBackFilter, this, args::arg1, args::arg2, args::arg3 ),
     boost::phoenix::bind( &AppScanner::HandleCallBackResults, this, args::arg1, args::arg2, args::arg3 )
     );
+  filter.SetCatalogFilter( boost::phoenix::bind( &AppScanner::HandleCallBackCatalog, this, args::arg1, args::arg2 ) );
   try {
     filter.Run();
   }
@@ -24,6 +24,8 @@
 
 #include <TFTimeSeries/DatedDatum.h>
 
+#include <TFHDF5TimeSeries/HDF5Catalog.h>
+
 #include <TFVuTrading/FrameMain.h>
 #include <TFVuTrading/PanelLogging.h>
 
@@ -73,6 +75,7 @@ private:
   void HandleMenuActionScan( void );
   void ScanBars( void );
   bool HandleCallBackUseGroup( s_t&, const std::string& sPath, const std::string& sGroup );
+  bool HandleCallBackCatalog( s_t&, const ou::tf::HDF5Catalog::Entry& entry );
   bool HandleCallBackFilter( s_t&, const std::string& sObject, ou::tf::Bars& bars );
   void HandleCallBackResults( s_t&, const std::string& sObject, ou::tf::Bars& bars );
 
@@ -0,0 +1,73 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// running 64 bit checksum, for telling whether two runs produced the same output
+// FNV-1a style, taken a 64 bit word at a time rather than a byte at a time, so a datum costs a handful of multiplies
+//   the high half of each product is folded into the low half, as the multiply alone only carries bits upwards
+// values are added field by field, never as raw structures, as padding bytes are not guaranteed to match
+// not a cryptographic hash
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace ou { // One Unified
+
+class Checksum {
+public:
+
+  Checksum( void ): m_nValue( nBasis ) {};
+
+  void Reset( void ) { m_nValue = nBasis; };
+  boost::uint64_t Value( void ) const { return m_nValue; };
+
+  void Add( boost::uint64_t n ) {
+    m_nValue ^= n;
+    m_nValue *= nPrime;
+    m_nValue ^= m_nValue >> 32;
+  };
+  void Add( double dbl ) {  // by bit pattern
+    boost::uint64_t n;
+    std::memcpy( &n, &dbl, sizeof( n ) );
+    Add( n );
+  };
+  void Add( const boost::posix_time::ptime& dt ) {  // special values each hash to a value of their own
+    static const boost::posix_time::ptime dtEpoch( boost::gregorian::date( 1970, 1, 1 ) );
+    if ( dt.is_special() ) Add( (boost::uint64_t) 0x8000000000000000ull + ( dt.is_not_a_date_time() ? 0 : ( dt.is_neg_infinity() ? 1 : 2 ) ) );
+    else Add( (boost::uint64_t) ( dt - dtEpoch ).ticks() );
+  };
+  void Add( const std::string& s ) {
+    Add( (boost::uint64_t) s.size() );
+    for ( std::string::size_type ix = 0; ix < s.size(); ix += sizeof( boost::uint64_t ) ) {
+      boost::uint64_t n( 0 );
+      std::memcpy( &n, s.data() + ix, std::min<std::string::size_type>( sizeof( n ), s.size() - ix ) );
+      Add( n );
+    }
+  };
+
+  void Add( const Checksum& checksum ) { Add( checksum.m_nValue ); };
+
+protected:
+private:
+  static const boost::uint64_t nBasis = 14695981039346656037ull;
+  static const boost::uint64_t nPrime = 1099511628211ull;
+  boost::uint64_t m_nValue;
+};
+
+} // namespace ou
@@ -20,6 +20,10 @@
 
 #include <OUCommon/SpinLock.h>
 
+#ifdef OU_PROFILE
+#include <OUCommon/Profiler.h>
+#endif
+
 // 2014/09/30 something to verify with existing code
 // http://preshing.com/20140709/the-purpose-of-memory_order_consume-in-cpp11/
 
@@ -71,6 +75,12 @@ private:
   vDispatch_t m_vDispatchMaster;  // master vector used for Add/Remove   
   vDispatch_t m_vDispatch;  // used by operator() for dispatch, copied from m_vDispatchMaster
 
+#ifdef OU_PROFILE
+  typedef std::vector<ou::Profiler::Probe*> vProbe_t;  // in step with the dispatch vectors
+  vProbe_t m_vProbeMaster;
+  vProbe_t m_vProbe;
+#endif
+
   void VectorReplace( void );  // handles the copy of m_vDispatchMaster to m_vDispatch
 
 };
@@ -124,6 +134,9 @@ void Delegate<T>::operator()( T t ) {
 
     iter = m_vDispatch.begin();  // start dispatching
     while ( m_vDispatch.end() != iter ) {
+#ifdef OU_PROFILE
+      ou::Profiler::Scope scope( m_vProbe[ iter - m_vDispatch.begin() ] );
+#endif
       (*iter)( t );
       ++iter;
     }
@@ -144,6 +157,9 @@ void Delegate<T>::Add( OnDispatchHandler function ) {
   m_spinlockVectorUpdate.lock(); 
 
   m_vDispatchMaster.push_back( function );
+#ifdef OU_PROFILE
+  m_vProbeMaster.push_back( ou::Profiler::Instance().Find( "Delegate", function ) );
+#endif
 
   m_cntChanges.fetch_add( 1, boost::memory_order_release );
 
@@ -161,6 +177,9 @@ void Delegate<T>::Remove( OnDispatchHandler function ) {
   const_iterator iter = m_vDispatchMaster.begin();
   while ( m_vDispatchMaster.end() != iter ) {
     if ( function == *iter ) {
+#ifdef OU_PROFILE
+      m_vProbeMaster.erase( m_vProbeMaster.begin() + ( iter - m_vDispatchMaster.begin() ) );
+#endif
       m_vDispatchMaster.erase( iter );
       break;  // allow only one deletion
     }
@@ -195,6 +214,9 @@ void Delegate<T>::VectorReplace( void ) {
         ++ixSrc, ++ixDst ) {
           *ixDst = *ixSrc;
       }
+#ifdef OU_PROFILE
+      m_vProbe = m_vProbeMaster;
+#endif
     }
 
     m_cntChanges.store( 0, boost::memory_order_release );
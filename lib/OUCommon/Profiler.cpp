@@ -0,0 +1,251 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+//#include "stdafx.h"
+
+#include <vector>
+#include <cstdio>
+#include <cassert>
+#include <iomanip>
+#include <algorithm>
+
+#if defined( OU_PROFILE ) && !defined( _WIN32 )
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+#include "Profiler.h"
+
+namespace ou {
+
+OU_PROFILE_TLS Profiler::Context Profiler::m_context;  // zero initialized
+unsigned int Profiler::m_nSampling( 64 );
+Profiler::cycles_t Profiler::m_cyclesRead( 0 );
+Profiler::cycles_t Profiler::m_cyclesScope( 0 );
+
+//
+// Probe
+//
+
+Profiler::Probe::Probe( const std::string& sSite, const void* pFunction )
+  : m_sSite( sSite ), m_pFunction( pFunction ),
+    m_cntSamples( 0 ), m_cyclesTotal( 0 ), m_cyclesSelf( 0 )
+{
+  for ( unsigned int ix = 0; ix < nBuckets; ++ix ) m_rBucket[ ix ].store( 0, boost::memory_order_relaxed );
+}
+
+unsigned int Profiler::Probe::Bucket( cycles_t cycles ) {
+  if ( ( (cycles_t) 1 << nSubBits ) > cycles ) return (unsigned int) cycles;
+#if defined( _MSC_VER )
+  unsigned long nBit;
+  _BitScanReverse64( &nBit, cycles );
+#else
+  const unsigned int nBit( 63 - __builtin_clzll( cycles ) );
+#endif
+  const unsigned int nSub( (unsigned int) ( cycles >> ( nBit - nSubBits ) ) & ( ( 1 << nSubBits ) - 1 ) );
+  return ( ( nBit - nSubBits + 1 ) << nSubBits ) + nSub;
+}
+
+Profiler::cycles_t Profiler::Probe::BucketValue( unsigned int ix ) {
+  if ( ( 1u << nSubBits ) > ix ) return ix;
+  const unsigned int nBit( ( ix >> nSubBits ) + nSubBits - 1 );
+  const cycles_t low( ( (cycles_t) 1 << nBit ) | ( (cycles_t) ( ix & ( ( 1 << nSubBits ) - 1 ) ) << ( nBit - nSubBits ) ) );
+  return low + ( (cycles_t) 1 << ( nBit - nSubBits ) ) / 2;
+}
+
+void Profiler::Probe::Record( cycles_t cyclesTotal, cycles_t cyclesSelf ) {
+  // relaxed load and store, no locked instructions, to keep the sampled path short
+  m_cntSamples.store( m_cntSamples.load( boost::memory_order_relaxed ) + 1, boost::memory_order_relaxed );
+  m_cyclesTotal.store( m_cyclesTotal.load( boost::memory_order_relaxed ) + cyclesTotal, boost::memory_order_relaxed );
+  m_cyclesSelf.store( m_cyclesSelf.load( boost::memory_order_relaxed ) + cyclesSelf, boost::memory_order_relaxed );
+  boost::atomic<boost::uint32_t>& bucket( m_rBucket[ Bucket( cyclesTotal ) ] );
+  bucket.store( bucket.load( boost::memory_order_relaxed ) + 1, boost::memory_order_relaxed );
+}
+
+Profiler::cycles_t Profiler::Probe::Percentile( double dbl ) const {
+  const boost::uint64_t cntSamples( m_cntSamples.load( boost::memory_order_relaxed ) );
+  if ( 0 == cntSamples ) return 0;
+  const boost::uint64_t nRank( (boost::uint64_t) ( dbl * (double) cntSamples ) );
+  boost::uint64_t cnt( 0 );
+  for ( unsigned int ix = 0; ix < nBuckets; ++ix ) {
+    cnt += m_rBucket[ ix ].load( boost::memory_order_relaxed );
+    if ( nRank < cnt ) return BucketValue( ix );
+  }
+  return BucketValue( nBuckets - 1 );
+}
+
+//
+// Profiler
+//
+
+Profiler::Profiler( void ) {
+  // calibration: what an empty sampled dispatch adds to the one around it, beyond what it takes out itself
+  Probe probe( "", 0 );
+  const Context context( m_context );
+  cycles_t cyclesRead( ~(cycles_t) 0 );
+  cycles_t cyclesScope( ~(cycles_t) 0 );
+  for ( unsigned int ix = 0; ix < 1000; ++ix ) {
+    const cycles_t cycles( Cycles() );
+    cyclesRead = std::min<cycles_t>( cyclesRead, Cycles() - cycles );
+  }
+  m_cyclesRead = 0;
+  m_cyclesScope = 0;
+  for ( unsigned int ix = 0; ix < 1000; ++ix ) {
+    m_context.eState = eSampling;  // as if within a timed dispatch
+    m_context.nDepth = 1;
+    const cycles_t cyclesOverhead( m_context.cyclesOverhead );
+    const cycles_t cyclesBegin( Cycles() );
+    {
+      Scope scope( &probe );
+    }
+    const cycles_t cycles( Cycles() - cyclesBegin - cyclesRead - ( m_context.cyclesOverhead - cyclesOverhead ) );
+    if ( cycles < ( cycles_t ) 1 << 63 ) cyclesScope = std::min<cycles_t>( cyclesScope, cycles );
+  }
+  m_cyclesRead = cyclesRead;
+  m_cyclesScope = ( ~(cycles_t) 0 == cyclesScope ) ? 0 : cyclesScope;
+  m_context = context;
+  m_cyclesReset = Cycles();
+  m_tpReset = boost::chrono::steady_clock::now();
+}
+
+Profiler::~Profiler( void ) {
+  for ( mapProbe_t::iterator iter = m_mapProbe.begin(); m_mapProbe.end() != iter; ++iter ) {
+    delete iter->second;
+  }
+  m_mapProbe.clear();
+}
+
+Profiler::Probe* Profiler::Find( const std::string& sSite, const void* pFunction ) {
+  boost::mutex::scoped_lock lock( m_mutex );
+  const key_t key( sSite, pFunction );
+  mapProbe_t::iterator iter = m_mapProbe.find( key );
+  if ( m_mapProbe.end() == iter ) {
+    iter = m_mapProbe.insert( mapProbe_t::value_type( key, new Probe( sSite, pFunction ) ) ).first;
+  }
+  return iter->second;
+}
+
+void Profiler::SetName( const void* pFunction, const std::string& sName ) {
+  boost::mutex::scoped_lock lock( m_mutex );
+  m_mapName[ pFunction ] = sName;
+}
+
+void Profiler::SetSampling( unsigned int nSampling ) {
+  assert( 0 < nSampling );
+  m_nSampling = nSampling;
+}
+
+void Profiler::Reset( void ) {
+  boost::mutex::scoped_lock lock( m_mutex );
+  for ( mapProbe_t::iterator iter = m_mapProbe.begin(); m_mapProbe.end() != iter; ++iter ) {
+    Probe& probe( *iter->second );
+    probe.m_cntSamples = 0;
+    probe.m_cyclesTotal = 0;
+    probe.m_cyclesSelf = 0;
+    for ( unsigned int ix = 0; ix < Probe::nBuckets; ++ix ) probe.m_rBucket[ ix ] = 0;
+  }
+  m_cyclesReset = Cycles();
+  m_tpReset = boost::chrono::steady_clock::now();
+}
+
+std::string Profiler::Name( const void* pFunction ) {
+  if ( 0 == pFunction ) return "";
+  mapName_t::const_iterator iter = m_mapName.find( pFunction );
+  if ( m_mapName.end() != iter ) return iter->second;
+#if defined( OU_PROFILE ) && !defined( _WIN32 )
+  Dl_info info;
+  if ( ( 0 != dladdr( pFunction, &info ) ) && ( 0 != info.dli_sname ) ) {
+    int status( 0 );
+    char* szDemangled = abi::__cxa_demangle( info.dli_sname, 0, 0, &status );
+    std::string sName( ( 0 == status ) ? szDemangled : info.dli_sname );
+    std::free( szDemangled );
+    return sName;
+  }
+#endif
+  char sz[ 32 ];
+  std::sprintf( sz, "%p", pFunction );
+  return sz;
+}
+
+namespace {
+  struct Row {
+    Profiler::cycles_t cyclesTotal;
+    Profiler::cycles_t cyclesSelf;
+    Profiler::cycles_t cyclesP50;
+    Profiler::cycles_t cyclesP99;
+    boost::uint64_t cntSamples;
+    std::string sName;
+  };
+  bool ByTotal( const Row& lhs, const Row& rhs ) { return lhs.cyclesTotal > rhs.cyclesTotal; };
+  bool ByP99( const Row& lhs, const Row& rhs ) { return lhs.cyclesP99 > rhs.cyclesP99; };
+}
+
+void Profiler::Report( std::ostream& os, size_t nTop ) {
+
+  std::vector<Row> vRow;
+  {
+    boost::mutex::scoped_lock lock( m_mutex );
+    for ( mapProbe_t::iterator iter = m_mapProbe.begin(); m_mapProbe.end() != iter; ++iter ) {
+      Probe& probe( *iter->second );
+      Row row;
+      row.cntSamples = probe.m_cntSamples.load();
+      if ( 0 == row.cntSamples ) continue;
+      row.cyclesTotal = probe.m_cyclesTotal.load() * m_nSampling;
+      row.cyclesSelf = probe.m_cyclesSelf.load() * m_nSampling;
+      row.cyclesP50 = probe.Percentile( 0.50 );
+      row.cyclesP99 = probe.Percentile( 0.99 );
+      if ( probe.m_sName.empty() ) probe.m_sName = Name( probe.m_pFunction );
+      row.sName = probe.m_sName.empty() ? probe.m_sSite : ( probe.m_sName + " [" + probe.m_sSite + "]" );
+      vRow.push_back( row );
+    }
+  }
+
+  const double dblSeconds( boost::chrono::duration<double>( boost::chrono::steady_clock::now() - m_tpReset ).count() );
+  const double dblCyclesPerNs( ( 0.0 < dblSeconds ) ? ( (double) ( Cycles() - m_cyclesReset ) / ( dblSeconds * 1e9 ) ) : 1.0 );
+
+  const std::ios_base::fmtflags flags( os.flags() );
+  const std::streamsize precision( os.precision() );
+
+  os << "profile: 1 in " << m_nSampling << " dispatches timed, " << std::fixed << std::setprecision( 2 ) << dblCyclesPerNs << " cycles/ns" << std::endl;
+
+  for ( unsigned int nTable = 0; nTable < 2; ++nTable ) {
+    std::sort( vRow.begin(), vRow.end(), ( 0 == nTable ) ? ByTotal : ByP99 );
+    os << ( ( 0 == nTable ) ? "by total:" : "by p99:" ) << std::endl;
+    os
+      << std::setw( 12 ) << "calls"
+      << std::setw( 12 ) << "total ms"
+      << std::setw( 12 ) << "self ms"
+      << std::setw( 10 ) << "mean ns"
+      << std::setw( 10 ) << "p50 ns"
+      << std::setw( 10 ) << "p99 ns"
+      << "  handler" << std::endl;
+    size_t cnt( 0 );
+    for ( std::vector<Row>::const_iterator iter = vRow.begin(); ( vRow.end() != iter ) && ( cnt < nTop ); ++iter, ++cnt ) {
+      os << std::setprecision( 1 )
+        << std::setw( 12 ) << iter->cntSamples * m_nSampling
+        << std::setw( 12 ) << (double) iter->cyclesTotal / dblCyclesPerNs / 1e6
+        << std::setw( 12 ) << (double) iter->cyclesSelf / dblCyclesPerNs / 1e6
+        << std::setw( 10 ) << (double) iter->cyclesTotal / (double) ( iter->cntSamples * m_nSampling ) / dblCyclesPerNs
+        << std::setw( 10 ) << (double) iter->cyclesP50 / dblCyclesPerNs
+        << std::setw( 10 ) << (double) iter->cyclesP99 / dblCyclesPerNs
+        << "  " << iter->sName << std::endl;
+    }
+  }
+
+  os.flags( flags );
+  os.precision( precision );
+}
+
+} // namespace ou
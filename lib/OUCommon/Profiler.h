@@ -0,0 +1,211 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// where a simulation run spends its time: cycles attributed to each handler
+// the dispatch sites are instrumented when OU_PROFILE is defined, otherwise nothing is added to them
+//   OU_PROFILE changes the layout of ou::Delegate, so define it for the whole build, libraries included
+// sites: MergeDatedDatums per datum, each merge carrier's OnDatum, each handler in an ou::Delegate
+//   a probe per handler function, shared by all the objects it is called on
+// one outermost dispatch in nSampling is timed with rdtsc, along with everything dispatched within it
+//   on other than x86, 'cycles' are steady_clock nanoseconds
+//   so a handler's self time is its time less that of the handlers it dispatches to
+//   calls and totals are scaled back up by nSampling in the report
+// probe counters are only touched when sampled, and are not locked:
+//   threads dispatching at once through the same handler may lose the odd sample between them
+// names: SetName, otherwise the symbol for the handler's address, where it can be found (link with -rdynamic)
+// Profiler::Instance().Report( std::cout ) ranks handlers by total time, and by p99 time
+
+#include <map>
+#include <string>
+#include <ostream>
+#include <cstring>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/utility.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/chrono/chrono.hpp>
+
+#if defined( _MSC_VER )
+#define OU_PROFILE_TLS __declspec( thread )
+#else
+#define OU_PROFILE_TLS __thread
+#endif
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#define OU_PROFILE_RDTSC
+#if defined( _MSC_VER )
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+#include "FastDelegate.h"
+#include "Singleton.h"
+
+namespace ou {
+
+class Profiler: public Singleton<Profiler> {
+public:
+
+  typedef boost::uint64_t cycles_t;
+
+  class Probe: boost::noncopyable {
+    friend class Profiler;
+  public:
+    Probe( const std::string& sSite, const void* pFunction );
+    void Record( cycles_t cyclesTotal, cycles_t cyclesSelf );
+  private:
+    static const unsigned int nSubBits = 3;  // each power of two split in 8, p99 to within ~12%
+    static const unsigned int nBuckets = 64 << nSubBits;
+    std::string m_sSite;
+    std::string m_sName;
+    const void* m_pFunction;
+    boost::atomic<boost::uint64_t> m_cntSamples;
+    boost::atomic<boost::uint64_t> m_cyclesTotal;
+    boost::atomic<boost::uint64_t> m_cyclesSelf;
+    boost::atomic<boost::uint32_t> m_rBucket[ nBuckets ];  // of cyclesTotal
+    static unsigned int Bucket( cycles_t cycles );
+    static cycles_t BucketValue( unsigned int ix );  // middle of the bucket
+    cycles_t Percentile( double dbl ) const;
+  };
+
+  // times a dispatch, on the stack around the call
+  class Scope {
+  public:
+    explicit Scope( Probe* pProbe ): m_pProbe( 0 ), m_bOutermost( false ) {
+      switch ( m_context.eState ) {
+        case eSkipping:  // the usual case, within an outermost dispatch not being timed
+          break;
+        case eSampling:
+          Start( pProbe );
+          break;
+        case eIdle:  // outermost dispatch decides for all within it
+          m_bOutermost = true;
+          if ( 0 == m_context.nCountdown ) {
+            m_context.nCountdown = m_nSampling - 1;
+            m_context.eState = eSampling;
+            m_context.nDepth = 0;
+            Start( pProbe );
+          }
+          else {
+            --m_context.nCountdown;
+            m_context.eState = eSkipping;
+          }
+          break;
+      }
+    }
+    ~Scope( void ) {
+      if ( 0 != m_pProbe ) {
+        const cycles_t cyclesEnd( Cycles() );
+        const unsigned int ix( --m_context.nDepth );
+        // less the time spent recording the dispatches within, and the read of the clock itself
+        cycles_t cycles( cyclesEnd - m_cyclesStart - ( m_context.cyclesOverhead - m_cyclesOverhead ) );
+        cycles = ( m_cyclesRead < cycles ) ? ( cycles - m_cyclesRead ) : 0;
+        m_pProbe->Record( cycles, cycles - m_context.rChildren[ ix ] );
+        if ( 0 != ix ) m_context.rChildren[ ix - 1 ] += cycles;
+        m_context.cyclesOverhead += Cycles() - cyclesEnd + m_cyclesScope;
+      }
+      if ( m_bOutermost ) m_context.eState = eIdle;
+    }
+  private:
+    Probe* m_pProbe;
+    bool m_bOutermost;
+    cycles_t m_cyclesStart;
+    cycles_t m_cyclesOverhead;
+    void Start( Probe* pProbe ) {
+      if ( ( 0 != pProbe ) && ( nMaxDepth > m_context.nDepth ) ) {
+        m_pProbe = pProbe;
+        m_context.rChildren[ m_context.nDepth++ ] = 0;
+        m_cyclesOverhead = m_context.cyclesOverhead;
+        m_cyclesStart = Cycles();
+      }
+    }
+  };
+
+  Profiler( void );
+  virtual ~Profiler( void );
+
+#if defined( OU_PROFILE_RDTSC )
+  static cycles_t Cycles( void ) { return __rdtsc(); };
+#else
+  static cycles_t Cycles( void ) { return boost::chrono::duration_cast<boost::chrono::nanoseconds>( boost::chrono::steady_clock::now().time_since_epoch() ).count(); };
+#endif
+
+  // the probe for a handler, found (or made) when the handler is attached, not on each dispatch
+  template<typename D>
+  Probe* Find( const std::string& sSite, D delegate ) { return Find( sSite, Function( delegate ) ); };
+  Probe* Find( const std::string& sSite, const void* pFunction = 0 );
+
+  template<typename D>
+  void SetName( D delegate, const std::string& sName ) { SetName( Function( delegate ), sName ); };
+  void SetName( const void* pFunction, const std::string& sName );
+
+  void SetSampling( unsigned int nSampling );  // 1 in nSampling, before dispatching starts
+  unsigned int GetSampling( void ) const { return m_nSampling; };
+
+  void Reset( void );  // clears the counts, keeps the probes
+  void Report( std::ostream& os, size_t nTop = 20 );  // the stream's format is put back after
+
+protected:
+private:
+
+  static const unsigned int nMaxDepth = 32;
+
+  enum EState { eIdle = 0, eSkipping, eSampling };
+
+  struct Context {  // per thread, plain data for OU_PROFILE_TLS
+    EState eState;
+    unsigned int nDepth;  // of timed dispatches
+    unsigned int nCountdown;  // outermost dispatches till the next one timed
+    cycles_t cyclesOverhead;  // running total of time spent in Record
+    cycles_t rChildren[ nMaxDepth ];  // cycles of the dispatches within each level
+  };
+
+  static OU_PROFILE_TLS Context m_context;
+  static unsigned int m_nSampling;
+  static cycles_t m_cyclesRead;  // the cost of Cycles(), measured at start up
+  static cycles_t m_cyclesScope;  // the rest of a sampled Scope's cost, measured at start up
+
+  typedef std::pair<std::string, const void*> key_t;
+  typedef std::map<key_t, Probe*> mapProbe_t;
+  typedef std::map<const void*, std::string> mapName_t;
+
+  boost::mutex m_mutex;
+  mapProbe_t m_mapProbe;
+  mapName_t m_mapName;
+
+  // to convert cycles to time, Cycles is calibrated against the steady clock over the run
+  cycles_t m_cyclesReset;
+  boost::chrono::steady_clock::time_point m_tpReset;
+
+  struct Memento: public fastdelegate::DelegateMemento {  // to get at the handler's function
+    Memento( const fastdelegate::DelegateMemento& memento ): fastdelegate::DelegateMemento( memento ) {};
+    const void* Function( void ) const {
+      const void* p;
+      std::memcpy( &p, &m_pFunction, sizeof( p ) );  // the address, or the vtable offset of a virtual function
+      return p;
+    }
+  };
+
+  template<typename D>
+  static const void* Function( D& delegate ) { return Memento( delegate.GetMemento() ).Function(); };
+
+  std::string Name( const void* pFunction );
+};
+
+} // namespace ou
@@ -22,7 +22,8 @@ boost::local_time::tz_database TimeSource::m_tzDb;
 boost::local_time::time_zone_ptr TimeSource::m_tzNewYork;
 
 TimeSource::TimeSource(void)
-: m_dtLastRetrievedExternalTime( boost::posix_time::microsec_clock::universal_time() ) 
+: m_dtLastRetrievedExternalTime( boost::posix_time::microsec_clock::universal_time() ),
+  m_bDeterministic( false ), m_cntWallClockRefusals( 0 )
 {
   // http://www.boost.org/doc/libs/1_54_0/doc/html/date_time/examples.html#date_time.examples.local_utc_conversion
   try {
@@ -76,8 +77,13 @@ void TimeSource::Internal( ptime* dt, SimulationContext* context ) {
 ptime TimeSource::Internal( SimulationContext* context ) {
   if ( context->m_bInSimulation ) 
     return context->m_dtSimulationTime;
-  else 
+  else {
+    if ( m_bDeterministic ) {
+      m_cntWallClockRefusals.fetch_add( 1, boost::memory_order_relaxed );
+      return context->m_dtSimulationTime;
+    }
     return External(); 
+  }
 }
 
 } // ou
\ No newline at end of file
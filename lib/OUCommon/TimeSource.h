@@ -22,6 +22,7 @@ using namespace boost::posix_time;
 using namespace boost::gregorian;
 #include "boost/date_time/local_time/local_time.hpp"
 
+#include <boost/atomic.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include "Singleton.h"
@@ -74,6 +75,12 @@ public:
   }
   void ForceSimulationTime( const ptime &dt ) { m_contextCommon.m_bInSimulation = true; m_contextCommon.m_dtSimulationTime = dt; };
 
+  // deterministic: Internal never falls back to the wall clock, outside of simulation mode it returns the simulation time as it stands
+  //   (not_a_date_time before a simulation starts), and counts the read, so a deterministic run can show it had none
+  void SetDeterministic( bool bDeterministic = true ) { m_bDeterministic = bDeterministic; };
+  bool GetDeterministic( void ) const { return m_bDeterministic; };
+  unsigned long GetWallClockRefusals( void ) const { return m_cntWallClockRefusals.load( boost::memory_order_relaxed ); };
+
   SimulationContext* AcquireSimulationContext( void );
   void ReleaseSimulationContext( SimulationContext* );
 
@@ -108,6 +115,9 @@ private:
   SimulationContext m_contextCommon;
   ptime m_dtLastRetrievedExternalTime;
 
+  bool m_bDeterministic;
+  boost::atomic<unsigned long> m_cntWallClockRefusals;
+
   static bool m_bTzLoaded;
   static boost::local_time::tz_database m_tzDb;
   static boost::local_time::time_zone_ptr m_tzNewYork;
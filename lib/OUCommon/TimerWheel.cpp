@@ -0,0 +1,279 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+//#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <boost/bind.hpp>
+
+#include "TimeSource.h"
+
+#include "TimerWheel.h"
+
+namespace ou {
+
+TimerWheel::TimerWheel( time_duration tdResolution )
+  : m_tdResolution( tdResolution ), m_dtEpoch( not_a_date_time ),
+    m_tickNow( 0 ), m_nSequence( 0 ), m_cntActive( 0 ),
+    m_dtArmed( not_a_date_time ), m_bLive( false )
+{
+  assert( time_duration( 0, 0, 0 ) < m_tdResolution );
+}
+
+TimerWheel::~TimerWheel( void ) {
+  Stop();
+}
+
+TimerWheel::tick_t TimerWheel::Tick( ptime dt ) {
+  if ( m_dtEpoch.is_not_a_date_time() ) m_dtEpoch = dt;
+  if ( dt <= m_dtEpoch ) return 0;
+  return ( dt - m_dtEpoch ).ticks() / m_tdResolution.ticks();
+}
+
+TimerWheel::idTimer_t TimerWheel::Schedule( ptime dt, OnTimer_t function, time_duration tdRepeat ) {
+  assert( !dt.is_not_a_date_time() );
+  assert( 0 != function );
+  ixEntry_t ix;
+  if ( m_vFree.empty() ) {
+    ix = m_vEntry.size();
+    m_vEntry.push_back( Entry() );
+    m_vEntry.back().nGeneration = 0;
+  }
+  else {
+    ix = m_vFree.back();
+    m_vFree.pop_back();
+  }
+  Entry& entry( m_vEntry[ ix ] );
+  entry.dt = dt;
+  entry.tdRepeat = tdRepeat;
+  entry.function = function;
+#ifdef OU_PROFILE
+  entry.pProbe = ou::Profiler::Instance().Find( "TimerWheel", function );
+#endif
+  entry.nSequence = m_nSequence++;
+  entry.bActive = true;
+  ++m_cntActive;
+  Place( ix );
+  if ( m_bLive && ( m_dtArmed.is_not_a_date_time() || ( dt < m_dtArmed ) ) ) {
+    Arm();
+  }
+  return ( (idTimer_t) entry.nGeneration << 32 ) | ix;
+}
+
+bool TimerWheel::Cancel( idTimer_t id ) {
+  const ixEntry_t ix( id & 0xffffffff );
+  if ( m_vEntry.size() <= ix ) return false;
+  Entry& entry( m_vEntry[ ix ] );
+  if ( !entry.bActive || ( entry.nGeneration != ( id >> 32 ) ) ) return false;
+  entry.bActive = false;  // the slot lets go of it when next visited
+  --m_cntActive;
+  return true;
+}
+
+void TimerWheel::Release( ixEntry_t ix ) {
+  Entry& entry( m_vEntry[ ix ] );
+  entry.bActive = false;
+  entry.function = OnTimer_t();
+  ++entry.nGeneration;
+  m_vFree.push_back( ix );
+}
+
+void TimerWheel::Place( ixEntry_t ix ) {
+  tick_t tick( Tick( m_vEntry[ ix ].dt ) );
+  if ( tick < m_tickNow ) tick = m_tickNow;  // overdue, fires with the current slot
+  const tick_t delta( tick - m_tickNow );
+  for ( unsigned int level = 0; level < nLevels; ++level ) {
+    if ( delta < ( (tick_t) 1 << ( nBits * ( level + 1 ) ) ) ) {
+      m_vSlot[ level ][ ( tick >> ( nBits * level ) ) & nMask ].push_back( ix );
+      return;
+    }
+  }
+  // beyond the wheel, parked in the last slot level 3 reaches, and placed again from there
+  m_vSlot[ nLevels - 1 ][ ( ( m_tickNow >> ( nBits * ( nLevels - 1 ) ) ) - 1 ) & nMask ].push_back( ix );
+}
+
+void TimerWheel::Cascade( void ) {
+  // m_tickNow is at the start of a turn of level 0, bring down the next slot of level 1, and so on up while levels turn over
+  for ( unsigned int level = 1; level < nLevels; ++level ) {
+    const tick_t ixSlot( ( m_tickNow >> ( nBits * level ) ) & nMask );
+    m_vScratch.clear();
+    m_vScratch.swap( m_vSlot[ level ][ ixSlot ] );
+    for ( vEntry_t::const_iterator iter = m_vScratch.begin(); m_vScratch.end() != iter; ++iter ) {
+      if ( m_vEntry[ *iter ].bActive ) {
+        Place( *iter );
+      }
+      else {
+        Release( *iter );
+      }
+    }
+    if ( 0 != ixSlot ) break;
+  }
+}
+
+bool TimerWheel::Collect( ptime dt ) {
+  vEntry_t& slot( m_vSlot[ 0 ][ m_tickNow & nMask ] );
+  if ( slot.empty() ) return false;
+  bool bFound( false );
+  Earlier earlier( m_vEntry );
+  m_vScratch.clear();
+  for ( vEntry_t::const_iterator iter = slot.begin(); slot.end() != iter; ++iter ) {
+    const Entry& entry( m_vEntry[ *iter ] );
+    if ( !entry.bActive ) {
+      Release( *iter );
+    }
+    else {
+      if ( entry.dt <= dt ) {
+        m_vDue.push_back( *iter );
+        std::push_heap( m_vDue.begin(), m_vDue.end(), earlier );
+        bFound = true;
+      }
+      else {
+        m_vScratch.push_back( *iter );  // later in this tick
+      }
+    }
+  }
+  slot.swap( m_vScratch );
+  return bFound;
+}
+
+void TimerWheel::Fire( void ) {
+  ou::TimeSource& ts( ou::TimeSource::LocalCommonInstance() );
+  Earlier earlier( m_vEntry );
+  while ( !m_vDue.empty() ) {
+    std::pop_heap( m_vDue.begin(), m_vDue.end(), earlier );
+    const ixEntry_t ix( m_vDue.back() );
+    m_vDue.pop_back();
+    Entry& entry( m_vEntry[ ix ] );
+    if ( !entry.bActive ) {  // cancelled by an earlier callback
+      Release( ix );
+      continue;
+    }
+    if ( ts.GetSimulationMode() ) {
+      ptime dtNow( ts.Internal() );
+      if ( dtNow.is_not_a_date_time() || ( dtNow < entry.dt ) ) ts.SetSimulationTime( entry.dt );
+    }
+    OnTimer_t function( entry.function );
+#ifdef OU_PROFILE
+    ou::Profiler::Probe* pProbe( entry.pProbe );
+#endif
+    // done with the entry before the callback, which may schedule, and grow m_vEntry
+    if ( time_duration( 0, 0, 0 ) < entry.tdRepeat ) {
+      entry.dt += entry.tdRepeat;
+      entry.nSequence = m_nSequence++;
+      Place( ix );  // if due already, the caller's next Collect picks it up
+    }
+    else {
+      --m_cntActive;
+      Release( ix );
+    }
+#ifdef OU_PROFILE
+    ou::Profiler::Scope scope( pProbe );
+#endif
+    function();
+  }
+}
+
+void TimerWheel::Clear( void ) {
+  // nothing active, let go of the cancelled entries still in slots
+  for ( unsigned int level = 0; level < nLevels; ++level ) {
+    for ( unsigned int ixSlot = 0; ixSlot < nSlots; ++ixSlot ) {
+      vEntry_t& slot( m_vSlot[ level ][ ixSlot ] );
+      for ( vEntry_t::const_iterator iter = slot.begin(); slot.end() != iter; ++iter ) {
+        Release( *iter );
+      }
+      slot.clear();
+    }
+  }
+}
+
+void TimerWheel::Advance( ptime dt ) {
+  const tick_t tickTarget( Tick( dt ) );
+  while ( true ) {
+    while ( Collect( dt ) ) Fire();
+    if ( tickTarget <= m_tickNow ) break;
+    if ( 0 == m_cntActive ) {
+      Clear();
+      m_tickNow = tickTarget;
+      break;
+    }
+    // next occupied slot in this turn of level 0, otherwise the start of the next turn
+    tick_t tickNext( ( m_tickNow | nMask ) + 1 );
+    for ( tick_t tick = m_tickNow + 1; tick < tickNext; ++tick ) {
+      if ( !m_vSlot[ 0 ][ tick & nMask ].empty() ) {
+        tickNext = tick;
+        break;
+      }
+    }
+    if ( tickTarget < tickNext ) {
+      m_tickNow = tickTarget;  // slots in between are empty
+    }
+    else {
+      m_tickNow = tickNext;
+      if ( 0 == ( m_tickNow & nMask ) ) Cascade();
+    }
+  }
+}
+
+ptime TimerWheel::NextTime( void ) {
+  if ( 0 == m_cntActive ) return not_a_date_time;
+  const tick_t tickEnd( ( m_tickNow | nMask ) + 1 );
+  for ( tick_t tick = m_tickNow; tick < tickEnd; ++tick ) {
+    const vEntry_t& slot( m_vSlot[ 0 ][ tick & nMask ] );
+    ptime dt( not_a_date_time );
+    for ( vEntry_t::const_iterator iter = slot.begin(); slot.end() != iter; ++iter ) {
+      const Entry& entry( m_vEntry[ *iter ] );
+      if ( entry.bActive && ( dt.is_not_a_date_time() || ( entry.dt < dt ) ) ) dt = entry.dt;
+    }
+    if ( !dt.is_not_a_date_time() ) return dt;
+  }
+  return m_dtEpoch + time_duration( 0, 0, 0, m_tdResolution.ticks() * tickEnd );  // time to cascade
+}
+
+void TimerWheel::Start( boost::asio::io_service& io ) {
+  assert( !m_bLive );
+  m_pStrand.reset( new boost::asio::io_service::strand( io ) );
+  m_pDeadline.reset( new boost::asio::deadline_timer( io ) );
+  m_bLive = true;
+  m_pStrand->post( boost::bind( &TimerWheel::HandleDeadline, this, boost::system::error_code() ) );
+}
+
+void TimerWheel::Stop( void ) {
+  // the io_service is expected to have finished with the strand before the wheel is destroyed
+  if ( m_bLive ) {
+    m_bLive = false;
+    m_pDeadline->cancel();
+    m_dtArmed = not_a_date_time;
+  }
+}
+
+void TimerWheel::Arm( void ) {
+  m_dtArmed = NextTime();
+  if ( m_dtArmed.is_not_a_date_time() ) {
+    m_pDeadline->cancel();
+  }
+  else {
+    m_pDeadline->expires_at( m_dtArmed );  // cancels the previous wait
+    m_pDeadline->async_wait( m_pStrand->wrap( boost::bind( &TimerWheel::HandleDeadline, this, boost::asio::placeholders::error ) ) );
+  }
+}
+
+void TimerWheel::HandleDeadline( const boost::system::error_code& error ) {
+  if ( ( boost::asio::error::operation_aborted == error ) || !m_bLive ) return;
+  Advance( ou::TimeSource::Instance().External() );
+  Arm();
+}
+
+} // namespace ou
@@ -0,0 +1,133 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// callbacks at given times, for bar closes, rebalances, order time outs, without polling on each tick
+// hierarchical timer wheel: 4 levels of 256 slots, a slot in level 0 covers one tick of tdResolution
+//   a timer is kept in the lowest level which reaches its tick, and cascades down as time approaches
+//   with 1ms resolution, the wheel spans 49 days, anything further is re-placed each time level 3 turns over
+// timers fire in order of time, timers with the same time fire in order of scheduling, so runs are repeatable
+// time is pushed along by Advance:
+//   simulation: MergeDatedDatums calls Advance before each datum, timers at or before the datum's time fire first,
+//     simulation time is set to each timer's time as it fires
+//   live: Start runs the wheel on a strand of the io_service, a deadline timer wakes it for the next occupied slot
+//     Schedule and Cancel are then to be called on the strand (from a timer callback, or posted through Strand())
+
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/asio.hpp>
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+using namespace boost::posix_time;
+
+#include "FastDelegate.h"
+using namespace fastdelegate;
+
+#ifdef OU_PROFILE
+#include "Profiler.h"
+#endif
+
+namespace ou {
+
+class TimerWheel {
+public:
+
+  typedef FastDelegate0<> OnTimer_t;
+  typedef boost::uint64_t idTimer_t;  // slot in the pool, and a generation to catch stale ids
+
+  explicit TimerWheel( time_duration tdResolution = milliseconds( 1 ) );
+  virtual ~TimerWheel( void );
+
+  // tdRepeat non-zero: fires again every tdRepeat until cancelled
+  idTimer_t Schedule( ptime dt, OnTimer_t function, time_duration tdRepeat = time_duration( 0, 0, 0 ) );
+  bool Cancel( idTimer_t id );  // false when the timer has already fired, or been cancelled
+
+  size_t Size( void ) const { return m_cntActive; };
+
+  void Advance( ptime dt );  // fires timers at or before dt
+  ptime NextTime( void );  // earliest time worth advancing to, not_a_date_time when empty
+
+  // live
+  void Start( boost::asio::io_service& io );
+  void Stop( void );
+  boost::asio::io_service::strand* Strand( void ) { return m_pStrand.get(); };
+
+protected:
+private:
+
+  static const unsigned int nLevels = 4;
+  static const unsigned int nBits = 8;
+  static const unsigned int nSlots = 1 << nBits;
+  static const boost::uint64_t nMask = nSlots - 1;
+
+  typedef boost::uint64_t tick_t;
+  typedef boost::uint32_t ixEntry_t;
+  typedef std::vector<ixEntry_t> vEntry_t;
+
+  struct Entry {
+    ptime dt;
+    time_duration tdRepeat;
+    OnTimer_t function;
+    boost::uint64_t nSequence;  // order of scheduling, breaks ties on dt
+    boost::uint32_t nGeneration;
+    bool bActive;
+#ifdef OU_PROFILE
+    ou::Profiler::Probe* pProbe;
+#endif
+  };
+
+  struct Earlier {  // heap ordering of due entries, earliest on top
+    const std::vector<Entry>& v;
+    Earlier( const std::vector<Entry>& v_ ): v( v_ ) {};
+    bool operator()( ixEntry_t lhs, ixEntry_t rhs ) const {
+      const Entry& l( v[ lhs ] );
+      const Entry& r( v[ rhs ] );
+      return ( l.dt == r.dt ) ? ( l.nSequence > r.nSequence ) : ( l.dt > r.dt );
+    }
+  };
+
+  time_duration m_tdResolution;
+  ptime m_dtEpoch;  // tick 0, set by the first Schedule or Advance
+  tick_t m_tickNow;  // slot in level 0 being worked
+  boost::uint64_t m_nSequence;
+  size_t m_cntActive;
+
+  std::vector<Entry> m_vEntry;
+  std::vector<ixEntry_t> m_vFree;
+  vEntry_t m_vSlot[ nLevels ][ nSlots ];
+  vEntry_t m_vDue;  // heap of entries to fire in this Advance
+  vEntry_t m_vScratch;
+
+  // live
+  boost::scoped_ptr<boost::asio::io_service::strand> m_pStrand;
+  boost::scoped_ptr<boost::asio::deadline_timer> m_pDeadline;
+  ptime m_dtArmed;
+  bool m_bLive;
+
+  tick_t Tick( ptime dt );
+  void Place( ixEntry_t ix );
+  void Release( ixEntry_t ix );
+  void Cascade( void );
+  bool Collect( ptime dt );  // moves entries of the current slot due by dt to m_vDue
+  void Fire( void );
+  void Clear( void );
+
+  void Arm( void );
+  void HandleDeadline( const boost::system::error_code& error );
+};
+
+} // namespace ou
@@ -39,6 +39,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/ConsoleStream.o \
 	${OBJECTDIR}/CountryCode.o \
 	${OBJECTDIR}/CurrencyCode.o \
+	${OBJECTDIR}/Profiler.o \
 	${OBJECTDIR}/ReadCodeListCommon.o \
 	${OBJECTDIR}/ReadNaicsToSicCodeList.o \
 	${OBJECTDIR}/ReadSicCodeList.o \
@@ -46,6 +47,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/Singleton.o \
 	${OBJECTDIR}/SmartVar.o \
 	${OBJECTDIR}/TimeSource.o \
+	${OBJECTDIR}/TimerWheel.o \
 	${OBJECTDIR}/WuManber.o
 
 
@@ -93,6 +95,11 @@ ${OBJECTDIR}/CurrencyCode.o: CurrencyCode.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/CurrencyCode.o CurrencyCode.cpp
 
+${OBJECTDIR}/Profiler.o: Profiler.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/Profiler.o Profiler.cpp
+
 ${OBJECTDIR}/ReadCodeListCommon.o: ReadCodeListCommon.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -128,6 +135,11 @@ ${OBJECTDIR}/TimeSource.o: TimeSource.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TimeSource.o TimeSource.cpp
 
+${OBJECTDIR}/TimerWheel.o: TimerWheel.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TimerWheel.o TimerWheel.cpp
+
 ${OBJECTDIR}/WuManber.o: WuManber.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -26,6 +26,7 @@ using namespace boost::gregorian;
 #include <TFHDF5TimeSeries/HDF5DataManager.h>
 #include <TFHDF5TimeSeries/HDF5IterateGroups.h>
 #include <TFHDF5TimeSeries/HDF5TimeSeriesContainer.h>
+#include <TFHDF5TimeSeries/HDF5Catalog.h>
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
@@ -38,9 +39,11 @@ public:
   typedef boost::function<bool (S&, const std::string&, const std::string&)> cbUseGroup_t;  // use a particular group in HDF5
   typedef boost::function<bool (S&, const std::string&, TS&)> cbFilter_t; // used for filtering on fields in the Time Series
   typedef boost::function<void (S&, const std::string&, TS&)> cbResult_t;  // send the chosen filtered results back
+  typedef boost::function<bool (S&, const HDF5Catalog::Entry&)> cbCatalog_t;  // pre-filter on the dataset's summary, false: not opened
   InstrumentFilter( const std::string& sPath, ptime dtBegin, ptime dtEnd, typename TS::size_type, 
     cbUseGroup_t, cbFilter_t, cbResult_t );
   ~InstrumentFilter( void ) {};
+  void SetCatalogFilter( cbCatalog_t cbCatalog ) { m_cbCatalog = cbCatalog; };  // Run then goes by the catalog, see HDF5Catalog.h
   void Run( void );
 protected:
 private:
@@ -55,6 +58,7 @@ private:
   cbUseGroup_t m_cbUseGroup;
   cbFilter_t m_cbFilter;
   cbResult_t m_cbResult;
+  cbCatalog_t m_cbCatalog;
 
   ou::tf::HDF5DataManager m_dm;
 
@@ -80,12 +84,35 @@ InstrumentFilter<S,TS>::InstrumentFilter(
 
 template<typename S, typename TS>
 void InstrumentFilter<S,TS>::Run( void ) {
-  namespace args = boost::phoenix::placeholders;
-  ou::tf::hdf5::IterateGroups ig( 
-    m_sRootPath, 
-    boost::phoenix::bind( &InstrumentFilter<S,TS>::HandleGroup, this, args::arg1, args::arg2 ), 
-    boost::phoenix::bind( &InstrumentFilter<S,TS>::HandleObject, this, args::arg1, args::arg2 ) 
-    );
+  if ( m_cbCatalog ) {
+    HDF5Catalog catalog( m_sRootPath );
+    catalog.Load( m_dm );
+    std::string sGroupPath( catalog.GetGroup() );
+    for ( HDF5Catalog::vEntry_t::const_iterator iter = catalog.Entries().begin(); catalog.Entries().end() != iter; ++iter ) {
+      const std::string sPath( iter->sPath.substr( 0, iter->sPath.rfind( '/' ) + 1 ) );
+      if ( sPath != sGroupPath ) {  // the group call IterateGroups makes, for groups holding datasets
+        sGroupPath = sPath;
+        const std::string::size_type ix( sPath.rfind( '/', sPath.size() - 2 ) + 1 );
+        HandleGroup( sPath, sPath.substr( ix, sPath.size() - ix - 1 ) );
+      }
+      if ( m_bSendThroughFilter && ( !iter->bSummarised || m_cbCatalog( m_struct, *iter ) ) ) {
+        try {
+          HandleObject( iter->sPath, iter->sName );
+        }
+        catch (...) {
+          std::cout << "InstrumentFilter::Run Object " << iter->sName << " problem" << std::endl;
+        }
+      }
+    }
+  }
+  else {
+    namespace args = boost::phoenix::placeholders;
+    ou::tf::hdf5::IterateGroups ig( 
+      m_sRootPath, 
+      boost::phoenix::bind( &InstrumentFilter<S,TS>::HandleGroup, this, args::arg1, args::arg2 ), 
+      boost::phoenix::bind( &InstrumentFilter<S,TS>::HandleObject, this, args::arg1, args::arg2 ) 
+      );
+  }
 }
 
 template<typename S, typename TS>
@@ -36,14 +36,23 @@ void InstrumentSelection::Process( const ptime& eod, setInfo_t& selected ) {
 
   std::cout << "Running" << std::endl;
 
-  ou::tf::HDF5IterateGroups groups;
-  groups.SetOnHandleObject( MakeDelegate( this, &InstrumentSelection::ProcessGroupItem ) );
+  ou::tf::HDF5Catalog catalog( "/bar/86400/" );  // pre-filter on the summaries, open only the survivors
   try {
-    int result = groups.Start( "/bar/86400/" );
+    catalog.Load( m_dm );
   }
   catch (...) {
     std::cout << "ouch" << std::endl;
   }
+  for ( ou::tf::HDF5Catalog::vEntry_t::const_iterator iter = catalog.Entries().begin(); catalog.Entries().end() != iter; ++iter ) {
+    if ( Survives( *iter ) ) {
+      try {
+        ProcessGroupItem( iter->sPath, iter->sName );
+      }
+      catch (...) {
+        std::cout << "InstrumentSelection::Process " << iter->sName << " problem" << std::endl;
+      }
+    }
+  }
 
   std::cout << "History Scanned." << std::endl;
 
@@ -70,6 +79,22 @@ public:
   operator ou::tf::Bar::volume_t() { return m_nTotalVolume / m_nNumberOfValues; };
 };
 
+// conditions ProcessGroupItem needs, taken from the summary, so failing them doesn't need the bars
+bool InstrumentSelection::Survives( const ou::tf::HDF5Catalog::Entry& entry ) const {
+  if ( !entry.bSummarised ) return true;  // unknown, is opened
+  if ( 8 >= entry.nCount ) return false;
+  if ( ( entry.dtLast < m_dtDate1 ) || ( entry.dtFirst >= m_dtDate2 ) ) return false;
+  if ( entry.dtLast < m_dtDate2 ) {
+    // the last bar is the last of the range, and the range, at most 14 bars, lies within the trailing days
+    if ( ( 12.0 > entry.dblClose ) || ( 80.0 < entry.dblClose ) ) return false;
+    if ( 9000000.0 >= entry.TrailingVolume() ) return false;  // more than 8 bars averaging more than 1000000
+  }
+  else {
+    if ( ( 12.0 > entry.dblMaxPrice ) || ( 80.0 < entry.dblMinPrice ) ) return false;
+  }
+  return true;
+}
+
 void InstrumentSelection::ProcessGroupItem( const std::string& sObjectPath, const std::string& sObjectName ) {
   ou::tf::HDF5TimeSeriesContainer<ou::tf::Bar> barRepository( m_dm, sObjectPath );
   ou::tf::HDF5TimeSeriesContainer<ou::tf::Bar>::iterator begin, end;
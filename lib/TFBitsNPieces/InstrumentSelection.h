@@ -34,6 +34,7 @@ using namespace boost::gregorian;
 
 #include <TFTimeSeries/TimeSeries.h>
 #include <TFHDF5TimeSeries/HDF5DataManager.h>
+#include <TFHDF5TimeSeries/HDF5Catalog.h>
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
@@ -77,6 +78,7 @@ private:
 
   mapInfoRankedByVolume_t m_mapInfoRankedByVolume;
 
+  bool Survives( const ou::tf::HDF5Catalog::Entry& entry ) const;
   void ProcessGroupItem( const std::string& sObjectPath, const std::string& sObjectName );
 
 };
@@ -30,6 +30,8 @@ const char szDay[] = "Day";
 const char szMultiplier[] = "Multiplier";
 const char szSignificantDigits[] = "SignificantDigits";
 const char szSignature[] = "Signature";
+const char szSummary[] = "Summary";
+const char szRolledDays[] = "RolledDays";
 
  HDF5Attributes::HDF5Attributes( HDF5DataManager& dm ) 
  : m_pDataSet( NULL ), m_dm( dm )
@@ -145,6 +147,82 @@ unsigned short HDF5Attributes::GetMultiplier( void ) {
   return mult;
 }
 
+namespace {
+H5::CompType* DefineSummaryType( void ) {
+  typedef HDF5Attributes::structSummary summary_t;
+  const hsize_t nDays( summary_t::nTrailingDays );
+  H5::CompType* pComp = new H5::CompType( sizeof( summary_t ) );
+  pComp->insertMember( "Count",         HOFFSET( summary_t, nCount ),           H5::PredType::NATIVE_UINT64 );
+  pComp->insertMember( "First",         HOFFSET( summary_t, dtFirst ),          H5::PredType::NATIVE_LLONG );
+  pComp->insertMember( "Last",          HOFFSET( summary_t, dtLast ),           H5::PredType::NATIVE_LLONG );
+  pComp->insertMember( "MinPrice",      HOFFSET( summary_t, dblMinPrice ),      H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "MaxPrice",      HOFFSET( summary_t, dblMaxPrice ),      H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "Close",         HOFFSET( summary_t, dblClose ),         H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "Volume",        HOFFSET( summary_t, nVolume ),          H5::PredType::NATIVE_UINT64 );
+  pComp->insertMember( "AverageVolume", HOFFSET( summary_t, dblAverageVolume ), H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "Days",          HOFFSET( summary_t, nDays ),            H5::PredType::NATIVE_UINT32 );
+  pComp->insertMember( "Day",           HOFFSET( summary_t, rDay ),       H5::ArrayType( H5::PredType::NATIVE_UINT32, 1, &nDays ) );
+  pComp->insertMember( "DayVolume",     HOFFSET( summary_t, rDayVolume ), H5::ArrayType( H5::PredType::NATIVE_UINT64, 1, &nDays ) );
+  return pComp;
+}
+}
+
+void HDF5Attributes::SetSummary( const structSummary& summary ) {
+  // one compound attribute, so a catalog build reads one per dataset
+  H5::CompType* pComp = DefineSummaryType();
+  if ( m_pDataSet->attrExists( szSummary ) ) {
+    H5::Attribute attribute( m_pDataSet->openAttribute( szSummary ) );
+    attribute.write( *pComp, &summary );
+    attribute.close();
+  }
+  else {
+    H5::DataSpace dspace;
+    H5::Attribute attribute( m_pDataSet->createAttribute( szSummary, *pComp, dspace ) );
+    attribute.write( *pComp, &summary );
+    attribute.close();
+  }
+  pComp->close();
+  delete pComp;
+}
+
+bool HDF5Attributes::GetSummary( structSummary* summary ) {
+  if ( !m_pDataSet->attrExists( szSummary ) ) return false;
+  H5::CompType* pComp = DefineSummaryType();
+  H5::Attribute attribute( m_pDataSet->openAttribute( szSummary ) );
+  attribute.read( *pComp, summary );
+  attribute.close();
+  pComp->close();
+  delete pComp;
+  return true;
+}
+
+void HDF5Attributes::SetRolledDays( const std::vector<boost::uint32_t>& vDay ) {
+  // the list only grows, but the dataspace is fixed, so it is replaced
+  if ( m_pDataSet->attrExists( szRolledDays ) ) {
+    m_pDataSet->removeAttr( szRolledDays );
+  }
+  if ( !vDay.empty() ) {
+    hsize_t dim = vDay.size();
+    H5::DataSpace dspace( 1, &dim );
+    H5::Attribute attribute( m_pDataSet->createAttribute( szRolledDays, H5::PredType::NATIVE_UINT32, dspace ) );
+    attribute.write( H5::PredType::NATIVE_UINT32, &vDay[ 0 ] );
+    attribute.close();
+    dspace.close();
+  }
+}
+
+void HDF5Attributes::GetRolledDays( std::vector<boost::uint32_t>& vDay ) {
+  vDay.clear();
+  if ( m_pDataSet->attrExists( szRolledDays ) ) {
+    H5::Attribute attribute( m_pDataSet->openAttribute( szRolledDays ) );
+    H5::DataSpace dspace( attribute.getSpace() );
+    vDay.resize( dspace.getSimpleExtentNpoints() );
+    if ( !vDay.empty() ) attribute.read( H5::PredType::NATIVE_UINT32, &vDay[ 0 ] );
+    dspace.close();
+    attribute.close();
+  }
+}
+
 void HDF5Attributes::SetOptionAttributes( const structOption& option ) {
 
   SetInstrumentType( InstrumentType::Option );
@@ -15,8 +15,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "HDF5DataManager.h"
 #include <TFTrading/TradingEnumerations.h>
@@ -49,6 +51,22 @@ public:
       : nYear( nYear_ ), nMonth( nMonth_ ), nDay( nDay_) {};
   };
 
+  struct structSummary {  // maintained by HDF5WriteTimeSeries::Write, see HDF5Summary.h
+    static const unsigned int nTrailingDays = 20;
+    boost::uint64_t nCount;
+    boost::posix_time::ptime dtFirst;
+    boost::posix_time::ptime dtLast;
+    double dblMinPrice;  // prices and volumes remain 0 for datums without them
+    double dblMaxPrice;
+    double dblClose;  // price of the last datum
+    boost::uint64_t nVolume;  // total
+    double dblAverageVolume;  // per day, over the trailing days
+    boost::uint32_t nDays;  // trailing days held, oldest first, the last is the day of dtLast
+    boost::uint32_t rDay[ nTrailingDays ];  // gregorian day numbers
+    boost::uint64_t rDayVolume[ nTrailingDays ];
+    structSummary( void ) : nCount( 0 ), dblMinPrice( 0 ), dblMaxPrice( 0 ), dblClose( 0 ), nVolume( 0 ), dblAverageVolume( 0 ), nDays( 0 ) {};
+  };
+
   HDF5Attributes( HDF5DataManager& dm );
   HDF5Attributes( HDF5DataManager& dm, const std::string& sPath );
   HDF5Attributes( HDF5DataManager& dm, const std::string& sPath, InstrumentType::enumInstrumentTypes );
@@ -77,6 +95,12 @@ public:
   void SetMultiplier( unsigned short );
   unsigned short GetMultiplier( void );
 
+  void SetSummary( const structSummary& );  // creates, or replaces the one there
+  bool GetSummary( structSummary* );  // false when the dataset has none
+
+  void SetRolledDays( const std::vector<boost::uint32_t>& );  // gregorian day numbers, see HDF5BarRollup.h
+  void GetRolledDays( std::vector<boost::uint32_t>& );  // empty when the dataset has none
+
 protected:
   void OpenDataSet( const std::string& sPath );
   void CloseDataSet( void );
@@ -0,0 +1,270 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+//#include "StdAfx.h"
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "HDF5Attribute.h"
+#include "HDF5IterateGroups.h"
+#include "HDF5WriteTimeSeries.h"
+#include "HDF5TimeSeriesContainer.h"
+
+#include "HDF5BarRollup.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+namespace {
+  const size_t nQueued = 2;  // rolled symbols waiting on the writer, per worker, bounds the bars held
+}
+
+HDF5BarRollup::HDF5BarRollup( const std::string& sTarget )
+: m_sTarget( sTarget ), m_nWorkers( 1 ),
+  m_dateThrough( boost::gregorian::day_clock::universal_day() ),
+  m_ixNextSymbol( 0 ), m_nWorkersRunning( 0 ),
+  m_cntSymbolsRolled( 0 ), m_cntDaysRolled( 0 ), m_cntTrades( 0 ), m_cntBars( 0 ), m_cntFailed( 0 ), m_dblSeconds( 0 )
+{
+  assert( !m_sTarget.empty() && ( '/' == m_sTarget[ m_sTarget.size() - 1 ] ) );
+  m_vWidth.push_back( 60 );
+  m_vWidth.push_back( 300 );
+  m_vWidth.push_back( 3600 );
+  m_vWidth.push_back( 86400 );
+}
+
+HDF5BarRollup::~HDF5BarRollup( void ) {
+}
+
+void HDF5BarRollup::SetWorkers( unsigned int nWorkers ) {
+  m_nWorkers = std::max<unsigned int>( 1, nWorkers );
+}
+
+void HDF5BarRollup::Run( const std::string& sSource ) {
+
+  boost::posix_time::ptime dtStart( boost::posix_time::microsec_clock::universal_time() );
+
+  m_mapSource.clear();
+  m_vSymbol.clear();
+  m_qRolled.clear();
+  m_ixNextSymbol = 0;
+  m_cntSymbolsRolled = m_cntDaysRolled = 0;
+  m_cntTrades = m_cntBars = 0;
+  m_cntFailed = 0;
+
+  HDF5DataManager dm( HDF5DataManager::RDWR );  // the writer's, open before the readers'
+
+  HDF5IterateGroups control;
+  control.SetOnHandleObject( MakeDelegate( this, &HDF5BarRollup::HandleObject ) );
+  control.Start( sSource );
+  for ( mapSource_t::const_iterator iter = m_mapSource.begin(); m_mapSource.end() != iter; ++iter ) {
+    m_vSymbol.push_back( iter );
+  }
+
+  if ( !m_vSymbol.empty() ) {
+    boost::thread threadWriter( boost::bind( &HDF5BarRollup::Writer, this, boost::ref( dm ) ) );
+    boost::thread_group workers;
+    m_nWorkersRunning = m_nWorkers;
+    for ( unsigned int ix = 0; ix < m_nWorkers; ++ix ) {
+      workers.create_thread( boost::bind( &HDF5BarRollup::Worker, this ) );
+    }
+    workers.join_all();
+    threadWriter.join();
+  }
+
+  m_dblSeconds = ( boost::posix_time::microsec_clock::universal_time() - dtStart ).total_microseconds() / 1000000.0;
+}
+
+void HDF5BarRollup::HandleObject( const std::string& sObjectPath, const std::string& sObjectName ) {
+  if ( 0 == sObjectPath.compare( 0, m_sTarget.size(), m_sTarget ) ) return;  // not the bars already rolled
+  if ( sObjectPath.size() < ( sObjectName.size() + 2 ) ) return;  // needs a parent group
+  const std::string::size_type ix( sObjectPath.rfind( '/', sObjectPath.size() - sObjectName.size() - 2 ) );
+  const std::string sParent( sObjectPath.substr( ix + 1, sObjectPath.size() - sObjectName.size() - ix - 2 ) );
+  if ( ( "trades" == sParent ) || ( "trade" == sParent ) ) {
+    m_mapSource[ sObjectName ].push_back( sObjectPath );
+  }
+}
+
+bool HDF5BarRollup::Wanted( const vDay_t& vDay, boost::gregorian::date date ) const {
+  return ( date < m_dateThrough ) && !std::binary_search( vDay.begin(), vDay.end(), date.day_number() );
+}
+
+void HDF5BarRollup::Worker( void ) {
+  boost::scoped_ptr<HDF5DataManager> pdm;
+  {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    pdm.reset( new HDF5DataManager( HDF5DataManager::RO ) );  // the worker's own
+  }
+  while ( true ) {
+    const size_t ix( m_ixNextSymbol.fetch_add( 1 ) );
+    if ( ix >= m_vSymbol.size() ) break;
+    pRolled_t pRolled( new Rolled );
+    pRolled->sSymbol = m_vSymbol[ ix ]->first;
+    try {
+      Roll( *pdm, m_vSymbol[ ix ]->first, m_vSymbol[ ix ]->second, *pRolled );
+    }
+    catch ( std::runtime_error& e ) {
+      ++m_cntFailed;
+      std::cout << "HDF5BarRollup " << pRolled->sSymbol << ": " << e.what() << std::endl;
+      continue;
+    }
+    catch ( H5::Exception& e ) {
+      ++m_cntFailed;
+      std::cout << "HDF5BarRollup " << pRolled->sSymbol << ": " << e.getDetailMsg() << std::endl;
+      continue;
+    }
+    if ( 0 != pRolled->nDaysNew ) {
+      boost::mutex::scoped_lock lock( m_mutexQueue );
+      while ( ( nQueued * m_nWorkers ) <= m_qRolled.size() ) m_cvQueue.wait( lock );
+      m_qRolled.push_back( pRolled );
+      m_cvQueue.notify_all();
+    }
+  }
+  {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    pdm.reset();
+  }
+  boost::mutex::scoped_lock lock( m_mutexQueue );
+  --m_nWorkersRunning;
+  m_cvQueue.notify_all();
+}
+
+void HDF5BarRollup::Roll( HDF5DataManager& dm, const std::string& sSymbol, const vPath_t& vPath, Rolled& rolled ) {
+
+  std::string sPathRolled;
+  HDF5DataManager::BarPath( m_sTarget, m_vWidth[ 0 ], sSymbol, sPathRolled );
+
+  std::vector<Trade> vTrade;
+  {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    if ( dm.PathExists( sPathRolled ) ) {
+      HDF5Attributes attributes( dm, sPathRolled );
+      attributes.GetRolledDays( rolled.vDayRolled );
+    }
+  }
+
+  for ( vPath_t::const_iterator iterPath = vPath.begin(); vPath.end() != iterPath; ++iterPath ) {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );  // released between blocks
+    HDF5TimeSeriesContainer<Trade> repository( dm, *iterPath, false );  // read once, front to back
+    const size_t nRemaining( repository.size() );
+    {
+      HDF5Attributes attributes( dm, *iterPath );
+      HDF5Attributes::structSummary summary;
+      if ( attributes.GetSummary( &summary ) && ( nRemaining == summary.nCount ) ) {
+        bool bWanted( false );
+        for ( boost::gregorian::date date = summary.dtFirst.date(); !bWanted && ( date <= summary.dtLast.date() ); date += boost::gregorian::days( 1 ) ) {
+          bWanted = Wanted( rolled.vDayRolled, date );
+        }
+        if ( !bWanted ) continue;
+      }
+    }
+    size_t nChunk( repository.ChunkSize() );
+    if ( 0 == nChunk ) nChunk = 4096;
+    const size_t nBlock( nChunk * std::max<size_t>( 1, 16384 / nChunk ) );
+    TimeSeries<Trade> block;
+    HDF5TimeSeriesContainer<Trade>::iterator begin, end;
+    size_t ix( 0 );
+    while ( ix < nRemaining ) {
+      const size_t n( std::min( nBlock - ( ix % nBlock ), nRemaining - ix ) );  // along chunk boundaries
+      begin = repository.begin();
+      begin += ix;
+      end = begin;
+      end += n;
+      block.Clear();
+      block.Resize( n );
+      repository.Read( begin, end, &block );
+      lock.unlock();
+      for ( size_t ixBlock = 0; ixBlock < n; ++ixBlock ) {
+        const Trade& trade( block.At( ixBlock ) );
+        if ( Wanted( rolled.vDayRolled, trade.DateTime().date() ) ) vTrade.push_back( trade );
+      }
+      ix += n;
+      lock.lock();
+    }
+  }
+
+  if ( !vTrade.empty() ) {
+    if ( 1 < vPath.size() ) std::stable_sort( vTrade.begin(), vTrade.end() );  // sessions may overlap
+    for ( size_t ix = 0; ix < m_vWidth.size(); ++ix ) {
+      rolled.vBars.push_back( boost::shared_ptr<Bars>( new Bars ) );
+    }
+    Collector collector( rolled );
+    MultiBarFactory factory( m_vWidth );
+    factory.SetOnBarComplete( MakeDelegate( &collector, &Collector::HandleBarComplete ) );
+    boost::gregorian::date date;
+    vDay_t vDayNew;
+    for ( std::vector<Trade>::const_iterator iter = vTrade.begin(); vTrade.end() != iter; ++iter ) {
+      if ( vDayNew.empty() || ( iter->DateTime().date() != date ) ) {
+        date = iter->DateTime().date();
+        vDayNew.push_back( date.day_number() );
+      }
+      factory.Add( *iter );
+    }
+    factory.Close();
+    rolled.nTrades = vTrade.size();
+    rolled.nDaysNew = vDayNew.size();
+    vDay_t vDay;
+    std::merge( rolled.vDayRolled.begin(), rolled.vDayRolled.end(), vDayNew.begin(), vDayNew.end(), std::back_inserter( vDay ) );
+    rolled.vDayRolled.swap( vDay );
+  }
+}
+
+void HDF5BarRollup::Writer( HDF5DataManager& dm ) {
+  while ( true ) {
+    pRolled_t pRolled;
+    {
+      boost::mutex::scoped_lock lock( m_mutexQueue );
+      while ( m_qRolled.empty() && ( 0 != m_nWorkersRunning ) ) m_cvQueue.wait( lock );
+      if ( m_qRolled.empty() ) break;  // and the workers are done
+      pRolled = m_qRolled.front();
+      m_qRolled.pop_front();
+      m_cvQueue.notify_all();
+    }
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    try {
+      Write( dm, *pRolled );
+    }
+    catch ( H5::Exception& e ) {
+      ++m_cntFailed;
+      std::cout << "HDF5BarRollup " << pRolled->sSymbol << " write: " << e.getDetailMsg() << std::endl;
+    }
+  }
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+  dm.Flush();
+}
+
+void HDF5BarRollup::Write( HDF5DataManager& dm, Rolled& rolled ) {
+  std::string sPath;
+  for ( size_t ix = 0; ix < m_vWidth.size(); ++ix ) {
+    HDF5DataManager::BarPath( m_sTarget, m_vWidth[ ix ], rolled.sSymbol, sPath );
+    HDF5WriteTimeSeries<Bars> wts( dm, true, true, 5, 256 );
+    wts.Merge( sPath, rolled.vBars[ ix ].get() );  // the days are new, so no de-duplication
+    m_cntBars += rolled.vBars[ ix ]->Size();
+  }
+  HDF5DataManager::BarPath( m_sTarget, m_vWidth[ 0 ], rolled.sSymbol, sPath );
+  HDF5Attributes attributes( dm, sPath );
+  attributes.SetRolledDays( rolled.vDayRolled );
+  ++m_cntSymbolsRolled;
+  m_cntDaysRolled += rolled.nDaysNew;
+  m_cntTrades += rolled.nTrades;
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,137 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// rolls the trades kept in the hdf5 file up into bars of several widths, see TFTimeSeries/MultiBarFactory.h
+//   sources: the datasets in a group named trades (Watch::SaveSeries, WatchRecorder) or trade (IQFeedGetHistory)
+//     found under the source group, the dataset name being the symbol; a symbol's datasets are taken together
+//   bars go to HDF5DataManager::BarPath( sTarget, width, symbol ), eg /rollup/60/S/P/SPY, merged in with their summaries,
+//     /bar/86400/ is left to the daily bar downloads
+//   incremental: the days (utc, as the timestamps) rolled for a symbol are listed in the RolledDays attribute
+//     of its narrowest bars, and are not rolled again; days from the through date on are left, they may still be recording
+//     so a day is best rolled once all its trades are in
+//   a source whose summary shows only days rolled, or to be left, is not read
+// threads: nWorkers each with a data manager of their own read a symbol's trades and build its bars,
+//   one writer thread merges the bars in, so the file has one writer
+//   calls into hdf5 hold HDF5DataManager::Mutex, as every threaded user of hdf5 does,
+//   so the workers overlap on sorting and bar building, and with the writer
+// How to Use:
+/*
+  ou::tf::HDF5BarRollup rollup;  // 60, 300, 3600, 86400 seconds under /rollup/
+  rollup.SetWorkers( boost::thread::hardware_concurrency() );
+  rollup.Run( "/" );  // no hdf5 data manager held open by the caller
+  std::cout << rollup.GetSymbolsRolled() << " symbols, " << rollup.GetDaysRolled() << " days, " << rollup.GetSeconds() << "s" << std::endl;
+*/
+
+#include <map>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+#include <TFTimeSeries/TimeSeries.h>
+#include <TFTimeSeries/MultiBarFactory.h>
+
+#include "HDF5DataManager.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class HDF5BarRollup {
+public:
+
+  typedef MultiBarFactory::vWidth_t vWidth_t;
+
+  explicit HDF5BarRollup( const std::string& sTarget = "/rollup/" );  // with trailing /
+  ~HDF5BarRollup( void );
+
+  void SetWidths( const vWidth_t& vWidth ) { m_vWidth = vWidth; };  // as MultiBarFactory
+  void SetWorkers( unsigned int nWorkers );  // 1 (default) still has the writer thread
+  void SetThrough( boost::gregorian::date date ) { m_dateThrough = date; };  // days before are rolled, default today (utc)
+
+  void Run( const std::string& sSource = "/" );
+
+  size_t GetSymbols( void ) const { return m_mapSource.size(); };
+  size_t GetSymbolsRolled( void ) const { return m_cntSymbolsRolled; };
+  size_t GetDaysRolled( void ) const { return m_cntDaysRolled; };
+  boost::uint64_t GetTrades( void ) const { return m_cntTrades; };
+  boost::uint64_t GetBars( void ) const { return m_cntBars; };
+  size_t GetFailed( void ) const { return m_cntFailed; };
+  double GetSeconds( void ) const { return m_dblSeconds; };  // wall clock of the last Run
+
+protected:
+private:
+
+  typedef std::vector<boost::uint32_t> vDay_t;  // gregorian day numbers, ascending
+
+  struct Rolled {  // a symbol's new bars, from a worker to the writer
+    std::string sSymbol;
+    vDay_t vDayRolled;  // those already rolled and those now
+    size_t nDaysNew;
+    boost::uint64_t nTrades;
+    std::vector<boost::shared_ptr<Bars> > vBars;  // by width
+    Rolled( void ): nDaysNew( 0 ), nTrades( 0 ) {};
+  };
+  typedef boost::shared_ptr<Rolled> pRolled_t;
+
+  struct Collector {  // takes the bars from a worker's MultiBarFactory
+    Rolled& m_rolled;
+    explicit Collector( Rolled& rolled ): m_rolled( rolled ) {};
+    void HandleBarComplete( size_t ix, const Bar& bar ) { m_rolled.vBars[ ix ]->Append( bar ); };
+  };
+
+  typedef std::vector<std::string> vPath_t;
+  typedef std::map<std::string, vPath_t> mapSource_t;  // symbol, its trade datasets
+
+  std::string m_sTarget;
+  vWidth_t m_vWidth;
+  unsigned int m_nWorkers;
+  boost::gregorian::date m_dateThrough;
+
+  mapSource_t m_mapSource;
+  std::vector<mapSource_t::const_iterator> m_vSymbol;  // in turn to the workers
+  boost::atomic<size_t> m_ixNextSymbol;
+
+  boost::mutex m_mutexQueue;
+  boost::condition_variable m_cvQueue;
+  std::deque<pRolled_t> m_qRolled;
+  unsigned int m_nWorkersRunning;
+
+  size_t m_cntSymbolsRolled;
+  size_t m_cntDaysRolled;
+  boost::uint64_t m_cntTrades;
+  boost::uint64_t m_cntBars;
+  boost::atomic<size_t> m_cntFailed;
+  double m_dblSeconds;
+
+  void HandleObject( const std::string& sObjectPath, const std::string& sObjectName );
+
+  void Worker( void );
+  void Roll( HDF5DataManager& dm, const std::string& sSymbol, const vPath_t& vPath, Rolled& rolled );
+  bool Wanted( const vDay_t& vDay, boost::gregorian::date date ) const;
+
+  void Writer( HDF5DataManager& dm );
+  void Write( HDF5DataManager& dm, Rolled& rolled );
+
+};
+
+} // namespace tf
+} // namespace ou
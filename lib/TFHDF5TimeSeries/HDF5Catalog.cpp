@@ -0,0 +1,264 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+//#include "StdAfx.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "HDF5Attribute.h"
+#include "HDF5Catalog.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+namespace {
+
+const char szCatalog[] = "/catalog";
+const char szEntries[] = "entries";
+const char szNames[] = "names";
+const char szGeneration[] = "Generation";
+
+struct Record {  // an Entry as kept, the names are kept separately, nul separated, relative to the group
+  boost::uint8_t bSummarised;
+  boost::uint64_t nCount;
+  boost::posix_time::ptime dtFirst;
+  boost::posix_time::ptime dtLast;
+  double dblMinPrice;
+  double dblMaxPrice;
+  double dblClose;
+  boost::uint64_t nVolume;
+  double dblAverageVolume;
+  boost::uint32_t nDays;
+};
+
+H5::CompType* DefineRecordType( void ) {
+  H5::CompType* pComp = new H5::CompType( sizeof( Record ) );
+  pComp->insertMember( "Summarised",    HOFFSET( Record, bSummarised ),      H5::PredType::NATIVE_UINT8 );
+  pComp->insertMember( "Count",         HOFFSET( Record, nCount ),           H5::PredType::NATIVE_UINT64 );
+  pComp->insertMember( "First",         HOFFSET( Record, dtFirst ),          H5::PredType::NATIVE_LLONG );
+  pComp->insertMember( "Last",          HOFFSET( Record, dtLast ),           H5::PredType::NATIVE_LLONG );
+  pComp->insertMember( "MinPrice",      HOFFSET( Record, dblMinPrice ),      H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "MaxPrice",      HOFFSET( Record, dblMaxPrice ),      H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "Close",         HOFFSET( Record, dblClose ),         H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "Volume",        HOFFSET( Record, nVolume ),          H5::PredType::NATIVE_UINT64 );
+  pComp->insertMember( "AverageVolume", HOFFSET( Record, dblAverageVolume ), H5::PredType::NATIVE_DOUBLE );
+  pComp->insertMember( "Days",          HOFFSET( Record, nDays ),            H5::PredType::NATIVE_UINT32 );
+  return pComp;
+}
+
+boost::uint64_t ReadGeneration( H5::H5Object& object ) {
+  boost::uint64_t nGeneration( 0 );
+  if ( object.attrExists( szGeneration ) ) {
+    H5::Attribute attribute( object.openAttribute( szGeneration ) );
+    attribute.read( H5::PredType::NATIVE_UINT64, &nGeneration );
+    attribute.close();
+  }
+  return nGeneration;
+}
+
+void WriteGeneration( H5::H5Object& object, boost::uint64_t nGeneration ) {
+  if ( object.attrExists( szGeneration ) ) {
+    H5::Attribute attribute( object.openAttribute( szGeneration ) );
+    attribute.write( H5::PredType::NATIVE_UINT64, &nGeneration );
+    attribute.close();
+  }
+  else {
+    H5::DataSpace dspace;
+    H5::Attribute attribute( object.createAttribute( szGeneration, H5::PredType::NATIVE_UINT64, dspace ) );
+    attribute.write( H5::PredType::NATIVE_UINT64, &nGeneration );
+    attribute.close();
+  }
+}
+
+struct IterateNames {
+  std::vector<std::string> vName;
+  static herr_t Callback( hid_t, const char* name, void* op_data ) {
+    reinterpret_cast<IterateNames*>( op_data )->vName.push_back( name );
+    return 0;
+  }
+};
+
+} // namespace anonymous
+
+HDF5Catalog::HDF5Catalog( const std::string& sGroup ): m_sGroup( sGroup ) {
+  if ( m_sGroup.empty() || ( '/' != m_sGroup[ m_sGroup.size() - 1 ] ) ) m_sGroup.append( "/" );
+}
+
+void HDF5Catalog::Touch( HDF5DataManager& dm ) {
+  if ( dm.PathExists( szCatalog ) ) {  // nothing to mark till a copy has been kept
+    H5::Group group( dm.GetH5File()->openGroup( szCatalog ) );
+    WriteGeneration( group, ReadGeneration( group ) + 1 );
+    group.close();
+  }
+}
+
+bool HDF5Catalog::Load( HDF5DataManager& dm ) {
+  m_vEntry.clear();
+  const std::string sKept( szCatalog + m_sGroup );
+  bool bCurrent( false );
+  if ( dm.PathExists( sKept + szEntries ) ) {
+    H5::Group group( dm.GetH5File()->openGroup( szCatalog ) );
+    H5::DataSet dsEntries( dm.GetH5File()->openDataSet( sKept + szEntries ) );
+    if ( ReadGeneration( group ) == ReadGeneration( dsEntries ) ) {
+      H5::DataSet dsNames( dm.GetH5File()->openDataSet( sKept + szNames ) );
+      hsize_t nEntries( 0 );
+      hsize_t nNames( 0 );
+      dsEntries.getSpace().getSimpleExtentDims( &nEntries );
+      dsNames.getSpace().getSimpleExtentDims( &nNames );
+      std::vector<Record> vRecord( (size_t) nEntries );
+      std::vector<char> vNames( (size_t) nNames + 1, 0 );
+      if ( 0 != nEntries ) {
+        H5::CompType* pComp = DefineRecordType();
+        dsEntries.read( &vRecord[ 0 ], *pComp );
+        pComp->close();
+        delete pComp;
+        dsNames.read( &vNames[ 0 ], H5::PredType::NATIVE_CHAR );
+      }
+      dsNames.close();
+      m_vEntry.resize( (size_t) nEntries );
+      const char* pName( &vNames[ 0 ] );
+      for ( size_t ix = 0; ix < vRecord.size(); ++ix ) {
+        const Record& record( vRecord[ ix ] );
+        Entry& entry( m_vEntry[ ix ] );
+        entry.sPath = m_sGroup + pName;
+        pName += std::strlen( pName ) + 1;
+        entry.sName = entry.sPath.substr( entry.sPath.rfind( '/' ) + 1 );
+        entry.bSummarised = 0 != record.bSummarised;
+        entry.nCount = record.nCount;
+        entry.dtFirst = record.dtFirst;
+        entry.dtLast = record.dtLast;
+        entry.dblMinPrice = record.dblMinPrice;
+        entry.dblMaxPrice = record.dblMaxPrice;
+        entry.dblClose = record.dblClose;
+        entry.nVolume = record.nVolume;
+        entry.dblAverageVolume = record.dblAverageVolume;
+        entry.nDays = record.nDays;
+      }
+      bCurrent = true;
+    }
+    dsEntries.close();
+    group.close();
+  }
+  if ( !bCurrent ) {
+    Build( dm );
+  }
+  return bCurrent;
+}
+
+void HDF5Catalog::Build( HDF5DataManager& dm ) {
+  m_vEntry.clear();
+  BuildGroup( dm, m_sGroup );
+}
+
+void HDF5Catalog::BuildGroup( HDF5DataManager& dm, const std::string& sGroup ) {
+  IterateNames names;
+  int idx = 0;  // starting location for interrupted queries
+  dm.GetH5File()->iterateElems( sGroup, &idx, &IterateNames::Callback, &names );
+  for ( std::vector<std::string>::const_iterator iter = names.vName.begin(); names.vName.end() != iter; ++iter ) {
+    const std::string sObjectPath( sGroup + *iter );
+    try {
+      H5G_stat_t stats;
+      dm.GetH5File()->getObjinfo( sObjectPath, stats );
+      switch ( stats.type ) {
+        case H5G_DATASET: {
+            Entry entry;
+            entry.sPath = sObjectPath;
+            entry.sName = *iter;
+            hsize_t nSize( 0 );
+            H5::DataSet dataset( dm.GetH5File()->openDataSet( sObjectPath ) );
+            dataset.getSpace().getSimpleExtentDims( &nSize );
+            dataset.close();
+            HDF5Attributes::structSummary summary;
+            HDF5Attributes attributes( dm, sObjectPath );
+            if ( attributes.GetSummary( &summary ) && ( nSize == summary.nCount ) ) {
+              entry.bSummarised = true;
+              entry.nCount = summary.nCount;
+              entry.dtFirst = summary.dtFirst;
+              entry.dtLast = summary.dtLast;
+              entry.dblMinPrice = summary.dblMinPrice;
+              entry.dblMaxPrice = summary.dblMaxPrice;
+              entry.dblClose = summary.dblClose;
+              entry.nVolume = summary.nVolume;
+              entry.dblAverageVolume = summary.dblAverageVolume;
+              entry.nDays = summary.nDays;
+            }
+            m_vEntry.push_back( entry );
+          }
+          break;
+        case H5G_GROUP:
+          BuildGroup( dm, sObjectPath + "/" );
+          break;
+        default:
+          break;
+      }
+    }
+    catch ( H5::Exception& e ) {
+      std::cout << "HDF5Catalog::Build " << sObjectPath << " H5::Exception " << e.getDetailMsg() << std::endl;
+    }
+  }
+}
+
+void HDF5Catalog::Save( HDF5DataManager& dm ) {
+  const std::string sKept( szCatalog + m_sGroup );
+  dm.AddGroup( sKept );
+  H5::Group group( dm.GetH5File()->openGroup( szCatalog ) );
+  const boost::uint64_t nGeneration( ReadGeneration( group ) );
+  WriteGeneration( group, nGeneration );  // in case this is the first copy
+  group.close();
+
+  std::vector<Record> vRecord( m_vEntry.size() );
+  std::string sNames;
+  for ( size_t ix = 0; ix < m_vEntry.size(); ++ix ) {
+    const Entry& entry( m_vEntry[ ix ] );
+    Record& record( vRecord[ ix ] );
+    record.bSummarised = entry.bSummarised ? 1 : 0;
+    record.nCount = entry.nCount;
+    record.dtFirst = entry.dtFirst;
+    record.dtLast = entry.dtLast;
+    record.dblMinPrice = entry.dblMinPrice;
+    record.dblMaxPrice = entry.dblMaxPrice;
+    record.dblClose = entry.dblClose;
+    record.nVolume = entry.nVolume;
+    record.dblAverageVolume = entry.dblAverageVolume;
+    record.nDays = entry.nDays;
+    sNames.append( entry.sPath.substr( m_sGroup.size() ) );
+    sNames.push_back( '\0' );
+  }
+
+  // replaced whole, the catalog is small
+  if ( dm.PathExists( sKept + szEntries ) ) dm.GetH5File()->unlink( sKept + szEntries );
+  if ( dm.PathExists( sKept + szNames ) ) dm.GetH5File()->unlink( sKept + szNames );
+
+  H5::CompType* pComp = DefineRecordType();
+  hsize_t nEntries( vRecord.size() );
+  H5::DataSpace dspaceEntries( 1, &nEntries );
+  H5::DataSet dsEntries( dm.GetH5File()->createDataSet( sKept + szEntries, *pComp, dspaceEntries ) );
+  if ( 0 != nEntries ) dsEntries.write( &vRecord[ 0 ], *pComp );
+  WriteGeneration( dsEntries, nGeneration );
+  dsEntries.close();
+  dspaceEntries.close();
+  pComp->close();
+  delete pComp;
+
+  hsize_t nNames( sNames.size() );
+  H5::DataSpace dspaceNames( 1, &nNames );
+  H5::DataSet dsNames( dm.GetH5File()->createDataSet( sKept + szNames, H5::PredType::NATIVE_CHAR, dspaceNames ) );
+  if ( 0 != nNames ) dsNames.write( sNames.data(), H5::PredType::NATIVE_CHAR );
+  dsNames.close();
+  dspaceNames.close();
+}
+
+} // namespace tf
+} // namespace ou
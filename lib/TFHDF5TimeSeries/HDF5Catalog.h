@@ -0,0 +1,89 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// one compact in memory list of the dataset summaries (see HDF5Summary.h) under a group, eg /bar/86400/,
+//   so a scanner can pre-filter on count, date range, prices and volume, and open only the datasets which survive
+// Load reads the copy kept by Save, two reads, when no summarised write has happened since the copy was saved,
+//   otherwise it builds from the dataset attributes, which opens each dataset for its summary but reads none of its data
+// the copy is kept under /catalog + group, the /catalog group carries a generation which each summarised write bumps (Touch)
+// entries are in the order the group iterates, depth first
+//   one without a summary, or whose summary count differs from the dataset's size (added to by other means),
+//   has bSummarised false: a scanner treats it as a survivor and opens it
+// How to Use:
+/*
+  ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
+  ou::tf::HDF5Catalog catalog( "/bar/86400/" );
+  catalog.Load( dm );
+  for ( ou::tf::HDF5Catalog::vEntry_t::const_iterator iter = catalog.Entries().begin(); catalog.Entries().end() != iter; ++iter ) {
+    if ( !iter->bSummarised || ( 1000000 < iter->dblAverageVolume ) ) ProcessGroupItem( iter->sPath, iter->sName );
+  }
+*/
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "HDF5DataManager.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class HDF5Catalog {
+public:
+
+  struct Entry {
+    std::string sPath;  // of the dataset
+    std::string sName;  // last part of the path, the symbol for bars
+    bool bSummarised;
+    boost::uint64_t nCount;
+    boost::posix_time::ptime dtFirst;
+    boost::posix_time::ptime dtLast;
+    double dblMinPrice;
+    double dblMaxPrice;
+    double dblClose;
+    boost::uint64_t nVolume;
+    double dblAverageVolume;  // per day over the trailing days
+    boost::uint32_t nDays;  // trailing days, at most HDF5Attributes::structSummary::nTrailingDays
+    Entry( void ) : bSummarised( false ), nCount( 0 ), dblMinPrice( 0 ), dblMaxPrice( 0 ), dblClose( 0 ), nVolume( 0 ), dblAverageVolume( 0 ), nDays( 0 ) {};
+    double TrailingVolume( void ) const { return dblAverageVolume * nDays; };
+  };
+  typedef std::vector<Entry> vEntry_t;
+
+  explicit HDF5Catalog( const std::string& sGroup );
+
+  bool Load( HDF5DataManager& dm );  // true when the kept copy was current, false when built
+  void Build( HDF5DataManager& dm );
+  void Save( HDF5DataManager& dm );  // dm needs to be read/write, straight after Load or Build so the copy is current
+
+  const std::string& GetGroup( void ) const { return m_sGroup; };
+  const vEntry_t& Entries( void ) const { return m_vEntry; };
+
+  static void Touch( HDF5DataManager& dm );  // marks kept copies as out of date, by HDF5WriteTimeSeries::Write
+
+protected:
+private:
+
+  std::string m_sGroup;  // with trailing /
+  vEntry_t m_vEntry;
+
+  void BuildGroup( HDF5DataManager& dm, const std::string& sGroup );
+
+};
+
+} // namespace tf
+} // namespace ou
@@ -14,16 +14,44 @@
 
 //#include "StdAfx.h"
 
+#include <vector>
 #include <iostream>
 #include <stdexcept>
 
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "HDF5Filter.h"
 #include "HDF5DataManager.h"
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
 
+namespace {
+
+struct TransferBuffers {
+  static const size_t nBytes = 64 * 1024;  // each, as quick as hdf5's 1MB on large reads, conversions go through in pieces this size
+  H5::DSetMemXferPropList pl;
+  std::vector<char> vConvert;
+  std::vector<char> vBackground;
+  TransferBuffers( void ): vConvert( nBytes ), vBackground( nBytes ) {
+    pl.setBuffer( nBytes, &vConvert[ 0 ], &vBackground[ 0 ] );
+    pl.setPreserve( true );  // memory between members, eg the vtable pointer of a datum, is left as is
+  }
+  ~TransferBuffers( void ) {  // as a thread ends, while others may be in hdf5
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    pl.close();
+  }
+};
+
+// not deleted: the main thread's buffers are kept till the process ends, after hdf5 may have closed
+boost::thread_specific_ptr<TransferBuffers>* const pTransferBuffers( new boost::thread_specific_ptr<TransferBuffers> );
+
+} // namespace anonymous
+
 //const char HDF5DataManager::m_H5FileName[] = "TradeFrame.%03d.hdf5";
 const char HDF5DataManager::m_H5FileName[] = "TradeFrame.hdf5";
+HDF5DataManager::mutex_t HDF5DataManager::m_mutexHDF5;
 //H5::H5File HDF5DataManager::m_H5File;
 //unsigned int HDF5DataManager::m_RefCount = 0;
 
@@ -31,7 +59,16 @@ const char HDF5DataManager::m_H5FileName[] = "TradeFrame.hdf5";
 //  (2012/08/12: why?) because code is inefficient.  file is open/closed repeatedly.,  need to be able to pass a handle for operations.
 //  needs a good rethink and re-architect for file handle handling
 
-HDF5DataManager::HDF5DataManager( enumFileOptionType fot ) {
+HDF5DataManager::HDF5DataManager( enumFileOptionType fot ): m_sFileName( m_H5FileName ) {
+  Open( fot );
+}
+
+HDF5DataManager::HDF5DataManager( enumFileOptionType fot, const std::string& sFileName ): m_sFileName( sFileName ) {
+  Open( fot );
+}
+
+void HDF5DataManager::Open( enumFileOptionType fot ) {
+  HDF5Filter::Register();  // for datasets written through it
 //  ++m_RefCount;
 //  if ( 1 == m_RefCount ) {
     //std::cout << "Opening DataManager" << std::endl;
@@ -45,17 +82,17 @@ HDF5DataManager::HDF5DataManager( enumFileOptionType fot ) {
         // try for existing file
         switch ( fot ) {
         case RO:
-          m_H5File.openFile( m_H5FileName, H5F_ACC_RDONLY, pl2 );
+          m_H5File.openFile( m_sFileName, H5F_ACC_RDONLY, pl2 );
           break;
         case RDWR:
-          m_H5File.openFile( m_H5FileName, H5F_ACC_RDWR, pl2 );
+          m_H5File.openFile( m_sFileName, H5F_ACC_RDWR, pl2 );
           break;
         }
         
       }
       catch (...) {
         // try to create and open if it doesn't exist
-        m_H5File.openFile( m_H5FileName, H5F_ACC_CREAT | H5F_ACC_RDWR, pl2 );
+        m_H5File.openFile( m_sFileName, H5F_ACC_CREAT | H5F_ACC_RDWR, pl2 );
         H5::Group g1( GetH5File()->createGroup( "/bar" ) );
         g1.close();
         H5::Group g2( GetH5File()->createGroup( "/bar/86400" ) );
@@ -83,6 +120,11 @@ HDF5DataManager::~HDF5DataManager(void) {
 //  }
 }
 
+H5::DSetMemXferPropList& HDF5DataManager::Transfer( void ) {
+  if ( 0 == pTransferBuffers->get() ) pTransferBuffers->reset( new TransferBuffers );
+  return pTransferBuffers->get()->pl;
+}
+
 void HDF5DataManager::Flush( void ) {
   GetH5File()->flush( H5F_SCOPE_GLOBAL );
 }
@@ -103,6 +145,18 @@ bool HDF5DataManager::GroupExists( const std::string &sGroup ) {
   return bGroupExists;
 }
 
+bool HDF5DataManager::PathExists( const std::string& sPath ) {
+  // H5Lexists, a part at a time, as a missing intermediate group is an error rather than false
+  std::string::size_type ix = sPath.find( '/', 1 );
+  while ( true ) {
+    const std::string sPart( sPath.substr( 0, ix ) );
+    if ( 0 >= H5Lexists( GetH5File()->getId(), sPart.c_str(), H5P_DEFAULT ) ) return false;
+    if ( ( std::string::npos == ix ) || ( sPath.size() == ix + 1 ) ) break;
+    ix = sPath.find( '/', ix + 1 );
+  }
+  return true;
+}
+
 void HDF5DataManager::IteratePathParts( const std::string& sPath, callbackIteratePath_t object ) {
   // path needs to be an established, proven path, something already generated by the path search mechanism
   //  /symbol, /symbol/G, /symbol/G/O, /symbol/G/O/GOOG
@@ -162,7 +216,11 @@ herr_t HDF5DataManager::PrintH5ErrorStackItem( int n, H5E_error_t *err_desc, voi
 }
 
 void HDF5DataManager::DailyBarPath(const std::string &sSymbol, std::string &sPath) {
-  sPath = "/bar/86400/";
+  BarPath( "/bar/", 86400, sSymbol, sPath );
+}
+
+void HDF5DataManager::BarPath( const std::string& sRoot, unsigned int nSeconds, const std::string& sSymbol, std::string& sPath ) {
+  sPath = sRoot + boost::lexical_cast<std::string>( nSeconds ) + "/";
   sPath.append( sSymbol.substr( 0, 1 ) );
   sPath.append( "/" );
   sPath.append( sSymbol.substr( sSymbol.length() == 1 ? 0 : 1, 1 ) );
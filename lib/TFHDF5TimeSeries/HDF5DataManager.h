@@ -17,7 +17,11 @@
 // changed to lower case 2015/02/08
 #include <hdf5/H5Cpp.h>
 
+#include <string>
+
 #include <boost/function.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/recursive_mutex.hpp>
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
@@ -26,17 +30,32 @@ class HDF5DataManager {
 public:
   enum enumFileOptionType{ RDWR, RO };
   HDF5DataManager( enumFileOptionType );
+  HDF5DataManager( enumFileOptionType, const std::string& sFileName );  // a file other than TradeFrame.hdf5, eg a partition, see HDF5Partitions
   ~HDF5DataManager(void);
+  const std::string& GetFileName( void ) const { return m_sFileName; };
   H5::H5File *GetH5File( void ) { return &m_H5File; };
   bool GroupExists( const std::string &sGroup );
+  bool PathExists( const std::string& sPath );  // group or dataset, without the error stack a failed open prints
   void AddGroup( const std::string &sGroupPath );  // last group needs trailing '/'
   void AddGroupForSymbol( const std::string &sSymbol );
   static herr_t PrintH5ErrorStackItem( int n, H5E_error_t *err_desc, void *client_data );
 //  static hsize_t H5ChunkSize( void ) { return 1024; };  // # elements to be shuffled/compressed in one block,  was 64
 //  static hsize_t H5ChunkSize( void ) { return 32; };  // # elements to be shuffled/compressed in one block,  was 64
   static void DailyBarPath( const std::string &sSymbol, std::string &sPath );
+  static void BarPath( const std::string& sRoot, unsigned int nSeconds, const std::string& sSymbol, std::string& sPath );  // sRoot with trailing '/', eg /bar/
   void Flush( void );
 
+  // this thread's transfer properties for dataset reads and writes, type conversion buffers kept from call to call
+  //   rather than the 1MB hdf5 otherwise sets up on each call, which costs more than a small read itself
+  static H5::DSetMemXferPropList& Transfer( void );
+
+  // the process' one lock on hdf5, the library may be built without thread safety (see hdf5 build.txt),
+  //   so code calling hdf5 from threads of its own, or while such threads run, holds it around its calls,
+  //   and around the lifetimes of its H5 objects and data managers, their destructors call into hdf5 as well
+  typedef boost::recursive_mutex mutex_t;
+  typedef boost::unique_lock<mutex_t> lock_t;
+  static mutex_t& Mutex( void ) { return m_mutexHDF5; };
+
   typedef boost::function<void (const std::string& )> callbackIteratePath_t;
   void IteratePathParts( const std::string& sPath, callbackIteratePath_t object );
 protected:
@@ -45,6 +64,9 @@ protected:
 //  static H5::H5File m_H5File;
   H5::H5File m_H5File;
 private:
+  static mutex_t m_mutexHDF5;
+  std::string m_sFileName;
+  void Open( enumFileOptionType );
 };
 
 } // namespace tf
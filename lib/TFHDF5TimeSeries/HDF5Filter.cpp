@@ -0,0 +1,478 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+//#include "StdAfx.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#include <zlib.h>
+
+#include "HDF5Filter.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+namespace {
+
+// client data: codec, level, datum bytes, members, then offset, bytes, kind for each member
+enum EKind { KindRaw = 0, KindTime, KindPrice };
+const size_t nClientFixed = 4;
+
+// chunk: version, codec, two spare, datums (little endian), a mode for each member, then the compressed columns
+const unsigned char nVersion = 1;
+const size_t nChunkHeader = 8;
+enum EMode { ModeRaw = 0, ModeDelta = 1, ModeTicks = 0x10 };  // ModeTicks + the power of ten
+const int nMaxPower = 8;
+const double rPower[ nMaxPower + 1 ] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8 };
+
+const size_t nTargetChunkBytes = 128 * 1024;  // within hdf5's default 1MB chunk cache with room to spare
+const hsize_t nMinChunk = 256;
+const hsize_t nMaxChunk = 16384;
+
+inline boost::uint64_t ZigZag( boost::uint64_t n ) { return ( n << 1 ) ^ (boost::uint64_t) ( (boost::int64_t) n >> 63 ); };
+inline boost::uint64_t UnZigZag( boost::uint64_t n ) { return ( n >> 1 ) ^ ( ~( n & 1 ) + 1 ); };
+
+inline boost::uint32_t Read32( const unsigned char* p ) { boost::uint32_t n; std::memcpy( &n, p, sizeof( n ) ); return n; };
+
+// byte b of each value in a column goes to plane b of the column, planes are n bytes apart
+//   values are little endian, as hdf5's native types are here
+template<size_t W> inline void Scatter( boost::uint64_t value, unsigned char* p, size_t n ) {
+  for ( size_t b = 0; b < W; ++b ) p[ b * n ] = (unsigned char) ( value >> ( 8 * b ) );
+}
+
+template<size_t W> inline boost::uint64_t Gather( const unsigned char* p, size_t n ) {
+  boost::uint64_t value( 0 );
+  for ( size_t b = 0; b < W; ++b ) value |= (boost::uint64_t) p[ b * n ] << ( 8 * b );
+  return value;
+}
+
+template<size_t W> void PutRaw( const unsigned char* pIn, size_t nDatumBytes, size_t n, unsigned char* pColumn ) {
+  for ( size_t ix = 0; ix < n; ++ix, pIn += nDatumBytes ) {
+    boost::uint64_t value( 0 );
+    std::memcpy( &value, pIn, W );
+    Scatter<W>( value, pColumn + ix, n );
+  }
+}
+
+template<size_t W> void GetRaw( const unsigned char* pColumn, size_t n, unsigned char* pOut, size_t nDatumBytes ) {
+  for ( size_t ix = 0; ix < n; ++ix, pOut += nDatumBytes ) {
+    const boost::uint64_t value( Gather<W>( pColumn + ix, n ) );
+    std::memcpy( pOut, &value, W );
+  }
+}
+
+void PutRaw( const unsigned char* pIn, size_t nDatumBytes, size_t nBytes, size_t n, unsigned char* pColumn ) {
+  switch ( nBytes ) {
+    case 1: PutRaw<1>( pIn, nDatumBytes, n, pColumn ); break;
+    case 2: PutRaw<2>( pIn, nDatumBytes, n, pColumn ); break;
+    case 4: PutRaw<4>( pIn, nDatumBytes, n, pColumn ); break;
+    case 8: PutRaw<8>( pIn, nDatumBytes, n, pColumn ); break;
+    default:
+      for ( size_t b = 0; b < nBytes; ++b ) {
+        unsigned char* pPlane( pColumn + b * n );
+        const unsigned char* p( pIn + b );
+        for ( size_t ix = 0; ix < n; ++ix, p += nDatumBytes ) pPlane[ ix ] = *p;
+      }
+  }
+}
+
+void GetRaw( const unsigned char* pColumn, size_t nBytes, size_t n, unsigned char* pOut, size_t nDatumBytes ) {
+  switch ( nBytes ) {
+    case 1: GetRaw<1>( pColumn, n, pOut, nDatumBytes ); break;
+    case 2: GetRaw<2>( pColumn, n, pOut, nDatumBytes ); break;
+    case 4: GetRaw<4>( pColumn, n, pOut, nDatumBytes ); break;
+    case 8: GetRaw<8>( pColumn, n, pOut, nDatumBytes ); break;
+    default:
+      for ( size_t b = 0; b < nBytes; ++b ) {
+        const unsigned char* pPlane( pColumn + b * n );
+        unsigned char* p( pOut + b );
+        for ( size_t ix = 0; ix < n; ++ix, p += nDatumBytes ) *p = pPlane[ ix ];
+      }
+  }
+}
+
+// times as the change in their differences
+void PutTime( const unsigned char* pIn, size_t nDatumBytes, size_t n, unsigned char* pColumn ) {
+  boost::uint64_t prior( 0 );
+  boost::uint64_t priorDelta( 0 );
+  for ( size_t ix = 0; ix < n; ++ix, pIn += nDatumBytes ) {
+    boost::uint64_t value;
+    std::memcpy( &value, pIn, 8 );
+    const boost::uint64_t delta( value - prior );
+    Scatter<8>( ZigZag( delta - priorDelta ), pColumn + ix, n );
+    prior = value;
+    priorDelta = delta;
+  }
+}
+
+void GetTime( const unsigned char* pColumn, size_t n, unsigned char* pOut, size_t nDatumBytes ) {
+  boost::uint64_t prior( 0 );
+  boost::uint64_t priorDelta( 0 );
+  for ( size_t ix = 0; ix < n; ++ix, pOut += nDatumBytes ) {
+    priorDelta += UnZigZag( Gather<8>( pColumn + ix, n ) );
+    prior += priorDelta;
+    std::memcpy( pOut, &prior, 8 );
+  }
+}
+
+// ticks as their differences
+void PutTicks( const boost::uint64_t* pTicks, size_t n, unsigned char* pColumn ) {
+  boost::uint64_t prior( 0 );
+  for ( size_t ix = 0; ix < n; ++ix ) {
+    Scatter<8>( ZigZag( pTicks[ ix ] - prior ), pColumn + ix, n );
+    prior = pTicks[ ix ];
+  }
+}
+
+void GetTicks( const unsigned char* pColumn, size_t n, double scale, unsigned char* pOut, size_t nDatumBytes ) {
+  boost::uint64_t prior( 0 );
+  for ( size_t ix = 0; ix < n; ++ix, pOut += nDatumBytes ) {
+    prior += UnZigZag( Gather<8>( pColumn + ix, n ) );
+    const double value( (double) (boost::int64_t) prior / scale );  // as Ticks checked
+    std::memcpy( pOut, &value, 8 );
+  }
+}
+
+// the smallest power of ten at which each price is a whole number of ticks, reproduced exactly on the way back
+int Ticks( const unsigned char* pDatum, size_t nDatumBytes, size_t offset, size_t n, boost::uint64_t* pTicks ) {
+  for ( int e = 0; e <= nMaxPower; ++e ) {
+    const double scale( rPower[ e ] );
+    const double limit( 9e15 / scale );  // whole numbers held exactly in a double
+    bool bOk( true );
+    const unsigned char* p( pDatum + offset );
+    for ( size_t ix = 0; bOk && ( ix < n ); ++ix, p += nDatumBytes ) {
+      double value;
+      std::memcpy( &value, p, sizeof( value ) );
+      if ( !( std::fabs( value ) < limit ) ) return -1;  // nan, inf, or too big at any scale
+      const boost::int64_t k( std::llround( value * scale ) );
+      const double back( (double) k / scale );
+      bOk = 0 == std::memcmp( &back, &value, sizeof( value ) );  // bit for bit, -0.0 included
+      pTicks[ ix ] = (boost::uint64_t) k;
+    }
+    if ( bOk ) return e;
+  }
+  return -1;
+}
+
+} // namespace anonymous
+
+void HDF5Filter::Register( void ) {
+  if ( 0 < H5Zfilter_avail( nFilter ) ) return;
+  const H5Z_class2_t filter = {
+    H5Z_CLASS_T_VERS, nFilter, 1, 1, "ou::tf::HDF5Filter", NULL, NULL, &HDF5Filter::Filter
+  };
+  H5Zregister( &filter );
+}
+
+void HDF5Filter::Set( H5::DSetCreatPropList& pl, const H5::CompType& type, ECodec codec, int nLevel ) {
+  Register();
+  const int nMembers( type.getNmembers() );
+  std::vector<unsigned int> vClient;
+  vClient.push_back( codec );
+  vClient.push_back( nLevel );
+  vClient.push_back( (unsigned int) type.getSize() );
+  vClient.push_back( nMembers );
+  for ( int ix = 0; ix < nMembers; ++ix ) {
+    H5::DataType typeMember( type.getMemberDataType( ix ) );
+    const size_t nBytes( typeMember.getSize() );
+    const H5T_class_t classMember( type.getMemberClass( ix ) );
+    EKind kind( KindRaw );
+    if ( ( 8 == nBytes ) && ( H5T_INTEGER == classMember ) && ( "DateTime" == type.getMemberName( ix ) ) ) kind = KindTime;
+    if ( ( 8 == nBytes ) && ( H5T_FLOAT == classMember ) ) kind = KindPrice;
+    vClient.push_back( (unsigned int) type.getMemberOffset( ix ) );
+    vClient.push_back( (unsigned int) nBytes );
+    vClient.push_back( kind );
+    typeMember.close();
+  }
+  pl.setFilter( nFilter, H5Z_FLAG_OPTIONAL, vClient.size(), &vClient[ 0 ] );
+}
+
+hsize_t HDF5Filter::ChunkSize( size_t nDatumBytes ) {
+  hsize_t nChunk( nMinChunk );
+  while ( ( nChunk < nMaxChunk ) && ( 2 * nChunk * nDatumBytes <= nTargetChunkBytes ) ) nChunk *= 2;
+  return nChunk;
+}
+
+size_t HDF5Filter::Filter( unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[], size_t nbytes, size_t* buf_size, void** buf ) {
+
+  if ( nClientFixed > cd_nelmts ) return 0;
+  const unsigned int codec( cd_values[ 0 ] );
+  const int nLevel( cd_values[ 1 ] );
+  const size_t nDatumBytes( cd_values[ 2 ] );
+  const size_t nMembers( cd_values[ 3 ] );
+  if ( ( 0 == nDatumBytes ) || ( nClientFixed + 3 * nMembers > cd_nelmts ) ) return 0;
+  const unsigned int* pMember( cd_values + nClientFixed );
+  for ( size_t ixMember = 0; ixMember < nMembers; ++ixMember ) {
+    if ( pMember[ 3 * ixMember ] + pMember[ 3 * ixMember + 1 ] > nDatumBytes ) return 0;
+  }
+  const size_t nHeader( nChunkHeader + nMembers );
+
+  if ( 0 != ( flags & H5Z_FLAG_REVERSE ) ) {  // read
+
+    const unsigned char* pIn( static_cast<const unsigned char*>( *buf ) );
+    if ( ( nHeader > nbytes ) || ( nVersion != pIn[ 0 ] ) ) return 0;
+    const size_t n( Read32( pIn + 4 ) );
+    if ( 0 == n ) return 0;
+    const size_t nRaw( n * nDatumBytes );
+    size_t nColumns( 0 );
+    for ( size_t ixMember = 0; ixMember < nMembers; ++ixMember ) {  // a damaged chunk fails here, rather than being decoded out of bounds
+      const size_t nBytes( pMember[ 3 * ixMember + 1 ] );
+      const unsigned char mode( pIn[ nChunkHeader + ixMember ] );
+      const bool bTicks( ( ModeTicks <= mode ) && ( ModeTicks + nMaxPower >= mode ) );
+      if ( ( ModeRaw != mode ) && ( ( ( ModeDelta != mode ) && !bTicks ) || ( 8 != nBytes ) ) ) return 0;
+      nColumns += n * nBytes;
+    }
+    if ( nRaw != nColumns ) return 0;
+    std::vector<unsigned char> vColumns( nRaw );
+    bool bOk( false );
+    switch ( pIn[ 1 ] ) {
+      case LZ4:
+        bOk = LZ4Decompress( pIn + nHeader, nbytes - nHeader, vColumns.empty() ? 0 : &vColumns[ 0 ], nRaw );
+        break;
+      case Deflate: {
+          uLongf nOut( nRaw );
+          bOk = ( Z_OK == uncompress( vColumns.empty() ? 0 : &vColumns[ 0 ], &nOut, pIn + nHeader, nbytes - nHeader ) ) && ( nRaw == nOut );
+        }
+        break;
+    }
+    if ( !bOk ) return 0;
+
+    unsigned char* pOut( static_cast<unsigned char*>( H5allocate_memory( nRaw, false ) ) );
+    if ( 0 == pOut ) return 0;
+    size_t ixColumn( 0 );
+    for ( size_t ixMember = 0; ixMember < nMembers; ++ixMember ) {
+      const size_t offset( pMember[ 3 * ixMember ] );
+      const size_t nBytes( pMember[ 3 * ixMember + 1 ] );
+      const unsigned char* pColumn( &vColumns[ 0 ] + ixColumn );
+      const unsigned char mode( pIn[ nChunkHeader + ixMember ] );
+      if ( ModeRaw == mode ) GetRaw( pColumn, nBytes, n, pOut + offset, nDatumBytes );
+      else if ( ModeDelta == mode ) GetTime( pColumn, n, pOut + offset, nDatumBytes );
+      else GetTicks( pColumn, n, rPower[ mode - ModeTicks ], pOut + offset, nDatumBytes );  // checked above
+      ixColumn += n * nBytes;
+    }
+
+    H5free_memory( *buf );
+    *buf = pOut;
+    *buf_size = nRaw;
+    return nRaw;
+  }
+  else {  // write
+
+    const size_t n( nbytes / nDatumBytes );
+    if ( ( 0 == n ) || ( n * nDatumBytes != nbytes ) ) return 0;
+    const unsigned char* pIn( static_cast<const unsigned char*>( *buf ) );
+    std::vector<unsigned char> vColumns( nbytes );
+    std::vector<unsigned char> vMode( nMembers, ModeRaw );
+    std::vector<boost::uint64_t> vValue( n );
+    size_t ixColumn( 0 );
+    for ( size_t ixMember = 0; ixMember < nMembers; ++ixMember ) {
+      const size_t offset( pMember[ 3 * ixMember ] );
+      const size_t nBytes( pMember[ 3 * ixMember + 1 ] );
+      unsigned char* pColumn( &vColumns[ 0 ] + ixColumn );
+      switch ( pMember[ 3 * ixMember + 2 ] ) {
+        case KindTime:
+          PutTime( pIn + offset, nDatumBytes, n, pColumn );
+          vMode[ ixMember ] = ModeDelta;
+          break;
+        case KindPrice: {
+            const int e( Ticks( pIn, nDatumBytes, offset, n, &vValue[ 0 ] ) );
+            if ( 0 <= e ) {
+              PutTicks( &vValue[ 0 ], n, pColumn );
+              vMode[ ixMember ] = (unsigned char) ( ModeTicks + e );
+            }
+          }
+          break;
+      }
+      if ( ModeRaw == vMode[ ixMember ] ) PutRaw( pIn + offset, nDatumBytes, nBytes, n, pColumn );
+      ixColumn += n * nBytes;
+    }
+    if ( ixColumn != nbytes ) return 0;  // members don't cover the datum, padding say, the chunk is left as is
+
+    size_t nBound( 0 );
+    switch ( codec ) {
+      case LZ4: nBound = LZ4Bound( nbytes ); break;
+      case Deflate: nBound = compressBound( nbytes ); break;
+      default: return 0;
+    }
+    unsigned char* pOut( static_cast<unsigned char*>( H5allocate_memory( nHeader + nBound, false ) ) );
+    if ( 0 == pOut ) return 0;
+    pOut[ 0 ] = nVersion;
+    pOut[ 1 ] = (unsigned char) codec;
+    pOut[ 2 ] = pOut[ 3 ] = 0;
+    const boost::uint32_t nDatums( (boost::uint32_t) n );
+    std::memcpy( pOut + 4, &nDatums, sizeof( nDatums ) );
+    std::memcpy( pOut + nChunkHeader, &vMode[ 0 ], nMembers );
+    size_t nCompressed( 0 );
+    switch ( codec ) {
+      case LZ4:
+        nCompressed = LZ4Compress( &vColumns[ 0 ], nbytes, pOut + nHeader, nBound );
+        break;
+      case Deflate: {
+          uLongf nOut( nBound );
+          if ( Z_OK == compress2( pOut + nHeader, &nOut, &vColumns[ 0 ], nbytes, ( 0 == nLevel ) ? Z_DEFAULT_COMPRESSION : nLevel ) ) nCompressed = nOut;
+        }
+        break;
+    }
+    if ( ( 0 == nCompressed ) || ( nHeader + nCompressed >= nbytes ) ) {  // kept as is
+      H5free_memory( pOut );
+      return 0;
+    }
+
+    H5free_memory( *buf );
+    *buf = pOut;
+    *buf_size = nHeader + nBound;
+    return nHeader + nCompressed;
+  }
+}
+
+// the lz4 block format: sequences of a token (literal count, match length - 4), literals, a two byte offset back to the match
+//   the last five bytes are literals, and a match starts at least twelve bytes from the end
+
+namespace {
+
+const size_t nMinMatch = 4;
+const size_t nLastLiterals = 5;
+const size_t nMatchLimit = 12;
+const size_t nMaxOffset = 65535;
+const unsigned int nHashLog = 14;
+
+inline unsigned int Hash( boost::uint32_t sequence ) { return ( sequence * 2654435761U ) >> ( 32 - nHashLog ); };
+
+inline unsigned char* Length( unsigned char* pDst, size_t n ) {  // past the token's 15
+  while ( 255 <= n ) {
+    *pDst++ = 255;
+    n -= 255;
+  }
+  *pDst++ = (unsigned char) n;
+  return pDst;
+}
+
+} // namespace anonymous
+
+size_t HDF5Filter::LZ4Compress( const unsigned char* pSrc, size_t nSrc, unsigned char* pDst, size_t nDst ) {
+  std::vector<boost::uint32_t> vTable( 1 << nHashLog, 0 );
+  unsigned char* pOut( pDst );
+  unsigned char* const pOutEnd( pDst + nDst );
+  size_t ixAnchor( 0 );
+  size_t ix( 0 );
+  if ( nSrc > nMatchLimit ) {
+    const size_t ixLimit( nSrc - nMatchLimit );
+    const size_t ixMatchEnd( nSrc - nLastLiterals );
+    size_t nMisses( 0 );
+    while ( ix < ixLimit ) {
+      const boost::uint32_t sequence( Read32( pSrc + ix ) );
+      boost::uint32_t& entry( vTable[ Hash( sequence ) ] );
+      const size_t ixRef( entry );
+      entry = (boost::uint32_t) ix;
+      if ( ( ixRef < ix ) && ( ix - ixRef <= nMaxOffset ) && ( Read32( pSrc + ixRef ) == sequence ) ) {
+        size_t nMatch( nMinMatch );
+        while ( ( ix + nMatch < ixMatchEnd ) && ( pSrc[ ixRef + nMatch ] == pSrc[ ix + nMatch ] ) ) ++nMatch;
+        const size_t nLiterals( ix - ixAnchor );
+        if ( (size_t) ( pOutEnd - pOut ) < 1 + nLiterals / 255 + 1 + nLiterals + 2 + nMatch / 255 + 1 ) return 0;
+        unsigned char* pToken( pOut++ );
+        *pToken = (unsigned char) ( ( ( 15 <= nLiterals ) ? 15 : nLiterals ) << 4 );
+        if ( 15 <= nLiterals ) pOut = Length( pOut, nLiterals - 15 );
+        std::memcpy( pOut, pSrc + ixAnchor, nLiterals );
+        pOut += nLiterals;
+        const size_t offset( ix - ixRef );
+        *pOut++ = (unsigned char) offset;
+        *pOut++ = (unsigned char) ( offset >> 8 );
+        const size_t nExtra( nMatch - nMinMatch );
+        *pToken |= (unsigned char) ( ( 15 <= nExtra ) ? 15 : nExtra );
+        if ( 15 <= nExtra ) pOut = Length( pOut, nExtra - 15 );
+        ix += nMatch;
+        ixAnchor = ix;
+        if ( ix < ixLimit ) vTable[ Hash( Read32( pSrc + ix - 2 ) ) ] = (boost::uint32_t) ( ix - 2 );
+        nMisses = 0;
+      }
+      else {
+        ix += 1 + ( nMisses++ >> 6 );  // skip faster through what doesn't compress
+      }
+    }
+  }
+  const size_t nLiterals( nSrc - ixAnchor );
+  if ( (size_t) ( pOutEnd - pOut ) < 1 + nLiterals / 255 + 1 + nLiterals ) return 0;
+  unsigned char* pToken( pOut++ );
+  *pToken = (unsigned char) ( ( ( 15 <= nLiterals ) ? 15 : nLiterals ) << 4 );
+  if ( 15 <= nLiterals ) pOut = Length( pOut, nLiterals - 15 );
+  std::memcpy( pOut, pSrc + ixAnchor, nLiterals );
+  pOut += nLiterals;
+  return pOut - pDst;
+}
+
+bool HDF5Filter::LZ4Decompress( const unsigned char* pSrc, size_t nSrc, unsigned char* pDst, size_t nDst ) {
+  const unsigned char* pIn( pSrc );
+  const unsigned char* const pInEnd( pSrc + nSrc );
+  unsigned char* pOut( pDst );
+  unsigned char* const pOutEnd( pDst + nDst );
+  while ( pIn < pInEnd ) {
+    const unsigned int token( *pIn++ );
+    size_t nLiterals( token >> 4 );
+    if ( 15 == nLiterals ) {
+      unsigned int b;
+      do {
+        if ( pIn >= pInEnd ) return false;
+        b = *pIn++;
+        nLiterals += b;
+      } while ( 255 == b );
+    }
+    if ( ( (size_t) ( pInEnd - pIn ) < nLiterals ) || ( (size_t) ( pOutEnd - pOut ) < nLiterals ) ) return false;
+    std::memcpy( pOut, pIn, nLiterals );
+    pIn += nLiterals;
+    pOut += nLiterals;
+    if ( pIn == pInEnd ) break;  // the last literals
+    if ( 2 > pInEnd - pIn ) return false;
+    const size_t offset( pIn[ 0 ] | ( pIn[ 1 ] << 8 ) );
+    pIn += 2;
+    if ( ( 0 == offset ) || ( (size_t) ( pOut - pDst ) < offset ) ) return false;
+    size_t nMatch( token & 15 );
+    if ( 15 == nMatch ) {
+      unsigned int b;
+      do {
+        if ( pIn >= pInEnd ) return false;
+        b = *pIn++;
+        nMatch += b;
+      } while ( 255 == b );
+    }
+    nMatch += nMinMatch;
+    if ( (size_t) ( pOutEnd - pOut ) < nMatch ) return false;
+    if ( offset >= nMatch ) {
+      std::memcpy( pOut, pOut - offset, nMatch );
+      pOut += nMatch;
+    }
+    else if ( 1 == offset ) {  // a run of one byte, zeros from the upper bytes of the shuffled columns mostly
+      std::memset( pOut, pOut[ -1 ], nMatch );
+      pOut += nMatch;
+    }
+    else {  // overlapping: the pattern repeats every offset bytes, so copy whole repeats, doubling as they become available
+      size_t nPeriod( offset );
+      while ( 0 < nMatch ) {
+        const size_t n( ( nPeriod < nMatch ) ? nPeriod : nMatch );
+        std::memcpy( pOut, pOut - nPeriod, n );
+        pOut += n;
+        nMatch -= n;
+        nPeriod *= 2;
+      }
+    }
+  }
+  return pOut == pOutEnd;
+}
+
+} // namespace tf
+} // namespace ou
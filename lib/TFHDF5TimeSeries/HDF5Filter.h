@@ -0,0 +1,64 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// an hdf5 filter for time series chunks, in place of shuffle + deflate, see HDF5WriteTimeSeries
+// each chunk is split into its compound members, one column each, and each column is transformed:
+//   DateTime: delta of delta, zig zag, so a steady tick rate becomes mostly zeros
+//   doubles: as integer ticks when every value in the chunk is exactly k / 10^e for the smallest such e (0 to 8), then delta, zig zag,
+//     otherwise left as is (greeks, say), checked bit for bit so a read gives back exactly what was written
+//   others: left as is
+// the columns are byte shuffled by their width, then compressed:
+//   LZ4: the lz4 block format, implemented here so there is nothing further to link, fast to decompress
+//   Deflate: zlib, smaller, slower
+// a chunk which doesn't get smaller is kept as is (the filter is optional)
+// the member layout goes with the dataset as the filter's client data, so the filter needs nothing else on reading
+// the filter id is from hdf5's range for unregistered filters: the filter needs to be registered (Register)
+//   before a dataset using it is read, HDF5DataManager does so on opening a file; h5dump and the like can't read these datasets
+// How to Use:
+/*
+  ou::tf::HDF5WriteTimeSeries<ou::tf::Quotes> wtsQuotes( dm, ou::tf::HDF5Filter::LZ4 );  // chunk size from the datum size
+  wtsQuotes.Write( sPathName, &quotes );
+*/
+
+#include <hdf5/H5Cpp.h>
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class HDF5Filter {
+public:
+
+  enum ECodec { None = 0, LZ4, Deflate };
+
+  static const H5Z_filter_t nFilter = 311;
+
+  static void Register( void );  // once per process is enough, more is harmless
+  static void Set( H5::DSetCreatPropList& pl, const H5::CompType& type, ECodec codec, int nLevel = 0 );  // type packed, as on disk
+  static hsize_t ChunkSize( size_t nDatumBytes );  // datums to a chunk
+
+protected:
+private:
+
+  static size_t Filter( unsigned int flags, size_t cd_nelmts, const unsigned int cd_values[], size_t nbytes, size_t* buf_size, void** buf );
+
+  static size_t LZ4Bound( size_t n ) { return n + n / 255 + 16; };
+  static size_t LZ4Compress( const unsigned char* pSrc, size_t nSrc, unsigned char* pDst, size_t nDst );  // 0 when it doesn't fit
+  static bool LZ4Decompress( const unsigned char* pSrc, size_t nSrc, unsigned char* pDst, size_t nDst );  // exactly nDst
+
+};
+
+} // namespace tf
+} // namespace ou
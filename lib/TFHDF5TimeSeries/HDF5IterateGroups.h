@@ -44,7 +44,7 @@ public:
 
   typedef FastDelegate2<const std::string&,const std::string&> OnObjectHandler_t;  // objectpath, objectname
 
-  HDF5IterateGroups( void ) {};
+  HDF5IterateGroups( void ): m_pdm( 0 ) {};
 
   void SetOnHandleObject( OnObjectHandler_t handler ) {
     HandleObject = handler;;
@@ -54,7 +54,12 @@ public:
   }
 
   int Start( const std::string& sBaseGroup ) {
-    HDF5DataManager dm( HDF5DataManager::RO );
+    HDF5DataManager dm( HDF5DataManager::RO );  // the one file open for the whole traversal
+    return Start( sBaseGroup, dm );
+  }
+
+  int Start( const std::string& sBaseGroup, HDF5DataManager& dm ) {  // a file already open, eg a partition
+    m_pdm = &dm;
     m_sBaseGroup = sBaseGroup;
     int idx = 0;  // starting location for interrupted queries
     int result = dm.GetH5File()->iterateElems( sBaseGroup, &idx, &HDF5IterateCallback, this );  
@@ -66,9 +71,10 @@ protected:
 private:
   OnObjectHandler_t HandleObject;
   OnObjectHandler_t HandleGroup;
+  HDF5DataManager* m_pdm;  // from Start, shared down the recursion, rather than one per object
 
   void Process( const std::string &sObjectName ) {
-    HDF5DataManager dm( HDF5DataManager::RO );
+    HDF5DataManager& dm( *m_pdm );
     std::string sObjectPath;
     if ( '/' == m_sBaseGroup[ m_sBaseGroup.size() - 1 ] ) {
       sObjectPath = m_sBaseGroup + sObjectName;
@@ -98,7 +104,7 @@ private:
             HDF5IterateGroups control;  // recursive call
             control.SetOnHandleObject( HandleObject );
             control.SetOnHandleGroup( HandleGroup );
-            int result = control.Start( sObjectPath );
+            control.Start( sObjectPath, dm );
           }
           break;
         default:
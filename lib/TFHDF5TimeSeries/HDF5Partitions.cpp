@@ -0,0 +1,206 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+//#include "StdAfx.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+
+#include "HDF5IterateGroups.h"
+#include "HDF5Partitions.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+namespace {
+
+const char szExtension[] = ".hdf5";
+
+struct Fan {  // HDF5IterateGroups' handler, with the partition added
+  HDF5DataManager* pdm;
+  HDF5Partitions::OnObjectHandler_t handler;
+  void HandleObject( const std::string& sObjectPath, const std::string& sObjectName ) {
+    handler( *pdm, sObjectPath, sObjectName );
+  }
+};
+
+} // namespace anonymous
+
+HDF5Partitions::HDF5Partitions( const std::string& sDirectory )
+: m_sDirectory( sDirectory ), m_ruleDefault( "/", Whole, "TradeFrame" ),
+  m_pmapReader( &HDF5Partitions::ReleaseReaders )
+{
+}
+
+HDF5Partitions::~HDF5Partitions( void ) {
+  Close();
+}
+
+void HDF5Partitions::AddRule( const std::string& sPrefix, EPeriod period, const std::string& sName ) {
+  assert( !sPrefix.empty() && ( '/' == sPrefix[ 0 ] ) );
+  assert( !sName.empty() );
+  m_vRule.push_back( Rule( sPrefix, period, sName ) );
+}
+
+const HDF5Partitions::Rule& HDF5Partitions::Route( const std::string& sPath ) const {
+  const Rule* pRule( &m_ruleDefault );
+  size_t nLongest( 0 );
+  for ( vRule_t::const_iterator iter = m_vRule.begin(); m_vRule.end() != iter; ++iter ) {
+    if ( ( nLongest < iter->sPrefix.size() ) && ( 0 == sPath.compare( 0, iter->sPrefix.size(), iter->sPrefix ) ) ) {
+      pRule = &(*iter);
+      nLongest = iter->sPrefix.size();
+    }
+  }
+  return *pRule;
+}
+
+std::string HDF5Partitions::Key( EPeriod period, const boost::gregorian::date& date ) {
+  char szKey[ 16 ];
+  switch ( period ) {
+    case Year:
+      std::sprintf( szKey, "%04d", (int) date.year() );
+      break;
+    case Month:
+      std::sprintf( szKey, "%04d%02d", (int) date.year(), (int) date.month() );
+      break;
+    case Day:
+      std::sprintf( szKey, "%04d%02d%02d", (int) date.year(), (int) date.month(), (int) date.day() );
+      break;
+    default:
+      szKey[ 0 ] = 0;
+      break;
+  }
+  return szKey;
+}
+
+HDF5Partitions::ptime HDF5Partitions::PeriodEnd( EPeriod period, const ptime& dt ) {
+  const boost::gregorian::date date( dt.date() );
+  switch ( period ) {
+    case Year:
+      return ptime( boost::gregorian::date( date.year() + 1, 1, 1 ) );
+    case Month:
+      return ptime( boost::gregorian::date( date.year(), date.month(), 1 ) + boost::gregorian::months( 1 ) );
+    case Day:
+      return ptime( date + boost::gregorian::days( 1 ) );
+    default:
+      return ptime( boost::posix_time::pos_infin );
+  }
+}
+
+std::string HDF5Partitions::FileName( const Rule& rule, const ptime& dt ) const {
+  if ( Whole == rule.period ) return m_sDirectory + rule.sName + szExtension;
+  return m_sDirectory + rule.sName + "." + Key( rule.period, dt.date() ) + szExtension;
+}
+
+std::string HDF5Partitions::FileName( const std::string& sPath, const ptime& dt ) const {
+  return FileName( Route( sPath ), dt );
+}
+
+void HDF5Partitions::FileNames( const std::string& sPath, const ptime& dtBegin, const ptime& dtEnd, vFileName_t& vFileName ) const {
+  // from the directory, the keys being fixed width, they compare as the dates do
+  vFileName.clear();
+  const Rule& rule( Route( sPath ) );
+  boost::system::error_code ec;
+  if ( Whole == rule.period ) {
+    const std::string sFileName( FileName( rule, dtBegin ) );
+    if ( boost::filesystem::exists( sFileName, ec ) ) vFileName.push_back( sFileName );
+    return;
+  }
+  const std::string sFirst( dtBegin.is_special() ? "" : Key( rule.period, dtBegin.date() ) );
+  const std::string sLast( dtEnd.is_special() ? "" : Key( rule.period, ( dtEnd - boost::posix_time::microseconds( 1 ) ).date() ) );
+  const std::string sStart( rule.sName + "." );
+  const boost::filesystem::path pathDirectory( m_sDirectory.empty() ? "." : m_sDirectory );
+  for ( boost::filesystem::directory_iterator iter( pathDirectory, ec ), end; end != iter; iter.increment( ec ) ) {
+    const std::string sFile( iter->path().filename().string() );
+    const size_t nExtension( sizeof( szExtension ) - 1 );
+    if ( ( sStart.size() + nExtension < sFile.size() )
+      && ( 0 == sFile.compare( 0, sStart.size(), sStart ) )
+      && ( 0 == sFile.compare( sFile.size() - nExtension, std::string::npos, szExtension ) ) ) {
+      const std::string sKey( sFile.substr( sStart.size(), sFile.size() - sStart.size() - nExtension ) );
+      if ( ( sKey.size() == Key( rule.period, boost::gregorian::date( 2000, 1, 1 ) ).size() )
+        && ( std::string::npos == sKey.find_first_not_of( "0123456789" ) )
+        && ( sFirst.empty() || ( sFirst <= sKey ) )
+        && ( sLast.empty() || ( sKey <= sLast ) ) ) {
+        vFileName.push_back( m_sDirectory + sFile );
+      }
+    }
+  }
+  std::sort( vFileName.begin(), vFileName.end() );
+}
+
+void HDF5Partitions::ReleaseReaders( mapDataManager_t* pmap ) {
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+  delete pmap;
+}
+
+HDF5DataManager& HDF5Partitions::Reader( const std::string& sFileName ) {
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );  // for the open, the caller holds it as well to use the file
+  if ( 0 == m_pmapReader.get() ) m_pmapReader.reset( new mapDataManager_t );
+  mapDataManager_t& map( *m_pmapReader );
+  mapDataManager_t::iterator iter = map.find( sFileName );
+  if ( map.end() == iter ) {
+    boost::system::error_code ec;
+    if ( !boost::filesystem::exists( sFileName, ec ) ) {  // HDF5DataManager would create it
+      throw std::runtime_error( "HDF5Partitions::Reader no file " + sFileName );
+    }
+    iter = map.insert( mapDataManager_t::value_type( sFileName, pDataManager_t( new HDF5DataManager( HDF5DataManager::RO, sFileName ) ) ) ).first;
+  }
+  return *iter->second;
+}
+
+HDF5DataManager& HDF5Partitions::Writer( const std::string& sFileName ) {
+  mapDataManager_t::iterator iter = m_mapWriter.find( sFileName );
+  if ( m_mapWriter.end() == iter ) {
+    if ( !m_sDirectory.empty() ) {
+      boost::system::error_code ec;
+      boost::filesystem::create_directories( m_sDirectory, ec );
+    }
+    iter = m_mapWriter.insert( mapDataManager_t::value_type( sFileName, pDataManager_t( new HDF5DataManager( HDF5DataManager::RDWR, sFileName ) ) ) ).first;
+  }
+  return *iter->second;
+}
+
+void HDF5Partitions::IterateObjects( const std::string& sGroup, OnObjectHandler_t handler ) {
+  vFileName_t vFileName;
+  FileNames( sGroup, ptime(), ptime(), vFileName );
+  for ( vFileName_t::const_iterator iter = vFileName.begin(); vFileName.end() != iter; ++iter ) {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );  // the handler runs under it
+    Fan fan;
+    fan.pdm = &Reader( *iter );
+    fan.handler = handler;
+    if ( fan.pdm->PathExists( sGroup ) ) {
+      HDF5IterateGroups control;
+      control.SetOnHandleObject( MakeDelegate( &fan, &Fan::HandleObject ) );
+      control.Start( sGroup, *fan.pdm );
+    }
+  }
+}
+
+void HDF5Partitions::Close( void ) {
+  {
+    boost::mutex::scoped_lock lock( m_mutexWriter );
+    HDF5DataManager::lock_t lockHDF5( HDF5DataManager::Mutex() );
+    for ( mapDataManager_t::iterator iter = m_mapWriter.begin(); m_mapWriter.end() != iter; ++iter ) {
+      iter->second->Flush();
+    }
+    m_mapWriter.clear();
+  }
+  m_pmapReader.reset();
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,174 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// spreads the datasets over several hdf5 files, partitions, rather than the one TradeFrame.hdf5
+//   a rule routes the dataset paths beginning with its prefix, the longest matching prefix wins,
+//   to files named for the rule and, by its period, the date of the datums: name.hdf5, name.2016.hdf5, name.201603.hdf5, name.20160301.hdf5
+//   a dataset path is the same in each of its partitions, a series is split by date over them on Write, and put back together on Read
+//   paths no rule matches go to TradeFrame.hdf5, as before
+// so a recorder can write today's partition while other processes read earlier ones, each file locked by hdf5 on its own,
+//   and a damaged file loses one period rather than everything
+// handles: each thread reading keeps its own open files, opened on first use, till Close from that thread or the thread ends;
+//   files written go through one set of read/write handles, kept till Close
+// threads: each call into hdf5 here holds HDF5DataManager::Mutex, the library may be built without thread safety,
+//   so threads reading and writing take turns in hdf5, and overlap on the rest; a caller using a Reader's data manager itself holds it too
+//   hdf5 refuses a read/write open of a file the process already has open read only, so a process writes a partition before reading it,
+//   or leaves the reading of it to another process
+// How to Use:
+/*
+  ou::tf::HDF5Partitions partitions( "hdf5/" );
+  partitions.AddRule( "/optionables/trade/", ou::tf::HDF5Partitions::Month, "trades" );  // hdf5/trades.201603.hdf5, ...
+  partitions.AddRule( "/optionables/quote/", ou::tf::HDF5Partitions::Month, "quotes" );
+  partitions.AddRule( "/bar/86400/", ou::tf::HDF5Partitions::Whole, "daily" );  // hdf5/daily.hdf5
+  partitions.Write( "/optionables/trade/SPY", trades );
+  ou::tf::Trades trades;
+  partitions.Read( "/optionables/trade/SPY", dtBegin, dtEnd, trades );
+  partitions.IterateObjects( "/optionables/trade/", MakeDelegate( this, &Scanner::HandleObject ) );  // each partition in turn
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <OUCommon/FastDelegate.h>
+
+#include <TFTimeSeries/TimeSeries.h>
+
+#include "HDF5DataManager.h"
+#include "HDF5WriteTimeSeries.h"
+#include "HDF5TimeSeriesContainer.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class HDF5Partitions {
+public:
+
+  enum EPeriod { Whole, Year, Month, Day };
+
+  typedef boost::posix_time::ptime ptime;
+  typedef fastdelegate::FastDelegate3<HDF5DataManager&,const std::string&,const std::string&> OnObjectHandler_t;  // partition, objectpath, objectname
+  typedef std::vector<std::string> vFileName_t;
+
+  explicit HDF5Partitions( const std::string& sDirectory = "" );  // sDirectory with trailing '/', created on the first write
+  ~HDF5Partitions( void );
+
+  void AddRule( const std::string& sPrefix, EPeriod period, const std::string& sName );
+
+  std::string FileName( const std::string& sPath, const ptime& dt ) const;  // the partition for datums at dt
+  // partitions which exist holding sPath's datums from dtBegin up to dtEnd, either may be not_a_date_time for no limit, in date order
+  void FileNames( const std::string& sPath, const ptime& dtBegin, const ptime& dtEnd, vFileName_t& vFileName ) const;
+
+  HDF5DataManager& Reader( const std::string& sFileName );  // this thread's, the file needs to exist, used under HDF5DataManager::Mutex
+
+  template<class TS>
+  void Write( const std::string& sPath, TS& series, bool bMerge = false );  // bMerge: see HDF5WriteTimeSeries::Merge
+  template<class TS>
+  void Read( const std::string& sPath, const ptime& dtBegin, const ptime& dtEnd, TS& series );  // appends [dtBegin, dtEnd)
+
+  void IterateObjects( const std::string& sGroup, OnObjectHandler_t handler );  // the datasets under sGroup in each partition of its rule
+
+  void Close( void );  // writers flushed and closed, and this thread's readers closed
+
+protected:
+private:
+
+  struct Rule {
+    std::string sPrefix;
+    EPeriod period;
+    std::string sName;
+    Rule( const std::string& sPrefix_, EPeriod period_, const std::string& sName_ ): sPrefix( sPrefix_ ), period( period_ ), sName( sName_ ) {};
+  };
+  typedef std::vector<Rule> vRule_t;
+
+  typedef boost::shared_ptr<HDF5DataManager> pDataManager_t;
+  typedef std::map<std::string,pDataManager_t> mapDataManager_t;  // by file name
+
+  std::string m_sDirectory;
+  vRule_t m_vRule;
+  Rule m_ruleDefault;
+
+  boost::thread_specific_ptr<mapDataManager_t> m_pmapReader;  // closed by ReleaseReaders
+  boost::mutex m_mutexWriter;  // held for the whole of a write, the handles are shared by the threads writing
+  mapDataManager_t m_mapWriter;
+
+  HDF5DataManager& Writer( const std::string& sFileName );  // created when missing, m_mutexWriter held by the caller
+
+  const Rule& Route( const std::string& sPath ) const;
+  std::string FileName( const Rule& rule, const ptime& dt ) const;
+  static std::string Key( EPeriod period, const boost::gregorian::date& date );  // empty for Whole
+  static ptime PeriodEnd( EPeriod period, const ptime& dt );  // start of the next partition
+  static void ReleaseReaders( mapDataManager_t* pmap );  // as a thread ends, or on Close, under the hdf5 lock
+
+};
+
+template<class TS>
+void HDF5Partitions::Write( const std::string& sPath, TS& series, bool bMerge ) {
+  // the series is in time order, so each partition's datums are a run
+  const Rule& rule( Route( sPath ) );
+  typename TS::const_iterator iterBegin( series.begin() );
+  while ( series.end() != iterBegin ) {
+    const ptime dtEnd( PeriodEnd( rule.period, iterBegin->DateTime() ) );
+    typename TS::const_iterator iterEnd( iterBegin );
+    TS part;
+    do {
+      part.Append( *iterEnd );
+      ++iterEnd;
+    } while ( ( series.end() != iterEnd ) && ( iterEnd->DateTime() < dtEnd ) );
+    {
+      boost::mutex::scoped_lock lock( m_mutexWriter );
+      HDF5DataManager::lock_t lockHDF5( HDF5DataManager::Mutex() );
+      HDF5DataManager& dm( Writer( FileName( rule, iterBegin->DateTime() ) ) );
+      HDF5WriteTimeSeries<TS> wts( dm, true, true, 5, 256 );
+      if ( bMerge ) wts.Merge( sPath, &part );
+      else wts.Write( sPath, &part );
+    }
+    iterBegin = iterEnd;
+  }
+}
+
+template<class TS>
+void HDF5Partitions::Read( const std::string& sPath, const ptime& dtBegin, const ptime& dtEnd, TS& series ) {
+  // read straight into the end of the series, no intermediate copy
+  typedef typename TS::datum_t DD;
+  vFileName_t vFileName;
+  FileNames( sPath, dtBegin, dtEnd, vFileName );
+  for ( vFileName_t::const_iterator iterFile = vFileName.begin(); vFileName.end() != iterFile; ++iterFile ) {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    HDF5DataManager& dm( Reader( *iterFile ) );
+    if ( !dm.PathExists( sPath ) ) continue;
+    HDF5TimeSeriesContainer<DD> repository( dm, sPath );
+    typename HDF5TimeSeriesContainer<DD>::iterator begin( repository.begin() ), end( repository.end() );
+    if ( !dtBegin.is_special() ) begin = std::lower_bound( repository.begin(), repository.end(), dtBegin );
+    if ( !dtEnd.is_special() ) end = std::lower_bound( begin, repository.end(), dtEnd );
+    hsize_t cnt = end - begin;
+    if ( 0 != cnt ) {
+      const size_t nExisting( series.Size() );
+      series.Resize( nExisting + cnt );
+      H5::DataSpace ds( 1, &cnt );
+      repository.HDF5TimeSeriesAccessor<DD>::Read( begin - repository.begin(), cnt, &ds, const_cast<DD*>( series.First() ) + nExisting );
+      ds.close();
+    }
+  }
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,454 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+//#include "StdAfx.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "HDF5Attribute.h"
+#include "HDF5IterateGroups.h"
+#include "HDF5PathIndex.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+const char HDF5PathIndex::rchMagicIndex[ 8 ] = { 'O', 'U', 'P', 'A', 'T', 'H', 'X', '1' };
+
+namespace {
+
+const char szIndex[] = ".index";
+const char szJournal[] = ".journal";
+const char szLock[] = ".index.lock";
+const char szSignature[] = "Signature";  // see HDF5Attributes
+
+size_t Pad( size_t n ) { return ( n + 7 ) & ~(size_t) 7; };
+
+struct BySymbol {  // orders record numbers by symbol, then path
+  const HDF5PathIndex::Record* pRecord;
+  const char* pPath;
+  bool operator()( boost::uint32_t ix1, boost::uint32_t ix2 ) const {
+    const HDF5PathIndex::Record& r1( pRecord[ ix1 ] );
+    const HDF5PathIndex::Record& r2( pRecord[ ix2 ] );
+    const int n( Compare( pPath + r1.nPath + r1.ixSymbol, r1.nPathLength - r1.ixSymbol, pPath + r2.nPath + r2.ixSymbol, r2.nPathLength - r2.ixSymbol ) );
+    if ( 0 != n ) return n < 0;
+    return 0 > Compare( pPath + r1.nPath, r1.nPathLength, pPath + r2.nPath, r2.nPathLength );
+  }
+  static int Compare( const char* p1, size_t n1, const char* p2, size_t n2 ) {
+    const int n( std::memcmp( p1, p2, std::min( n1, n2 ) ) );
+    if ( 0 != n ) return n;
+    return ( n1 < n2 ) ? -1 : ( ( n1 > n2 ) ? 1 : 0 );
+  }
+};
+
+boost::mutex mutexJournal;  // a file lock doesn't exclude the threads of its own process
+
+class JournalLock {  // throws interprocess_exception when the lock file can't be had
+public:
+  explicit JournalLock( const std::string& sLock ): m_lock( mutexJournal ) {
+    std::FILE* pFile( std::fopen( sLock.c_str(), "ab" ) );  // file_lock needs the file to exist
+    if ( 0 != pFile ) std::fclose( pFile );
+    boost::interprocess::file_lock lock( sLock.c_str() );
+    m_file.swap( lock );
+    m_file.lock();
+  }
+  ~JournalLock( void ) {
+    m_file.unlock();
+  }
+private:
+  boost::mutex::scoped_lock m_lock;
+  boost::interprocess::file_lock m_file;
+};
+
+struct Collect {  // HDF5IterateGroups' handler for Rebuild
+  HDF5DataManager* pdm;
+  HDF5PathIndex::vEntry_t* pv;
+  void HandleObject( const std::string& sObjectPath, const std::string& ) {
+    HDF5PathIndex::Entry entry;
+    entry.sPath = sObjectPath;
+    H5::DataSet dataset( pdm->GetH5File()->openDataSet( sObjectPath ) );
+    if ( dataset.attrExists( szSignature ) ) {
+      H5::Attribute attribute( dataset.openAttribute( szSignature ) );
+      attribute.read( H5::PredType::NATIVE_UINT64, &entry.nSignature );
+      attribute.close();
+    }
+    H5::DataSpace dspace( dataset.getSpace() );
+    hsize_t nSize( 0 );
+    if ( 1 == dspace.getSimpleExtentNdims() ) dspace.getSimpleExtentDims( &nSize );
+    entry.nCount = nSize;
+    HDF5Attributes::structSummary summary;
+    HDF5Attributes attributes( *pdm, sObjectPath );
+    if ( attributes.GetSummary( &summary ) && ( nSize == summary.nCount ) ) {  // see HDF5Summary.h, an attribute is cheaper than a chunk
+      entry.dtFirst = summary.dtFirst;
+      entry.dtLast = summary.dtLast;
+    }
+    else if ( ( 0 != nSize ) && ( H5T_COMPOUND == dataset.getTypeClass() ) ) {
+      H5::CompType typeDisk( dataset );
+      if ( 0 <= typeDisk.getMemberIndex( "DateTime" ) ) {  // a time series, the first and last times are read by themselves
+        H5::CompType typeTime( sizeof( boost::posix_time::ptime ) );
+        typeTime.insertMember( "DateTime", 0, H5::PredType::NATIVE_LLONG );
+        hsize_t nOne( 1 );
+        H5::DataSpace dspaceMemory( 1, &nOne );
+        hsize_t ix( 0 );
+        dspace.selectHyperslab( H5S_SELECT_SET, &nOne, &ix );
+        dataset.read( &entry.dtFirst, typeTime, dspaceMemory, dspace );
+        ix = nSize - 1;
+        dspace.selectHyperslab( H5S_SELECT_SET, &nOne, &ix );
+        dataset.read( &entry.dtLast, typeTime, dspaceMemory, dspace );
+        dspaceMemory.close();
+        typeTime.close();
+      }
+      typeDisk.close();
+    }
+    dspace.close();
+    dataset.close();
+    pv->push_back( entry );
+  }
+};
+
+} // namespace anonymous
+
+HDF5PathIndex::HDF5PathIndex( const std::string& sFileName )
+: m_sIndex( sFileName + szIndex ), m_sJournal( sFileName + szJournal ), m_sLock( sFileName + szLock ),
+  m_pRecord( 0 ), m_pBySymbol( 0 ), m_pPath( 0 ), m_nRecords( 0 )
+{
+}
+
+HDF5PathIndex::~HDF5PathIndex( void ) {
+  Unmap();
+}
+
+void HDF5PathIndex::Unmap( void ) {
+  m_pRegion.reset();  // before the mapping
+  m_pMapping.reset();
+  m_pRecord = 0;
+  m_pBySymbol = 0;
+  m_pPath = 0;
+  m_nRecords = 0;
+}
+
+bool HDF5PathIndex::Map( void ) {
+  Unmap();
+  boost::system::error_code ec;
+  const boost::uintmax_t nFileBytes( boost::filesystem::file_size( m_sIndex, ec ) );
+  if ( ec || ( sizeof( Header ) > nFileBytes ) ) return false;
+  try {
+    m_pMapping.reset( new boost::interprocess::file_mapping( m_sIndex.c_str(), boost::interprocess::read_only ) );
+    m_pRegion.reset( new boost::interprocess::mapped_region( *m_pMapping, boost::interprocess::read_only, 0, (size_t) nFileBytes ) );
+  }
+  catch ( boost::interprocess::interprocess_exception& e ) {
+    std::cout << "HDF5PathIndex: can't map " << m_sIndex << ": " << e.what() << std::endl;
+    Unmap();
+    return false;
+  }
+  const char* pBase( static_cast<const char*>( m_pRegion->get_address() ) );
+  Header header;
+  std::memcpy( &header, pBase, sizeof( header ) );
+  const size_t nRecords( (size_t) header.nRecords );
+  if ( ( 0 != std::memcmp( header.rchMagic, rchMagicIndex, sizeof( header.rchMagic ) ) )
+    || ( nFileBytes != sizeof( Header ) + nRecords * sizeof( Record ) + Pad( nRecords * sizeof( boost::uint32_t ) ) + header.nPathBytes ) ) {
+    std::cout << "HDF5PathIndex: " << m_sIndex << " is not an index, or is damaged, Rebuild it" << std::endl;
+    Unmap();
+    return false;
+  }
+  m_nRecords = nRecords;
+  m_pRecord = reinterpret_cast<const Record*>( pBase + sizeof( Header ) );
+  m_pBySymbol = reinterpret_cast<const boost::uint32_t*>( pBase + sizeof( Header ) + nRecords * sizeof( Record ) );
+  m_pPath = pBase + sizeof( Header ) + nRecords * sizeof( Record ) + Pad( nRecords * sizeof( boost::uint32_t ) );
+  return true;
+}
+
+boost::uint64_t HDF5PathIndex::Check( const JournalRecord& record, const char* pPath ) {
+  // fnv-1a
+  JournalRecord copy( record );
+  copy.nCheck = 0;
+  boost::uint64_t nCheck( 14695981039346656037ULL );
+  const unsigned char* p( reinterpret_cast<const unsigned char*>( &copy ) );
+  for ( size_t ix = 0; ix < sizeof( copy ); ++ix ) nCheck = ( nCheck ^ p[ ix ] ) * 1099511628211ULL;
+  p = reinterpret_cast<const unsigned char*>( pPath );
+  for ( size_t ix = 0; ix < record.nPathLength; ++ix ) nCheck = ( nCheck ^ p[ ix ] ) * 1099511628211ULL;
+  return nCheck;
+}
+
+void HDF5PathIndex::ReadJournal( void ) {
+  m_mapJournal.clear();
+  std::FILE* pFile( std::fopen( m_sJournal.c_str(), "rb" ) );
+  if ( 0 == pFile ) return;
+  JournalRecord record;
+  std::vector<char> vPath;
+  while ( 1 == std::fread( &record, sizeof( record ), 1, pFile ) ) {
+    if ( nMagicJournal != record.nMagic ) break;
+    vPath.resize( Pad( record.nPathLength ) + 1 );
+    if ( 1 != std::fread( &vPath[ 0 ], vPath.size() - 1, 1, pFile ) ) break;
+    if ( Check( record, &vPath[ 0 ] ) != record.nCheck ) break;  // partly written
+    Entry entry;
+    entry.sPath.assign( &vPath[ 0 ], record.nPathLength );
+    entry.nSignature = record.nSignature;
+    entry.nCount = record.nCount;
+    entry.dtFirst = record.dtFirst;
+    entry.dtLast = record.dtLast;
+    if ( entry.dtFirst.is_not_a_date_time() ) {  // an append
+      Entry previous;
+      if ( Find( entry.sPath, previous ) ) entry.dtFirst = previous.dtFirst;
+    }
+    m_mapJournal[ entry.sPath ] = entry;
+  }
+  std::fclose( pFile );
+}
+
+bool HDF5PathIndex::Load( void ) {
+  m_mapJournal.clear();
+  if ( !Map() ) return false;
+  ReadJournal();
+  return true;
+}
+
+size_t HDF5PathIndex::Size( void ) const {
+  size_t n( m_nRecords );
+  for ( mapEntry_t::const_iterator iter = m_mapJournal.begin(); m_mapJournal.end() != iter; ++iter ) {
+    Entry entry;
+    if ( !FindRecord( iter->first, entry ) ) ++n;  // new since the index was written
+  }
+  return n;
+}
+
+void HDF5PathIndex::ToEntry( const Record& record, Entry& entry ) const {
+  entry.sPath.assign( m_pPath + record.nPath, record.nPathLength );
+  entry.nSignature = record.nSignature;
+  entry.nCount = record.nCount;
+  entry.dtFirst = record.dtFirst;
+  entry.dtLast = record.dtLast;
+}
+
+size_t HDF5PathIndex::LowerBound( const std::string& sPath ) const {
+  size_t ixFirst( 0 );
+  size_t cnt( m_nRecords );
+  while ( 0 < cnt ) {
+    const size_t step( cnt / 2 );
+    const Record& record( m_pRecord[ ixFirst + step ] );
+    if ( 0 > BySymbol::Compare( m_pPath + record.nPath, record.nPathLength, sPath.data(), sPath.size() ) ) {
+      ixFirst += step + 1;
+      cnt -= step + 1;
+    }
+    else {
+      cnt = step;
+    }
+  }
+  return ixFirst;
+}
+
+bool HDF5PathIndex::FindRecord( const std::string& sPath, Entry& entry ) const {
+  const size_t ix( LowerBound( sPath ) );
+  if ( m_nRecords == ix ) return false;
+  const Record& record( m_pRecord[ ix ] );
+  if ( 0 != BySymbol::Compare( m_pPath + record.nPath, record.nPathLength, sPath.data(), sPath.size() ) ) return false;
+  ToEntry( record, entry );
+  return true;
+}
+
+bool HDF5PathIndex::Find( const std::string& sPath, Entry& entry ) const {
+  mapEntry_t::const_iterator iter = m_mapJournal.find( sPath );
+  if ( m_mapJournal.end() != iter ) {
+    entry = iter->second;
+    return true;
+  }
+  return FindRecord( sPath, entry );
+}
+
+void HDF5PathIndex::Prefix( const std::string& sPrefix, vEntry_t& v ) const {
+  // the records and the journal, both in path order, merged, the journal's entry winning a tie
+  size_t ix( LowerBound( sPrefix ) );
+  mapEntry_t::const_iterator iter = m_mapJournal.lower_bound( sPrefix );
+  Entry entry;
+  while ( true ) {
+    bool bRecord( false );
+    if ( m_nRecords != ix ) {
+      const Record& record( m_pRecord[ ix ] );
+      bRecord = ( sPrefix.size() <= record.nPathLength ) && ( 0 == std::memcmp( m_pPath + record.nPath, sPrefix.data(), sPrefix.size() ) );
+    }
+    const bool bJournal( ( m_mapJournal.end() != iter ) && ( 0 == iter->first.compare( 0, sPrefix.size(), sPrefix ) ) );
+    if ( !bRecord && !bJournal ) break;
+    if ( bRecord ) ToEntry( m_pRecord[ ix ], entry );
+    if ( bRecord && bJournal && ( entry.sPath == iter->first ) ) {
+      v.push_back( iter->second );
+      ++ix;
+      ++iter;
+    }
+    else {
+      if ( bRecord && ( !bJournal || ( entry.sPath < iter->first ) ) ) {
+        v.push_back( entry );
+        ++ix;
+      }
+      else {
+        v.push_back( iter->second );
+        ++iter;
+      }
+    }
+  }
+}
+
+void HDF5PathIndex::Symbol( const std::string& sSymbol, vEntry_t& v ) const {
+  const size_t nFirst( v.size() );
+  size_t ixFirst( 0 );
+  size_t cnt( m_nRecords );
+  while ( 0 < cnt ) {
+    const size_t step( cnt / 2 );
+    const Record& record( m_pRecord[ m_pBySymbol[ ixFirst + step ] ] );
+    if ( 0 > BySymbol::Compare( m_pPath + record.nPath + record.ixSymbol, record.nPathLength - record.ixSymbol, sSymbol.data(), sSymbol.size() ) ) {
+      ixFirst += step + 1;
+      cnt -= step + 1;
+    }
+    else {
+      cnt = step;
+    }
+  }
+  Entry entry;
+  for ( size_t ix = ixFirst; ix < m_nRecords; ++ix ) {
+    const Record& record( m_pRecord[ m_pBySymbol[ ix ] ] );
+    if ( 0 != BySymbol::Compare( m_pPath + record.nPath + record.ixSymbol, record.nPathLength - record.ixSymbol, sSymbol.data(), sSymbol.size() ) ) break;
+    ToEntry( record, entry );
+    if ( m_mapJournal.end() == m_mapJournal.find( entry.sPath ) ) v.push_back( entry );
+  }
+  for ( mapEntry_t::const_iterator iter = m_mapJournal.begin(); m_mapJournal.end() != iter; ++iter ) {  // the journal is short
+    if ( iter->second.Symbol() == sSymbol ) v.push_back( iter->second );
+  }
+  std::sort( v.begin() + nFirst, v.end(), []( const Entry& e1, const Entry& e2 ){ return e1.sPath < e2.sPath; } );
+}
+
+void HDF5PathIndex::Write( const vEntry_t& v ) {
+  // v in path order
+  Unmap();  // the old index may be replaced
+  Header header;
+  std::memcpy( header.rchMagic, rchMagicIndex, sizeof( header.rchMagic ) );
+  header.nRecords = v.size();
+  header.nPathBytes = 0;
+  header.nReserved = 0;
+  std::vector<Record> vRecord( v.size() );
+  std::string sPaths;
+  for ( size_t ix = 0; ix < v.size(); ++ix ) {
+    const Entry& entry( v[ ix ] );
+    Record& record( vRecord[ ix ] );
+    record.nSignature = entry.nSignature;
+    record.nCount = entry.nCount;
+    record.dtFirst = entry.dtFirst;
+    record.dtLast = entry.dtLast;
+    record.nPath = sPaths.size();
+    record.nPathLength = (boost::uint32_t) entry.sPath.size();
+    record.ixSymbol = (boost::uint32_t) ( entry.sPath.rfind( '/' ) + 1 );
+    sPaths.append( entry.sPath );
+  }
+  header.nPathBytes = sPaths.size();
+  std::vector<boost::uint32_t> vBySymbol( Pad( v.size() * sizeof( boost::uint32_t ) ) / sizeof( boost::uint32_t ), 0 );
+  for ( size_t ix = 0; ix < v.size(); ++ix ) vBySymbol[ ix ] = (boost::uint32_t) ix;
+  if ( !v.empty() ) {
+    BySymbol by;
+    by.pRecord = &vRecord[ 0 ];
+    by.pPath = sPaths.data();
+    std::sort( vBySymbol.begin(), vBySymbol.begin() + v.size(), by );
+  }
+
+  const std::string sTemp( m_sIndex + ".tmp" );
+  std::FILE* pFile( std::fopen( sTemp.c_str(), "wb" ) );
+  if ( 0 == pFile ) throw std::runtime_error( "HDF5PathIndex: can't write " + sTemp );
+  bool bOk( 1 == std::fwrite( &header, sizeof( header ), 1, pFile ) );
+  if ( !vRecord.empty() ) bOk = bOk && ( 1 == std::fwrite( &vRecord[ 0 ], vRecord.size() * sizeof( Record ), 1, pFile ) );
+  if ( !vBySymbol.empty() ) bOk = bOk && ( 1 == std::fwrite( &vBySymbol[ 0 ], vBySymbol.size() * sizeof( boost::uint32_t ), 1, pFile ) );
+  if ( !sPaths.empty() ) bOk = bOk && ( 1 == std::fwrite( sPaths.data(), sPaths.size(), 1, pFile ) );
+  bOk = ( 0 == std::fclose( pFile ) ) && bOk;
+  if ( !bOk ) {
+    std::remove( sTemp.c_str() );
+    throw std::runtime_error( "HDF5PathIndex: can't write " + sTemp );
+  }
+  // the index is replaced whole, then the journal it includes is emptied, a crash between leaves entries applied twice, to the same effect
+  boost::filesystem::rename( sTemp, m_sIndex );
+  std::FILE* pJournal( std::fopen( m_sJournal.c_str(), "wb" ) );
+  if ( 0 != pJournal ) std::fclose( pJournal );
+  Load();
+}
+
+void HDF5PathIndex::Compact( void ) {
+  JournalLock lock( m_sLock );
+  if ( !Load() ) return;  // the journal as it is now, later appends wait for the lock
+  vEntry_t v;
+  Prefix( "/", v );
+  Write( v );
+}
+
+void HDF5PathIndex::Rebuild( HDF5DataManager& dm ) {
+  JournalLock lock( m_sLock );  // held through the walk, a dataset written meanwhile is journaled after the new index
+  vEntry_t v;
+  Collect collect;
+  collect.pdm = &dm;
+  collect.pv = &v;
+  HDF5IterateGroups control;
+  control.SetOnHandleObject( MakeDelegate( &collect, &Collect::HandleObject ) );
+  control.Start( "/", dm );
+  std::sort( v.begin(), v.end(), []( const Entry& e1, const Entry& e2 ){ return e1.sPath < e2.sPath; } );
+  Write( v );
+}
+
+bool HDF5PathIndex::Indexed( const HDF5DataManager& dm ) {
+  boost::system::error_code ec;
+  return boost::filesystem::exists( dm.GetFileName() + szIndex, ec );
+}
+
+void HDF5PathIndex::Journal( HDF5DataManager& dm, const std::string& sPath, boost::uint64_t nSignature, boost::uint64_t nCount, const ptime& dtFirst, const ptime& dtLast ) {
+  if ( !Indexed( dm ) ) return;  // nothing to keep up to date
+  boost::system::error_code ec;
+  JournalRecord record = JournalRecord();  // value initialised, the record has no padding to leave out of the check
+  record.nMagic = nMagicJournal;
+  record.nPathLength = (boost::uint32_t) sPath.size();
+  record.nSignature = nSignature;
+  record.nCount = nCount;
+  record.dtFirst = dtFirst;
+  record.dtLast = dtLast;
+  record.nCheck = Check( record, sPath.data() );
+  std::vector<char> v( sizeof( record ) + Pad( sPath.size() ), 0 );  // one write
+  std::memcpy( &v[ 0 ], &record, sizeof( record ) );
+  std::memcpy( &v[ sizeof( record ) ], sPath.data(), sPath.size() );
+  const std::string sJournal( dm.GetFileName() + szJournal );
+  try {
+    JournalLock lock( dm.GetFileName() + szLock );
+    const boost::uintmax_t nBefore( boost::filesystem::exists( sJournal, ec ) ? boost::filesystem::file_size( sJournal, ec ) : 0 );
+    std::FILE* pFile( std::fopen( sJournal.c_str(), "ab" ) );
+    if ( 0 == pFile ) {
+      std::cout << "HDF5PathIndex: can't append to " << sJournal << std::endl;
+      return;
+    }
+    bool bOk( 1 == std::fwrite( &v[ 0 ], v.size(), 1, pFile ) );
+    bOk = ( 0 == std::fflush( pFile ) ) && bOk;
+    bOk = ( 0 == std::fclose( pFile ) ) && bOk;
+    if ( !bOk ) {
+      // a partial record would end the journal for the appends after it, it is cut off, the index is behind till the next Rebuild
+      boost::filesystem::resize_file( sJournal, nBefore, ec );
+      std::cout << "HDF5PathIndex: can't append to " << sJournal << ", " << sPath << " isn't journaled, Rebuild the index" << std::endl;
+    }
+  }
+  catch ( boost::interprocess::interprocess_exception& e ) {
+    std::cout << "HDF5PathIndex: can't lock " << dm.GetFileName() << szLock << ": " << e.what() << std::endl;
+  }
+}
+
+} // namespace tf
+} // namespace ou
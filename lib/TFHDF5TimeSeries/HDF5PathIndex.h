@@ -0,0 +1,156 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// an index of the datasets in an hdf5 file: path, datum signature, count, first and last time,
+//   kept beside the file so the tree of datasets can be had without walking the file's groups
+// files, for TradeFrame.hdf5:
+//   TradeFrame.hdf5.index: Header, Records sorted by path, a uint32 per record ordering them by symbol (last part of the path),
+//     then the paths; mapped read only by Load, so searches work on it in place
+//   TradeFrame.hdf5.journal: a Journal record, then its path, for each dataset written since the index was written,
+//     appended by HDF5WriteTimeSeries::Write and WatchRecorder through Journal;
+//     each record is one write with a checksum, a partly written record (a crash) ends the journal and is ignored
+// Load reads the journal into a map overlaying the index, Compact folds it in by writing a new index and renaming it into place
+// TradeFrame.hdf5.index.lock: locked by Journal around each append, and by Compact and Rebuild from reading the journal till it is emptied,
+//   so an append from another thread or process waits, rather than landing in a journal about to be emptied
+// Rebuild walks the hdf5 file once, for a file without an index, or one written by something which doesn't journal,
+//   taking the times from the summary attribute (HDF5Summary.h) where it is current, otherwise reading the first and last datums;
+//   Journal does nothing till an index has been built, an index of just the later datasets would be misleading
+// How to Use:
+/*
+  ou::tf::HDF5PathIndex index( "TradeFrame.hdf5" );
+  if ( !index.Load() ) {  // no index yet
+    ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
+    index.Rebuild( dm );
+  }
+  ou::tf::HDF5PathIndex::vEntry_t v;
+  index.Prefix( "/bar/86400/", v );
+  index.Symbol( "SPY", v );  // each dataset named SPY
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "HDF5DataManager.h"
+
+namespace boost { // mapping is kept out of the header
+namespace interprocess {
+  class file_mapping;
+  class mapped_region;
+} }
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class HDF5PathIndex {
+public:
+
+  typedef boost::posix_time::ptime ptime;
+
+  struct Entry {
+    std::string sPath;
+    boost::uint64_t nSignature;  // DD::Signature()
+    boost::uint64_t nCount;
+    ptime dtFirst;
+    ptime dtLast;
+    Entry( void ): nSignature( 0 ), nCount( 0 ) {};
+    std::string Symbol( void ) const { return sPath.substr( sPath.rfind( '/' ) + 1 ); };
+  };
+  typedef std::vector<Entry> vEntry_t;
+
+  explicit HDF5PathIndex( const std::string& sFileName = "TradeFrame.hdf5" );  // the hdf5 file
+  ~HDF5PathIndex( void );
+
+  bool Load( void );  // false when there is no index
+  size_t Size( void ) const;  // datasets
+
+  bool Find( const std::string& sPath, Entry& entry ) const;
+  void Prefix( const std::string& sPrefix, vEntry_t& v ) const;  // appended in path order, "/" for all
+  void Symbol( const std::string& sSymbol, vEntry_t& v ) const;  // appended in path order
+
+  void Rebuild( HDF5DataManager& dm );  // replaces the index and journal, and loads it
+  void Compact( void );  // reloads, then folds the journal into the index, does nothing without an index
+
+  static bool Indexed( const HDF5DataManager& dm );  // whether the file has an index for Journal to keep up to date
+  // after a dataset is written, dtFirst not_a_date_time for an append, which keeps the first time indexed
+  static void Journal( HDF5DataManager& dm, const std::string& sPath, boost::uint64_t nSignature, boost::uint64_t nCount, const ptime& dtFirst, const ptime& dtLast );
+
+  // file layout
+  struct Header {
+    char rchMagic[ 8 ];
+    boost::uint64_t nRecords;
+    boost::uint64_t nPathBytes;
+    boost::uint64_t nReserved;
+  };
+  struct Record {
+    boost::uint64_t nSignature;
+    boost::uint64_t nCount;
+    ptime dtFirst;
+    ptime dtLast;
+    boost::uint64_t nPath;  // offset into the paths
+    boost::uint32_t nPathLength;
+    boost::uint32_t ixSymbol;  // offset of the symbol within the path
+  };
+  struct JournalRecord {
+    boost::uint32_t nMagic;
+    boost::uint32_t nPathLength;
+    boost::uint64_t nSignature;
+    boost::uint64_t nCount;
+    ptime dtFirst;
+    ptime dtLast;
+    boost::uint64_t nCheck;  // over the record, with nCheck zero, and the path
+  };
+
+  static const char rchMagicIndex[ 8 ];
+  static const boost::uint32_t nMagicJournal = 0x4a585450;  // PTXJ
+
+protected:
+private:
+
+  typedef std::map<std::string,Entry> mapEntry_t;
+
+  std::string m_sIndex;
+  std::string m_sJournal;
+  std::string m_sLock;
+
+  boost::scoped_ptr<boost::interprocess::file_mapping> m_pMapping;
+  boost::scoped_ptr<boost::interprocess::mapped_region> m_pRegion;
+  const Record* m_pRecord;
+  const boost::uint32_t* m_pBySymbol;
+  const char* m_pPath;
+  size_t m_nRecords;
+
+  mapEntry_t m_mapJournal;  // overlays the mapped records
+
+  void Unmap( void );
+  bool Map( void );
+  void ReadJournal( void );
+  void Write( const vEntry_t& v );  // a new index, renamed into place, and the journal emptied, with the lock held
+
+  size_t LowerBound( const std::string& sPath ) const;  // first record at or after sPath
+  void ToEntry( const Record& record, Entry& entry ) const;
+  bool FindRecord( const std::string& sPath, Entry& entry ) const;
+
+  static boost::uint64_t Check( const JournalRecord& record, const char* pPath );
+
+};
+
+} // namespace tf
+} // namespace ou
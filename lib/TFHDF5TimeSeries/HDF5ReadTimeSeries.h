@@ -0,0 +1,119 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// whole datasets read into time series, one or many at a time, the counterpart to HDF5WriteTimeSeries
+//   for part of a dataset, a date range say, use HDF5TimeSeriesContainer::Read
+// each series is sized to its dataset, then the dataset is read in one call straight into the series' storage,
+//   with the datum type kept by HDF5TimeSeriesAccessor<DD>::DataType, the conversion buffers of HDF5DataManager::Transfer,
+//   and one memory dataspace re-sized for each dataset, rather than a container, with its iterators, and new ones of each
+// a dataset which is missing, or doesn't hold DD, leaves its series empty
+// How to Use:
+/*
+  ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
+  ou::tf::HDF5ReadTimeSeries<ou::tf::Bars> rts( dm );
+  std::vector<ou::tf::Bars> vBars;
+  rts.Read( vPathName, vBars );  // vBars[ ix ] from vPathName[ ix ]
+*/
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <TFTimeSeries/TimeSeries.h>
+
+#include "HDF5DataManager.h"
+#include "HDF5TimeSeriesAccessor.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+template<class TS> class HDF5ReadTimeSeries {
+public:
+
+  typedef typename TS::datum_t DD;
+
+  explicit HDF5ReadTimeSeries<TS>( HDF5DataManager& dm );
+  ~HDF5ReadTimeSeries<TS>( void );
+
+  bool Read( const std::string& sPathName, TS& series );  // false when not read, series is then empty
+  size_t Read( const std::vector<std::string>& vPathName, std::vector<TS>& vSeries );  // vSeries sized to match, returns the datasets read
+
+protected:
+private:
+
+  HDF5DataManager& m_dm;
+  H5::DataSpace m_dsMemory;
+  H5::DSetAccPropList m_pla;
+
+  HDF5ReadTimeSeries( const HDF5ReadTimeSeries& ); // copy constructor not implemented
+  HDF5ReadTimeSeries& operator=( const HDF5ReadTimeSeries& ); // assignment constructor not implemented
+};
+
+template<class TS> HDF5ReadTimeSeries<TS>::HDF5ReadTimeSeries( HDF5DataManager& dm )
+: m_dm( dm ), m_dsMemory( H5S_SIMPLE )
+{
+  m_pla.setChunkCache( 0, 0, 1.0 );  // each chunk is read once
+}
+
+template<class TS> HDF5ReadTimeSeries<TS>::~HDF5ReadTimeSeries( void ) {
+  m_pla.close();
+  m_dsMemory.close();
+}
+
+template<class TS> bool HDF5ReadTimeSeries<TS>::Read( const std::string& sPathName, TS& series ) {
+  series.Clear();
+  bool bRead( false );
+  try {
+    H5::DataSet dataset( m_dm.GetH5File()->openDataSet( sPathName, m_pla ) );
+    H5::DataSpace dsDisk( dataset.getSpace() );
+    H5::CompType typeDisk( dataset );
+    const H5::CompType& typeMemory( HDF5TimeSeriesAccessor<DD>::DataType() );
+    if ( ( 1 == dsDisk.getSimpleExtentNdims() ) && ( typeMemory.getNmembers() == typeDisk.getNmembers() ) ) {  // as HDF5TimeSeriesAccessor checks
+      hsize_t nSize( 0 );
+      dsDisk.getSimpleExtentDims( &nSize );
+      if ( 0 != nSize ) {
+        series.Resize( nSize );
+        m_dsMemory.setExtentSimple( 1, &nSize );
+        dataset.read( const_cast<DD*>( series.First() ), typeMemory, m_dsMemory, dsDisk, HDF5DataManager::Transfer() );
+      }
+      bRead = true;
+    }
+    else {
+      std::cout << "HDF5ReadTimeSeries::Read " << sPathName << " CompType doesn't match" << std::endl;
+    }
+    typeDisk.close();
+    dsDisk.close();
+    dataset.close();
+  }
+  catch ( const H5::Exception& e ) {
+    std::cout << "HDF5ReadTimeSeries::Read " << sPathName << " H5::Exception " << e.getDetailMsg() << std::endl;
+    series.Clear();
+    bRead = false;
+  }
+  return bRead;
+}
+
+template<class TS> size_t HDF5ReadTimeSeries<TS>::Read( const std::vector<std::string>& vPathName, std::vector<TS>& vSeries ) {
+  vSeries.resize( vPathName.size() );
+  size_t nRead( 0 );
+  for ( size_t ix = 0; ix < vPathName.size(); ++ix ) {
+    if ( Read( vPathName[ ix ], vSeries[ ix ] ) ) ++nRead;
+  }
+  return nRead;
+}
+
+} // namespace tf
+} // namespace ou
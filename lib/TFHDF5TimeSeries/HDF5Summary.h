@@ -0,0 +1,177 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// the summary kept as an attribute on each time series dataset, see HDF5Attributes::structSummary and HDF5Catalog.h
+//   HDF5WriteTimeSeries::Write calls SummariseWrite once the series is written:
+//     datums making up the whole dataset, or written after the summarised last one, are summarised without reading the dataset
+//     otherwise (an overwrite, a dataset without a summary, or one added to by other means) the dataset is read through
+//   prices and volumes come from SummaryTraits<DD>, specialised below for the datums which carry them
+
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
+#include <TFTimeSeries/TimeSeries.h>
+
+#include "HDF5Attribute.h"
+#include "HDF5TimeSeriesContainer.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+template<class DD> struct SummaryTraits {  // count and date range only
+  static bool Priced( const DD& ) { return false; };
+  static double Low( const DD& ) { return 0; };
+  static double High( const DD& ) { return 0; };
+  static double Close( const DD& ) { return 0; };
+  static boost::uint64_t Volume( const DD& ) { return 0; };
+};
+
+template<> struct SummaryTraits<Bar> {
+  static bool Priced( const Bar& ) { return true; };
+  static double Low( const Bar& bar ) { return bar.Low(); };
+  static double High( const Bar& bar ) { return bar.High(); };
+  static double Close( const Bar& bar ) { return bar.Close(); };
+  static boost::uint64_t Volume( const Bar& bar ) { return bar.Volume(); };
+};
+
+template<> struct SummaryTraits<Trade> {
+  static bool Priced( const Trade& ) { return true; };
+  static double Low( const Trade& trade ) { return trade.Price(); };
+  static double High( const Trade& trade ) { return trade.Price(); };
+  static double Close( const Trade& trade ) { return trade.Price(); };
+  static boost::uint64_t Volume( const Trade& trade ) { return trade.Volume(); };
+};
+
+template<> struct SummaryTraits<Quote> {  // one sided quotes don't count toward the prices
+  static bool Priced( const Quote& quote ) { return ( 0 != quote.Bid() ) && ( 0 != quote.Ask() ); };
+  static double Low( const Quote& quote ) { return quote.Bid(); };
+  static double High( const Quote& quote ) { return quote.Ask(); };
+  static double Close( const Quote& quote ) { return quote.Midpoint(); };
+  static boost::uint64_t Volume( const Quote& ) { return 0; };
+};
+
+template<> struct SummaryTraits<MarketDepth> {  // depth size is resting, not traded, so no volume
+  static bool Priced( const MarketDepth& ) { return true; };
+  static double Low( const MarketDepth& md ) { return md.Price(); };
+  static double High( const MarketDepth& md ) { return md.Price(); };
+  static double Close( const MarketDepth& md ) { return md.Price(); };
+  static boost::uint64_t Volume( const MarketDepth& ) { return 0; };
+};
+
+template<> struct SummaryTraits<Price> {
+  static bool Priced( const Price& ) { return true; };
+  static double Low( const Price& price ) { return price.Value(); };
+  static double High( const Price& price ) { return price.Value(); };
+  static double Close( const Price& price ) { return price.Value(); };
+  static boost::uint64_t Volume( const Price& ) { return 0; };
+};
+
+template<> struct SummaryTraits<PriceIV>: public SummaryTraits<Price> {};
+
+template<class DD>
+void AddToSummary( HDF5Attributes::structSummary& summary, const DD* begin, const DD* end ) {
+  typedef SummaryTraits<DD> traits_t;
+  typedef HDF5Attributes::structSummary summary_t;
+  if ( begin == end ) return;
+  if ( 0 == summary.nCount ) summary.dtFirst = begin->DateTime();
+  bool bPriced( 0 != summary.dblMaxPrice );
+  ptime dtDayBegin, dtDayEnd;  // the trailing day last added to, the day is only worked out when a datum leaves it
+  if ( 0 != summary.nDays ) {
+    dtDayBegin = ptime( boost::gregorian::date( summary.rDay[ summary.nDays - 1 ] ) );
+    dtDayEnd = dtDayBegin + boost::gregorian::days( 1 );
+  }
+  for ( const DD* pDatum = begin; end != pDatum; ++pDatum ) {
+    const DD& datum( *pDatum );
+    if ( traits_t::Priced( datum ) ) {
+      const double dblLow( traits_t::Low( datum ) );
+      const double dblHigh( traits_t::High( datum ) );
+      if ( !bPriced ) {
+        summary.dblMinPrice = dblLow;
+        summary.dblMaxPrice = dblHigh;
+        bPriced = true;
+      }
+      if ( dblLow < summary.dblMinPrice ) summary.dblMinPrice = dblLow;
+      if ( dblHigh > summary.dblMaxPrice ) summary.dblMaxPrice = dblHigh;
+      summary.dblClose = traits_t::Close( datum );
+    }
+    const boost::uint64_t nVolume( traits_t::Volume( datum ) );
+    summary.nVolume += nVolume;
+    const ptime& dt( datum.DateTime() );
+    if ( ( 0 == summary.nDays ) || ( dt < dtDayBegin ) || ( dt >= dtDayEnd ) ) {
+      const boost::gregorian::date day( dt.date() );
+      if ( summary_t::nTrailingDays == summary.nDays ) {  // oldest day drops off
+        std::copy( summary.rDay + 1, summary.rDay + summary.nDays, summary.rDay );
+        std::copy( summary.rDayVolume + 1, summary.rDayVolume + summary.nDays, summary.rDayVolume );
+        --summary.nDays;
+      }
+      summary.rDay[ summary.nDays ] = day.day_number();
+      summary.rDayVolume[ summary.nDays ] = 0;
+      ++summary.nDays;
+      dtDayBegin = ptime( day );
+      dtDayEnd = dtDayBegin + boost::gregorian::days( 1 );
+    }
+    summary.rDayVolume[ summary.nDays - 1 ] += nVolume;
+  }
+  summary.nCount += end - begin;
+  summary.dtLast = ( end - 1 )->DateTime();
+  boost::uint64_t nTrailing( 0 );
+  for ( boost::uint32_t ix = 0; ix < summary.nDays; ++ix ) nTrailing += summary.rDayVolume[ ix ];
+  summary.dblAverageVolume = (double) nTrailing / summary.nDays;
+}
+
+// called with the container the datums were just written through
+//   bWhole false: some of the datums were not written (a de-duplicating merge), so the dataset is read through
+template<class DD>
+void SummariseWrite( HDF5DataManager& dm, HDF5TimeSeriesContainer<DD>& repository, const std::string& sPathName, const DD* begin, const DD* end, bool bWhole = true ) {
+  HDF5Attributes attributes( dm, sPathName );
+  HDF5Attributes::structSummary summary;
+  if ( bWhole && ( repository.size() == (size_t) ( end - begin ) ) ) {  // the datums are the whole dataset, a new one usually
+    AddToSummary( summary, begin, end );
+  }
+  else if (
+       bWhole
+    && attributes.GetSummary( &summary )
+    && ( 0 != summary.nCount )
+    && ( summary.dtLast < begin->DateTime() )
+    && ( repository.size() == summary.nCount + ( end - begin ) ) ) {  // appended
+    AddToSummary( summary, begin, end );
+  }
+  else {
+    summary = HDF5Attributes::structSummary();
+    typename HDF5TimeSeriesContainer<DD>::iterator iterBegin, iterEnd;
+    const size_t nRemaining( repository.size() );
+    const size_t nBlock( std::max<size_t>( 4096, repository.ChunkSize() ) );
+    TimeSeries<DD> block;
+    size_t ix( 0 );
+    while ( ix < nRemaining ) {
+      const size_t n( std::min( nBlock, nRemaining - ix ) );
+      iterBegin = repository.begin();
+      iterBegin += ix;
+      iterEnd = iterBegin;
+      iterEnd += n;
+      block.Clear();
+      block.Resize( n );
+      repository.Read( iterBegin, iterEnd, &block );
+      AddToSummary( summary, block.First(), block.First() + n );
+      ix += n;
+    }
+  }
+  attributes.SetSummary( summary );
+}
+
+} // namespace tf
+} // namespace ou
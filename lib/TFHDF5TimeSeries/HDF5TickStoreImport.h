@@ -0,0 +1,129 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// copies hdf5 time series into the tick store (see TFTimeSeries/TickStore.h)
+//   a series is split by day (of its timestamps, utc) into the symbol's segments
+//   segments are appended to, so a day already imported is refused (its datums come before those in the segment)
+// HDF5TickStoreImport takes a group of recorded series, eg /app/recorder/20160104, and imports
+//   each of its quotes/, trades/, greeks/ and depths/ datasets, the dataset name being the symbol
+
+#include <string>
+#include <iostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <TFTimeSeries/TimeSeries.h>
+#include <TFTimeSeries/TickStore.h>
+
+#include "HDF5DataManager.h"
+#include "HDF5TimeSeriesContainer.h"
+#include "HDF5IterateGroups.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+// returns the datums copied
+template<class DD>
+boost::uint64_t ImportToTickStore( HDF5DataManager& dm, const std::string& sPath, const std::string& sRoot, const std::string& sSymbol ) {
+  HDF5TimeSeriesContainer<DD> repository( dm, sPath, false );  // read once, front to back, no cache needed
+  typename HDF5TimeSeriesContainer<DD>::iterator begin, end;
+  const size_t nRemaining( repository.end() - repository.begin() );
+  size_t nChunk( repository.ChunkSize() );
+  if ( 0 == nChunk ) nChunk = TickStore::nBlockDatums;
+  boost::scoped_ptr<TickStoreWriter<DD> > pWriter;
+  boost::gregorian::date day;
+  TimeSeries<DD> block;
+  size_t ix( 0 );
+  while ( ix < nRemaining ) {
+    const size_t n( std::min( nChunk - ( ix % nChunk ), nRemaining - ix ) );  // along chunk boundaries
+    begin = repository.begin();
+    begin += ix;
+    end = begin;
+    end += n;
+    block.Clear();
+    block.Resize( n );
+    repository.Read( begin, end, &block );
+    for ( size_t ixBlock = 0; ixBlock < n; ++ixBlock ) {
+      const DD& datum( block.At( ixBlock ) );
+      if ( ( 0 == pWriter.get() ) || ( datum.DateTime().date() != day ) ) {
+        day = datum.DateTime().date();
+        pWriter.reset();  // closes the previous day's segment
+        pWriter.reset( new TickStoreWriter<DD>( TickStore::SegmentPath<DD>( sRoot, sSymbol, day ) ) );
+      }
+      pWriter->Append( datum );
+    }
+    ix += n;
+  }
+  if ( 0 != pWriter.get() ) pWriter->Close();
+  return nRemaining;
+}
+
+class HDF5TickStoreImport {
+public:
+
+  explicit HDF5TickStoreImport( const std::string& sRoot ): m_sRoot( sRoot ), m_cntSeries( 0 ), m_cntDatums( 0 ), m_cntFailed( 0 ) {};
+
+  void Import( const std::string& sGroup ) {  // eg /app/recorder/20160104, without trailing /
+    HDF5DataManager dm( HDF5DataManager::RO );
+    Kind( dm, sGroup + "/quotes/", &HDF5TickStoreImport::HandleQuotes );
+    Kind( dm, sGroup + "/trades/", &HDF5TickStoreImport::HandleTrades );
+    Kind( dm, sGroup + "/greeks/", &HDF5TickStoreImport::HandleGreeks );
+    Kind( dm, sGroup + "/depths/", &HDF5TickStoreImport::HandleDepths );
+  };
+
+  size_t GetSeriesCount( void ) const { return m_cntSeries; };
+  boost::uint64_t GetDatumCount( void ) const { return m_cntDatums; };
+  size_t GetFailedCount( void ) const { return m_cntFailed; };
+
+protected:
+private:
+
+  std::string m_sRoot;
+  size_t m_cntSeries;
+  boost::uint64_t m_cntDatums;
+  size_t m_cntFailed;
+
+  void Kind( HDF5DataManager& dm, const std::string& sGroup, void (HDF5TickStoreImport::*handler)( const std::string&, const std::string& ) ) {
+    if ( dm.GroupExists( sGroup ) ) {
+      HDF5IterateGroups control;
+      control.SetOnHandleObject( MakeDelegate( this, handler ) );
+      control.Start( sGroup );
+    }
+  };
+
+  template<class DD>
+  void Series( const std::string& sObjectPath, const std::string& sObjectName ) {
+    try {
+      HDF5DataManager dm( HDF5DataManager::RO );
+      m_cntDatums += ImportToTickStore<DD>( dm, sObjectPath, m_sRoot, sObjectName );
+      ++m_cntSeries;
+    }
+    catch ( std::runtime_error& e ) {
+      ++m_cntFailed;
+      std::cout << "HDF5TickStoreImport " << sObjectPath << ": " << e.what() << std::endl;
+    }
+  };
+
+  void HandleQuotes( const std::string& sObjectPath, const std::string& sObjectName ) { Series<Quote>( sObjectPath, sObjectName ); };
+  void HandleTrades( const std::string& sObjectPath, const std::string& sObjectName ) { Series<Trade>( sObjectPath, sObjectName ); };
+  void HandleGreeks( const std::string& sObjectPath, const std::string& sObjectName ) { Series<Greek>( sObjectPath, sObjectName ); };
+  void HandleDepths( const std::string& sObjectPath, const std::string& sObjectName ) { Series<MarketDepth>( sObjectPath, sObjectName ); };
+
+};
+
+} // namespace tf
+} // namespace ou
@@ -16,6 +16,8 @@
 
 #include <string>
 
+#include <boost/thread/once.hpp>
+
 #include <TFTimeSeries/DatedDatum.h>
 
 #include "HDF5DataManager.h"
@@ -31,22 +33,32 @@ namespace tf { // TradeFrame
 // class DD needs to be composed from the CDatedDatum class for access to ptime element
 template<class DD> class HDF5TimeSeriesAccessor {
 public:
-  explicit HDF5TimeSeriesAccessor<DD>( HDF5DataManager& dm, const std::string &sPathName );
+  // bCacheChunks false: no chunk cache for the dataset, for sequential reads of many datasets at once, see ChunkSize
+  explicit HDF5TimeSeriesAccessor<DD>( HDF5DataManager& dm, const std::string &sPathName, bool bCacheChunks = true );
   virtual ~HDF5TimeSeriesAccessor<DD>( void );
   typedef hsize_t size_type;
   size_type size() const { return m_curElementCount; };
+  size_type ChunkSize() const { return m_nChunkSize; };  // elements per chunk, 0 when not chunked
   void Read( hsize_t index, DD* );
   void Read( hsize_t ixStart, hsize_t count, H5::DataSpace *pMemoryDataSpace, DD* pDatedDatum );
   void Write( hsize_t ixStart, size_t count, const DD* );
+  // DD::DefineDataType, built once on first use and kept for the life of the process, rather than on each read and write
+  //   its id belongs to the library as first opened, closing hdf5 (H5close, H5::H5Library::close) and using it again in the process
+  //   is not supported, the id would be stale, as would HDF5DataManager::Transfer's property lists
+  static const H5::CompType& DataType( void );
 protected:
   std::string m_sPathName;
   H5::DataSet* m_pDiskDataSet;
   H5::CompType* m_pDiskCompType;
   size_type m_curElementCount, m_maxElementCount;
+  size_type m_nChunkSize;
   virtual void SetNewSize( size_type size ) {};
   void UpdateElementCount( void );
 private:
   HDF5DataManager& m_dm;
+  static const H5::CompType* m_pDataType;  // not deleted, hdf5 may be closed by then, see DataType
+  static boost::once_flag m_flagDataType;
+  static void BuildDataType( void ) { m_pDataType = DD::DefineDataType( NULL ); };
   HDF5TimeSeriesAccessor( const HDF5TimeSeriesAccessor& ); // copy constructor not implemented
   HDF5TimeSeriesAccessor& operator=( const HDF5TimeSeriesAccessor& ); // assignment constructor not implemented
 };
@@ -60,21 +72,38 @@ template<class DD> void HDF5TimeSeriesAccessor<DD>::UpdateElementCount( void ) {
   SetNewSize( m_curElementCount );
 }
 
-template<class DD> HDF5TimeSeriesAccessor<DD>::HDF5TimeSeriesAccessor( HDF5DataManager& dm, const std::string &sPathName):
-  m_dm( dm ),
-  m_sPathName( sPathName ) {
+template<class DD> const H5::CompType* HDF5TimeSeriesAccessor<DD>::m_pDataType = NULL;
+template<class DD> boost::once_flag HDF5TimeSeriesAccessor<DD>::m_flagDataType = BOOST_ONCE_INIT;
+
+template<class DD> const H5::CompType& HDF5TimeSeriesAccessor<DD>::DataType( void ) {
+  boost::call_once( m_flagDataType, &HDF5TimeSeriesAccessor<DD>::BuildDataType );  // readers may be on several threads, see HDF5Partitions.h
+  return *m_pDataType;
+}
+
+template<class DD> HDF5TimeSeriesAccessor<DD>::HDF5TimeSeriesAccessor( HDF5DataManager& dm, const std::string &sPathName, bool bCacheChunks ):
+  m_sPathName( sPathName ), m_nChunkSize( 0 ),
+  m_dm( dm ) {
 
   try {
-    m_pDiskDataSet = new H5::DataSet( m_dm.GetH5File()->openDataSet( m_sPathName.c_str() ) );
+    H5::DSetAccPropList pla;
+    if ( !bCacheChunks ) {
+      pla.setChunkCache( 0, 0, 1.0 );  // each read decompresses the chunks it touches, nothing is held between reads
+    }
+    m_pDiskDataSet = new H5::DataSet( m_dm.GetH5File()->openDataSet( m_sPathName.c_str(), pla ) );
     m_pDiskCompType = new H5::CompType( *m_pDiskDataSet );
 
-    H5::CompType *pMemCompType = DD::DefineDataType( NULL );
-    if ( ( pMemCompType->getNmembers() != m_pDiskCompType->getNmembers() ) ) { // can't do size as drive datatypes are packed, need instead to check member names
+    if ( ( DataType().getNmembers() != m_pDiskCompType->getNmembers() ) ) { // can't do size as drive datatypes are packed, need instead to check member names
       //|| ( pMemCompType->getSize()     != m_pDiskCompType->getSize() ) ) { // works as Quote, Trade, Bar  have different member count (but MarketDepth has same count as Quote
       throw std::runtime_error( "HDF5TimeSeriesAccessor<DD>::HDF5TimeSeriesAccessor CompType doesn't match" );
     }
-    pMemCompType->close();
-    delete pMemCompType;
+
+    H5::DSetCreatPropList plc( m_pDiskDataSet->getCreatePlist() );
+    if ( H5D_CHUNKED == plc.getLayout() ) {
+      hsize_t dim;
+      plc.getChunk( 1, &dim );
+      m_nChunkSize = dim;
+    }
+    plc.close();
 
     UpdateElementCount();
   }
@@ -105,24 +134,19 @@ template<class DD> void HDF5TimeSeriesAccessor<DD>::Read( hsize_t ixSource, DD*
     hsize_t coord1[] = { ixSource };  // index on disk
     hsize_t coord2[] = { 0 };      // only one item in memory
     try {
-      H5::CompType *pComp = pDatedDatum->DefineDataType();
-
       H5::DataSpace MemoryDataspace(1, &dim ); // create one element dataspace to get requested element of dataset
       MemoryDataspace.selectElements( H5S_SELECT_SET, 1, coord2 );
 
       H5::DataSpace *pDiskDataSpaceSelection = new H5::DataSpace( m_pDiskDataSet->getSpace() );
       pDiskDataSpaceSelection->selectElements( H5S_SELECT_SET, 1, coord1 );
 
-      m_pDiskDataSet->read( pDatedDatum, *pComp, MemoryDataspace, *pDiskDataSpaceSelection );
+      m_pDiskDataSet->read( pDatedDatum, DataType(), MemoryDataspace, *pDiskDataSpaceSelection, HDF5DataManager::Transfer() );
 
       pDiskDataSpaceSelection->close();
       delete pDiskDataSpaceSelection;
 
       MemoryDataspace.close();
 
-      pComp->close();
-      delete pComp;
-
       //cout << "read from index " << ixSource << endl;
     }
     catch ( H5::Exception e ) {
@@ -142,18 +166,7 @@ template <class DD> void HDF5TimeSeriesAccessor<DD>::Read( hsize_t ixStart, hsiz
       H5::DataSpace *pDiskDataSpaceSelection = new H5::DataSpace( m_pDiskDataSet->getSpace() );
       pDiskDataSpaceSelection->selectHyperslab( H5S_SELECT_SET, &dim[0], &ixStart, 0, 0 );
 
-      H5::DSetMemXferPropList pl;
-      bool b = pl.getPreserve();
-      pl.setPreserve( true );
-
-      H5::CompType *pComp = pDatedDatum->DefineDataType();
-
-      m_pDiskDataSet->read( pDatedDatum, *pComp, *pMemoryDataSpace, *pDiskDataSpaceSelection, pl );
-
-      pComp->close();
-      delete pComp;
-
-      pl.close();
+      m_pDiskDataSet->read( pDatedDatum, DataType(), *pMemoryDataSpace, *pDiskDataSpaceSelection, HDF5DataManager::Transfer() );  // preserves
 
       pDiskDataSpaceSelection->close();
       delete pDiskDataSpaceSelection;
@@ -174,8 +187,6 @@ template<class DD> void HDF5TimeSeriesAccessor<DD>::Write( hsize_t ixStart, size
     hsize_t oldElementCount = m_curElementCount;  // keep for later comparison
     hsize_t dim[] = { count };
     try {
-      H5::CompType *pComp = pDatedDatum->DefineDataType();
-
       H5::DataSpace MemoryDataspace(1, dim ); // rank, dimensions
       MemoryDataspace.selectAll();
 
@@ -188,16 +199,13 @@ template<class DD> void HDF5TimeSeriesAccessor<DD>::Write( hsize_t ixStart, size
       H5::DataSpace *pDiskDataSpaceSelection = new H5::DataSpace( m_pDiskDataSet->getSpace() );
       pDiskDataSpaceSelection->selectHyperslab( H5S_SELECT_SET, &dim[0], &ixStart, 0, 0 );
 
-      m_pDiskDataSet->write( pDatedDatum, *pComp, MemoryDataspace, *pDiskDataSpaceSelection );
+      m_pDiskDataSet->write( pDatedDatum, DataType(), MemoryDataspace, *pDiskDataSpaceSelection, HDF5DataManager::Transfer() );
 
       pDiskDataSpaceSelection->close();
       delete pDiskDataSpaceSelection;
 
       MemoryDataspace.close();
 
-      pComp->close();
-      delete pComp;
-
       if ( m_curElementCount == oldElementCount ) {
         //cout << "Dataset did not expand" << endl;
       }
@@ -15,6 +15,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <functional>
 
 #include <OUCommon/Delegate.h>
 
@@ -31,7 +35,7 @@ namespace tf { // TradeFrame
 // DD is expecting type derived from DatedDatum
 template<class DD> class HDF5TimeSeriesContainer: public HDF5TimeSeriesAccessor<DD> {
 public:
-  HDF5TimeSeriesContainer<DD>( HDF5DataManager& dm, const std::string& sPathName );
+  HDF5TimeSeriesContainer<DD>( HDF5DataManager& dm, const std::string& sPathName, bool bCacheChunks = true );
   virtual ~HDF5TimeSeriesContainer<DD>( void );
   //typedef HDF5TimeSeriesIterator<T> const_iterator;
   typedef HDF5TimeSeriesIterator<DD> iterator;
@@ -41,14 +45,35 @@ public:
   //void Read( const iterator &_begin, const iterator &_end, T* _dest ); 
   void Read( iterator &_begin, iterator &_end, typename ou::tf::TimeSeries<DD>* _dest ); 
   void Write( const DD* _begin, const DD* _end );
+  // datums in time order are merged with those in the dataset, which stays in time order, existing datums first on equal times:
+  //   a batch after the last datum is appended, otherwise the datums from the first overlapped one are rewritten back to front,
+  //   nBlock at a time (0: the larger of 64k and the chunk size), so a near tail is one read and one write, a deep one is bounded in memory
+  // bDeduplicate: a datum equal in time and every member to one in the dataset, or an earlier one in the batch, is not written
+  void Merge( const DD* _begin, const DD* _end, bool bDeduplicate = false, size_type nBlock = 0 );
 protected:
   iterator* m_end;
   virtual void SetNewSize( size_type newsize );
 private:
+
+  class Duplicates {  // the datums at the latest time merged, compared member by member as DD::DefineDataType lays them out
+  public:
+    Duplicates( void );
+    void Existing( const DD& datum ) { Advance( datum ); m_vDatum.push_back( datum ); };
+    bool Keep( const DD& datum );  // false when a match is already at that time
+  private:
+    typedef std::pair<size_t,size_t> member_t;  // offset, size
+    std::vector<member_t> m_vMember;
+    std::vector<DD> m_vDatum;
+    void Advance( const DD& datum ) { if ( !m_vDatum.empty() && ( m_vDatum.back() != datum ) ) m_vDatum.clear(); };
+  };
+
+  void ReadBlock( size_type ixStart, std::vector<DD>& v );  // v.size() datums
+  void WriteBlock( size_type ixStart, const std::vector<DD>& v, size_t ixBegin, size_t ixEnd );
+
 };
 
-template<class DD> HDF5TimeSeriesContainer<DD>::HDF5TimeSeriesContainer( HDF5DataManager& dm, const std::string& sPathName ):
-  HDF5TimeSeriesAccessor<DD>( dm, sPathName ) {
+template<class DD> HDF5TimeSeriesContainer<DD>::HDF5TimeSeriesContainer( HDF5DataManager& dm, const std::string& sPathName, bool bCacheChunks ):
+  HDF5TimeSeriesAccessor<DD>( dm, sPathName, bCacheChunks ) {
     m_end = new iterator( this, this->size() );
 }
 
@@ -95,5 +120,152 @@ template<class DD> void HDF5TimeSeriesContainer<DD>::Write( const DD* _begin, co
   }
 }
 
+template<class DD> HDF5TimeSeriesContainer<DD>::Duplicates::Duplicates( void ) {
+  const H5::CompType& comp( HDF5TimeSeriesAccessor<DD>::DataType() );
+  for ( int ix = 0; ix < comp.getNmembers(); ++ix ) {
+    H5::DataType type( comp.getMemberDataType( ix ) );
+    m_vMember.push_back( member_t( comp.getMemberOffset( ix ), type.getSize() ) );
+    type.close();
+  }
+}
+
+template<class DD> bool HDF5TimeSeriesContainer<DD>::Duplicates::Keep( const DD& datum ) {
+  Advance( datum );
+  for ( typename std::vector<DD>::const_iterator iter = m_vDatum.begin(); m_vDatum.end() != iter; ++iter ) {
+    bool bMatch( true );
+    for ( std::vector<member_t>::const_iterator iterMember = m_vMember.begin(); bMatch && ( m_vMember.end() != iterMember ); ++iterMember ) {
+      bMatch = 0 == std::memcmp(
+        reinterpret_cast<const char*>( &*iter ) + iterMember->first, reinterpret_cast<const char*>( &datum ) + iterMember->first, iterMember->second );
+    }
+    if ( bMatch ) return false;
+  }
+  m_vDatum.push_back( datum );
+  return true;
+}
+
+template<class DD> void HDF5TimeSeriesContainer<DD>::ReadBlock( size_type ixStart, std::vector<DD>& v ) {
+  hsize_t dim = v.size();
+  H5::DataSpace ds( 1, &dim );
+  HDF5TimeSeriesAccessor<DD>::Read( ixStart, v.size(), &ds, &v[ 0 ] );
+  ds.close();
+}
+
+template<class DD> void HDF5TimeSeriesContainer<DD>::WriteBlock( size_type ixStart, const std::vector<DD>& v, size_t ixBegin, size_t ixEnd ) {
+  if ( ixBegin < ixEnd ) {
+    HDF5TimeSeriesAccessor<DD>::Write( ixStart, ixEnd - ixBegin, &v[ ixBegin ] );
+  }
+}
+
+template<class DD> void HDF5TimeSeriesContainer<DD>::Merge( const DD* _begin, const DD* _end, bool bDeduplicate, size_type nBlock ) {
+
+  if ( _begin == _end ) return;
+  assert( _end == std::adjacent_find( _begin, _end, std::greater<DD>() ) );  // batch in time order
+
+  const size_type nExisting( this->size() );
+  if ( 0 == nBlock ) nBlock = std::max<size_type>( 65536, this->ChunkSize() );
+
+  // the first datum on disk at or after the batch, datums before it are untouched
+  size_type ixFirst( nExisting );
+  if ( 0 != nExisting ) {
+    DD last;
+    HDF5TimeSeriesAccessor<DD>::Read( nExisting - 1, &last );
+    if ( !( last < *_begin ) ) {
+      ixFirst = std::lower_bound( begin(), end(), *_begin ).m_ItemIndex;
+    }
+  }
+
+  // which of the batch are written: in time order against the datums on disk from ixFirst
+  std::vector<bool> vKeep;
+  size_t nKeep( _end - _begin );
+  std::vector<DD> vTail;  // holds all of a tail which fits a block, read once for both passes
+  if ( nBlock >= ( nExisting - ixFirst ) ) {
+    vTail.resize( nExisting - ixFirst );
+    if ( !vTail.empty() ) ReadBlock( ixFirst, vTail );
+  }
+  if ( bDeduplicate ) {
+    Duplicates duplicates;
+    vKeep.resize( nKeep );
+    std::vector<DD> v;
+    const DD* pDatum( _begin );
+    size_type ixDisk( ixFirst );
+    while ( ixDisk < nExisting ) {
+      const std::vector<DD>* pv( &vTail );
+      if ( vTail.empty() ) {
+        v.resize( std::min<size_type>( nBlock, nExisting - ixDisk ) );
+        ReadBlock( ixDisk, v );
+        pv = &v;
+      }
+      for ( typename std::vector<DD>::const_iterator iter = pv->begin(); pv->end() != iter; ++iter ) {
+        for ( ; ( _end != pDatum ) && ( *pDatum < *iter ); ++pDatum ) {
+          vKeep[ pDatum - _begin ] = duplicates.Keep( *pDatum );
+        }
+        duplicates.Existing( *iter );
+      }
+      ixDisk += pv->size();
+    }
+    for ( ; _end != pDatum; ++pDatum ) {
+      vKeep[ pDatum - _begin ] = duplicates.Keep( *pDatum );
+    }
+    nKeep = std::count( vKeep.begin(), vKeep.end(), true );
+  }
+  if ( 0 == nKeep ) return;
+
+  if ( nExisting == ixFirst ) {  // append
+    if ( bDeduplicate ) {
+      std::vector<DD> v;
+      v.reserve( nKeep );
+      for ( const DD* pDatum = _begin; _end != pDatum; ++pDatum ) {
+        if ( vKeep[ pDatum - _begin ] ) v.push_back( *pDatum );
+      }
+      WriteBlock( nExisting, v, 0, v.size() );
+    }
+    else {
+      HDF5TimeSeriesAccessor<DD>::Write( nExisting, nKeep, _begin );
+    }
+    return;
+  }
+
+  // rewrite from the end back, the write position stays at or beyond the datums on disk not yet read
+  hsize_t newsize[] = { nExisting + nKeep };
+  this->m_pDiskDataSet->extend( newsize );
+  this->UpdateElementCount();
+
+  std::vector<DD> vIn;  // a block of the tail read from ixRead, consumed from the back
+  std::vector<DD>& vDisk( vTail.empty() ? vIn : vTail );
+  size_type ixRead( nExisting );  // disk datums from ixFirst to here are unread
+  size_t nIn( vTail.size() );  // unconsumed in vDisk
+  if ( 0 != nIn ) ixRead = ixFirst;
+  size_type ixWrite( nExisting + nKeep );
+  std::vector<DD> vOut( std::min<size_type>( nBlock, nExisting + nKeep - ixFirst ) );
+  size_t ixOut( vOut.size() );  // filled from the back
+  const DD* pDatum( _end );
+  while ( _begin != pDatum ) {
+    if ( bDeduplicate && !vKeep[ pDatum - 1 - _begin ] ) {
+      --pDatum;
+      continue;
+    }
+    if ( ( 0 == nIn ) && ( ixFirst < ixRead ) ) {
+      const size_type n( std::min<size_type>( nBlock, ixRead - ixFirst ) );
+      ixRead -= n;
+      vIn.resize( n );
+      ReadBlock( ixRead, vIn );
+      nIn = n;
+    }
+    if ( 0 == ixOut ) {
+      ixWrite -= vOut.size();
+      WriteBlock( ixWrite, vOut, 0, vOut.size() );
+      ixOut = vOut.size();
+    }
+    if ( ( 0 == nIn ) || !( *( pDatum - 1 ) < vDisk[ nIn - 1 ] ) ) {  // batch datum goes after those on disk at the same time
+      vOut[ --ixOut ] = *( --pDatum );
+    }
+    else {
+      vOut[ --ixOut ] = vDisk[ --nIn ];
+    }
+  }
+  // what remains on disk, and buffered, is already in place
+  WriteBlock( ixWrite - ( vOut.size() - ixOut ), vOut, ixOut, vOut.size() );
+}
+
 } // namespace tf
 } // namespace ou
@@ -18,6 +18,10 @@
 #include <stdexcept>
 
 #include "HDF5TimeSeriesContainer.h"
+#include "HDF5Summary.h"
+#include "HDF5Catalog.h"
+#include "HDF5PathIndex.h"
+#include "HDF5Filter.h"
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
@@ -30,8 +34,10 @@ public:
 
   HDF5WriteTimeSeries<TS>( HDF5DataManager& dm );  // dm needs to be read/write
   HDF5WriteTimeSeries<TS>( HDF5DataManager& dm, bool bDeflatable, bool bExpandable, int nDeflate = 5, hsize_t nChunkSize = 1024 );
+  HDF5WriteTimeSeries<TS>( HDF5DataManager& dm, HDF5Filter::ECodec codec, int nLevel = 0, hsize_t nChunkSize = 0 );  // expandable, see HDF5Filter.h, chunk size 0: by datum size
   virtual ~HDF5WriteTimeSeries<TS>( void );
   void Write( const std::string &sPathName, TS* timeseries );
+  void Merge( const std::string &sPathName, TS* timeseries, bool bDeduplicate = false );  // see HDF5TimeSeriesContainer::Merge, for backfills
 
 protected:
 private:
@@ -40,24 +46,40 @@ private:
   int m_nDeflate;
   bool m_bExpandable;
   hsize_t m_nChunkSize;
+  HDF5Filter::ECodec m_codec;
+  int m_nLevel;
+  void Write( const std::string &sPathName, TS* timeseries, bool bMerge, bool bDeduplicate );
 };
 
 template<class TS> HDF5WriteTimeSeries<TS>::HDF5WriteTimeSeries( HDF5DataManager& dm ) 
-: m_dm( dm ), m_bDeflatable( false ), m_bExpandable( false ), m_nDeflate( 0 ), m_nChunkSize( 0 )
+: m_dm( dm ), m_bDeflatable( false ), m_nDeflate( 0 ), m_bExpandable( false ), m_nChunkSize( 0 ), m_codec( HDF5Filter::None ), m_nLevel( 0 )
 {
 }
 
 template<class TS> HDF5WriteTimeSeries<TS>::HDF5WriteTimeSeries( HDF5DataManager& dm, bool bDeflatable, bool bExpandable, int nDeflate, hsize_t nChunkSize )
-: m_dm( dm ), m_bDeflatable( bDeflatable ), m_bExpandable( bExpandable ), m_nDeflate( nDeflate ), m_nChunkSize( nChunkSize )
+: m_dm( dm ), m_bDeflatable( bDeflatable ), m_nDeflate( nDeflate ), m_bExpandable( bExpandable ), m_nChunkSize( nChunkSize ), m_codec( HDF5Filter::None ), m_nLevel( 0 )
 {
   if ( bDeflatable ) assert( 0 < nDeflate );
   if ( bExpandable ) assert( 0 < nChunkSize );
 }
 
+template<class TS> HDF5WriteTimeSeries<TS>::HDF5WriteTimeSeries( HDF5DataManager& dm, HDF5Filter::ECodec codec, int nLevel, hsize_t nChunkSize )
+: m_dm( dm ), m_bDeflatable( false ), m_nDeflate( 0 ), m_bExpandable( true ), m_nChunkSize( nChunkSize ), m_codec( codec ), m_nLevel( nLevel )
+{
+}
+
 template<class TS> HDF5WriteTimeSeries<TS>::~HDF5WriteTimeSeries() {
 }
 
 template<class TS> void HDF5WriteTimeSeries<TS>::Write(const std::string &sPathName, TS* timeseries) {
+  Write( sPathName, timeseries, false, false );
+}
+
+template<class TS> void HDF5WriteTimeSeries<TS>::Merge( const std::string &sPathName, TS* timeseries, bool bDeduplicate ) {
+  Write( sPathName, timeseries, true, bDeduplicate );
+}
+
+template<class TS> void HDF5WriteTimeSeries<TS>::Write( const std::string &sPathName, TS* timeseries, bool bMerge, bool bDeduplicate ) {
 
   if ( 0 == timeseries->Size() ) {
     throw std::invalid_argument( "zero length time series found" );
@@ -97,12 +119,16 @@ template<class TS> void HDF5WriteTimeSeries<TS>::Write(const std::string &sPathN
       H5::DSetCreatPropList pl;
       //hsize_t sizeChunk = HDF5DataManager::H5ChunkSize();
       if ( m_bExpandable ) {
-        pl.setChunk( 1, &m_nChunkSize );
+        const hsize_t nChunkSize( ( 0 == m_nChunkSize ) ? HDF5Filter::ChunkSize( pdt->getSize() ) : m_nChunkSize );
+        pl.setChunk( 1, &nChunkSize );
       }
       if ( m_bDeflatable ) {
         pl.setShuffle();
         pl.setDeflate(m_nDeflate);
       }
+      if ( HDF5Filter::None != m_codec ) {
+        HDF5Filter::Set( pl, *pdt, m_codec, m_nLevel );
+      }
 
       dataset = new H5::DataSet( m_dm.GetH5File()->createDataSet( sPathName, *pdt, *pds, pl ) );
       dataset->close();
@@ -124,7 +150,23 @@ template<class TS> void HDF5WriteTimeSeries<TS>::Write(const std::string &sPathN
 
   try {
     HDF5TimeSeriesContainer<DD> repository( m_dm, sPathName );
-    repository.Write( timeseries->First(), timeseries->Last() + 1 );
+    bool bWhole( true );
+    if ( bMerge ) {
+      const hsize_t nBefore( repository.size() );
+      repository.Merge( timeseries->First(), timeseries->Last() + 1, bDeduplicate );
+      bWhole = ( repository.size() - nBefore ) == timeseries->Size();
+    }
+    else {
+      repository.Write( timeseries->First(), timeseries->Last() + 1 );
+    }
+    SummariseWrite<DD>( m_dm, repository, sPathName, timeseries->First(), timeseries->Last() + 1, bWhole );  // see HDF5Summary.h
+    HDF5Catalog::Touch( m_dm );
+    if ( HDF5PathIndex::Indexed( m_dm ) ) {  // see HDF5PathIndex.h, without an index the end datums aren't read
+      DD first, last;
+      repository.HDF5TimeSeriesAccessor<DD>::Read( 0, &first );
+      repository.HDF5TimeSeriesAccessor<DD>::Read( repository.size() - 1, &last );
+      HDF5PathIndex::Journal( m_dm, sPathName, DD::Signature(), repository.size(), first.DateTime(), last.DateTime() );
+    }
     //dm.AddGroupForSymbol( m_sSymbol );
     //dm.GetH5File()->link( H5L_type_t::H5L_TYPE_HARD, sFileName1, "/symbol/" + m_sSymbol + "/bar.86400" );
   }
@@ -132,6 +174,10 @@ template<class TS> void HDF5WriteTimeSeries<TS>::Write(const std::string &sPathN
     std::cout << "H5::FileIException " << e.getDetailMsg() << std::endl;
     e.walkErrorStack( H5E_WALK_DOWNWARD, (H5E_walk2_t) &HDF5DataManager::PrintH5ErrorStackItem, this );
   }
+  catch ( H5::Exception& e ) {  // summary attribute
+    std::cout << "H5::Exception " << e.getDetailMsg() << std::endl;
+    e.walkErrorStack( H5E_WALK_DOWNWARD, (H5E_walk2_t) &HDF5DataManager::PrintH5ErrorStackItem, this );
+  }
   catch ( ... ) {
     std::cout << "CHistoryCollectorDaily::WriteData:  unknown error 2" << std::endl;
   }
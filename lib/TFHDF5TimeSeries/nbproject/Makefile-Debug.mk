@@ -36,7 +36,12 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 # Object Files
 OBJECTFILES= \
 	${OBJECTDIR}/HDF5Attribute.o \
-	${OBJECTDIR}/HDF5DataManager.o
+	${OBJECTDIR}/HDF5BarRollup.o \
+	${OBJECTDIR}/HDF5Catalog.o \
+	${OBJECTDIR}/HDF5DataManager.o \
+	${OBJECTDIR}/HDF5Filter.o \
+	${OBJECTDIR}/HDF5Partitions.o \
+	${OBJECTDIR}/HDF5PathIndex.o
 
 
 # C Compiler Flags
@@ -70,11 +75,36 @@ ${OBJECTDIR}/HDF5Attribute.o: HDF5Attribute.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HDF5Attribute.o HDF5Attribute.cpp
 
+${OBJECTDIR}/HDF5BarRollup.o: HDF5BarRollup.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HDF5BarRollup.o HDF5BarRollup.cpp
+
+${OBJECTDIR}/HDF5Catalog.o: HDF5Catalog.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HDF5Catalog.o HDF5Catalog.cpp
+
 ${OBJECTDIR}/HDF5DataManager.o: HDF5DataManager.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HDF5DataManager.o HDF5DataManager.cpp
 
+${OBJECTDIR}/HDF5Filter.o: HDF5Filter.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HDF5Filter.o HDF5Filter.cpp
+
+${OBJECTDIR}/HDF5Partitions.o: HDF5Partitions.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HDF5Partitions.o HDF5Partitions.cpp
+
+${OBJECTDIR}/HDF5PathIndex.o: HDF5PathIndex.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/HDF5PathIndex.o HDF5PathIndex.cpp
+
 # Subprojects
 .build-subprojects:
 
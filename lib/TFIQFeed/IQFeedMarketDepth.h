@@ -0,0 +1,124 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// level 2 port: market maker quotes arrive as Z (update) and 2 (summary) messages
+// same CRTP arrangement as IQFeed<T>, watches are "w<symbol>", removals "r<symbol>"
+
+#include <string>
+
+#include <boost/assert.hpp>
+
+#include <OUCommon/Network.h>
+#include <OUCommon/ReusableBuffers.h>
+
+#include "IQFeedMessages.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+template <typename T>
+class IQFeedMarketDepth: public ou::Network<IQFeedMarketDepth<T> > {
+  friend ou::Network<IQFeedMarketDepth<T> >;
+public:
+
+  typedef typename ou::Network<IQFeedMarketDepth<T> > inherited_t;
+  typedef typename inherited_t::linebuffer_t linebuffer_t;
+
+  IQFeedMarketDepth( void );
+  ~IQFeedMarketDepth( void );
+
+  void WatchDepth( const std::string& sSymbol ) { inherited_t::Send( "w" + sSymbol + "\n" ); };
+  void UnWatchDepth( const std::string& sSymbol ) { inherited_t::Send( "r" + sSymbol + "\n" ); };
+
+  // linebuffer_t needs to be kept with msg as there are dynamic accesses from it
+  void inline MarketDepthDone( linebuffer_t* p, IQFMarketDepthMessage* msg ) {
+    this->GiveBackBuffer( p );
+    m_reposMarketDepthMessages.CheckInL( msg );
+  }
+
+protected:
+
+  // called by Network via CRTP
+  void OnNetworkConnected(void) {
+    if ( &IQFeedMarketDepth<T>::OnIQFeedMarketDepthConnected != &T::OnIQFeedMarketDepthConnected ) {
+      static_cast<T*>( this )->OnIQFeedMarketDepthConnected();
+    }
+  };
+  void OnNetworkDisconnected(void) {
+    if ( &IQFeedMarketDepth<T>::OnIQFeedMarketDepthDisConnected != &T::OnIQFeedMarketDepthDisConnected ) {
+      static_cast<T*>( this )->OnIQFeedMarketDepthDisConnected();
+    }
+  };
+  void OnNetworkError( size_t e ) {
+    if ( &IQFeedMarketDepth<T>::OnIQFeedMarketDepthError != &T::OnIQFeedMarketDepthError ) {
+      static_cast<T*>( this )->OnIQFeedMarketDepthError( e );
+    }
+  };
+  void OnNetworkLineBuffer( linebuffer_t* );  // new line available for processing
+
+  // CRTP based dummy callbacks
+  void OnIQFeedMarketDepthConnected( void ) {};
+  void OnIQFeedMarketDepthDisConnected( void ) {};
+  void OnIQFeedMarketDepthError( size_t ) {};
+  void OnIQFeedMarketDepthMessage( linebuffer_t*, IQFMarketDepthMessage* ) {};
+
+private:
+
+  typename ou::BufferRepository<IQFMarketDepthMessage> m_reposMarketDepthMessages;
+
+};
+
+template <typename T>
+IQFeedMarketDepth<T>::IQFeedMarketDepth( void )
+: ou::Network<IQFeedMarketDepth<T> >( "127.0.0.1", 9200 )
+{
+}
+
+template <typename T>
+IQFeedMarketDepth<T>::~IQFeedMarketDepth( void ) {
+}
+
+template <typename T>
+void IQFeedMarketDepth<T>::OnNetworkLineBuffer( linebuffer_t* pBuffer ) {
+
+  typename linebuffer_t::iterator iter = (*pBuffer).begin();
+  typename linebuffer_t::iterator end = (*pBuffer).end();
+
+  BOOST_ASSERT( iter != end );
+
+  switch ( *iter ) {
+    case 'Z':
+    case '2':
+      {
+        IQFMarketDepthMessage* msg = m_reposMarketDepthMessages.CheckOutL();
+        msg->Assign( iter, end );
+        if ( &IQFeedMarketDepth<T>::OnIQFeedMarketDepthMessage != &T::OnIQFeedMarketDepthMessage ) {
+          static_cast<T*>( this )->OnIQFeedMarketDepthMessage( pBuffer, msg );
+        }
+        else {
+          MarketDepthDone( pBuffer, msg );
+        }
+      }
+      break;
+    default:  // time stamps, system, symbol not found, errors:  nothing needed from them here
+      this->GiveBackBuffer( pBuffer );
+      break;
+  }
+
+}
+
+} // namespace tf
+} // namespace ou
@@ -62,6 +62,21 @@ IQFNewsMessage::IQFNewsMessage( iterator_t& current, iterator_t& end )
 IQFNewsMessage::~IQFNewsMessage() {
 }
 
+//**** IQFMarketDepthMessage
+
+IQFMarketDepthMessage::IQFMarketDepthMessage( void ) 
+: IQFBaseMessage<IQFMarketDepthMessage>()
+{
+}
+
+IQFMarketDepthMessage::IQFMarketDepthMessage( iterator_t& current, iterator_t& end ) 
+: IQFBaseMessage<IQFMarketDepthMessage>( current, end )
+{
+}
+
+IQFMarketDepthMessage::~IQFMarketDepthMessage() {
+}
+
 //**** IQFFundamentalMessage
 // resize the vector to accept with out resizing so often?
 
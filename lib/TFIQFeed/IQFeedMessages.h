@@ -314,6 +314,40 @@ public:
 private:
 };
 
+//**** IQFMarketDepthMessage
+class IQFMarketDepthMessage: public IQFBaseMessage<IQFMarketDepthMessage> { // Z, 2 on the level 2 port
+public:
+
+  enum enumFieldIds {
+    MDSymbol = 2,
+    MDMMID,
+    MDBid,
+    MDAsk,
+    MDBidSize,
+    MDAskSize,
+    MDBidTime,
+    MDDate,
+    MDConditionCode,
+    MDAskTime,
+    MDBidInfoValid,
+    MDAskInfoValid,
+    _MDLastEntry
+  };
+
+  IQFMarketDepthMessage( void );
+  IQFMarketDepthMessage( iterator_t& current, iterator_t& end );
+  ~IQFMarketDepthMessage(void);
+
+  bool BidInfoValid( void ) const { return Flag( MDBidInfoValid ); };
+  bool AskInfoValid( void ) const { return Flag( MDAskInfoValid ); };
+
+private:
+  bool Flag( ixFields_t ix ) const {  // 'T' or 'F', missing is false
+    return ( ix < m_vFieldDelimiters.size() ) 
+      && ( m_vFieldDelimiters[ ix ].first != m_vFieldDelimiters[ ix ].second ) 
+      && ( 'T' == *m_vFieldDelimiters[ ix ].first );
+  }
+};
 
 template <class T, class charT>
 IQFBaseMessage<T, charT>::IQFBaseMessage( void )
@@ -14,6 +14,8 @@
 
 //#include "StdAfx.h"
 
+#include <algorithm>
+
 #include <boost/lexical_cast.hpp>
 
 #include <TFTrading/KeyTypes.h>
@@ -25,12 +27,14 @@ namespace tf { // TradeFrame
 
 IQFeedProvider::IQFeedProvider( void ) 
 : ProviderInterface<IQFeedProvider,IQFeedSymbol>(), 
-  IQFeed<IQFeedProvider>()
+  IQFeed<IQFeedProvider>(),
+  m_stateDepthPort( DPSDisconnected )
 {
   m_sName = "IQF";
   m_nID = keytypes::EProviderIQF;
   m_bProvidesQuotes = true;
   m_bProvidesTrades = true;
+  m_bProvidesDepth = true;
 }
 
 IQFeedProvider::~IQFeedProvider(void) {
@@ -52,6 +56,17 @@ void IQFeedProvider::OnIQFeedConnected( void ) {
 void IQFeedProvider::Disconnect() {
   if ( m_bConnected ) {
     ProviderInterfaceBase::OnDisconnecting( 0 );
+    DepthPort* pDepthPort( 0 );  // kept till the provider goes, to reconnect with
+    {
+      boost::mutex::scoped_lock lock( m_mutexDepthPort );
+      if ( DPSConnected == m_stateDepthPort ) {
+        pDepthPort = m_pDepthPort.get();
+      }
+      m_vDepthPending.clear();
+    }
+    if ( 0 != pDepthPort ) {
+      pDepthPort->Disconnect();  // without the lock, OnDepthPortDisConnected may be called on this thread
+    }
     IQFeed_t::Disconnect();
     inherited_t::Disconnect();
   }
@@ -106,6 +121,69 @@ void IQFeedProvider::StopTradeWatch(pSymbol_t pSymbol) {
   StopQuoteTradeWatch( dynamic_cast<IQFeedSymbol*>( pSymbol.get() ) );
 }
 
+void IQFeedProvider::StartDepthWatch( pSymbol_t pSymbol ) {
+  if ( !pSymbol->GetDepthWatchInProgress() ) {
+    pSymbol->ResetBook();
+    pSymbol->SetDepthWatchInProgress();
+    boost::mutex::scoped_lock lock( m_mutexDepthPort );
+    switch ( m_stateDepthPort ) {
+      case DPSConnected:
+        m_pDepthPort->WatchDepth( pSymbol->GetId() );
+        break;
+      case DPSDisconnected:
+        if ( 0 == m_pDepthPort.get() ) {
+          m_pDepthPort.reset( new DepthPort( *this ) );
+        }
+        m_stateDepthPort = DPSConnecting;
+        m_pDepthPort->Connect();
+        // fall through to queue the watch
+      case DPSConnecting:
+        m_vDepthPending.push_back( pSymbol->GetId() );
+        break;
+    }
+  }
+}
+
+void IQFeedProvider::StopDepthWatch( pSymbol_t pSymbol ) {
+  if ( pSymbol->DepthWatchNeeded() ) {
+    // still in use
+  }
+  else {
+    boost::mutex::scoped_lock lock( m_mutexDepthPort );
+    if ( DPSConnected == m_stateDepthPort ) {
+      m_pDepthPort->UnWatchDepth( pSymbol->GetId() );
+    }
+    else {
+      m_vDepthPending.erase( 
+        std::remove( m_vDepthPending.begin(), m_vDepthPending.end(), pSymbol->GetId() ), m_vDepthPending.end() );
+    }
+    pSymbol->ResetDepthWatchInProgress();
+  }
+}
+
+void IQFeedProvider::OnDepthPortConnected( void ) {
+  boost::mutex::scoped_lock lock( m_mutexDepthPort );
+  m_stateDepthPort = DPSConnected;
+  for ( std::vector<std::string>::const_iterator iter = m_vDepthPending.begin(); m_vDepthPending.end() != iter; ++iter ) {
+    m_pDepthPort->WatchDepth( *iter );
+  }
+  m_vDepthPending.clear();
+}
+
+void IQFeedProvider::OnDepthPortDisConnected( void ) {
+  boost::mutex::scoped_lock lock( m_mutexDepthPort );
+  m_stateDepthPort = DPSDisconnected;
+}
+
+void IQFeedProvider::OnDepthPortMessage( DepthPort::linebuffer_t* pBuffer, IQFMarketDepthMessage* pMsg ) {
+  inherited_t::m_mapSymbols_t::iterator m_mapSymbols_Iter;
+  m_mapSymbols_Iter = m_mapSymbols.find( pMsg->Field( IQFMarketDepthMessage::MDSymbol ) );
+  if ( m_mapSymbols.end() != m_mapSymbols_Iter ) {
+    m_mapSymbols_Iter->second->HandleMarketDepthMessage( pMsg );
+  }
+  m_pDepthPort->MarketDepthDone( pBuffer, pMsg );
+}
+
 void IQFeedProvider::OnIQFeedUpdateMessage( linebuffer_t* pBuffer, IQFUpdateMessage *pMsg ) {
   inherited_t::m_mapSymbols_t::iterator m_mapSymbols_Iter;
   m_mapSymbols_Iter = m_mapSymbols.find( pMsg->Field( IQFUpdateMessage::QPSymbol ) );
@@ -14,11 +14,17 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "TFTrading/ProviderInterface.h"
 
 #include "IQFeed.h"
+#include "IQFeedMarketDepth.h"
 #include "IQFeedSymbol.h"
 
 namespace ou { // One Unified
@@ -59,8 +65,8 @@ protected:
   virtual void StartTradeWatch( pSymbol_t pSymbol );
   virtual void  StopTradeWatch( pSymbol_t pSymbol );
 
-  virtual void StartDepthWatch( pSymbol_t pSymbol ) {};
-  virtual void  StopDepthWatch( pSymbol_t pSymbol ) {};
+  virtual void StartDepthWatch( pSymbol_t pSymbol );
+  virtual void  StopDepthWatch( pSymbol_t pSymbol );
 
   pSymbol_t NewCSymbol( pInstrument_t pInstrument );  // used by Add/Remove x handlers in base class
 
@@ -77,6 +83,28 @@ protected:
 
 private:
 
+  // level 2 runs on its own port, opened with the first depth watch
+  class DepthPort: public IQFeedMarketDepth<DepthPort> {
+    friend IQFeedMarketDepth<DepthPort>;
+  public:
+    DepthPort( IQFeedProvider& provider ): m_provider( provider ) {};
+  protected:
+    void OnIQFeedMarketDepthConnected( void ) { m_provider.OnDepthPortConnected(); };
+    void OnIQFeedMarketDepthDisConnected( void ) { m_provider.OnDepthPortDisConnected(); };
+    void OnIQFeedMarketDepthMessage( linebuffer_t* pBuffer, IQFMarketDepthMessage* pMsg ) { m_provider.OnDepthPortMessage( pBuffer, pMsg ); };
+  private:
+    IQFeedProvider& m_provider;
+  };
+
+  enum EDepthPortState { DPSDisconnected, DPSConnecting, DPSConnected } m_stateDepthPort;
+  boost::scoped_ptr<DepthPort> m_pDepthPort;
+  boost::mutex m_mutexDepthPort;
+  std::vector<std::string> m_vDepthPending;  // watches requested while the port is connecting
+
+  void OnDepthPortConnected( void );
+  void OnDepthPortDisConnected( void );
+  void OnDepthPortMessage( DepthPort::linebuffer_t* pBuffer, IQFMarketDepthMessage* pMsg );
+
 };
 
 } // namespace tf
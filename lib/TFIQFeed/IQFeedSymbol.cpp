@@ -147,5 +147,29 @@ void IQFeedSymbol::HandleUpdateMessage( IQFUpdateMessage *pMsg ) {
 void IQFeedSymbol::HandleNewsMessage( IQFNewsMessage *pMsg ) {
 }
 
+void IQFeedSymbol::ResetBook( void ) {
+  if ( 0 == m_pBook.get() ) {
+    m_pBook.reset( new OrderBook( GetInstrument()->GetMinTick() ) );
+  }
+  else {
+    m_pBook->Clear();
+  }
+}
+
+// each message carries the market maker's current bid and ask, an invalid side withdraws that side
+void IQFeedSymbol::HandleMarketDepthMessage( IQFMarketDepthMessage *pMsg ) {
+  if ( !m_bDepthWatchInProgress ) return;
+  ptime dt( ou::TimeSource::Instance().External() );
+  MarketDepth::MMID_t mmid( MarketDepth::PackMMID( pMsg->Field( IQFMarketDepthMessage::MDMMID ) ) );
+  MarketDepth mdBid( dt, 'B', pMsg->BidInfoValid() ? pMsg->Integer( IQFMarketDepthMessage::MDBidSize ) : 0, 
+    pMsg->Double( IQFMarketDepthMessage::MDBid ), mmid );
+  MarketDepth mdAsk( dt, 'S', pMsg->AskInfoValid() ? pMsg->Integer( IQFMarketDepthMessage::MDAskSize ) : 0, 
+    pMsg->Double( IQFMarketDepthMessage::MDAsk ), mmid );
+  m_pBook->Apply( mdBid );
+  m_pBook->Apply( mdAsk );
+  Symbol::m_OnDepth( mdBid );
+  Symbol::m_OnDepth( mdAsk );
+}
+
 } // namespace tf
 } // namespace ou
@@ -17,8 +17,12 @@
 #include <vector>
 #include <string>
 
+#include <boost/scoped_ptr.hpp>
+
 #include <OUCommon/Delegate.h>
 
+#include <TFTimeSeries/OrderBook.h>
+
 #include <TFTrading/Symbol.h>
 
 #include "IQFeedMessages.h"
@@ -82,6 +86,8 @@ public:
   ou::Delegate<IQFeedSymbol&> OnSummaryMessage;
   ou::Delegate<IQFeedSymbol&> OnNewsMessage;
 
+  const OrderBook* Book( void ) const { return m_pBook.get(); };  // maintained while a depth watch is in progress, null before the first
+
 protected:
 
   unsigned short m_cnt;  // used for watch/unwatch
@@ -97,10 +103,14 @@ protected:
   bool GetDepthWatchInProgress( void ) { return m_bDepthWatchInProgress; };
   bool m_bDepthWatchInProgress;
 
+  boost::scoped_ptr<OrderBook> m_pBook;  // created by the first depth watch
+  void ResetBook( void );
+
   void HandleFundamentalMessage( IQFFundamentalMessage *pMsg );
   void HandleUpdateMessage( IQFUpdateMessage *pMsg );
   void HandleSummaryMessage( IQFSummaryMessage *pMsg );
   void HandleNewsMessage( IQFNewsMessage *pMsg );
+  void HandleMarketDepthMessage( IQFMarketDepthMessage *pMsg );
 
   template <typename T>
   void DecodePricingMessage( IQFPricingMessage<T> *pMsg );
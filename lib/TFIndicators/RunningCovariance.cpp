@@ -0,0 +1,196 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+#include "RunningCovariance.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+RunningCovariance::RunningCovariance( size_t nColumns, size_t nWindow, double dblLambda )
+  : m_nColumns( nColumns ), m_nWindow( nWindow ), m_dblLambda( dblLambda ),
+    m_nCount( 0 ), m_nSkipped( 0 ), m_dblWeight( 0.0 ), m_ixRing( 0 )
+{
+  assert( 0 < nColumns );
+  assert( ( 0.0 < dblLambda ) && ( 1.0 >= dblLambda ) );
+  m_nBlocks = ( nColumns + nBlock - 1 ) / nBlock;
+  m_nPadded = m_nBlocks * nBlock;
+  m_dblLambdaWindow = std::pow( dblLambda, (double) nWindow );
+  m_vShift.resize( m_nPadded, 0.0 );
+  m_vSum.resize( m_nPadded, 0.0 );
+  m_vCross.resize( ( m_nBlocks * ( m_nBlocks + 1 ) / 2 ) * nBlockSize, 0.0 );
+  m_vRow.resize( m_nPadded, 0.0 );
+  m_vRing.resize( nWindow * m_nPadded, 0.0 );
+}
+
+RunningCovariance::~RunningCovariance( void ) {
+}
+
+void RunningCovariance::Reset( void ) {
+  m_nCount = 0;
+  m_nSkipped = 0;
+  m_dblWeight = 0.0;
+  m_ixRing = 0;
+  std::fill( m_vShift.begin(), m_vShift.end(), 0.0 );
+  std::fill( m_vSum.begin(), m_vSum.end(), 0.0 );
+  std::fill( m_vCross.begin(), m_vCross.end(), 0.0 );
+}
+
+bool RunningCovariance::Add( const double* row ) {
+  for ( size_t ix = 0; ix < m_nColumns; ++ix ) {
+    if ( !std::isfinite( row[ ix ] ) ) {  // would poison the shift and the sums
+      ++m_nSkipped;
+      return false;
+    }
+  }
+  if ( ( 0 == m_nCount ) && ( 0.0 == m_dblWeight ) ) {
+    std::copy( row, row + m_nColumns, m_vShift.begin() );
+  }
+  double* x( &m_vRow[ 0 ] );
+  for ( size_t ix = 0; ix < m_nColumns; ++ix ) {
+    x[ ix ] = row[ ix ] - m_vShift[ ix ];
+  }
+  if ( 0 == m_nWindow ) {
+    Update( x, x, 0.0 );
+    ++m_nCount;
+  }
+  else {
+    double* slot( &m_vRing[ m_ixRing * m_nPadded ] );
+    if ( m_nWindow == m_nCount ) {
+      Update( x, slot, m_dblLambdaWindow );  // slot holds the oldest row
+    }
+    else {
+      Update( x, x, 0.0 );
+      ++m_nCount;
+    }
+    std::copy( x, x + m_nPadded, slot );
+    ++m_ixRing;
+    if ( m_nWindow == m_ixRing ) m_ixRing = 0;
+  }
+  return true;
+}
+
+void RunningCovariance::Update( const double* x, const double* y, double a ) {
+  const double lambda( m_dblLambda );
+  double* pBlock( &m_vCross[ 0 ] );
+  for ( size_t ixBlockRow = 0; ixBlockRow < m_nBlocks; ++ixBlockRow ) {
+    const double* xRow( x + ixBlockRow * nBlock );
+    const double* yRow( y + ixBlockRow * nBlock );
+    for ( size_t ixBlockCol = ixBlockRow; ixBlockCol < m_nBlocks; ++ixBlockCol ) {
+      const double* xCol( x + ixBlockCol * nBlock );
+      const double* yCol( y + ixBlockCol * nBlock );
+      for ( size_t ixRow = 0; ixRow < nBlock; ++ixRow ) {
+        const double xr( xRow[ ixRow ] );
+        const double yr( a * yRow[ ixRow ] );
+        double* p( pBlock + ixRow * nBlock );
+        for ( size_t ixCol = 0; ixCol < nBlock; ++ixCol ) {
+          p[ ixCol ] = lambda * p[ ixCol ] + xr * xCol[ ixCol ] - yr * yCol[ ixCol ];
+        }
+      }
+      pBlock += nBlockSize;
+    }
+  }
+  for ( size_t ix = 0; ix < m_nPadded; ++ix ) {
+    m_vSum[ ix ] = lambda * m_vSum[ ix ] + x[ ix ] - a * y[ ix ];
+  }
+  m_dblWeight = lambda * m_dblWeight + 1.0 - a;
+}
+
+void RunningCovariance::Recompute( void ) {
+  if ( 0 == m_nWindow ) return;  // rows aren't kept
+  std::fill( m_vSum.begin(), m_vSum.end(), 0.0 );
+  std::fill( m_vCross.begin(), m_vCross.end(), 0.0 );
+  m_dblWeight = 0.0;
+  size_t ixRing( ( m_nWindow == m_nCount ) ? m_ixRing : 0 );  // oldest first
+  for ( size_t cnt = 0; cnt < m_nCount; ++cnt ) {
+    const double* x( &m_vRing[ ixRing * m_nPadded ] );
+    Update( x, x, 0.0 );
+    ++ixRing;
+    if ( m_nWindow == ixRing ) ixRing = 0;
+  }
+}
+
+const double* RunningCovariance::Block( size_t ixBlockRow, size_t ixBlockCol ) const {
+  // blocks are stored row by row, from the diagonal across
+  const size_t ixBlock( ixBlockRow * m_nBlocks - ( ixBlockRow * ( ixBlockRow - 1 ) ) / 2 + ( ixBlockCol - ixBlockRow ) );
+  return &m_vCross[ ixBlock * nBlockSize ];
+}
+
+double RunningCovariance::Cross( size_t ix1, size_t ix2 ) const {
+  if ( ix1 > ix2 ) std::swap( ix1, ix2 );
+  return Block( ix1 / nBlock, ix2 / nBlock )[ ( ix1 % nBlock ) * nBlock + ( ix2 % nBlock ) ];
+}
+
+double RunningCovariance::Mean( size_t ix ) const {
+  assert( ix < m_nColumns );
+  if ( 0.0 == m_dblWeight ) return 0.0;
+  return m_vShift[ ix ] + m_vSum[ ix ] / m_dblWeight;
+}
+
+double RunningCovariance::Covariance( size_t ix1, size_t ix2 ) const {
+  assert( ix1 < m_nColumns );
+  assert( ix2 < m_nColumns );
+  if ( 0.0 == m_dblWeight ) return 0.0;
+  return ( Cross( ix1, ix2 ) - m_vSum[ ix1 ] * m_vSum[ ix2 ] / m_dblWeight ) / m_dblWeight;
+}
+
+double RunningCovariance::Correlation( size_t ix1, size_t ix2 ) const {
+  double denominator = std::sqrt( Variance( ix1 ) * Variance( ix2 ) );
+  return ( 0.0 == denominator ) ? 0.0 : Covariance( ix1, ix2 ) / denominator;
+}
+
+double RunningCovariance::Beta( size_t ix, size_t ixMarket ) const {
+  double var = Variance( ixMarket );
+  return ( 0.0 == var ) ? 0.0 : Covariance( ix, ixMarket ) / var;
+}
+
+void RunningCovariance::Covariance( std::vector<double>& v ) const {
+  v.resize( m_nColumns * m_nColumns );
+  for ( size_t ix1 = 0; ix1 < m_nColumns; ++ix1 ) {
+    for ( size_t ix2 = ix1; ix2 < m_nColumns; ++ix2 ) {
+      v[ ix1 * m_nColumns + ix2 ] = v[ ix2 * m_nColumns + ix1 ] = Covariance( ix1, ix2 );
+    }
+  }
+}
+
+void RunningCovariance::Correlation( std::vector<double>& v ) const {
+  Covariance( v );
+  std::vector<double> vSD( m_nColumns );
+  for ( size_t ix = 0; ix < m_nColumns; ++ix ) {
+    vSD[ ix ] = std::sqrt( v[ ix * m_nColumns + ix ] );
+  }
+  for ( size_t ix1 = 0; ix1 < m_nColumns; ++ix1 ) {
+    for ( size_t ix2 = 0; ix2 < m_nColumns; ++ix2 ) {
+      double denominator = vSD[ ix1 ] * vSD[ ix2 ];
+      double& cell( v[ ix1 * m_nColumns + ix2 ] );
+      cell = ( 0.0 == denominator ) ? 0.0 : cell / denominator;
+    }
+  }
+}
+
+void RunningCovariance::Beta( size_t ixMarket, std::vector<double>& v ) const {
+  v.resize( m_nColumns );
+  double var = Variance( ixMarket );
+  for ( size_t ix = 0; ix < m_nColumns; ++ix ) {
+    v[ ix ] = ( 0.0 == var ) ? 0.0 : Covariance( ix, ixMarket ) / var;
+  }
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,93 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// N x N covariance over a rolling window of aligned rows (eg returns from an hf::TSPanel), for baskets and hedges
+// RunningStats does one x/y pair, this does every pair:
+//   each Add is a rank one update of the cross products, and a rank one removal of the row leaving the window
+//   with dblLambda < 1.0, rows are exponentially weighted, the newest has weight 1, the one before lambda, ...
+//   nWindow of 0 keeps everything, normally used with dblLambda < 1.0
+// a row holding a non-finite value (eg a TSPanel row before each column's first datum) is skipped, and counted
+// values are shifted by the first row added, which keeps the sums small, covariance is unaffected
+// cross products are kept in 8 x 8 blocks of the upper triangle, each block is contiguous
+// covariance is the population version, divided by the sum of the weights
+// add and remove accumulate rounding over long runs, Recompute rebuilds the sums from the rows in the window
+
+#include <cstddef>
+#include <vector>
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class RunningCovariance {
+public:
+
+  RunningCovariance( size_t nColumns, size_t nWindow, double dblLambda = 1.0 );
+  virtual ~RunningCovariance( void );
+
+  bool Add( const double* row );  // nColumns values, the oldest row leaves once the window is full, false when skipped
+  bool Add( const std::vector<double>& row ) { return Add( &row[ 0 ] ); };
+  void Recompute( void );
+  void Reset( void );
+
+  size_t Columns( void ) const { return m_nColumns; };
+  size_t Count( void ) const { return m_nCount; };  // rows in the window
+  size_t Skipped( void ) const { return m_nSkipped; };  // rows with non-finite values, since construction or Reset
+  double Weight( void ) const { return m_dblWeight; };  // sum of the weights of the rows in the window
+
+  double Mean( size_t ix ) const;
+  double Variance( size_t ix ) const { return Covariance( ix, ix ); };
+  double Covariance( size_t ix1, size_t ix2 ) const;
+  double Correlation( size_t ix1, size_t ix2 ) const;
+  double Beta( size_t ix, size_t ixMarket ) const;  // slope of ix regressed on ixMarket, cov / var( market )
+
+  // whole matrices on demand, row major nColumns x nColumns
+  void Covariance( std::vector<double>& v ) const;
+  void Correlation( std::vector<double>& v ) const;
+  void Beta( size_t ixMarket, std::vector<double>& v ) const;  // each column against ixMarket
+
+protected:
+private:
+
+  static const size_t nBlock = 8;  // doubles per block row, one cache line
+  static const size_t nBlockSize = nBlock * nBlock;
+
+  size_t m_nColumns;
+  size_t m_nPadded;  // m_nColumns rounded up to a multiple of nBlock
+  size_t m_nBlocks;  // blocks per side
+  size_t m_nWindow;
+  double m_dblLambda;
+  double m_dblLambdaWindow;  // weight of the row leaving the window, lambda ^ nWindow
+
+  size_t m_nCount;
+  size_t m_nSkipped;
+  double m_dblWeight;
+
+  std::vector<double> m_vShift;  // first row added
+  std::vector<double> m_vSum;  // weighted sum of shifted values
+  std::vector<double> m_vCross;  // weighted sums of shifted cross products, upper triangle blocks
+  std::vector<double> m_vRow;  // row being added, shifted and padded
+  std::vector<double> m_vRing;  // shifted rows in the window, m_nPadded each
+  size_t m_ixRing;  // next row to be written
+
+  const double* Block( size_t ixBlockRow, size_t ixBlockCol ) const;
+  double Cross( size_t ix1, size_t ix2 ) const;
+
+  // cross = lambda * cross + x x' - a y y', one pass over the blocks
+  void Update( const double* x, const double* y, double a );
+};
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,297 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <cmath>
+
+#include "RunningStats.h"
+#include "RunningMinMax.h"
+
+#include "TSBatch.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+namespace batch { // whole series at once
+
+namespace {
+
+  // decay factors for each datum, as computed in TSEMA<D>::EMA, index 0 is unused
+  void Decay( const std::vector<ptime>& vDateTime, double dblTimeRange, std::vector<double>& vMu, std::vector<double>& vV ) {
+    static const time_duration tdOne( microseconds( 1 ) );
+    const size_t n( vDateTime.size() );
+    vMu.resize( n );
+    vV.resize( n );
+    if ( 0 == n ) return;
+    vMu[ 0 ] = vV[ 0 ] = 0.0;
+    for ( size_t ix = 1; ix < n; ++ix ) {  // alpha, kept in vV until the next pass
+      const ptime& t( vDateTime[ ix ] );
+      const ptime& dtPrv( vDateTime[ ix - 1 ] );
+      time_duration tdDif = t == dtPrv ? tdOne : t - dtPrv;
+      vV[ ix ] = ( (double) tdDif.total_microseconds() ) / dblTimeRange;
+    }
+    for ( size_t ix = 1; ix < n; ++ix ) {
+      double alpha = vV[ ix ];
+      double mu = std::exp( -alpha );
+      vMu[ ix ] = mu;
+      vV[ ix ] = ( 1.0 - mu ) / alpha;
+    }
+  }
+
+  // nStages emas chained one on the other, as TSMA builds them, all stages advanced together per datum
+  // vSum gets the stage outputs summed in stage order, vLast the output of the final stage
+  void Chain(
+    const std::vector<double>& vX, const std::vector<double>& vMu, const std::vector<double>& vV,
+    unsigned int nStages, std::vector<double>* pvSum, std::vector<double>* pvLast
+  ) {
+    const size_t n( vX.size() );
+    if ( 0 != pvSum ) pvSum->resize( n );
+    if ( 0 != pvLast ) pvLast->resize( n );
+    if ( 0 == n ) return;
+    std::vector<double> vEMA( nStages, vX[ 0 ] );  // prior output per stage
+    std::vector<double> vXatTminus1( nStages, vX[ 0 ] );  // prior input per stage
+    double sum( 0.0 );
+    for ( unsigned int ixStage = 0; ixStage < nStages; ++ixStage ) sum += vX[ 0 ];
+    if ( 0 != pvSum ) ( *pvSum )[ 0 ] = sum;
+    if ( 0 != pvLast ) ( *pvLast )[ 0 ] = vX[ 0 ];
+    for ( size_t ix = 1; ix < n; ++ix ) {
+      const double mu( vMu[ ix ] );
+      const double v( vV[ ix ] );
+      double x( vX[ ix ] );
+      sum = 0.0;
+      for ( unsigned int ixStage = 0; ixStage < nStages; ++ixStage ) {
+        double ema = mu * vEMA[ ixStage ] + ( v - mu ) * vXatTminus1[ ixStage ] + ( 1.0 - v ) * x;
+        vXatTminus1[ ixStage ] = x;
+        vEMA[ ixStage ] = ema;
+        sum += ema;
+        x = ema;
+      }
+      if ( 0 != pvSum ) ( *pvSum )[ ix ] = sum;
+      if ( 0 != pvLast ) ( *pvLast )[ ix ] = x;
+    }
+  }
+
+  // TSMA( series, td, n ) runs its emas with 2 * td / ( n + 1 )
+  double MARange( time_duration td, unsigned int n ) {
+    return (double) microseconds( ( 2 * td.total_microseconds() ) / ( n + 1 ) ).total_microseconds();
+  }
+
+  void MovingAverage( const std::vector<double>& vX,
+    const std::vector<double>& vMu, const std::vector<double>& vV, unsigned int n, std::vector<double>& vMA
+  ) {
+    Chain( vX, vMu, vV, n, &vMA, 0 );
+    const size_t cnt( vMA.size() );
+    double* p( cnt ? &vMA[ 0 ] : 0 );
+    for ( size_t ix = 0; ix < cnt; ++ix ) p[ ix ] /= n;
+  }
+
+  class PeakCollector {
+  public:
+    PeakCollector( std::vector<Peak>& vPeaks ): m_vPeaks( vPeaks ) {};
+    void HandlePeakFound( const ZigZag&, ptime dt, double val, ZigZag::EDirection direction ) {
+      m_vPeaks.push_back( Peak( dt, val, direction ) );
+    }
+  private:
+    std::vector<Peak>& m_vPeaks;
+  };
+
+} // namespace anonymous
+
+void ToPrices( const Columns& columns, Prices& prices ) {
+  const size_t n( columns.Size() );
+  prices.Reserve( prices.Size() + n );
+  for ( size_t ix = 0; ix < n; ++ix ) {
+    prices.Append( Price( columns.vDateTime[ ix ], columns.vValue[ ix ] ) );
+  }
+}
+
+void EMA( const Columns& in, time_duration td, Columns& out ) {
+  assert( 0 < td.total_seconds() );
+  std::vector<double> vMu, vV;
+  Decay( in.vDateTime, (double) td.total_microseconds(), vMu, vV );
+  out.vDateTime = in.vDateTime;
+  Chain( in.vValue, vMu, vV, 1, 0, &out.vValue );
+}
+
+void MA( const Columns& in, time_duration td, unsigned int n, Columns& out ) {
+  assert( 1 <= n );
+  std::vector<double> vMu, vV;
+  Decay( in.vDateTime, MARange( td, n ), vMu, vV );
+  out.vDateTime = in.vDateTime;
+  MovingAverage( in.vValue, vMu, vV, n, out.vValue );
+}
+
+void Variance( const Columns& in, time_duration td, unsigned int n, double p1, double p2, Columns& out ) {
+  assert( 0 < n );
+  assert( 0.0 < p2 );
+  const size_t cnt( in.Size() );
+  std::vector<double> vMu, vV;
+  Decay( in.vDateTime, MARange( td, n ), vMu, vV );  // both moving averages run on the same time stamps
+
+  std::vector<double> vMA1;
+  MovingAverage( in.vValue, vMu, vV, n, vMA1 );
+
+  std::vector<double> vDev( cnt );  // deviation from the first average, raised to p1
+  for ( size_t ix = 0; ix < cnt; ++ix ) {
+    double t = in.vValue[ ix ] - vMA1[ ix ];
+    if ( 1.0 == p1 ) vDev[ ix ] = std::abs( t );
+    else {
+      if ( 2.0 == p1 ) vDev[ ix ] = t * t;
+      else vDev[ ix ] = std::pow( std::abs( t ), p1 );
+    }
+  }
+
+  out.vDateTime = in.vDateTime;
+  MovingAverage( vDev, vMu, vV, n, out.vValue );
+
+  if ( 1.0 != p2 ) {
+    for ( size_t ix = 0; ix < cnt; ++ix ) {
+      if ( 2.0 == p2 ) out.vValue[ ix ] = std::sqrt( out.vValue[ ix ] );
+      else out.vValue[ ix ] = std::pow( out.vValue[ ix ], 1.0 / p2 );
+    }
+  }
+}
+
+void Returns( const Columns& in, Columns& out ) {
+  const size_t n( in.Size() );
+  if ( 2 > n ) {
+    out.Resize( 0 );
+    return;
+  }
+  std::vector<double> vLog( n );
+  for ( size_t ix = 0; ix < n; ++ix ) vLog[ ix ] = std::log( in.vValue[ ix ] );
+  out.Resize( n - 1 );
+  out.vDateTime.assign( in.vDateTime.begin() + 1, in.vDateTime.end() );
+  const double* pLog( &vLog[ 0 ] );
+  double* pOut( &out.vValue[ 0 ] );
+  for ( size_t ix = 0; ix < n - 1; ++ix ) pOut[ ix ] = pLog[ ix + 1 ] - pLog[ ix ];
+}
+
+void Stats::Resize( size_t n ) {
+  vSlope.resize( n );
+  vOffset.resize( n );
+  vMeanY.resize( n );
+  vRR.resize( n );
+  vR.resize( n );
+  vSD.resize( n );
+}
+
+namespace {
+
+  // the window movement in TimeSeriesSlidingWindow<T,D>::Update, applied once per datum
+  // x is whole seconds from the first datum, one or two y values per datum
+  void Slide( const std::vector<ptime>& vDateTime, const double* pY1, const double* pY2,
+    time_duration tdWindowWidth, size_t nWindowSizeCount, Stats& stats
+  ) {
+    const size_t n( vDateTime.size() );
+    stats.Resize( n );
+    if ( 0 == n ) return;
+
+    std::vector<double> vX( n );
+    const ptime dtZero( vDateTime[ 0 ] );
+    for ( size_t ix = 0; ix < n; ++ix ) {
+      vX[ ix ] = (double) ( vDateTime[ ix ] - dtZero ).total_seconds();
+    }
+
+    const bool bByTime( 0 < tdWindowWidth.total_milliseconds() );
+    RunningStats rs;
+    size_t ixTrailing( 0 );
+    for ( size_t ixLeading = 0; ixLeading < n; ) {
+      rs.Add( vX[ ixLeading ], pY1[ ixLeading ] );
+      if ( 0 != pY2 ) rs.Add( vX[ ixLeading ], pY2[ ixLeading ] );
+      const ptime& dtLeading( vDateTime[ ixLeading ] );
+      ++ixLeading;
+      if ( 0 < nWindowSizeCount ) {
+        while ( ( ixLeading - ixTrailing ) > nWindowSizeCount ) {
+          rs.Remove( vX[ ixTrailing ], pY1[ ixTrailing ] );
+          if ( 0 != pY2 ) rs.Remove( vX[ ixTrailing ], pY2[ ixTrailing ] );
+          ++ixTrailing;
+        }
+      }
+      if ( bByTime ) {
+        while ( ( dtLeading - vDateTime[ ixTrailing ] ) > tdWindowWidth ) {
+          rs.Remove( vX[ ixTrailing ], pY1[ ixTrailing ] );
+          if ( 0 != pY2 ) rs.Remove( vX[ ixTrailing ], pY2[ ixTrailing ] );
+          ++ixTrailing;
+          if ( ixTrailing >= ixLeading ) break;
+        }
+      }
+      rs.CalcStats();
+      const size_t ix( ixLeading - 1 );
+      stats.vSlope[ ix ] = rs.Slope();
+      stats.vOffset[ ix ] = rs.Offset();
+      stats.vMeanY[ ix ] = rs.MeanY();
+      stats.vRR[ ix ] = rs.RR();
+      stats.vR[ ix ] = rs.R();
+      stats.vSD[ ix ] = rs.SD();
+    }
+  }
+
+} // namespace anonymous
+
+void SlidingStats( const Columns& in, time_duration tdWindowWidth, size_t nWindowSizeCount, Stats& stats ) {
+  Slide( in.vDateTime, in.Size() ? &in.vValue[ 0 ] : 0, 0, tdWindowWidth, nWindowSizeCount, stats );
+}
+
+void SlidingStats( const Columns& bid, const Columns& ask, time_duration tdWindowWidth, size_t nWindowSizeCount, Stats& stats ) {
+  assert( bid.Size() == ask.Size() );
+  Slide(
+    bid.vDateTime, bid.Size() ? &bid.vValue[ 0 ] : 0, ask.Size() ? &ask.vValue[ 0 ] : 0, tdWindowWidth, nWindowSizeCount, stats );
+}
+
+void Stochastic( const Columns& in, time_duration tdWindowWidth, std::vector<double>& vK ) {
+  const size_t n( in.Size() );
+  vK.resize( n );
+  const bool bByTime( 0 < tdWindowWidth.total_milliseconds() );
+  RunningMinMax minmax;
+  double lastAdd( 0 );
+  double lastExpire( 0 );
+  size_t ixTrailing( 0 );
+  for ( size_t ixLeading = 0; ixLeading < n; ) {
+    double tmp = in.vValue[ ixLeading ];
+    if ( tmp != lastAdd ) {  // same filtering as TSSWStochastic::Add
+      lastAdd = tmp;
+      minmax.Add( lastAdd );
+    }
+    const ptime& dtLeading( in.vDateTime[ ixLeading ] );
+    ++ixLeading;
+    if ( bByTime ) {
+      while ( ( dtLeading - in.vDateTime[ ixTrailing ] ) > tdWindowWidth ) {
+        tmp = in.vValue[ ixTrailing ];
+        if ( tmp != lastExpire ) {  // same filtering as TSSWStochastic::Expire
+          lastExpire = tmp;
+          minmax.Remove( lastExpire );
+        }
+        ++ixTrailing;
+        if ( ixTrailing >= ixLeading ) break;
+      }
+    }
+    vK[ ixLeading - 1 ] =
+      minmax.Max() == minmax.Min() ? 0 : ( ( lastAdd - minmax.Min() ) / ( minmax.Max() - minmax.Min() ) ) * 100.0;
+  }
+}
+
+void ZigZagPeaks( const Columns& in, double dblFilterWidth, std::vector<Peak>& vPeaks ) {
+  PeakCollector collector( vPeaks );
+  ZigZag zigzag( dblFilterWidth );
+  zigzag.SetOnPeakFound( MakeDelegate( &collector, &PeakCollector::HandlePeakFound ) );
+  const size_t n( in.Size() );
+  for ( size_t ix = 0; ix < n; ++ix ) {
+    zigzag.Check( in.vDateTime[ ix ], in.vValue[ ix ] );
+  }
+}
+
+} // namespace batch
+} // namespace tf
+} // namespace ou
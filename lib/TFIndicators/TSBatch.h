@@ -0,0 +1,94 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// batch evaluation of the streaming indicators, for when the whole series is already loaded (backtests from hdf5)
+// each routine walks the columns in a single loop, no delegates, output is sized once up front
+// results match the streaming classes value for value, the arithmetic is done in the same order:
+//   EMA       <=> hf::TSEMA
+//   MA        <=> hf::TSMA( series, td, n )
+//   Variance  <=> hf::TSVariance
+//   Returns   <=> TSReturns
+//   Stats     <=> TSSWStatsPrice/Trade/MidQuote ( one column ), TSSWStatsQuote ( bid and ask columns )
+//   Stochastic <=> TSSWStochastic
+//   ZigZag    <=> ZigZag::Check, peaks as reported to OnPeakFound
+// chained ema stages share their decay factors, so the exp is evaluated once per datum rather than once per stage
+
+#include <vector>
+
+#include <TFTimeSeries/TimeSeries.h>
+
+#include "ZigZag.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+namespace batch { // whole series at once
+
+// one value per datum, extracted from a series
+struct Columns {
+  std::vector<ptime> vDateTime;
+  std::vector<double> vValue;
+  Columns( void ) {};
+  Columns( size_t n ) { Resize( n ); };
+  size_t Size( void ) const { return vValue.size(); };
+  void Resize( size_t n ) { vDateTime.resize( n ); vValue.resize( n ); };
+};
+
+// eg: Load( quotes, &Quote::Midpoint, columns ), Load( trades, &Trade::Price, columns )
+template<class D>
+void Load( const TimeSeries<D>& series, DatedDatum::price_t (D::*f)( void ) const, Columns& columns ) {
+  columns.Resize( series.Size() );
+  size_t ix( 0 );
+  for ( typename TimeSeries<D>::const_iterator iter = series.begin(); series.end() != iter; ++iter, ++ix ) {
+    columns.vDateTime[ ix ] = iter->DateTime();
+    columns.vValue[ ix ] = ( (*iter).*f )();
+  }
+}
+
+void ToPrices( const Columns& columns, Prices& prices );  // reserves, then appends
+
+void EMA( const Columns& in, time_duration td, Columns& out );
+void MA( const Columns& in, time_duration td, unsigned int n, Columns& out );
+void Variance( const Columns& in, time_duration td, unsigned int n, double p1, double p2, Columns& out );
+void Returns( const Columns& in, Columns& out );  // one less than in
+
+// state of the sliding window statistics after each datum
+struct Stats {
+  std::vector<double> vSlope;
+  std::vector<double> vOffset;
+  std::vector<double> vMeanY;
+  std::vector<double> vRR;
+  std::vector<double> vR;
+  std::vector<double> vSD;
+  void Resize( size_t n );
+};
+
+void SlidingStats( const Columns& in, time_duration tdWindowWidth, size_t nWindowSizeCount, Stats& stats );
+void SlidingStats( const Columns& bid, const Columns& ask, time_duration tdWindowWidth, size_t nWindowSizeCount, Stats& stats );
+
+void Stochastic( const Columns& in, time_duration tdWindowWidth, std::vector<double>& vK );
+
+struct Peak {
+  ptime dt;
+  double value;
+  ZigZag::EDirection direction;
+  Peak( ptime dt_, double value_, ZigZag::EDirection direction_ ): dt( dt_ ), value( value_ ), direction( direction_ ) {};
+};
+
+void ZigZagPeaks( const Columns& in, double dblFilterWidth, std::vector<Peak>& vPeaks );
+
+} // namespace batch
+} // namespace tf
+} // namespace ou
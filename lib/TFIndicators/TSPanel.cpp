@@ -0,0 +1,213 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "TSPanel.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+namespace hf { // high frequency
+
+namespace {
+
+  const double dblNaN = std::numeric_limits<double>::quiet_NaN();
+
+  // linear interpolation at dt, between the datum at or before and the datum after, as in TSHomogenization
+  inline double Interpolate( ptime dt, ptime dtPrev, double prev, ptime dtNext, double next ) {
+    double ratio = ( (double) ( dt - dtPrev ).total_microseconds() ) / ( (double) ( dtNext - dtPrev ).total_microseconds() );
+    return prev + ratio * ( next - prev );
+  }
+
+  // one column of the panel, walks the series once alongside the grid
+  void Fill( const batch::Columns& in, const std::vector<ptime>& vGrid, TSPanel::interpolation_t interpolation, std::vector<double>& out ) {
+    const std::vector<ptime>& vDateTime( in.vDateTime );
+    const std::vector<double>& vValue( in.vValue );
+    const size_t n( in.Size() );
+    size_t ix( 0 );  // first datum after the grid point
+    for ( size_t ixRow = 0; ixRow < vGrid.size(); ++ixRow ) {
+      const ptime dt( vGrid[ ixRow ] );
+      while ( ( ix < n ) && ( vDateTime[ ix ] <= dt ) ) ++ix;
+      if ( 0 == ix ) {
+        out[ ixRow ] = dblNaN;
+      }
+      else {
+        const size_t ixPrev( ix - 1 );
+        if ( ( TSPanel::ePreviousTick == interpolation ) || ( vDateTime[ ixPrev ] == dt ) || ( n == ix ) ) {
+          out[ ixRow ] = vValue[ ixPrev ];
+        }
+        else {
+          out[ ixRow ] = Interpolate( dt, vDateTime[ ixPrev ], vValue[ ixPrev ], vDateTime[ ix ], vValue[ ix ] );
+        }
+      }
+    }
+  }
+
+} // namespace anonymous
+
+void TSPanel::Panel::Resize( size_t nRows, size_t nColumns ) {
+  vDateTime.resize( nRows );
+  vColumn.resize( nColumns );
+  for ( std::vector<std::vector<double> >::iterator iter = vColumn.begin(); vColumn.end() != iter; ++iter ) {
+    iter->resize( nRows );
+  }
+}
+
+TSPanel::TSPanel( time_duration interval, interpolation_t interpolation )
+  : m_tdInterval( interval ), m_interpolation( interpolation ),
+    m_dtMarker( not_a_date_time ), m_dtLatest( not_a_date_time ),
+    m_ixHeld( 0 )
+{
+  assert( time_duration( 0, 0, 0 ) < m_tdInterval );
+}
+
+TSPanel::~TSPanel( void ) {
+  m_vSource.clear();  // detach from the series
+}
+
+ptime TSPanel::Align( ptime dt, time_duration interval ) {
+  const boost::int64_t nTicks( interval.ticks() );
+  const boost::int64_t nMarks( ( dt.time_of_day().ticks() + nTicks - 1 ) / nTicks );
+  return ptime( dt.date(), time_duration( 0, 0, 0, nMarks * nTicks ) );
+}
+
+TSPanel::column_t TSPanel::AddColumn( void ) {
+  assert( m_dtMarker.is_not_a_date_time() );  // all columns are present before the first row is started
+  m_vLast.push_back( Last() );
+  m_vRow.push_back( dblNaN );
+  return m_vLast.size() - 1;
+}
+
+void TSPanel::Append( column_t ix, ptime dt, double value ) {
+  assert( ix < m_vLast.size() );
+  assert( m_dtLatest.is_not_a_date_time() || ( dt >= m_dtLatest ) );
+  if ( m_dtMarker.is_not_a_date_time() ) {
+    m_dtMarker = Align( dt, m_tdInterval );
+  }
+  else {
+    Mark( dt );
+  }
+  Last& last( m_vLast[ ix ] );
+  if ( eLinear == m_interpolation ) {
+    // rows held on this column all have their grid point between last.dt and dt
+    const size_t ixEnd( m_ixHeld + m_dequeHeld.size() );
+    for ( size_t ixRow = std::max( last.ixHeld, m_ixHeld ); ixRow < ixEnd; ++ixRow ) {
+      Held& held( m_dequeHeld[ ixRow - m_ixHeld ] );
+      held.vValue[ ix ] = Interpolate( held.dt, last.dt, last.value, dt, value );
+      --held.nWaiting;
+    }
+    last.ixHeld = ixEnd;
+  }
+  last.dt = dt;
+  last.value = value;
+  m_dtLatest = dt;
+  if ( eLinear == m_interpolation ) Release();
+}
+
+void TSPanel::Mark( ptime dt ) {
+  // every grid point is visited, gaps in the data (overnight, halts) included
+  while ( m_dtMarker < dt ) {
+    switch ( m_interpolation ) {
+    case ePreviousTick:
+      for ( size_t ix = 0; ix < m_vLast.size(); ++ix ) {
+        const Last& last( m_vLast[ ix ] );
+        m_vRow[ ix ] = last.dt.is_not_a_date_time() ? dblNaN : last.value;
+      }
+      OnRow( Row( m_dtMarker, m_vRow ) );
+      break;
+    case eLinear: {
+        m_dequeHeld.push_back( Held() );
+        Held& held( m_dequeHeld.back() );
+        const size_t ixRow( m_ixHeld + m_dequeHeld.size() - 1 );
+        held.dt = m_dtMarker;
+        held.vValue.resize( m_vLast.size() );
+        held.nWaiting = 0;
+        for ( size_t ix = 0; ix < m_vLast.size(); ++ix ) {
+          Last& last( m_vLast[ ix ] );
+          if ( last.dt.is_not_a_date_time() ) {
+            held.vValue[ ix ] = dblNaN;
+            last.ixHeld = ixRow + 1;
+          }
+          else {
+            if ( m_dtMarker == last.dt ) {
+              held.vValue[ ix ] = last.value;
+              last.ixHeld = ixRow + 1;
+            }
+            else {
+              ++held.nWaiting;  // resolved by the next datum in the column
+            }
+          }
+        }
+      }
+      break;
+    }
+    m_dtMarker += m_tdInterval;
+  }
+}
+
+void TSPanel::Release( void ) {
+  while ( !m_dequeHeld.empty() && ( 0 == m_dequeHeld.front().nWaiting ) ) {
+    const Held& held( m_dequeHeld.front() );
+    OnRow( Row( held.dt, held.vValue ) );
+    m_dequeHeld.pop_front();
+    ++m_ixHeld;
+  }
+}
+
+void TSPanel::Flush( void ) {
+  if ( m_dtLatest.is_not_a_date_time() ) return;
+  Mark( m_dtLatest + time_duration( 0, 0, 0, 1 ) );  // includes a grid point on the last datum
+  if ( eLinear == m_interpolation ) {
+    const size_t ixEnd( m_ixHeld + m_dequeHeld.size() );
+    for ( size_t ix = 0; ix < m_vLast.size(); ++ix ) {
+      Last& last( m_vLast[ ix ] );
+      for ( size_t ixRow = std::max( last.ixHeld, m_ixHeld ); ixRow < ixEnd; ++ixRow ) {
+        Held& held( m_dequeHeld[ ixRow - m_ixHeld ] );
+        held.vValue[ ix ] = last.value;  // nothing further in the column, use the previous tick
+        --held.nWaiting;
+      }
+      last.ixHeld = ixEnd;
+    }
+    Release();
+  }
+}
+
+void TSPanel::Build(
+  const std::vector<batch::Columns>& vColumns, ptime dtBegin, ptime dtEnd,
+  time_duration interval, interpolation_t interpolation, Panel& panel
+) {
+  assert( time_duration( 0, 0, 0 ) < interval );
+  const ptime dtFirst( Align( dtBegin, interval ) );
+  size_t nRows( 0 );
+  if ( dtFirst < dtEnd ) {
+    nRows = ( ( dtEnd - dtFirst ).ticks() + interval.ticks() - 1 ) / interval.ticks();
+  }
+  panel.Resize( nRows, vColumns.size() );
+  ptime dt( dtFirst );
+  for ( size_t ixRow = 0; ixRow < nRows; ++ixRow ) {
+    panel.vDateTime[ ixRow ] = dt;
+    dt += interval;
+  }
+  for ( size_t ix = 0; ix < vColumns.size(); ++ix ) {
+    Fill( vColumns[ ix ], panel.vDateTime, interpolation, panel.vColumn[ ix ] );
+  }
+}
+
+} // namespace hf
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,150 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// N series aligned on a common time grid, for pairs, baskets, hedging
+// same conventions as TSHomogenization, but for many series at once:
+//   grid points are multiples of the interval within the day
+//   ePreviousTick: value of the last datum at or before the grid point
+//   eLinear: interpolated between the last datum at or before, and the first datum after, the grid point
+//   a column with no datum at or before a grid point is NaN
+// bulk: Build fills a struct of arrays panel from series already loaded into batch::Columns
+// streaming: series are attached, one row is emitted through OnRow per interval, once all columns are final for it
+//   data is expected to arrive in time order across all series (live, or replay through MergeDatedDatums)
+//   with eLinear, a row is held until each column has seen a datum past the grid point, Flush releases what is held
+
+#include <vector>
+#include <deque>
+
+#include <boost/shared_ptr.hpp>
+
+#include <OUCommon/Delegate.h>
+
+#include <TFTimeSeries/TimeSeries.h>
+
+#include "TSBatch.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+namespace hf { // high frequency
+
+class TSPanel {
+public:
+
+  enum interpolation_t { ePreviousTick, eLinear };
+
+  typedef size_t column_t;
+
+  // struct of arrays: one time stamp per row, one column per series
+  struct Panel {
+    std::vector<ptime> vDateTime;
+    std::vector<std::vector<double> > vColumn;
+    size_t Rows( void ) const { return vDateTime.size(); };
+    size_t Columns( void ) const { return vColumn.size(); };
+    void Resize( size_t nRows, size_t nColumns );
+  };
+
+  struct Row {
+    ptime dt;
+    const std::vector<double>& vValue;  // one per column, in order of Attach/AddColumn
+    Row( ptime dt_, const std::vector<double>& vValue_ ): dt( dt_ ), vValue( vValue_ ) {};
+  };
+
+  TSPanel( time_duration interval, interpolation_t interpolation = ePreviousTick );
+  ~TSPanel( void );
+
+  // eg: Attach( quotes, &Quote::Midpoint ), Attach( trades, &Trade::Price ), columns are added before the first datum
+  template<class D>
+  column_t Attach( TimeSeries<D>& series, DatedDatum::price_t (D::*f)( void ) const ) {
+    column_t ix( AddColumn() );
+    m_vSource.push_back( pSource_t( new SourceT<D>( *this, ix, series, f ) ) );
+    return ix;
+  }
+
+  column_t AddColumn( void );  // for a source not held in a TimeSeries, feed it with Append
+  void Append( column_t ix, ptime dt, double value );
+  void Flush( void );  // emits rows up to the last datum, held columns resolve to the previous tick
+
+  ou::Delegate<const Row&> OnRow;
+
+  // first grid point at or after dt
+  static ptime Align( ptime dt, time_duration interval );
+
+  // bulk: rows on the grid in [ dtBegin, dtEnd ), each column filled in a single pass over its series
+  static void Build(
+    const std::vector<batch::Columns>& vColumns, ptime dtBegin, ptime dtEnd,
+    time_duration interval, interpolation_t interpolation, Panel& panel );
+
+protected:
+private:
+
+  struct Source {
+    virtual ~Source( void ) {};
+  };
+
+  template<class D>
+  class SourceT: public Source {
+  public:
+    typedef DatedDatum::price_t (D::*f_t)( void ) const;
+    SourceT( TSPanel& panel, column_t ix, TimeSeries<D>& series, f_t f )
+      : m_panel( panel ), m_ix( ix ), m_series( series ), m_f( f ) {
+      m_series.OnAppend.Add( MakeDelegate( this, &SourceT<D>::HandleDatum ) );
+    }
+    virtual ~SourceT( void ) {
+      m_series.OnAppend.Remove( MakeDelegate( this, &SourceT<D>::HandleDatum ) );
+    }
+  private:
+    TSPanel& m_panel;
+    column_t m_ix;
+    TimeSeries<D>& m_series;
+    f_t m_f;
+    void HandleDatum( const D& datum ) { m_panel.Append( m_ix, datum.DateTime(), ( datum.*m_f )() ); };
+  };
+
+  typedef boost::shared_ptr<Source> pSource_t;
+
+  struct Last {  // most recent datum in a column
+    ptime dt;
+    double value;
+    size_t ixHeld;  // first held row still waiting on this column (eLinear), as a sequence number
+    Last( void ): dt( not_a_date_time ), value( 0.0 ), ixHeld( 0 ) {};
+  };
+
+  struct Held {  // row waiting on columns to be interpolated (eLinear)
+    ptime dt;
+    std::vector<double> vValue;
+    size_t nWaiting;
+  };
+
+  time_duration m_tdInterval;
+  interpolation_t m_interpolation;
+
+  ptime m_dtMarker;  // next grid point to be emitted, or held
+  ptime m_dtLatest;  // most recent datum in any column
+
+  std::vector<pSource_t> m_vSource;
+  std::vector<Last> m_vLast;
+  std::vector<double> m_vRow;  // ePreviousTick scratch
+
+  std::deque<Held> m_dequeHeld;
+  size_t m_ixHeld;  // sequence number of the front of m_dequeHeld
+
+  void Mark( ptime dt );  // emits, or holds, each grid point before dt
+  void Release( void );  // emits held rows which are complete
+};
+
+} // namespace hf
+} // namespace tf
+} // namespace ou
@@ -38,15 +38,18 @@ OBJECTFILES= \
 	${OBJECTDIR}/Crossing.o \
 	${OBJECTDIR}/PivotGroup.o \
 	${OBJECTDIR}/Pivots.o \
+	${OBJECTDIR}/RunningCovariance.o \
 	${OBJECTDIR}/RunningMinMax.o \
 	${OBJECTDIR}/RunningStats.o \
 	${OBJECTDIR}/SlidingWindow.o \
 	${OBJECTDIR}/StatsInSlidingWindow.o \
+	${OBJECTDIR}/TSBatch.o \
 	${OBJECTDIR}/TSDifferential.o \
 	${OBJECTDIR}/TSEMA.o \
 	${OBJECTDIR}/TSHomogenization.o \
 	${OBJECTDIR}/TSMA.o \
 	${OBJECTDIR}/TSNorm.o \
+	${OBJECTDIR}/TSPanel.o \
 	${OBJECTDIR}/TSReturns.o \
 	${OBJECTDIR}/TSSWEfficiencyRatio.o \
 	${OBJECTDIR}/TSSWRateOfChange.o \
@@ -102,6 +105,11 @@ ${OBJECTDIR}/Pivots.o: Pivots.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/Pivots.o Pivots.cpp
 
+${OBJECTDIR}/RunningCovariance.o: RunningCovariance.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/RunningCovariance.o RunningCovariance.cpp
+
 ${OBJECTDIR}/RunningMinMax.o: RunningMinMax.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -122,6 +130,11 @@ ${OBJECTDIR}/StatsInSlidingWindow.o: StatsInSlidingWindow.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/StatsInSlidingWindow.o StatsInSlidingWindow.cpp
 
+${OBJECTDIR}/TSBatch.o: TSBatch.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TSBatch.o TSBatch.cpp
+
 ${OBJECTDIR}/TSDifferential.o: TSDifferential.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -147,6 +160,11 @@ ${OBJECTDIR}/TSNorm.o: TSNorm.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TSNorm.o TSNorm.cpp
 
+${OBJECTDIR}/TSPanel.o: TSPanel.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TSPanel.o TSPanel.cpp
+
 ${OBJECTDIR}/TSReturns.o: TSReturns.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
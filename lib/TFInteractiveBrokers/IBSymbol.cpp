@@ -97,8 +97,7 @@ void IBSymbol::AcceptTickPrice(TickType tickType, double price) {
   }
 }
 
-void IBSymbol::AcceptTickSize(TickType tickType, int size) {
-
+int IBSymbol::ScaleSize( int size ) const {
   switch ( m_pInstrument->GetInstrumentType() ) {
   case InstrumentType::Stock:
   case InstrumentType::ETF:
@@ -107,6 +106,12 @@ void IBSymbol::AcceptTickSize(TickType tickType, int size) {
   default:
     break;
   }
+  return size;
+}
+
+void IBSymbol::AcceptTickSize(TickType tickType, int size) {
+
+  size = ScaleSize( size );
 
   switch ( tickType ) {
     case TickType::BID_SIZE:
@@ -146,6 +151,48 @@ void IBSymbol::AcceptTickString(TickType tickType, const std::string& value) {
   }
 }
 
+void IBSymbol::ResetBook( void ) {
+  if ( 0 == m_pBook.get() ) {
+    m_pBook.reset( new OrderBook( GetInstrument()->GetMinTick() ) );
+  }
+  else {
+    m_pBook->Clear();
+  }
+}
+
+// operation: 0 insert, 1 update, 2 delete;  side: 0 ask, 1 bid
+// the book tracks the rows, subscribers see each row change as a MarketDepth, a delete has zero volume
+void IBSymbol::AcceptMarketDepth( int position, const std::string& sMarketMaker, int operation, int side, double price, int size ) {
+
+  OrderBook::ESide eSide = ( 1 == side ) ? MarketDepth::Bid : MarketDepth::Ask;
+  size_t ix( position );
+  OrderBook::volume_t volume( ScaleSize( size ) );
+
+  MarketDepth::MMID_t mmid( MarketDepth::PackMMID( sMarketMaker ) );
+  ptime dt( ou::TimeSource::Instance().External() );
+
+  switch ( operation ) {
+    case 0:
+      m_pBook->Insert( dt, eSide, ix, price, volume, mmid );
+      break;
+    case 1:
+      m_pBook->Update( dt, eSide, ix, price, volume, mmid );
+      break;
+    case 2:
+      if ( ix >= m_pBook->Rows( eSide ) ) return;
+      price = m_pBook->RowAt( eSide, ix ).price;
+      mmid = m_pBook->RowAt( eSide, ix ).mmid;
+      volume = 0;
+      m_pBook->Delete( dt, eSide, ix );
+      break;
+    default:
+      return;
+  }
+
+  MarketDepth md( dt, ( MarketDepth::Bid == eSide ) ? 'B' : 'S', volume, price, mmid );
+  m_OnDepth( md );
+}
+
 void IBSymbol::BuildQuote() {
 //  if ( m_bAskFound && m_bBidFound && m_bAskSizeFound && m_bBidSizeFound ) {
     if ( m_bAskFound || m_bBidFound ) {
@@ -16,7 +16,10 @@
 
 #include <stdexcept>
 
+#include <boost/scoped_ptr.hpp>
+
 #include <TFTimeSeries/DatedDatum.h>
+#include <TFTimeSeries/OrderBook.h>
 #include <TFTrading/Symbol.h>
 
 #ifndef IB_USE_STD_STRING
@@ -48,6 +51,8 @@ public:
 
   double OptionPrice( void ) { return m_dblOptionPrice; };
 
+  const OrderBook* Book( void ) const { return m_pBook.get(); };  // maintained while a depth watch is in progress, null before the first
+
 protected:
 
   TickerId m_TickerId;
@@ -91,14 +96,21 @@ protected:
   void AcceptTickPrice( TickType tickType, double price );
   void AcceptTickSize( TickType tickType, int size );
   void AcceptTickString( TickType tickType, const std::string& value );
+  void AcceptMarketDepth( int position, const std::string& sMarketMaker, int operation, int side, double price, int size );
 
   void BuildQuote( void );
   void BuildTrade( void );
 
+  void ResetBook( void );
+
 private:
 
   long m_conId;  // matches IB contract id
 
+  boost::scoped_ptr<OrderBook> m_pBook;  // created by the first depth watch
+
+  int ScaleSize( int size ) const;  // stock sizes arrive in round lots
+
 };
 
 } // namespace tf
@@ -77,6 +77,7 @@ IBTWS::IBTWS( const std::string &acctCode, const std::string &address, unsigned
   m_bProvidesQuotes = true;
   m_bProvidesTrades = true;
   m_bProvidesGreeks = true;
+  m_bProvidesDepth = true;
   m_pProvidesBrokerInterface = true;
 }
 
@@ -299,7 +300,14 @@ void IBTWS::StopQuoteTradeWatch( pSymbol_t pIBSymbol ) {
 void IBTWS::StartDepthWatch( pSymbol_t pIBSymbol) {  // overridden from base class
   if ( !pIBSymbol->GetDepthWatchInProgress() ) {
     // start watch
+    Contract contract;
+    contract.conId = pIBSymbol->GetInstrument()->GetContract();
+    contract.exchange = pIBSymbol->GetInstrument()->GetExchangeName();
+    contract.currency = pIBSymbol->GetInstrument()->GetCurrencyName();
+    pIBSymbol->ResetBook();
     pIBSymbol->SetDepthWatchInProgress();
+    TagValueListSPtr pMktDepthOptions;
+    pTWS->reqMktDepth( pIBSymbol->GetTickerId(), contract, nDepthRows, pMktDepthOptions );
   }
 }
 
@@ -308,6 +316,7 @@ void IBTWS::StopDepthWatch( pSymbol_t pIBSymbol) {  // overridden from base clas
   }
   else {
     // stop watch
+    pTWS->cancelMktDepth( pIBSymbol->GetTickerId() );
     pIBSymbol->ResetDepthWatchInProgress();
   }
 }
@@ -1200,10 +1209,22 @@ void IBTWS::connectionClosed() {
 
 void IBTWS::updateMktDepth(TickerId id, int position, int operation, int side,
                             double price, int size) {
+  if ( ( id > 0 ) && ( id <= m_curTickerId ) ) {
+    IBSymbol::pSymbol_t pSym( m_vTickerToSymbol[ id ] );
+    if ( pSym->GetDepthWatchInProgress() ) {
+      pSym->AcceptMarketDepth( position, "", operation, side, price, size );
+    }
+  }
 }
 
 void IBTWS::updateMktDepthL2(TickerId id, int position, std::string marketMaker, int operation,
                               int side, double price, int size) {
+  if ( ( id > 0 ) && ( id <= m_curTickerId ) ) {
+    IBSymbol::pSymbol_t pSym( m_vTickerToSymbol[ id ] );
+    if ( pSym->GetDepthWatchInProgress() ) {
+      pSym->AcceptMarketDepth( position, marketMaker, operation, side, price, size );
+    }
+  }
 }
 
 void IBTWS::managedAccounts( const std::string& accountsList) {
@@ -241,6 +241,8 @@ protected:
   static const char *szSecurityType[];
   static const char *szOrderType[];
 
+  static const int nDepthRows = 10;  // rows requested per side with reqMktDepth
+
   pSymbol_t NewCSymbol( pInstrument_t pInstrument );
 
   // overridden from ProviderInterface
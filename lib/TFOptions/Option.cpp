@@ -107,6 +107,7 @@ void Option::SaveSeries( const std::string& sPrefix ) {
 
   Watch::SaveSeries( sPrefix );
 
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );  // a WatchRecorder may be writing
   ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RDWR );
 
   // add in option attributes to the already written quotes and trades.
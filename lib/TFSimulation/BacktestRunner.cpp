@@ -0,0 +1,443 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <cassert>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+
+#include <boost/chrono/chrono.hpp>
+#include <boost/filesystem.hpp>
+
+#if defined( _WIN32 )
+#define NOMINMAX  // std::min and std::max
+#include <windows.h>
+#else
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "BacktestRunner.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+//
+// DayResult
+//
+
+BacktestRunner::DayResult::DayResult( void )
+: bOk( false ), dblPL( 0.0 ), dblCommission( 0.0 ), nFills( 0 ), dblMaxDrawdown( 0.0 ),
+  nDatums( 0 ), dblSeconds( 0.0 ), m_dblPeak( 0.0 )
+{
+}
+
+void BacktestRunner::DayResult::Mark( double dblPL_ ) {
+  dblPL = dblPL_;
+  if ( dblPL > m_dblPeak ) m_dblPeak = dblPL;
+  if ( ( m_dblPeak - dblPL ) > dblMaxDrawdown ) dblMaxDrawdown = m_dblPeak - dblPL;
+}
+
+//
+// BacktestRunner
+//
+
+BacktestRunner::BacktestRunner( void )
+: m_nWorkers( 1 ), m_dblSeconds( 0.0 )
+{
+}
+
+BacktestRunner::~BacktestRunner( void ) {
+}
+
+void BacktestRunner::SetWorkers( unsigned int nWorkers ) {
+  assert( 0 < nWorkers );
+  m_nWorkers = nWorkers;
+}
+
+void BacktestRunner::WeekDays( boost::gregorian::date dateBegin, boost::gregorian::date dateEnd, std::vector<boost::gregorian::date>& vDays ) {
+  vDays.clear();
+  for ( boost::gregorian::day_iterator iter( dateBegin ); *iter <= dateEnd; ++iter ) {
+    const boost::gregorian::greg_weekday wd( iter->day_of_week() );
+    if ( ( boost::gregorian::Saturday != wd ) && ( boost::gregorian::Sunday != wd ) ) vDays.push_back( *iter );
+  }
+}
+
+namespace {
+  const char szDayArgument[] = "--backtest-day";  // followed by the day, yyyymmdd, and the result file
+  // fields are copied as they lie in memory, the record only goes between processes of the same program
+  template<typename T>
+  void Put( std::string& s, const T& t ) {
+    s.append( reinterpret_cast<const char*>( &t ), sizeof( T ) );
+  }
+  template<typename T>
+  bool Get( const std::string& s, size_t& ix, T& t ) {
+    if ( s.size() < ix + sizeof( T ) ) return false;
+    std::memcpy( &t, s.data() + ix, sizeof( T ) );
+    ix += sizeof( T );
+    return true;
+  }
+}
+
+void BacktestRunner::Encode( const DayResult& result, std::string& s ) {
+  s.clear();
+  Put( s, (boost::uint32_t) result.day.day_number() );
+  Put( s, (boost::uint8_t) ( result.bOk ? 1 : 0 ) );
+  Put( s, result.dblPL );
+  Put( s, result.dblCommission );
+  Put( s, result.nFills );
+  Put( s, result.dblMaxDrawdown );
+  Put( s, result.nDatums );
+  Put( s, result.dblSeconds );
+  Put( s, (boost::uint32_t) result.sStats.size() );
+  s.append( result.sStats );
+}
+
+bool BacktestRunner::Decode( const std::string& s, DayResult& result ) {
+  size_t ix( 0 );
+  boost::uint32_t nDay;
+  boost::uint8_t bOk;
+  boost::uint32_t nStats;
+  if ( !( Get( s, ix, nDay ) && Get( s, ix, bOk )
+    && Get( s, ix, result.dblPL ) && Get( s, ix, result.dblCommission ) && Get( s, ix, result.nFills )
+    && Get( s, ix, result.dblMaxDrawdown ) && Get( s, ix, result.nDatums ) && Get( s, ix, result.dblSeconds )
+    && Get( s, ix, nStats ) ) ) return false;
+  if ( s.size() != ix + nStats ) return false;
+  result.day = boost::gregorian::date( boost::gregorian::gregorian_calendar::from_day_number( nDay ) );
+  result.bOk = ( 0 != bOk );
+  result.sStats.assign( s, ix, nStats );
+  return true;
+}
+
+void BacktestRunner::RunDay( const boost::gregorian::date& day, DayResult& result ) {
+  const boost::chrono::steady_clock::time_point tpStart( boost::chrono::steady_clock::now() );
+  result = DayResult();
+  result.day = day;
+  try {
+    m_OnRunDay( day, result );
+    result.bOk = true;
+  }
+  catch ( std::exception& e ) {
+    result.bOk = false;
+    result.sStats = e.what();
+  }
+  catch ( ... ) {
+    result.bOk = false;
+    result.sStats = "unknown exception";
+  }
+  result.dblSeconds = boost::chrono::duration<double>( boost::chrono::steady_clock::now() - tpStart ).count();
+}
+
+void BacktestRunner::DayProcess( int argc, char* argv[] ) {
+  for ( int ix = 1; ix + 2 < argc; ++ix ) {
+    if ( 0 == std::strcmp( szDayArgument, argv[ ix ] ) ) {
+      assert( 0 != m_OnRunDay );
+      DayResult result;
+      RunDay( boost::gregorian::from_undelimited_string( argv[ ix + 1 ] ), result );
+      std::string s;
+      Encode( result, s );
+      std::ofstream ofs( argv[ ix + 2 ], std::ios::binary );
+      ofs.write( s.data(), s.size() );
+      ofs.close();
+      std::exit( ofs ? 0 : 1 );
+    }
+  }
+}
+
+void BacktestRunner::Run( const std::vector<boost::gregorian::date>& vDays ) {
+
+  assert( 0 != m_OnRunDay );
+
+  const boost::chrono::steady_clock::time_point tpStart( boost::chrono::steady_clock::now() );
+
+  m_vResult.assign( vDays.size(), DayResult() );
+
+#if defined( _WIN32 )
+
+  struct Worker {
+    HANDLE hProcess;
+    size_t ix;  // of the day
+    std::string sFile;  // the day's record, written by the day's process
+  };
+  std::vector<Worker> vWorker;
+  size_t ixNext( 0 );
+
+  char szModule[ MAX_PATH ];
+  const DWORD nModule( GetModuleFileNameA( 0, szModule, MAX_PATH ) );
+  if ( ( 0 == nModule ) || ( MAX_PATH == nModule ) ) throw std::runtime_error( "BacktestRunner::Run GetModuleFileName failed" );
+  const unsigned int nWorkers( std::min<unsigned int>( m_nWorkers, MAXIMUM_WAIT_OBJECTS ) );
+
+  try {
+    while ( ( ixNext < vDays.size() ) || !vWorker.empty() ) {
+
+      // start days while workers are free
+      while ( ( ixNext < vDays.size() ) && ( vWorker.size() < nWorkers ) ) {
+        Worker worker;
+        worker.ix = ixNext;
+        worker.sFile = ( boost::filesystem::temp_directory_path() / boost::filesystem::unique_path( "backtest-%%%%-%%%%-%%%%" ) ).string();
+        std::stringstream ss;
+        ss << GetCommandLineA() << " " << szDayArgument << " " << boost::gregorian::to_iso_string( vDays[ ixNext ] ) << " \"" << worker.sFile << "\"";
+        std::string sCommand( ss.str() );
+        std::vector<char> vCommand( sCommand.begin(), sCommand.end() );  // CreateProcess may write to the command line
+        vCommand.push_back( 0 );
+        STARTUPINFOA si;
+        ZeroMemory( &si, sizeof( si ) );
+        si.cb = sizeof( si );
+        PROCESS_INFORMATION pi;
+        if ( !CreateProcessA( szModule, &vCommand[ 0 ], 0, 0, FALSE, 0, 0, 0, &si, &pi ) ) {
+          throw std::runtime_error( "BacktestRunner::Run CreateProcess failed" );
+        }
+        CloseHandle( pi.hThread );
+        worker.hProcess = pi.hProcess;
+        ++ixNext;
+        vWorker.push_back( worker );
+      }
+
+      // collect a day as its process ends
+      std::vector<HANDLE> vHandle( vWorker.size() );
+      for ( size_t ix = 0; ix < vWorker.size(); ++ix ) vHandle[ ix ] = vWorker[ ix ].hProcess;
+      const DWORD dwWait( WaitForMultipleObjects( (DWORD) vHandle.size(), &vHandle[ 0 ], FALSE, INFINITE ) );
+      if ( ( WAIT_OBJECT_0 > dwWait ) || ( WAIT_OBJECT_0 + vHandle.size() <= dwWait ) ) {
+        throw std::runtime_error( "BacktestRunner::Run WaitForMultipleObjects failed" );
+      }
+      const size_t ix( dwWait - WAIT_OBJECT_0 );
+      Worker worker( vWorker[ ix ] );
+      vWorker.erase( vWorker.begin() + ix );
+      DWORD dwExit( 1 );
+      GetExitCodeProcess( worker.hProcess, &dwExit );
+      CloseHandle( worker.hProcess );
+      std::string s;
+      {
+        std::ifstream ifs( worker.sFile.c_str(), std::ios::binary );
+        s.assign( std::istreambuf_iterator<char>( ifs ), std::istreambuf_iterator<char>() );
+      }
+      boost::system::error_code ec;
+      boost::filesystem::remove( worker.sFile, ec );
+      DayResult& result( m_vResult[ worker.ix ] );
+      if ( !( ( 0 == dwExit ) && Decode( s, result ) ) ) {
+        result = DayResult();
+        result.day = vDays[ worker.ix ];
+        std::stringstream ssExit;
+        ssExit << "process exited with " << dwExit;
+        result.sStats = ssExit.str();
+      }
+      if ( 0 != m_OnDayDone ) m_OnDayDone( result );
+    }
+  }
+  catch ( ... ) {
+    // no day is left running unseen
+    for ( std::vector<Worker>::iterator iter = vWorker.begin(); vWorker.end() != iter; ++iter ) {
+      WaitForSingleObject( iter->hProcess, INFINITE );
+      CloseHandle( iter->hProcess );
+      boost::system::error_code ec;
+      boost::filesystem::remove( iter->sFile, ec );
+    }
+    throw;
+  }
+
+#else
+
+  struct Worker {
+    pid_t pid;
+    int fd;  // read end of the day's pipe
+    size_t ix;  // of the day
+    std::string s;  // the day's record, as it arrives
+  };
+  std::vector<Worker> vWorker;
+  size_t ixNext( 0 );
+
+  std::cout.flush();  // otherwise each process writes out what is buffered again
+  std::cerr.flush();
+
+  try {
+    while ( ( ixNext < vDays.size() ) || !vWorker.empty() ) {
+
+      // start days while workers are free
+      while ( ( ixNext < vDays.size() ) && ( vWorker.size() < m_nWorkers ) ) {
+        int fd[ 2 ];
+        if ( 0 != pipe( fd ) ) throw std::runtime_error( "BacktestRunner::Run pipe failed" );
+        const pid_t pid( fork() );
+        if ( -1 == pid ) {
+          close( fd[ 0 ] );
+          close( fd[ 1 ] );
+          throw std::runtime_error( "BacktestRunner::Run fork failed" );
+        }
+        if ( 0 == pid ) {  // the day's process
+          close( fd[ 0 ] );
+          for ( std::vector<Worker>::const_iterator iter = vWorker.begin(); vWorker.end() != iter; ++iter ) close( iter->fd );
+          DayResult result;
+          RunDay( vDays[ ixNext ], result );
+          std::string s;
+          Encode( result, s );
+          size_t ix( 0 );
+          while ( ix < s.size() ) {
+            const ssize_t n( write( fd[ 1 ], s.data() + ix, s.size() - ix ) );
+            if ( 0 < n ) ix += n;
+            else if ( EINTR != errno ) break;
+          }
+          close( fd[ 1 ] );
+          std::cout.flush();
+          std::cerr.flush();
+          _exit( ( s.size() == ix ) ? 0 : 1 );  // skips the destructors of the caller's objects, copied with the fork
+        }
+        close( fd[ 1 ] );
+        Worker worker;
+        worker.pid = pid;
+        worker.fd = fd[ 0 ];
+        worker.ix = ixNext++;
+        vWorker.push_back( worker );
+      }
+
+      // collect from the days in progress, a day is done when its pipe closes
+      std::vector<pollfd> vPoll( vWorker.size() );
+      for ( size_t ix = 0; ix < vWorker.size(); ++ix ) {
+        vPoll[ ix ].fd = vWorker[ ix ].fd;
+        vPoll[ ix ].events = POLLIN;
+        vPoll[ ix ].revents = 0;
+      }
+      if ( -1 == poll( &vPoll[ 0 ], vPoll.size(), -1 ) ) {
+        if ( EINTR == errno ) continue;
+        throw std::runtime_error( "BacktestRunner::Run poll failed" );
+      }
+      for ( size_t ix = vWorker.size(); 0 < ix; ) {
+        --ix;
+        if ( 0 == vPoll[ ix ].revents ) continue;
+        char buf[ 4096 ];
+        const ssize_t n( read( vWorker[ ix ].fd, buf, sizeof( buf ) ) );
+        if ( 0 < n ) {
+          vWorker[ ix ].s.append( buf, n );
+          continue;
+        }
+        if ( ( -1 == n ) && ( EINTR == errno ) ) continue;
+        const Worker worker( vWorker[ ix ] );
+        vWorker.erase( vWorker.begin() + ix );
+        close( worker.fd );
+        int status( 0 );
+        while ( ( -1 == waitpid( worker.pid, &status, 0 ) ) && ( EINTR == errno ) );
+        DayResult& result( m_vResult[ worker.ix ] );
+        if ( !( WIFEXITED( status ) && ( 0 == WEXITSTATUS( status ) ) && Decode( worker.s, result ) ) ) {
+          result = DayResult();
+          result.day = vDays[ worker.ix ];
+          std::stringstream ss;
+          if ( WIFSIGNALED( status ) ) ss << "process ended by signal " << WTERMSIG( status );
+          else ss << "process exited with " << WEXITSTATUS( status );
+          result.sStats = ss.str();
+        }
+        if ( 0 != m_OnDayDone ) m_OnDayDone( result );
+      }
+    }
+  }
+  catch ( ... ) {
+    // no day is left running unseen, closing the pipe first lets a day which is writing end
+    for ( std::vector<Worker>::iterator iter = vWorker.begin(); vWorker.end() != iter; ++iter ) {
+      close( iter->fd );
+      int status( 0 );
+      while ( ( -1 == waitpid( iter->pid, &status, 0 ) ) && ( EINTR == errno ) );
+    }
+    throw;
+  }
+
+#endif
+
+  m_dblSeconds = boost::chrono::duration<double>( boost::chrono::steady_clock::now() - tpStart ).count();
+}
+
+void BacktestRunner::Report( std::ostream& os ) const {
+
+  size_t cntOk( 0 );
+  size_t cntWin( 0 );
+  double dblSum( 0.0 );
+  double dblSumSq( 0.0 );
+  double dblCommission( 0.0 );
+  boost::uint64_t nFills( 0 );
+  boost::uint64_t nDatums( 0 );
+  double dblBest( 0.0 );
+  double dblWorst( 0.0 );
+  double dblCumulative( 0.0 );
+  double dblPeak( 0.0 );
+  double dblMaxDrawdown( 0.0 );  // of the cumulative daily P&L
+  double dblMaxDayDrawdown( 0.0 );
+
+  os << "backtest: " << m_vResult.size() << " days, " << m_nWorkers << " workers, "
+    << std::fixed << std::setprecision( 1 ) << m_dblSeconds << "s" << std::endl;
+  os
+    << std::setw( 12 ) << "day"
+    << std::setw( 12 ) << "P&L"
+    << std::setw( 12 ) << "commission"
+    << std::setw( 8 ) << "fills"
+    << std::setw( 12 ) << "drawdown"
+    << std::setw( 12 ) << "datums"
+    << std::setw( 8 ) << "secs"
+    << std::endl;
+
+  for ( vDayResult_t::const_iterator iter = m_vResult.begin(); m_vResult.end() != iter; ++iter ) {
+    os << std::setw( 12 ) << boost::gregorian::to_iso_extended_string( iter->day );
+    if ( !iter->bOk ) {
+      os << "  failed: " << iter->sStats << std::endl;
+      continue;
+    }
+    os << std::setprecision( 2 )
+      << std::setw( 12 ) << iter->dblPL
+      << std::setw( 12 ) << iter->dblCommission
+      << std::setw( 8 ) << iter->nFills
+      << std::setw( 12 ) << iter->dblMaxDrawdown
+      << std::setw( 12 ) << iter->nDatums
+      << std::setprecision( 1 ) << std::setw( 8 ) << iter->dblSeconds
+      << std::endl;
+    if ( 0 == cntOk ) {
+      dblBest = dblWorst = iter->dblPL;
+    }
+    else {
+      dblBest = std::max( dblBest, iter->dblPL );
+      dblWorst = std::min( dblWorst, iter->dblPL );
+    }
+    ++cntOk;
+    if ( 0.0 < iter->dblPL ) ++cntWin;
+    dblSum += iter->dblPL;
+    dblSumSq += iter->dblPL * iter->dblPL;
+    dblCommission += iter->dblCommission;
+    nFills += iter->nFills;
+    nDatums += iter->nDatums;
+    dblCumulative += iter->dblPL;
+    dblPeak = std::max( dblPeak, dblCumulative );
+    dblMaxDrawdown = std::max( dblMaxDrawdown, dblPeak - dblCumulative );
+    dblMaxDayDrawdown = std::max( dblMaxDayDrawdown, iter->dblMaxDrawdown );
+  }
+
+  const double dblMean( ( 0 == cntOk ) ? 0.0 : dblSum / cntOk );
+  const double dblVariance( ( 1 >= cntOk ) ? 0.0 : ( dblSumSq - dblSum * dblMean ) / ( cntOk - 1 ) );
+  const double dblStdDev( ( 0.0 < dblVariance ) ? std::sqrt( dblVariance ) : 0.0 );
+
+  os << std::setprecision( 2 )
+    << "days run: " << cntOk << ", failed: " << ( m_vResult.size() - cntOk ) << ", winning: " << cntWin << std::endl
+    << "total P&L: " << dblSum << ", commission: " << dblCommission << ", fills: " << nFills << ", datums: " << nDatums << std::endl
+    << "daily P&L mean: " << dblMean << ", std dev: " << dblStdDev << ", best: " << dblBest << ", worst: " << dblWorst << std::endl
+    << "sharpe (daily, x sqrt(252)): " << ( ( 0.0 < dblStdDev ) ? ( dblMean / dblStdDev * std::sqrt( 252.0 ) ) : 0.0 ) << std::endl
+    << "max drawdown across days: " << dblMaxDrawdown << ", largest within a day: " << dblMaxDayDrawdown << std::endl;
+}
+
+} // namespace tf
+} // namespace ou
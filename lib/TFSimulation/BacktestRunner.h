@@ -0,0 +1,114 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// runs a strategy over many recorded days, several days at a time
+// each day runs in a process of its own, with at most nWorkers at once:
+//   TimeSource, the managers and the other singletons start afresh for each day,
+//   so the day's OnRunDay sets up its own SimulationProvider, and reads the hdf5 file read only
+//   the caller should not have the hdf5 file open when calling Run, nor other threads running (only the calling thread is forked)
+// OnRunDay fills in a DayResult, which comes back to the caller through a pipe
+// a day whose process fails (exception, non-zero exit, signal) is reported as such, the others carry on
+// if Run throws (pipe, fork or process creation failed), it first waits for the days already started
+// Report consolidates the days: a line per day, then totals, daily statistics, and drawdown across days
+// windows, without fork: each day's process is the program started again, with its command line and a day argument,
+//   main calls DayProcess once OnRunDay is set, and before anything else is started;
+//   in a day's process DayProcess runs the day and exits, the result comes back through a temporary file
+//   (DayProcess returns at once in the caller, and on other systems, where days are forked)
+// How to Use:
+/*
+  int main( int argc, char* argv[] ) {
+    ou::tf::BacktestRunner runner;
+    runner.SetOnRunDay( MakeDelegate( &strategy, &Strategy::RunDay ) );
+    runner.DayProcess( argc, argv );
+    ...
+    runner.Run( vDays );
+  }
+*/
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+#include <OUCommon/FastDelegate.h>
+using namespace fastdelegate;
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class BacktestRunner {
+public:
+
+  struct DayResult {
+    boost::gregorian::date day;
+    bool bOk;  // false when the day's process failed
+    double dblPL;  // closing profit and loss, commissions included
+    double dblCommission;
+    boost::uint32_t nFills;
+    double dblMaxDrawdown;  // from the highest P&L of the day, see Mark
+    boost::uint64_t nDatums;
+    double dblSeconds;  // wall clock of the day's process
+    std::string sStats;  // free form, eg SimulationProvider::EmitStats or Portfolio::EmitStats
+    DayResult( void );
+    void Mark( double dblPL_ );  // call as the day's P&L changes, tracks dblPL and dblMaxDrawdown
+  private:
+    double m_dblPeak;  // the day starts flat
+  };
+
+  typedef std::vector<DayResult> vDayResult_t;
+
+  typedef FastDelegate2<boost::gregorian::date, DayResult&> OnRunDay_t;  // called in the day's process
+  typedef FastDelegate1<const DayResult&> OnDayDone_t;  // called in the caller's process, as each day finishes
+
+  BacktestRunner( void );
+  ~BacktestRunner( void );
+
+  void SetOnRunDay( OnRunDay_t function ) { m_OnRunDay = function; };
+  void SetOnDayDone( OnDayDone_t function ) { m_OnDayDone = function; };
+
+  void SetWorkers( unsigned int nWorkers );  // 1 (default) runs the days in turn
+  unsigned int GetWorkers( void ) const { return m_nWorkers; };
+
+  static void WeekDays( boost::gregorian::date dateBegin, boost::gregorian::date dateEnd, std::vector<boost::gregorian::date>& vDays );  // inclusive
+
+  void Run( const std::vector<boost::gregorian::date>& vDays );  // results in the order of vDays
+  void DayProcess( int argc, char* argv[] );  // see above, doesn't return in a day's process
+
+  const vDayResult_t& Results( void ) const { return m_vResult; };
+  double GetSeconds( void ) const { return m_dblSeconds; };  // wall clock of the last Run
+
+  void Report( std::ostream& os ) const;
+
+protected:
+private:
+
+  OnRunDay_t m_OnRunDay;
+  OnDayDone_t m_OnDayDone;
+  unsigned int m_nWorkers;
+
+  vDayResult_t m_vResult;
+  double m_dblSeconds;
+
+  void RunDay( const boost::gregorian::date& day, DayResult& result );  // in the day's process
+
+  static void Encode( const DayResult& result, std::string& s );
+  static bool Decode( const std::string& s, DayResult& result );
+};
+
+} // namespace tf
+} // namespace ou
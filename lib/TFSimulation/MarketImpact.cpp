@@ -0,0 +1,209 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+
+#include "MarketImpact.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+//
+// MarketImpact
+//
+
+boost::uint32_t MarketImpact::Touch( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice ) {
+  if ( OrderSide::Buy == side ) {
+    dblPrice = quote.Ask();
+    return std::min<boost::uint32_t>( nQuan, quote.AskSize() );
+  }
+  else {
+    dblPrice = quote.Bid();
+    return std::min<boost::uint32_t>( nQuan, quote.BidSize() );
+  }
+}
+
+//
+// MarketImpactLinear
+//
+
+MarketImpactLinear::MarketImpactLinear( double dblLambda )
+: m_dblLambda( dblLambda )
+{
+  assert( 0.0 <= dblLambda );
+}
+
+boost::uint32_t MarketImpactLinear::Fill( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice ) {
+  const double dblImpact( m_dblLambda * (double) nQuan );
+  dblPrice = ( OrderSide::Buy == side ) ? ( quote.Ask() + dblImpact ) : ( quote.Bid() - dblImpact );
+  return nQuan;
+}
+
+//
+// MarketImpactSqrt
+//
+
+MarketImpactSqrt::MarketImpactSqrt( double dblY, time_duration tdWindow, unsigned int nBuckets )
+: m_dblY( dblY ), m_tdBucket( tdWindow / nBuckets ), m_vBucket( nBuckets ), m_ixBucket( 0 ), m_dtBucketEnd( not_a_date_time ),
+  m_nVolume( 0 ), m_dblSumSq( 0.0 ), m_dblMid( 0.0 ), m_dblMidAtTrade( 0.0 )
+{
+  assert( 0 < nBuckets );
+  assert( time_duration( 0, 0, 0 ) < m_tdBucket );
+}
+
+void MarketImpactSqrt::NewQuote( const Quote& quote ) {
+  if ( quote.IsValid() ) m_dblMid = quote.Midpoint();
+}
+
+void MarketImpactSqrt::Roll( const ptime& dt ) {
+  // step the current bucket forward to the one holding dt, emptying those it passes
+  if ( m_dtBucketEnd.is_not_a_date_time() ) {
+    m_dtBucketEnd = dt + m_tdBucket;
+    return;
+  }
+  size_t cnt( 0 );
+  while ( m_dtBucketEnd <= dt ) {
+    if ( m_vBucket.size() == cnt ) {  // a gap longer than the window, the rest are empty already
+      m_dtBucketEnd = dt + m_tdBucket;
+      break;
+    }
+    m_ixBucket = ( m_vBucket.size() == m_ixBucket + 1 ) ? 0 : m_ixBucket + 1;
+    Bucket& bucket( m_vBucket[ m_ixBucket ] );
+    m_nVolume -= bucket.nVolume;
+    m_dblSumSq -= bucket.dblSumSq;
+    bucket = Bucket();
+    m_dtBucketEnd += m_tdBucket;
+    ++cnt;
+  }
+  if ( 0 == m_nVolume ) m_dblSumSq = 0.0;  // window empty, drop the rounding left over from the subtractions
+}
+
+void MarketImpactSqrt::NewTrade( const Trade& trade ) {
+  if ( m_dtBucketEnd.is_not_a_date_time() || ( m_dtBucketEnd <= trade.DateTime() ) ) Roll( trade.DateTime() );
+  Bucket& bucket( m_vBucket[ m_ixBucket ] );
+  bucket.nVolume += trade.Volume();
+  m_nVolume += trade.Volume();
+  if ( ( 0.0 != m_dblMid ) && ( 0.0 != m_dblMidAtTrade ) ) {
+    const double dblChange( m_dblMid - m_dblMidAtTrade );
+    bucket.dblSumSq += dblChange * dblChange;
+    m_dblSumSq += dblChange * dblChange;
+  }
+  m_dblMidAtTrade = m_dblMid;
+}
+
+double MarketImpactSqrt::GetSigma( void ) const {
+  return ( 0.0 < m_dblSumSq ) ? std::sqrt( m_dblSumSq ) : 0.0;
+}
+
+boost::uint32_t MarketImpactSqrt::Fill( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice ) {
+  if ( 0 == m_nVolume ) {
+    return Touch( side, nQuan, quote, dblPrice );
+  }
+  const double dblImpact( m_dblY * GetSigma() * std::sqrt( (double) nQuan / (double) m_nVolume ) );
+  dblPrice = ( OrderSide::Buy == side ) ? ( quote.Ask() + dblImpact ) : ( quote.Bid() - dblImpact );
+  return nQuan;
+}
+
+//
+// MarketImpactBook
+//
+
+namespace {
+  // orders indices into the entries by price, best first
+  template<typename V> struct ByPrice {
+    const V& v;
+    bool bLower;  // asks, the lowest price first
+    ByPrice( const V& v_, bool bLower_ ): v( v_ ), bLower( bLower_ ) {};
+    bool operator()( size_t lhs, size_t rhs ) const {
+      return bLower ? ( v[ lhs ].dblPrice < v[ rhs ].dblPrice ) : ( v[ lhs ].dblPrice > v[ rhs ].dblPrice );
+    };
+  };
+  template<typename E> bool Empty( const E& entry ) { return 0 == entry.nShares; };
+}
+
+void MarketImpactBook::Update( vEntry_t& vEntry, const MarketDepth& depth ) {
+  vEntry_t::iterator iter = vEntry.begin();
+  while ( ( vEntry.end() != iter ) && ( depth.MMID() != iter->mmid ) ) ++iter;
+  if ( ( 0 != depth.Volume() ) && ( 0.0 != depth.Price() ) ) {
+    if ( vEntry.end() == iter ) {
+      vEntry.push_back( Entry( depth.MMID(), depth.Price(), depth.Volume() ) );
+    }
+    else {
+      iter->dblPrice = depth.Price();
+      iter->nShares = depth.Volume();
+    }
+  }
+  else {  // market maker has left the side
+    if ( vEntry.end() != iter ) {
+      *iter = vEntry.back();
+      vEntry.pop_back();
+    }
+  }
+}
+
+void MarketImpactBook::NewDepth( const MarketDepth& depth ) {
+  switch ( depth.m_eSide ) {
+    case MarketDepth::Bid:
+      Update( m_vBids, depth );
+      break;
+    case MarketDepth::Ask:
+      Update( m_vAsks, depth );
+      break;
+    default:
+      break;
+  }
+}
+
+boost::uint32_t MarketImpactBook::Fill( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice ) {
+  // entries inside the touch are stale, the quote has moved through them
+  // (compared with a little slack, as depth and quote prices may not round the same)
+  const bool bBuy( OrderSide::Buy == side );
+  vEntry_t& vEntry( bBuy ? m_vAsks : m_vBids );
+  m_vScratch.clear();
+  if ( bBuy ) {
+    const double dblLimit( quote.Ask() * ( 1.0 - 1e-9 ) );
+    for ( size_t ix = 0; ix < vEntry.size(); ++ix ) {
+      if ( dblLimit <= vEntry[ ix ].dblPrice ) m_vScratch.push_back( ix );
+    }
+  }
+  else {
+    const double dblLimit( quote.Bid() * ( 1.0 + 1e-9 ) );
+    for ( size_t ix = 0; ix < vEntry.size(); ++ix ) {
+      if ( dblLimit >= vEntry[ ix ].dblPrice ) m_vScratch.push_back( ix );
+    }
+  }
+  std::sort( m_vScratch.begin(), m_vScratch.end(), ByPrice<vEntry_t>( vEntry, bBuy ) );
+  boost::uint32_t nFill( 0 );
+  double dblValue( 0.0 );
+  for ( std::vector<size_t>::const_iterator iter = m_vScratch.begin(); ( m_vScratch.end() != iter ) && ( nFill < nQuan ); ++iter ) {
+    Entry& entry( vEntry[ *iter ] );
+    const boost::uint32_t n( (boost::uint32_t) std::min<boost::uint64_t>( nQuan - nFill, entry.nShares ) );
+    nFill += n;
+    dblValue += entry.dblPrice * (double) n;
+    entry.nShares -= n;  // consumed
+  }
+  if ( 0 == nFill ) {
+    return Touch( side, nQuan, quote, dblPrice );
+  }
+  vEntry.erase( std::remove_if( vEntry.begin(), vEntry.end(), Empty<Entry> ), vEntry.end() );
+  dblPrice = dblValue / (double) nFill;
+  return nFill;
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,134 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// price impact of simulated market orders, see SimulateOrderExecution::SetMarketImpact
+// one model object per symbol, it sees the symbol's quotes, trades and depth ahead of the order processing
+// without a model, a market order fills at the touch for up to the displayed size, the rest waits for the next quote
+// with a model, the model decides how much fills on each quote, and at what average price
+// models keep their state in fixed size structures, updated in constant time per datum (depth excepted)
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+
+#include <TFTimeSeries/DatedDatum.h>
+#include <TFTrading/TradingEnumerations.h>
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class MarketImpact {
+public:
+
+  typedef boost::shared_ptr<MarketImpact> pMarketImpact_t;
+
+  MarketImpact( void ) {};
+  virtual ~MarketImpact( void ) {};
+
+  virtual void NewQuote( const Quote& ) {};
+  virtual void NewTrade( const Trade& ) {};
+  virtual void NewDepth( const MarketDepth& ) {};
+
+  // for a market order with nQuan remaining, on arrival of quote:
+  //   returns the quantity to fill now, zero to wait for the next quote, and sets dblPrice to its average price
+  virtual boost::uint32_t Fill( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice ) = 0;
+
+protected:
+
+  // the behaviour without a model
+  static boost::uint32_t Touch( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice );
+
+private:
+};
+
+// temporary impact linear in order size: the whole order fills now, at the touch moved by dblLambda per share
+class MarketImpactLinear: public MarketImpact {
+public:
+  explicit MarketImpactLinear( double dblLambda );  // price per share
+  virtual ~MarketImpactLinear( void ) {};
+  virtual boost::uint32_t Fill( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice );
+protected:
+private:
+  double m_dblLambda;
+};
+
+// square root law: the whole order fills now, at the touch moved by dblY * sigma * sqrt( quan / volume )
+//   volume: shares traded in the trailing window
+//   sigma: realized volatility of the midpoint over the same window, in price, sampled at each trade
+//     (midpoint rather than trade prices, so the bid/ask bounce doesn't count as volatility)
+// the window is a ring of buckets, each trade adds to the current bucket, buckets falling out of the window are subtracted
+// needs trades: the symbol's trade watch is to be on, until there is volume in the window, fills are as without a model
+class MarketImpactSqrt: public MarketImpact {
+public:
+  MarketImpactSqrt( double dblY = 1.0, time_duration tdWindow = minutes( 30 ), unsigned int nBuckets = 30 );
+  virtual ~MarketImpactSqrt( void ) {};
+  virtual void NewQuote( const Quote& quote );
+  virtual void NewTrade( const Trade& trade );
+  virtual boost::uint32_t Fill( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice );
+  boost::uint64_t GetVolume( void ) const { return m_nVolume; };
+  double GetSigma( void ) const;
+protected:
+private:
+  struct Bucket {
+    boost::uint64_t nVolume;
+    double dblSumSq;  // squared changes of the midpoint between trades
+    Bucket( void ): nVolume( 0 ), dblSumSq( 0.0 ) {};
+  };
+  double m_dblY;
+  time_duration m_tdBucket;
+  std::vector<Bucket> m_vBucket;
+  size_t m_ixBucket;  // current
+  ptime m_dtBucketEnd;  // end of the current bucket
+  boost::uint64_t m_nVolume;  // totals over the window
+  double m_dblSumSq;
+  double m_dblMid;  // at the last quote
+  double m_dblMidAtTrade;  // at the last trade
+  void Roll( const ptime& dt );
+};
+
+// walk the book: fills against the depth at or beyond the touch, at the average price of the depth consumed
+//   quantity beyond the displayed depth waits for the next quote
+//   the shares consumed are taken off the entries, so the next order walks what is left,
+//   until the market maker's next update replaces its entry
+// the book is kept as the latest MarketDepth entry of each market maker on each side
+//   an update overwrites the market maker's entry in place, entries are only sorted when an order fills,
+//   as depth updates far outnumber fills
+// without depth on the order's side, fills are as without a model
+class MarketImpactBook: public MarketImpact {
+public:
+  MarketImpactBook( void ) {};
+  virtual ~MarketImpactBook( void ) {};
+  virtual void NewDepth( const MarketDepth& depth );
+  virtual boost::uint32_t Fill( OrderSide::enumOrderSide side, boost::uint32_t nQuan, const Quote& quote, double& dblPrice );
+protected:
+private:
+  struct Entry {
+    MarketDepth::MMID_t mmid;
+    double dblPrice;
+    MarketDepth::volume_t nShares;
+    Entry( MarketDepth::MMID_t mmid_, double dblPrice_, MarketDepth::volume_t nShares_ )
+      : mmid( mmid_ ), dblPrice( dblPrice_ ), nShares( nShares_ ) {};
+  };
+  typedef std::vector<Entry> vEntry_t;  // a few dozen market makers at most, scanned rather than hashed
+  vEntry_t m_vBids;
+  vEntry_t m_vAsks;
+  std::vector<size_t> m_vScratch;  // indices of the entries at or beyond the touch, sorted for a fill
+  static void Update( vEntry_t& vEntry, const MarketDepth& depth );
+};
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,149 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+
+#include "stdafx.h"
+
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+
+#include <TFTrading/KeyTypes.h>
+
+#include "PaperTradingProvider.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+PaperTradingProvider::PaperTradingProvider( void )
+: ProviderInterface<PaperTradingProvider,PaperTradingSymbol>(),
+  m_tdOrderDelay( milliseconds( 500 ) ), m_dblCommission( 1.00 )  // as SimulateOrderExecution
+{
+  m_sName = "PaperTrading";
+  m_nID = keytypes::EProviderPaper;
+
+  m_pProvidesBrokerInterface = true;
+}
+
+PaperTradingProvider::~PaperTradingProvider( void ) {
+  Disconnect();
+}
+
+void PaperTradingProvider::SetDataProvider( pDataProvider_t pProvider ) {
+  if ( m_bConnected ) throw std::runtime_error( "PaperTradingProvider::SetDataProvider: disconnect first" );
+  m_pDataProvider = pProvider;
+}
+
+void PaperTradingProvider::Connect( void ) {
+  if ( !m_bConnected ) {
+    if ( 0 == m_pDataProvider.get() ) throw std::invalid_argument( "PaperTradingProvider::Connect: no data provider" );
+    OnConnecting( 0 );
+    m_io.reset();
+    m_pWork.reset( new boost::asio::io_service::work( m_io ) );
+    m_threadExecution = boost::thread( boost::bind( &PaperTradingProvider::ExecutionThread, this ) );
+    for ( m_mapSymbols_t::iterator iter = m_mapSymbols.begin(); m_mapSymbols.end() != iter; ++iter ) {
+      Watch( iter->second );
+    }
+    m_bConnected = true;
+    ProviderInterface::Connect();
+    OnConnected( 0 );
+  }
+}
+
+void PaperTradingProvider::Disconnect( void ) {
+  if ( m_bConnected ) {
+    OnDisconnecting( 0 );
+    for ( m_mapSymbols_t::iterator iter = m_mapSymbols.begin(); m_mapSymbols.end() != iter; ++iter ) {
+      Unwatch( iter->second );
+    }
+    m_pWork.reset();  // the thread ends once what has been posted is processed
+    m_threadExecution.join();
+    m_bConnected = false;
+    ProviderInterface::Disconnect();
+    OnDisconnected( 0 );
+  }
+}
+
+void PaperTradingProvider::ExecutionThread( void ) {
+  if ( 0 != m_OnExecutionThreadStarted ) m_OnExecutionThreadStarted();
+  m_io.run();
+  if ( 0 != m_OnExecutionThreadEnded ) m_OnExecutionThreadEnded();
+}
+
+PaperTradingProvider::pSymbol_t PaperTradingProvider::NewCSymbol( PaperTradingSymbol::pInstrument_t pInstrument ) {
+  pSymbol_t pSymbol( new PaperTradingSymbol( pInstrument->GetInstrumentName( m_nID ), pInstrument, m_io ) );
+  pSymbol->m_simExec.SetOnOrderFill( MakeDelegate( this, &PaperTradingProvider::HandleExecution ) );
+  pSymbol->m_simExec.SetOnCommission( MakeDelegate( this, &PaperTradingProvider::HandleCommission ) );
+  pSymbol->m_simExec.SetOnOrderCancelled( MakeDelegate( this, &PaperTradingProvider::HandleCancellation ) );
+  pSymbol->m_simExec.SetOrderDelay( m_tdOrderDelay );
+  pSymbol->m_simExec.SetCommission( m_dblCommission );
+  inherited_t::AddCSymbol( pSymbol );
+  if ( m_bConnected ) Watch( pSymbol );
+  return pSymbol;
+}
+
+void PaperTradingProvider::Watch( pSymbol_t pSymbol ) {
+  if ( !pSymbol->m_bWatching ) {
+    m_pDataProvider->AddQuoteHandler( pSymbol->GetInstrument(), MakeDelegate( pSymbol.get(), &PaperTradingSymbol::HandleQuote ) );
+    m_pDataProvider->AddTradeHandler( pSymbol->GetInstrument(), MakeDelegate( pSymbol.get(), &PaperTradingSymbol::HandleTrade ) );
+    pSymbol->m_bWatching = true;
+  }
+}
+
+void PaperTradingProvider::Unwatch( pSymbol_t pSymbol ) {
+  if ( pSymbol->m_bWatching ) {
+    m_pDataProvider->RemoveQuoteHandler( pSymbol->GetInstrument(), MakeDelegate( pSymbol.get(), &PaperTradingSymbol::HandleQuote ) );
+    m_pDataProvider->RemoveTradeHandler( pSymbol->GetInstrument(), MakeDelegate( pSymbol.get(), &PaperTradingSymbol::HandleTrade ) );
+    pSymbol->m_bWatching = false;
+  }
+}
+
+void PaperTradingProvider::PlaceOrder( pOrder_t pOrder ) {
+  if ( !m_bConnected ) throw std::runtime_error( "PaperTradingProvider::PlaceOrder: not connected" );
+  inherited_t::PlaceOrder( pOrder ); // any underlying initialization
+  m_mapSymbols_t::iterator iter;
+  if ( !Exists( pOrder->GetInstrument(), iter ) ) {
+    Add( pOrder->GetInstrument() );  // starts the quote/trade stream from the data provider
+    iter = m_mapSymbols.find( pOrder->GetInstrument()->GetInstrumentName( m_nID ) );
+    assert( m_mapSymbols.end() != iter );
+  }
+  m_io.post( boost::bind( &SimulateOrderExecution::SubmitOrder, &iter->second->m_simExec, pOrder ) );
+}
+
+void PaperTradingProvider::CancelOrder( pOrder_t pOrder ) {
+  inherited_t::CancelOrder( pOrder );
+  m_mapSymbols_t::iterator iter;
+  if ( !Exists( pOrder->GetInstrument(), iter ) ) {
+    std::cout << "Can't cancel order, can't find symbol: " << pOrder->GetInstrument()->GetInstrumentName( m_nID ) << std::endl;
+  }
+  else {
+    m_io.post( boost::bind( &SimulateOrderExecution::CancelOrder, &iter->second->m_simExec, pOrder->GetOrderId() ) );
+  }
+}
+
+// these are called in the execution thread
+void PaperTradingProvider::HandleExecution( Order::idOrder_t orderId, const Execution &exec ) {
+  OrderManager::LocalCommonInstance().ReportExecution( orderId, exec );
+}
+
+void PaperTradingProvider::HandleCommission( Order::idOrder_t orderId, double commission ) {
+  OrderManager::LocalCommonInstance().ReportCommission( orderId, commission );
+}
+
+void PaperTradingProvider::HandleCancellation( Order::idOrder_t orderId ) {
+  OrderManager::LocalCommonInstance().ReportCancellation( orderId );
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,106 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+
+#pragma once
+
+// paper trading: orders are filled by a SimulateOrderExecution per symbol, against live quotes and trades
+// from a data provider (IQFeed, IB, ...), fills are reported through OrderManager as with any execution provider
+// fill simulation runs in a thread of its own, the data provider's thread only copies each quote/trade across
+// the symbol is attached to the data provider when the first order is placed on it
+
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <OUCommon/FastDelegate.h>
+using namespace fastdelegate;
+
+#include <TFTrading/ProviderInterface.h>
+#include <TFTrading/Order.h>
+
+#include "PaperTradingSymbol.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class PaperTradingProvider
+: public ProviderInterface<PaperTradingProvider,PaperTradingSymbol>
+{
+public:
+
+  typedef boost::shared_ptr<PaperTradingProvider> pProvider_t;
+  typedef ProviderInterface<PaperTradingProvider,PaperTradingSymbol> inherited_t;
+  typedef ProviderInterfaceBase::pProvider_t pDataProvider_t;
+  typedef Instrument::pInstrument_t pInstrument_t;
+  typedef Instrument::pInstrument_cref pInstrument_cref;
+  typedef Order::pOrder_t pOrder_t;
+  typedef inherited_t::pSymbol_t pSymbol_t;
+
+  PaperTradingProvider( void );
+  virtual ~PaperTradingProvider( void );
+
+  void SetDataProvider( pDataProvider_t pProvider );  // before Connect
+  pDataProvider_t GetDataProvider( void ) { return m_pDataProvider; };
+
+  // applied to symbols as they are created
+  void SetOrderDelay( const time_duration& td ) { m_tdOrderDelay = td; };
+  void SetCommission( double dblCommission ) { m_dblCommission = dblCommission; };
+
+  virtual void Connect( void );  // starts the execution thread
+  virtual void Disconnect( void );  // detaches from the data provider, and ends the execution thread
+
+  void PlaceOrder( pOrder_t pOrder );
+  void CancelOrder( pOrder_t pOrder );
+
+  typedef FastDelegate0<> OnExecutionThreadStarted_t; // Allows Singleton LocalCommonInstances to be set, called within new thread
+  void SetOnExecutionThreadStarted( OnExecutionThreadStarted_t function ) {
+    m_OnExecutionThreadStarted = function;
+  }
+  typedef FastDelegate0<> OnExecutionThreadEnded_t; // Allows Singleton LocalCommonInstances to be reset
+  void SetOnExecutionThreadEnded( OnExecutionThreadEnded_t function ) {
+    m_OnExecutionThreadEnded = function;
+  }
+
+protected:
+
+  pSymbol_t NewCSymbol( PaperTradingSymbol::pInstrument_t pInstrument );
+
+  void HandleExecution( Order::idOrder_t orderId, const Execution &exec );
+  void HandleCommission( Order::idOrder_t orderId, double commission );
+  void HandleCancellation( Order::idOrder_t orderId );
+
+private:
+
+  pDataProvider_t m_pDataProvider;
+
+  time_duration m_tdOrderDelay;
+  double m_dblCommission;
+
+  boost::asio::io_service m_io;
+  boost::scoped_ptr<boost::asio::io_service::work> m_pWork;  // keeps the execution thread running
+  boost::thread m_threadExecution;
+
+  OnExecutionThreadStarted_t m_OnExecutionThreadStarted;
+  OnExecutionThreadEnded_t m_OnExecutionThreadEnded;
+
+  void Watch( pSymbol_t pSymbol );
+  void Unwatch( pSymbol_t pSymbol );
+
+  void ExecutionThread( void );  // runs m_io
+};
+
+} // namespace tf
+} // namespace ou
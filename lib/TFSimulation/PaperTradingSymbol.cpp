@@ -0,0 +1,42 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+
+#include "stdafx.h"
+
+#include <boost/bind.hpp>
+
+#include "PaperTradingSymbol.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+PaperTradingSymbol::PaperTradingSymbol( const std::string& sSymbol, pInstrument_cref pInstrument, boost::asio::io_service& io )
+: Symbol<PaperTradingSymbol>( pInstrument, sSymbol ), m_io( io ), m_bWatching( false )
+{
+}
+
+PaperTradingSymbol::~PaperTradingSymbol( void ) {
+}
+
+void PaperTradingSymbol::HandleQuote( const Quote& quote ) {
+  m_io.post( boost::bind( &SimulateOrderExecution::NewQuote, &m_simExec, quote ) );
+}
+
+void PaperTradingSymbol::HandleTrade( const Trade& trade ) {
+  m_io.post( boost::bind( &SimulateOrderExecution::NewTrade, &m_simExec, trade ) );
+}
+
+} // namespace tf
+} // namespace ou
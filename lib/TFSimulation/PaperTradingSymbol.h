@@ -0,0 +1,62 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+
+#pragma once
+
+// per symbol state for PaperTradingProvider
+// quotes and trades arrive in the data provider's thread, and are posted, by value, to the execution thread
+// m_simExec is only touched in the execution thread
+
+#include <string>
+
+#include <boost/asio/io_service.hpp>
+
+#include "TFTimeSeries/DatedDatum.h"
+#include "TFTrading/Symbol.h"
+
+#include "SimulateOrderExecution.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class PaperTradingSymbol: public Symbol<PaperTradingSymbol> {
+  friend class PaperTradingProvider;
+public:
+
+  typedef Symbol<PaperTradingSymbol> inherited_t;
+  typedef inherited_t::pInstrument_t pInstrument_t;
+  typedef inherited_t::pInstrument_cref pInstrument_cref;
+
+  PaperTradingSymbol( const std::string& sSymbol, pInstrument_cref pInstrument, boost::asio::io_service& io );
+  ~PaperTradingSymbol( void );
+
+protected:
+
+  boost::asio::io_service& m_io;  // the execution thread
+
+  SimulateOrderExecution m_simExec;
+
+  bool m_bWatching;  // handlers are attached to the data provider
+
+  // called in the data provider's thread
+  void HandleQuote( const Quote& quote );
+  void HandleTrade( const Trade& trade );
+
+private:
+
+};
+
+} // namespace tf
+} // namespace ou
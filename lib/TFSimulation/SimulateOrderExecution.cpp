@@ -14,6 +14,10 @@
 
 #include "stdafx.h"
 
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
 #include <OUCommon/TimeSource.h>
 
 #include "SimulateOrderExecution.h"
@@ -23,8 +27,17 @@ namespace tf { // TradeFrame
 
 int SimulateOrderExecution::m_nExecId( 1000 );
 
+const size_t SimulateOrderExecution::nNull( std::numeric_limits<size_t>::max() );
+
+SimulateOrderExecution::LimitSide::LimitSide( void )
+: tickBase( 0 ), 
+  tickLo( std::numeric_limits<tick_t>::max() ), tickHi( std::numeric_limits<tick_t>::min() ),
+  cntOrders( 0 )
+{
+}
+
 SimulateOrderExecution::SimulateOrderExecution(void)
-: m_dtQueueDelay( milliseconds( 500 ) ), m_dblCommission( 1.00 )//, m_ea( EAQuotes )
+: m_dtQueueDelay( milliseconds( 500 ) ), m_dblCommission( 1.00 ), m_dblTickSize( 0.0 ), m_pnExecId( &m_nExecId )//, m_ea( EAQuotes )
 {
 }
 
@@ -32,14 +45,20 @@ SimulateOrderExecution::~SimulateOrderExecution(void) {
 }
 
 void SimulateOrderExecution::NewTrade( const Trade& trade ) {
+  if ( 0 != m_pImpact.get() ) m_pImpact->NewTrade( trade );
   ProcessLimitOrders( trade );
 }
 
 void SimulateOrderExecution::NewQuote( const Quote& quote ) {
+  if ( 0 != m_pImpact.get() ) m_pImpact->NewQuote( quote );
   ProcessOrderQueues( quote );
   m_lastQuote = quote;
 }
 
+void SimulateOrderExecution::NewDepth( const MarketDepth& depth ) {
+  if ( 0 != m_pImpact.get() ) m_pImpact->NewDepth( depth );
+}
+
 void SimulateOrderExecution::SubmitOrder( pOrder_t pOrder ) {
   m_lOrderDelay.push_back( pOrder );
 }
@@ -86,6 +105,8 @@ void SimulateOrderExecution::ProcessOrderQueues( const Quote &quote ) {
 
   ProcessStopOrders( quote ); // places orders into market orders queue
 
+  UpdateQueuesAhead( quote );
+
   bool bProcessed;
   bProcessed = ProcessMarketOrders( quote );
   if ( !bProcessed ) {
@@ -129,11 +150,16 @@ bool SimulateOrderExecution::ProcessMarketOrders( const Quote& quote ) {
         throw std::runtime_error( "SimulateOrderExecution::ProcessMarketOrders unknown order side" );
         break;
     }
+    if ( 0 != m_pImpact.get() ) {
+      quanAvail = m_pImpact->Fill( orderSide, nOrderQuanRemaining, quote, dblPrice );
+      assert( quanAvail <= nOrderQuanRemaining );
+      if ( 0 == quanAvail ) return false;  // the model holds the order for the next quote, limit orders get their turn
+    }
 
     // execute order
     if ( 0 != OnOrderFill ) {
       std::string id;
-      int nId( m_nExecId );  // before it gets incremented in next function
+      int nId( *m_pnExecId );  // before it gets incremented in next function
       GetExecId( &id );
       // using id in first parameter may or may not work
       Execution exec( nId, pOrderFrontOfQueue->GetOrderId(), dblPrice, quanAvail, orderSide, "SIMMkt", id );
@@ -158,72 +184,259 @@ bool SimulateOrderExecution::ProcessMarketOrders( const Quote& quote ) {
 
 bool SimulateOrderExecution::ProcessLimitOrders( const Quote& quote ) {
 
-  pOrder_t pOrderFrontOfQueue; // change this so we reference the order directly, makes things a bit faster
   bool bProcessed = false;
-  boost::uint32_t nOrderQuanRemaining = 0;
+
+  if ( ( 0 == m_bids.cntOrders ) && ( 0 == m_asks.cntOrders ) ) return bProcessed;
 
   // todo: what about self's own crossing orders, could fill with out qoute
 
-  if ( !m_mapAsks.empty() ) {
-    if ( quote.Bid() >= m_mapAsks.begin()->first ) { 
-      bProcessed = true;
-      pOrderFrontOfQueue = m_mapAsks.begin()->second;
-      nOrderQuanRemaining = pOrderFrontOfQueue->GetQuanRemaining();
-      assert( 0 != nOrderQuanRemaining );
-      Trade::tradesize_t quanAvail = std::min<Trade::tradesize_t>( nOrderQuanRemaining, quote.BidSize() );
-      if ( 0 != OnOrderFill ) {
-        std::string id;
-        GetExecId( &id );
-        Execution exec( quote.Bid(), quanAvail, OrderSide::Sell, "SIMLmtSell", id );
-        OnOrderFill( pOrderFrontOfQueue->GetOrderId(), exec );
-        nOrderQuanRemaining -= quanAvail;
-        if ( 0 == nOrderQuanRemaining ) {
-          CalculateCommission( pOrderFrontOfQueue.get(), pOrderFrontOfQueue->GetQuanFilled() );
-          m_mapAsks.erase( m_mapAsks.begin() );
-        }
-      }
+  tick_t tickBid( ToTick( quote.Bid() ) );
+  tick_t tickAsk( ToTick( quote.Ask() ) );
+
+  // a quote through the limit price fills from the quoted size, at the quoted price
+  if ( ( 0 != m_asks.cntOrders ) && ( tickBid >= m_asks.tickLo ) ) {
+    bProcessed = true;
+    CrossLimitOrders( m_asks, m_asks.tickLo, std::min( m_asks.tickHi, tickBid ), 1, quote.Bid(), quote.BidSize() );
+  }
+  if ( ( 0 != m_bids.cntOrders ) && ( tickAsk <= m_bids.tickHi ) ) {
+    bProcessed = true;
+    CrossLimitOrders( m_bids, m_bids.tickHi, std::max( m_bids.tickLo, tickAsk ), -1, quote.Ask(), quote.AskSize() );
+  }
+
+  return bProcessed;
+}
+
+bool SimulateOrderExecution::ProcessLimitOrders( const Trade& trade ) {
+
+  bool bProcessed = false;
+
+  if ( ( 0 == m_bids.cntOrders ) && ( 0 == m_asks.cntOrders ) ) return bProcessed;
+
+  // the aggressor isn't known, so the trade's volume is available to each side
+  tick_t tickTrade( ToTick( trade.Price() ) );
+  boost::uint32_t nVolume;
+
+  if ( ( 0 != m_asks.cntOrders ) && ( tickTrade >= m_asks.tickLo ) ) {
+    bProcessed = true;
+    nVolume = trade.Volume();
+    if ( tickTrade > m_asks.tickLo ) {  // traded through, these levels would have been taken first
+      nVolume = CrossLimitOrders( m_asks, m_asks.tickLo, std::min( m_asks.tickHi, tickTrade - 1 ), 1, 0.0, nVolume );
+    }
+    if ( ( 0 != nVolume ) && ( 0 != m_asks.cntOrders ) && ( tickTrade >= m_asks.tickLo ) && ( tickTrade <= m_asks.tickHi ) ) {
+      DrainLimitOrders( m_asks, tickTrade, nVolume );
     }
   }
-  if ( !m_mapBids.empty() && !bProcessed) {
-    if ( quote.Ask() <= m_mapBids.rbegin()->first ) {
-      bProcessed = true;
-      pOrderFrontOfQueue = m_mapBids.rbegin()->second;
-      nOrderQuanRemaining = pOrderFrontOfQueue->GetQuanRemaining();
-      assert( 0 != nOrderQuanRemaining );
-      Trade::tradesize_t quanAvail = std::min<Trade::tradesize_t>( nOrderQuanRemaining, quote.AskSize() );
-      if ( 0 != OnOrderFill ) {
-        std::string id;
-        GetExecId( &id );
-        Execution exec( quote.Ask(), quanAvail, OrderSide::Buy, "SIMLmtBuy", id );
-        OnOrderFill( pOrderFrontOfQueue->GetOrderId(), exec );
-        nOrderQuanRemaining -= quanAvail;
-        if ( 0 == nOrderQuanRemaining ) {
-          CalculateCommission( pOrderFrontOfQueue.get(), pOrderFrontOfQueue->GetQuanFilled() );
-          m_mapBids.erase( --m_mapBids.rbegin().base() );
-        }
-      }
+  if ( ( 0 != m_bids.cntOrders ) && ( tickTrade <= m_bids.tickHi ) ) {
+    bProcessed = true;
+    nVolume = trade.Volume();
+    if ( tickTrade < m_bids.tickHi ) {
+      nVolume = CrossLimitOrders( m_bids, m_bids.tickHi, std::max( m_bids.tickLo, tickTrade + 1 ), -1, 0.0, nVolume );
+    }
+    if ( ( 0 != nVolume ) && ( 0 != m_bids.cntOrders ) && ( tickTrade >= m_bids.tickLo ) && ( tickTrade <= m_bids.tickHi ) ) {
+      DrainLimitOrders( m_bids, tickTrade, nVolume );
     }
   }
 
   return bProcessed;
 }
 
-bool SimulateOrderExecution::ProcessLimitOrders( const Trade& trade ) {
-  //bool bAllow( true );
-  double bid( trade.Price() );
-  double ask( trade.Price() );
-  if ( !m_mapAsks.empty() ) {
-    if ( m_lastQuote.Ask() <= m_mapAsks.begin()->first ) {
-      ask = m_lastQuote.Ask();
+SimulateOrderExecution::tick_t SimulateOrderExecution::ToTick( double price ) const {
+  return (tick_t) std::floor( price / m_dblTickSize + 0.5 );
+}
+
+SimulateOrderExecution::Level& SimulateOrderExecution::GetLevel( LimitSide& side, tick_t tick ) {
+  static const tick_t nMargin( 64 );  // levels added beyond the one needed, so growth is infrequent
+  if ( side.vLevel.empty() ) {
+    side.tickBase = tick - nMargin;
+    side.vLevel.resize( 2 * nMargin );
+  }
+  else {
+    if ( tick < side.tickBase ) {
+      tick_t n( side.tickBase - tick + nMargin );
+      side.vLevel.insert( side.vLevel.begin(), n, Level() );
+      side.tickBase -= n;
+    }
+    else {
+      if ( (size_t)( tick - side.tickBase ) >= side.vLevel.size() ) {
+        side.vLevel.resize( tick - side.tickBase + nMargin );
+      }
+    }
+  }
+  return side.vLevel[ tick - side.tickBase ];
+}
+
+void SimulateOrderExecution::InsertLimitOrder( pOrder_t pOrder ) {
+
+  if ( 0.0 == m_dblTickSize ) {
+    m_dblTickSize = pOrder->GetInstrument()->GetMinTick();
+    if ( 0.0 >= m_dblTickSize ) m_dblTickSize = 0.01;
+  }
+
+  size_t ix;
+  if ( m_vFree.empty() ) {
+    ix = m_vResting.size();
+    m_vResting.push_back( RestingOrder() );
+  }
+  else {
+    ix = m_vFree.back();
+    m_vFree.pop_back();
+  }
+
+  RestingOrder& ro( m_vResting[ ix ] );
+  ro.pOrder = pOrder;
+  ro.nRemaining = pOrder->GetQuanRemaining();
+  ro.nAhead = 0;
+  ro.bAheadKnown = false;
+  ro.tick = ToTick( pOrder->GetPrice1() );
+  ro.ixNext = nNull;
+
+  LimitSide& side( OrderSide::Buy == pOrder->GetOrderSide() ? m_bids : m_asks );
+  Level& level( GetLevel( side, ro.tick ) );
+  ro.ixPrev = level.ixTail;
+  if ( nNull == level.ixTail ) {
+    level.ixHead = ix;
+  }
+  else {
+    m_vResting[ level.ixTail ].ixNext = ix;
+  }
+  level.ixTail = ix;
+
+  if ( 0 == side.cntOrders ) {
+    side.tickLo = side.tickHi = ro.tick;
+  }
+  else {
+    side.tickLo = std::min( side.tickLo, ro.tick );
+    side.tickHi = std::max( side.tickHi, ro.tick );
+  }
+  ++side.cntOrders;
+
+  m_mapResting[ pOrder->GetOrderId() ] = ix;
+}
+
+void SimulateOrderExecution::RemoveLimitOrder( size_t ix ) {
+
+  RestingOrder& ro( m_vResting[ ix ] );
+  LimitSide& side( OrderSide::Buy == ro.pOrder->GetOrderSide() ? m_bids : m_asks );
+  Level& level( side.vLevel[ ro.tick - side.tickBase ] );
+
+  if ( nNull == ro.ixPrev ) {
+    level.ixHead = ro.ixNext;
+  }
+  else {
+    m_vResting[ ro.ixPrev ].ixNext = ro.ixNext;
+  }
+  if ( nNull == ro.ixNext ) {
+    level.ixTail = ro.ixPrev;
+  }
+  else {
+    m_vResting[ ro.ixNext ].ixPrev = ro.ixPrev;
+  }
+
+  --side.cntOrders;
+  if ( 0 == side.cntOrders ) {
+    side.tickLo = std::numeric_limits<tick_t>::max();
+    side.tickHi = std::numeric_limits<tick_t>::min();
+  }
+
+  m_mapResting.erase( ro.pOrder->GetOrderId() );
+  ro.pOrder.reset();
+  m_vFree.push_back( ix );
+}
+
+void SimulateOrderExecution::FillLimitOrder( size_t ix, double dblPrice, boost::uint32_t quan ) {
+
+  pOrder_t pOrder( m_vResting[ ix ].pOrder );
+  OrderSide::enumOrderSide orderSide = pOrder->GetOrderSide();
+
+  if ( 0 != OnOrderFill ) {
+    std::string id;
+    GetExecId( &id );
+    Execution exec( dblPrice, quan, orderSide, OrderSide::Buy == orderSide ? "SIMLmtBuy" : "SIMLmtSell", id );
+    OnOrderFill( pOrder->GetOrderId(), exec );
+  }
+
+  RestingOrder& ro( m_vResting[ ix ] );
+  ro.nRemaining -= quan;
+  if ( 0 == ro.nRemaining ) {
+    CalculateCommission( pOrder.get(), pOrder->GetQuanFilled() );
+    RemoveLimitOrder( ix );
+  }
+}
+
+boost::uint32_t SimulateOrderExecution::CrossLimitOrders(
+  LimitSide& side, tick_t tickFirst, tick_t tickLast, int step, double dblPrice, boost::uint32_t nVolume
+) {
+  // levels from tickFirst through tickLast, best first, each in arrival order
+  // dblPrice of 0.0 fills at the order's own limit
+  for ( tick_t tick = tickFirst; 0 != nVolume; tick += step ) {
+    size_t ix( side.vLevel[ tick - side.tickBase ].ixHead );
+    while ( ( nNull != ix ) && ( 0 != nVolume ) ) {
+      RestingOrder& ro( m_vResting[ ix ] );
+      size_t ixNext( ro.ixNext );
+      ro.nAhead = 0;
+      ro.bAheadKnown = true;
+      boost::uint32_t quan( std::min( ro.nRemaining, nVolume ) );
+      nVolume -= quan;
+      FillLimitOrder( ix, ( 0.0 == dblPrice ) ? ro.pOrder->GetPrice1() : dblPrice, quan );
+      ix = ixNext;
+    }
+    if ( tickLast == tick ) break;
+  }
+  return nVolume;
+}
+
+void SimulateOrderExecution::DrainLimitOrders( LimitSide& side, tick_t tick, boost::uint32_t nVolume ) {
+  // a trade at the level first works through the size ahead of each order,
+  //   what is left fills the orders, which share it in arrival order
+  // volume which filled an earlier order is not available to later ones, not even to work through their size ahead
+  boost::uint32_t nUsed( 0 );
+  size_t ix( side.vLevel[ tick - side.tickBase ].ixHead );
+  while ( ( nNull != ix ) && ( nVolume > nUsed ) ) {
+    RestingOrder& ro( m_vResting[ ix ] );
+    size_t ixNext( ro.ixNext );
+    if ( ro.bAheadKnown ) {
+      boost::uint32_t nAvailable( nVolume - nUsed );
+      boost::uint32_t nAheadTraded( std::min( ro.nAhead, nAvailable ) );
+      ro.nAhead -= nAheadTraded;
+      if ( nAvailable > nAheadTraded ) {
+        boost::uint32_t quan( std::min( ro.nRemaining, nAvailable - nAheadTraded ) );
+        nUsed += quan;
+        FillLimitOrder( ix, ro.pOrder->GetPrice1(), quan );
+      }
     }
+    ix = ixNext;
   }
-  if ( !m_mapBids.empty() ) {
-    if ( m_lastQuote.Bid() >= m_mapBids.rbegin()->first ) {
-      bid = m_lastQuote.Bid();
+}
+
+void SimulateOrderExecution::UpdateQueuesAhead( const Quote& quote ) {
+
+  if ( ( 0 == m_bids.cntOrders ) && ( 0 == m_asks.cntOrders ) ) return;
+
+  tick_t tickBid( ToTick( quote.Bid() ) );
+  tick_t tickAsk( ToTick( quote.Ask() ) );
+
+  LimitSide* rSide[] = { &m_bids, &m_asks };
+  for ( int ixSide = 0; ixSide < 2; ++ixSide ) {
+    LimitSide& side( *rSide[ ixSide ] );
+    if ( 0 == side.cntOrders ) continue;
+    // inside the spread, nothing is displayed ahead
+    for ( tick_t tick = std::max( side.tickLo, tickBid + 1 ); tick <= std::min( side.tickHi, tickAsk - 1 ); ++tick ) {
+      for ( size_t ix = side.vLevel[ tick - side.tickBase ].ixHead; nNull != ix; ix = m_vResting[ ix ].ixNext ) {
+        m_vResting[ ix ].nAhead = 0;
+        m_vResting[ ix ].bAheadKnown = true;
+      }
+    }
+    // at the top of book, no more than what is displayed
+    tick_t tickTop( 0 == ixSide ? tickBid : tickAsk );
+    boost::uint32_t nDisplayed( 0 == ixSide ? quote.BidSize() : quote.AskSize() );
+    if ( ( tickTop >= side.tickLo ) && ( tickTop <= side.tickHi ) ) {
+      for ( size_t ix = side.vLevel[ tickTop - side.tickBase ].ixHead; nNull != ix; ix = m_vResting[ ix ].ixNext ) {
+        RestingOrder& ro( m_vResting[ ix ] );
+        ro.nAhead = ro.bAheadKnown ? std::min( ro.nAhead, nDisplayed ) : nDisplayed;
+        ro.bAheadKnown = true;
+      }
     }
   }
-  Quote quote( trade.DateTime(), bid, trade.Volume(), ask, trade.Volume() );
-  return ProcessLimitOrders( quote );
 }
 
 void SimulateOrderExecution::ProcessDelayQueue( const Quote& quote ) {
@@ -260,10 +473,8 @@ void SimulateOrderExecution::ProcessDelayQueue( const Quote& quote ) {
           assert( 0 < pOrderFrontOfQueue->GetPrice1() );
           switch ( pOrderFrontOfQueue->GetOrderSide() ) {
             case OrderSide::Buy:
-              m_mapBids.insert( mapOrderBook_pair_t( pOrderFrontOfQueue->GetPrice1(), pOrderFrontOfQueue ) );
-              break;
             case OrderSide::Sell:
-              m_mapAsks.insert( mapOrderBook_pair_t( pOrderFrontOfQueue->GetPrice1(), pOrderFrontOfQueue ) );
+              InsertLimitOrder( pOrderFrontOfQueue );
               break;
             default:
               break;
@@ -330,37 +541,17 @@ void SimulateOrderExecution::ProcessCancelQueue( const Quote& quote ) {
         }
       }
 
-      // need to check orders in ask limit list
+      // need to check orders in the limit book
       if ( !bOrderFound ) { 
-        for ( mapOrderBook_iter_t iter = m_mapAsks.begin(); iter != m_mapAsks.end(); ++iter ) {
-          if ( co.nOrderId == iter->second->GetOrderId() ) {
-            if ( co.nOrderId == m_mapAsks.begin()->second->GetOrderId() ) {
-              boost::uint32_t nOrderQuanProcessed = iter->second->GetQuanFilled();
-              if ( 0 != nOrderQuanProcessed ) {  // partially processed order, so commission it out before full cancel
-                CalculateCommission( iter->second.get(), nOrderQuanProcessed );
-              }
-            }
-            m_mapAsks.erase( iter );
-            bOrderFound = true;
-            break;
-          }
-        }
-      }
-
-      // need to check orders in bid limit list
-      if ( !bOrderFound ) { 
-        for ( mapOrderBook_iter_t iter = m_mapBids.begin(); iter != m_mapBids.end(); ++iter ) {
-          if ( co.nOrderId == iter->second->GetOrderId() ) {
-            if ( co.nOrderId == m_mapBids.rbegin()->second->GetOrderId() ) {
-              boost::uint32_t nOrderQuanProcessed = iter->second->GetQuanFilled();
-              if ( 0 != nOrderQuanProcessed ) {  // partially processed order, so commission it out before full cancel
-                CalculateCommission( iter->second.get(), nOrderQuanProcessed );
-              }
-            }
-            m_mapBids.erase( iter );
-            bOrderFound = true;
-            break;
+        mapResting_t::iterator iter = m_mapResting.find( co.nOrderId );
+        if ( m_mapResting.end() != iter ) {
+          pOrder_t pOrder( m_vResting[ iter->second ].pOrder );
+          boost::uint32_t nOrderQuanProcessed = pOrder->GetQuanFilled();
+          if ( 0 != nOrderQuanProcessed ) {  // partially processed order, so commission it out before full cancel
+            CalculateCommission( pOrder.get(), nOrderQuanProcessed );
           }
+          RemoveLimitOrder( iter->second );
+          bOrderFound = true;
         }
       }
 
@@ -15,16 +15,19 @@
 #pragma once
 
 // 2012/01/01  could find a way to feed live data in and simulate executions against live quote/tick data
+//   PaperTradingProvider does this, one instance per symbol, fed from a live data provider
 // is this really needed?  useful if no paper trading available
 
 #include <map>
-#include <list>
+#include <deque>
+#include <vector>
 #include <string>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 using namespace boost::posix_time;
 using namespace boost::gregorian;
 #include <boost/lexical_cast.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <OUCommon/FastDelegate.h>
 using namespace fastdelegate;
@@ -33,6 +36,8 @@ using namespace fastdelegate;
 #include <TFTrading/Order.h>
 #include <TFTrading/Execution.h>
 
+#include "MarketImpact.h"
+
 namespace ou { // One Unified
 namespace tf { // TradeFrame
 
@@ -64,8 +69,17 @@ public:
   void SetOrderDelay( const time_duration &dtOrderDelay ) { m_dtQueueDelay = dtOrderDelay; };
   void SetCommission( double Commission ) { m_dblCommission = Commission; };
 
+  // prices market orders, one model per symbol, not shared, see MarketImpact.h
+  typedef MarketImpact::pMarketImpact_t pMarketImpact_t;
+  void SetMarketImpact( pMarketImpact_t pImpact ) { m_pImpact = pImpact; };
+
+  // execution ids are drawn from a counter shared by the symbols of a run, so they don't depend on earlier runs
+  //   by default, a counter common to all objects in the process
+  void SetExecIdCounter( int* pnExecId ) { m_pnExecId = ( 0 == pnExecId ) ? &m_nExecId : pnExecId; };
+
   void NewTrade( const Trade& trade );
   void NewQuote( const Quote& quote );
+  void NewDepth( const MarketDepth& depth );  // only of use to a market impact model
 
   void SubmitOrder( pOrder_t pOrder );
   void CancelOrder( Order::idOrder_t nOrderId );
@@ -83,25 +97,72 @@ protected:
 
   Quote m_lastQuote;
 
+  pMarketImpact_t m_pImpact;
+
   OnOrderCancelledHandler OnOrderCancelled;
   OnOrderFillHandler OnOrderFill;
   OnNoOrderFoundHandler OnNoOrderFound;
   OnCommissionHandler OnCommission;
 
-  typedef std::list<pOrder_t> lOrderQueue_t;
+  typedef std::deque<pOrder_t> lOrderQueue_t;  // deque: blocks are reused, no node per order
   typedef lOrderQueue_t::iterator lOrderQueue_iter_t;
-  std::list<structCancelOrder> m_lCancelDelay; // separate structure for the cancellations, since not an order
+  std::deque<structCancelOrder> m_lCancelDelay; // separate structure for the cancellations, since not an order
   lOrderQueue_t m_lOrderDelay;  // all orders put in delay queue, taken out then processed as limit or market or stop
   lOrderQueue_t m_lOrderMarket;  // market orders to be processed
 
   typedef std::multimap<double,pOrder_t> mapOrderBook_t;
   typedef mapOrderBook_t::iterator mapOrderBook_iter_t;
   typedef std::pair<double,pOrder_t> mapOrderBook_pair_t;
-  mapOrderBook_t m_mapAsks; // lowest at beginning
-  mapOrderBook_t m_mapBids; // highest at end
   mapOrderBook_t m_mapSellStops;  // pending sell stops, turned into market order when touched
   mapOrderBook_t m_mapBuyStops;  // pending buy stops, turned into market order when touched
 
+  // limit book:  price levels in arrays indexed by tick, orders at a level linked in arrival order
+  // each order carries an estimate of the displayed size in front of it:
+  //   set from the quoted size when its level is first seen at the top of book (zero when inside the spread),
+  //   reduced by trades printed at its level, and capped by the quoted size as it shrinks
+  // an order fills once the size in front of it has traded, or when a quote or trade crosses its price,
+  //   in each case no more than the volume available
+  typedef boost::int32_t tick_t;
+  static const size_t nNull;  // end of list
+  struct RestingOrder {
+    pOrder_t pOrder;
+    boost::uint32_t nRemaining;
+    boost::uint32_t nAhead;  // displayed size estimated in front of this order
+    bool bAheadKnown;  // false until the level has been at the top of book
+    tick_t tick;
+    size_t ixPrev;
+    size_t ixNext;
+  };
+  struct Level {
+    size_t ixHead;
+    size_t ixTail;
+    Level( void ): ixHead( nNull ), ixTail( nNull ) {};
+  };
+  struct LimitSide {
+    tick_t tickBase;  // tick of vLevel[ 0 ]
+    tick_t tickLo;  // range of levels with orders, may be wider than needed
+    tick_t tickHi;
+    size_t cntOrders;
+    std::vector<Level> vLevel;
+    LimitSide( void );
+  };
+  LimitSide m_bids;
+  LimitSide m_asks;
+  std::vector<RestingOrder> m_vResting;  // entries are recycled through m_vFree
+  std::vector<size_t> m_vFree;
+  typedef boost::unordered_map<Order::idOrder_t,size_t> mapResting_t;
+  mapResting_t m_mapResting;  // for cancellations
+  double m_dblTickSize;  // from the instrument of the first limit order
+
+  tick_t ToTick( double price ) const;
+  Level& GetLevel( LimitSide& side, tick_t tick );
+  void InsertLimitOrder( pOrder_t pOrder );
+  void RemoveLimitOrder( size_t ix );
+  void FillLimitOrder( size_t ix, double dblPrice, boost::uint32_t quan );  // removed once done
+  void UpdateQueuesAhead( const Quote& quote );
+  boost::uint32_t CrossLimitOrders( LimitSide& side, tick_t tickFirst, tick_t tickLast, int step, double dblPrice, boost::uint32_t nVolume );
+  void DrainLimitOrders( LimitSide& side, tick_t tick, boost::uint32_t nVolume );
+
   void ProcessOrderQueues( const Quote& quote );
   void CalculateCommission( Order* pOrder, Trade::tradesize_t quan );
   void ProcessCancelQueue( const Quote& quote );
@@ -112,8 +173,9 @@ protected:
   bool ProcessLimitOrders( const Trade& trade );
 
   static int m_nExecId;  // static provides unique number across universe of symbols
+  int* m_pnExecId;  // m_nExecId, or a run's counter
   void GetExecId( std::string* sId ) { 
-    *sId = boost::lexical_cast<std::string>( m_nExecId++ );
+    *sId = boost::lexical_cast<std::string>( (*m_pnExecId)++ );
     assert( 0 != sId->length() );
     return;
   }
@@ -16,10 +16,15 @@
 
 #include <stdexcept>
 #include <cassert>
+#include <iomanip>
 
 #include <TFHDF5TimeSeries/HDF5DataManager.h>
 #include <TFTrading/KeyTypes.h>
 
+#ifdef OU_PROFILE
+#include <OUCommon/Profiler.h>
+#endif
+
 #include "SimulationProvider.h"
 
 namespace ou { // One Unified
@@ -27,7 +32,8 @@ namespace tf { // TradeFrame
 
 SimulationProvider::SimulationProvider(void)
 : ProviderInterface<SimulationProvider,SimulationSymbol>(), 
-  m_pMerge( 0 )
+  m_dayTickStore( not_a_date_time ), m_tdSlice( 0, 0, 0 ), m_bReadAhead( true ), m_dtStart( not_a_date_time ), m_tdWarmUp( 0, 0, 0 ), m_pTimers( 0 ), m_dblPace( 0.0 ), m_bDeterministic( false ), 
+  m_pMerge( 0 ), m_nExecId( 1000 ), m_nChecksumDatums( 0 )
 {
   m_sName = "Simulator";
   m_nID = keytypes::EProviderSimulator;
@@ -35,11 +41,13 @@ SimulationProvider::SimulationProvider(void)
   m_bProvidesQuotes = true;
   m_bProvidesTrades = true;
   m_bProvidesGreeks = true;
+  m_bProvidesDepth = true;
   m_pProvidesBrokerInterface = true;
 }
 
 SimulationProvider::~SimulationProvider(void) {
 
+  boost::mutex::scoped_lock lock( m_mutexMerge );
   if ( 0 != m_pMerge ) {
     delete m_pMerge;
     m_pMerge = NULL;
@@ -60,6 +68,47 @@ void SimulationProvider::SetGroupDirectory( const std::string sGroupDirectory )
   m_sGroupDirectory = sGroupDirectory;
 }
 
+void SimulationProvider::SetTickStore( const std::string& sRoot, boost::gregorian::date day ) {
+  if ( !sRoot.empty() && day.is_special() ) throw std::invalid_argument( "Tick store needs a day" );
+  m_sTickStore = sRoot;
+  m_dayTickStore = day;
+  for ( m_mapSymbols_t::iterator iter = m_mapSymbols.begin(); m_mapSymbols.end() != iter; ++iter ) {
+    iter->second->SetTickStore( sRoot, day );
+  }
+}
+
+void SimulationProvider::SetSliceDuration( time_duration td ) {
+  m_tdSlice = td;
+  for ( m_mapSymbols_t::iterator iter = m_mapSymbols.begin(); m_mapSymbols.end() != iter; ++iter ) {
+    iter->second->SetSliceDuration( td );
+    iter->second->SetReadAhead( ReadAhead() );
+  }
+}
+
+void SimulationProvider::SetReadAhead( bool bReadAhead ) {
+  m_bReadAhead = bReadAhead;
+  for ( m_mapSymbols_t::iterator iter = m_mapSymbols.begin(); m_mapSymbols.end() != iter; ++iter ) {
+    iter->second->SetReadAhead( ReadAhead() );
+  }
+}
+
+SliceReader* SimulationProvider::ReadAhead( void ) {
+  if ( !m_bReadAhead || ( time_duration( 0, 0, 0 ) == m_tdSlice ) ) return 0;
+  if ( 0 == m_pSliceReader.get() ) {
+    m_pSliceReader.reset( new SliceReader );
+  }
+  return m_pSliceReader.get();
+}
+
+void SimulationProvider::SetStart( ptime dtStart, time_duration tdWarmUp ) {
+  m_dtStart = dtStart;
+  m_tdWarmUp = tdWarmUp;
+  ptime dtBegin( dtStart.is_not_a_date_time() ? dtStart : dtStart - tdWarmUp );
+  for ( m_mapSymbols_t::iterator iter = m_mapSymbols.begin(); m_mapSymbols.end() != iter; ++iter ) {
+    iter->second->SetBegin( dtBegin );
+  }
+}
+
 void SimulationProvider::Connect() {
   if ( !m_bConnected ) {
     OnConnecting( 0 );
@@ -80,9 +129,17 @@ void SimulationProvider::Disconnect() {
 
 SimulationProvider::pSymbol_t SimulationProvider::NewCSymbol( SimulationSymbol::pInstrument_t pInstrument ) {
   pSymbol_t pSymbol( new SimulationSymbol(pInstrument->GetInstrumentName(), pInstrument, m_sGroupDirectory) );
+  pSymbol->SetTickStore( m_sTickStore, m_dayTickStore );
+  pSymbol->SetSliceDuration( m_tdSlice );
+  pSymbol->SetReadAhead( ReadAhead() );
+  pSymbol->SetBegin( m_dtStart.is_not_a_date_time() ? m_dtStart : m_dtStart - m_tdWarmUp );
   pSymbol->m_simExec.SetOnOrderFill( MakeDelegate( this, &SimulationProvider::HandleExecution ) );
   pSymbol->m_simExec.SetOnCommission( MakeDelegate( this, &SimulationProvider::HandleCommission ) );
   pSymbol->m_simExec.SetOnOrderCancelled( MakeDelegate( this, &SimulationProvider::HandleCancellation ) );
+  pSymbol->m_simExec.SetExecIdCounter( &m_nExecId );
+  if ( 0 != m_OnMakeMarketImpact ) {
+    pSymbol->m_simExec.SetMarketImpact( m_OnMakeMarketImpact( pInstrument ) );
+  }
   inherited_t::AddCSymbol( pSymbol );
   return pSymbol;
 }
@@ -139,6 +196,32 @@ void SimulationProvider::RemoveTradeHandler( pInstrument_cref pInstrument, Simul
   }
 }
 
+void SimulationProvider::AddDepthHandler( pInstrument_cref pInstrument, SimulationSymbol::depthhandler_t handler ) {
+  inherited_t::AddDepthHandler( pInstrument, handler );
+  inherited_t::m_mapSymbols_t::iterator iter;
+  iter = m_mapSymbols.find( pInstrument->GetInstrumentName( m_nID ) );
+  assert( m_mapSymbols.end() != iter );
+  pSymbol_t pSymSymbol( iter->second );
+  if ( 1 == iter->second->GetDepthHandlerCount() ) {
+    inherited_t::AddDepthHandler( pInstrument, MakeDelegate( &pSymSymbol->m_simExec, &SimulateOrderExecution::NewDepth ) );
+  }
+}
+
+void SimulationProvider::RemoveDepthHandler( pInstrument_cref pInstrument, SimulationSymbol::depthhandler_t handler ) {
+  inherited_t::RemoveDepthHandler( pInstrument, handler );
+  inherited_t::m_mapSymbols_t::iterator iter;
+  iter = m_mapSymbols.find( pInstrument->GetInstrumentName( m_nID ) );
+  if ( m_mapSymbols.end() == iter ) {
+    assert( false );  // this shouldn't occur
+  }
+  else {
+    if ( 1 == iter->second->GetDepthHandlerCount() ) {
+      pSymbol_t pSymSymbol( iter->second );
+      inherited_t::RemoveDepthHandler( pInstrument, MakeDelegate( &pSymSymbol->m_simExec, &SimulateOrderExecution::NewDepth ) );
+    }
+  }
+}
+
 // these need to open the data file, load the data, and prepare to simulate
 void SimulationProvider::StartQuoteWatch( pSymbol_t pSymbol ) {
   pSymbol->StartQuoteWatch();
@@ -177,59 +260,99 @@ void SimulationProvider::Merge( void ) {
 
   if ( 0 != m_OnSimulationThreadStarted ) m_OnSimulationThreadStarted();
 
-  // for each of the symbols, add the quote, trade and greek series
+  // for each of the symbols, add the quote, trade, greek and depth series
   // datums from each series will be merged and emitted in chronological order
   for ( m_mapSymbols_t::iterator iter = m_mapSymbols.begin();
 
     iter != m_mapSymbols.end(); ++iter ) {
 
       pSymbol_t sym( iter->second );
+      bool bPaged( sym->IsPaged() );  // series hold their first slice, the merge asks for the rest
+      sym->RewindSlices();  // when an earlier run has moved them on
 
       Quotes& quotes( sym->m_quotes );
       if ( 0 != quotes.Size() ) {
         m_pMerge -> Add( 
           quotes, 
-          MakeDelegate( iter->second.get(), &SimulationSymbol::HandleQuoteEvent ) );
+          MakeDelegate( iter->second.get(), &SimulationSymbol::HandleQuoteEvent ),
+          bPaged ? MakeDelegate( iter->second.get(), &SimulationSymbol::LoadQuoteSlice ) : MergeDatedDatums::OnRefillHandler() );
       }
 
       Trades& trades( sym->m_trades );
       if ( 0 != trades.Size() ) {
         m_pMerge -> Add( 
           trades, 
-          MakeDelegate( iter->second.get(), &SimulationSymbol::HandleTradeEvent ) );
+          MakeDelegate( iter->second.get(), &SimulationSymbol::HandleTradeEvent ),
+          bPaged ? MakeDelegate( iter->second.get(), &SimulationSymbol::LoadTradeSlice ) : MergeDatedDatums::OnRefillHandler() );
       }
 
       Greeks& greeks( sym->m_greeks );
       if ( 0 != greeks.Size() ) {
         m_pMerge -> Add(
           greeks,
-          MakeDelegate( iter->second.get(), &SimulationSymbol::HandleGreekEvent ) );
+          MakeDelegate( iter->second.get(), &SimulationSymbol::HandleGreekEvent ),
+          bPaged ? MakeDelegate( iter->second.get(), &SimulationSymbol::LoadGreekSlice ) : MergeDatedDatums::OnRefillHandler() );
+      }
+
+      MarketDepths& depths( sym->m_depths );
+      if ( 0 != depths.Size() ) {
+        m_pMerge -> Add(
+          depths,
+          MakeDelegate( iter->second.get(), &SimulationSymbol::HandleDepthEvent ),
+          bPaged ? MakeDelegate( iter->second.get(), &SimulationSymbol::LoadDepthSlice ) : MergeDatedDatums::OnRefillHandler() );
       }
 
   }
 
   m_nProcessedDatums = 0;
-  m_dtSimStart = ou::TimeSource::Instance().External();
+  m_dtSimStart = ou::TimeSource::Instance().External();  // for EmitStats only
+
+  m_nExecId = 1000;
+  m_checksumExecutions.Reset();
+  m_nChecksumDatums = 0;
+  bool bOldDeterministic = ou::TimeSource::LocalCommonInstance().GetDeterministic();  // this thread's instance, put back after the run
+  ou::TimeSource::LocalCommonInstance().SetDeterministic( m_bDeterministic );
+  m_pMerge->SetDeterministic( m_bDeterministic );
 
   bool bOldMode = ou::TimeSource::LocalCommonInstance().GetSimulationMode();
   ou::TimeSource::LocalCommonInstance().SetSimulationMode();
 
+  m_pMerge->SetTimers( m_pTimers );
+  m_pMerge->SetPace( m_dblPace );
+
+  if ( !m_dtStart.is_not_a_date_time() ) {
+    ou::TimeSource::LocalCommonInstance().SetSimulationTime( m_dtStart - m_tdWarmUp );
+    m_pMerge->SetMark( m_dtStart, MakeDelegate( this, &SimulationProvider::HandleWarmedUp ) );
+  }
+
   m_pMerge -> Run();
 
   m_nProcessedDatums = m_pMerge->GetCountProcessedDatums();
+  m_nChecksumDatums = m_pMerge->GetChecksum().Value();
   m_dtSimStop = ou::TimeSource::LocalCommonInstance().External();
 
   if ( 0 != m_OnSimulationComplete ) m_OnSimulationComplete();
 
   ou::TimeSource::LocalCommonInstance().SetSimulationMode( bOldMode );
+  ou::TimeSource::LocalCommonInstance().SetDeterministic( bOldDeterministic );
 
   if ( 0 != m_OnSimulationThreadEnded ) m_OnSimulationThreadEnded();
+
+  boost::mutex::scoped_lock lock( m_mutexMerge );  // ready for another run
+  delete m_pMerge;
+  m_pMerge = 0;
+}
+
+void SimulationProvider::HandleWarmedUp( void ) {
+  ou::TimeSource::LocalCommonInstance().SetSimulationTime( m_dtStart );
+  if ( 0 != m_OnSimulationWarmedUp ) m_OnSimulationWarmedUp();
 }
 
 void SimulationProvider::Run( bool bAsync ) {
-  if ( 0 == m_sGroupDirectory.size() ) throw std::invalid_argument( "Group Directory is empty" );
+  if ( ( 0 == m_sGroupDirectory.size() ) && ( 0 == m_sTickStore.size() ) ) throw std::invalid_argument( "Group Directory is empty" );
   if ( 0 == m_mapSymbols.size() ) throw std::invalid_argument( "No Symbols to simulate" );
 
+  boost::mutex::scoped_lock lock( m_mutexMerge );
   if ( 0 != m_pMerge ) {
     std::cout << "Simulation already in progress" << std::endl;
   }
@@ -238,22 +361,45 @@ void SimulationProvider::Run( bool bAsync ) {
     boost::thread sim( boost::bind( &SimulationProvider::Merge, this ) );
 
     if ( !bAsync ) {
+      lock.unlock();  // the merge thread takes it to release m_pMerge
       sim.join();
     }
 
   }
 }
 
+void SimulationProvider::SetDeterministic( bool bDeterministic ) {
+  m_bDeterministic = bDeterministic;  // taken up by the simulation thread's TimeSource for the run
+}
+
+boost::uint64_t SimulationProvider::GetChecksum( void ) const {
+  ou::Checksum checksum( m_checksumExecutions );
+  checksum.Add( m_nChecksumDatums );
+  return checksum.Value();
+}
+
 void SimulationProvider::EmitStats( std::stringstream& ss ) {
   boost::posix_time::time_duration dur = m_dtSimStop - m_dtSimStart;
   unsigned long nDuration = dur.total_seconds();
   unsigned long nDatumsPerSecond = m_nProcessedDatums / nDuration;
 //  ss << m_nProcessedDatums << " datums in " << nDuration << " seconds, " << nDatumsPerSecond << " datums/second." << std::endl;
     ss << m_nProcessedDatums << " datums in " << nDuration << " seconds, " << nDatumsPerSecond << " datums/second.";
+  if ( m_bDeterministic ) {
+    ss 
+      << std::endl << "checksum " << std::hex << std::setfill( '0' ) << std::setw( 16 ) << GetChecksum()
+      << " (datums " << std::setw( 16 ) << m_nChecksumDatums 
+      << ", executions " << std::setw( 16 ) << m_checksumExecutions.Value() << ")" << std::dec << std::setfill( ' ' )
+      << ", wall clock reads refused: " << ou::TimeSource::LocalCommonInstance().GetWallClockRefusals();
+  }
+#ifdef OU_PROFILE
+  ss << std::endl;
+  ou::Profiler::Instance().Report( ss );
+#endif
 }
 
 // at some point:  run, stop, pause, resume, reset
 void SimulationProvider::Stop() {
+  boost::mutex::scoped_lock lock( m_mutexMerge );
   if ( NULL == m_pMerge ) {
     std::cout << "no simulation to stop" << std::endl;
   }
@@ -263,6 +409,27 @@ void SimulationProvider::Stop() {
   }
 }
 
+void SimulationProvider::SetPace( double dblPace ) {
+  m_dblPace = dblPace;
+  boost::mutex::scoped_lock lock( m_mutexMerge );
+  if ( NULL != m_pMerge ) m_pMerge->SetPace( dblPace );
+}
+
+void SimulationProvider::Pause( void ) {
+  boost::mutex::scoped_lock lock( m_mutexMerge );
+  if ( NULL != m_pMerge ) m_pMerge->Pause();
+}
+
+void SimulationProvider::Resume( void ) {
+  boost::mutex::scoped_lock lock( m_mutexMerge );
+  if ( NULL != m_pMerge ) m_pMerge->Resume();
+}
+
+void SimulationProvider::Step( void ) {
+  boost::mutex::scoped_lock lock( m_mutexMerge );
+  if ( NULL != m_pMerge ) m_pMerge->Step();
+}
+
 void SimulationProvider::PlaceOrder( pOrder_t pOrder ) {
   inherited_t::PlaceOrder( pOrder ); // any underlying initialization
   m_mapSymbols_t::iterator iter = m_mapSymbols.find( pOrder->GetInstrument()->GetInstrumentName() );
@@ -286,6 +453,13 @@ void SimulationProvider::CancelOrder( pOrder_t pOrder ) {
 }
 
 void SimulationProvider::HandleExecution( Order::idOrder_t orderId, const Execution &exec ) {
+  if ( m_bDeterministic ) {
+    m_checksumExecutions.Add( exec.GetTimeStamp() );
+    m_checksumExecutions.Add( exec.GetPrice() );
+    m_checksumExecutions.Add( ( (boost::uint64_t) exec.GetOrderSide() << 32 ) ^ exec.GetSize() );
+    m_checksumExecutions.Add( exec.GetExchange() );
+    m_checksumExecutions.Add( exec.GetExchangeExecutionId() );
+  }
   OrderManager::LocalCommonInstance().ReportExecution( orderId, exec );
 }
 
@@ -294,6 +468,10 @@ void SimulationProvider::HandleCommission( Order::idOrder_t orderId, double comm
 }
 
 void SimulationProvider::HandleCancellation( Order::idOrder_t orderId ) {
+  if ( m_bDeterministic ) {
+    m_checksumExecutions.Add( ou::TimeSource::LocalCommonInstance().Internal() );
+    m_checksumExecutions.Add( (boost::uint64_t) 0 );  // marks a cancellation
+  }
   OrderManager::LocalCommonInstance().ReportCancellation( orderId );
 }
 
@@ -18,6 +18,7 @@
 #include <sstream>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread.hpp>  // separate thread background merge processing
 #include <boost/bind.hpp>
 
@@ -25,6 +26,7 @@
 using namespace fastdelegate;
 
 #include <OUCommon/TimeSource.h>
+#include <OUCommon/Checksum.h>
 #include <TFTrading/ProviderInterface.h>
 #include <TFTrading/Order.h>
 #include <TFTimeSeries/MergeDatedDatums.h>
@@ -62,8 +64,50 @@ public:
   void SetGroupDirectory( const std::string sGroupDirectory );  // eg /basket/20080620
   const std::string &GetGroupDirectory( void ) { return m_sGroupDirectory; };
 
-  void Run( bool bAsync = true );
+  // read the day's series from the tick store at sRoot rather than from the group directory (see TFTimeSeries/TickStore.h)
+  //   an empty root goes back to the group directory
+  void SetTickStore( const std::string& sRoot, boost::gregorian::date day );
+  const std::string& GetTickStore( void ) const { return m_sTickStore; };
+
+  // non-zero: symbols read their series in slices of this duration, just ahead of the merge (see SimulationSymbol)
+  void SetSliceDuration( time_duration td );
+  time_duration GetSliceDuration( void ) const { return m_tdSlice; };
+  // with slices, true (default): a background thread reads each series' next slice while the merge works through the current one
+  //   its hdf5 reads hold HDF5DataManager::Mutex, strategies which use hdf5 from their handlers take it as well
+  void SetReadAhead( bool bReadAhead );
+  bool GetReadAhead( void ) const { return m_bReadAhead; };
+
+  // seek: series start at dtStart - tdWarmUp, rather than at their first datum
+  //   datums in the warm up window are emitted as usual, so indicators attached to the symbols build their history
+  //   OnSimulationWarmedUp is called once simulation time reaches dtStart, hold off on orders till then
+  // not_a_date_time (default) replays everything
+  void SetStart( ptime dtStart, time_duration tdWarmUp = time_duration( 0, 0, 0 ) );
+  ptime GetStart( void ) const { return m_dtStart; };
+
+  // timers fire in time order between datums, see MergeDatedDatums::SetTimers
+  void SetTimers( ou::TimerWheel* pTimers ) { m_pTimers = pTimers; };
+
+  void Run( bool bAsync = true );  // again once a run has ended, paged series start over from their first slice
   void Stop( void );
+
+  // paced replay, see MergeDatedDatums::SetPace, these may be called while running
+  void SetPace( double dblPace );  // 1.0 is real time, 0.0 (default) is flat out
+  double GetPace( void ) const { return m_dblPace; };
+  void Pause( void );
+  void Resume( void );
+  void Step( void );
+
+  // deterministic: two runs over the same day, with the same strategy, give the same datums, fills and checksum
+  //   datums with the same timestamp merge in the order the symbols' series were added (quotes, trades, greeks, depth, by symbol name)
+  //   pacing is off, during the run TimeSource::Internal in the simulation thread no longer falls back to the wall clock
+  //     (see TimeSource::SetDeterministic), its setting before the run is put back after,
+  //   execution ids start over at each run
+  //   the checksum covers every datum emitted, and every fill and cancellation, it is reported by EmitStats
+  //   order ids are left out, as they come from the OrderManager, and so depend on what ran before in the process
+  void SetDeterministic( bool bDeterministic = true );
+  bool GetDeterministic( void ) const { return m_bDeterministic; };
+  boost::uint64_t GetChecksum( void ) const;  // datums and executions, after the run
+
   void PlaceOrder( pOrder_t pOrder );
   void CancelOrder( pOrder_t pOrder );
 
@@ -71,6 +115,8 @@ public:
   void RemoveTradeHandler( pInstrument_cref pInstrument, SimulationSymbol::tradehandler_t handler );
   void AddQuoteHandler( pInstrument_cref pInstrument, SimulationSymbol::quotehandler_t handler );
   void RemoveQuoteHandler( pInstrument_cref pInstrument, SimulationSymbol::quotehandler_t handler );
+  void AddDepthHandler( pInstrument_cref pInstrument, SimulationSymbol::depthhandler_t handler );
+  void RemoveDepthHandler( pInstrument_cref pInstrument, SimulationSymbol::depthhandler_t handler );
 
   void EmitStats( std::stringstream& ss );
 
@@ -83,11 +129,24 @@ public:
     m_OnSimulationThreadEnded = function;
   }
 
+  typedef FastDelegate0<> OnSimulationWarmedUp_t;  // called in the simulation thread
+  void SetOnSimulationWarmedUp( OnSimulationWarmedUp_t function ) {
+    m_OnSimulationWarmedUp = function;
+  }
+
   typedef FastDelegate0<> OnSimulationComplete_t;
   void SetOnSimulationComplete( OnSimulationComplete_t function ) {
     m_OnSimulationComplete = function;
   }
 
+  // a market impact model for each symbol as it is added, set before adding symbols, see MarketImpact.h
+  //   the model sees the quotes, trades and depth the strategy watches on the symbol
+  typedef SimulateOrderExecution::pMarketImpact_t pMarketImpact_t;
+  typedef FastDelegate1<pInstrument_cref,pMarketImpact_t> OnMakeMarketImpact_t;
+  void SetOnMakeMarketImpact( OnMakeMarketImpact_t function ) {
+    m_OnMakeMarketImpact = function;
+  }
+
 protected:
 
   pSymbol_t NewCSymbol( SimulationSymbol::pInstrument_t pInstrument );
@@ -101,14 +160,33 @@ protected:
   void StopGreekWatch( pSymbol_t pSymbol );
 
   std::string m_sGroupDirectory;
-
+  std::string m_sTickStore;
+  boost::gregorian::date m_dayTickStore;
+  time_duration m_tdSlice;
+  bool m_bReadAhead;
+  boost::scoped_ptr<SliceReader> m_pSliceReader;  // started with the first paged symbol
+  ptime m_dtStart;
+  time_duration m_tdWarmUp;
+  ou::TimerWheel* m_pTimers;
+  double m_dblPace;
+  bool m_bDeterministic;
+
+  boost::mutex m_mutexMerge;  // guards m_pMerge, set by Run, released by the merge thread as the run ends
   MergeDatedDatums* m_pMerge;
 
+  int m_nExecId;  // the run's execution ids, shared by the symbols
+  ou::Checksum m_checksumExecutions;
+  boost::uint64_t m_nChecksumDatums;
+
   OnSimulationThreadStarted_t m_OnSimulationThreadStarted;
   OnSimulationThreadEnded_t m_OnSimulationThreadEnded;
+  OnSimulationWarmedUp_t m_OnSimulationWarmedUp;
   OnSimulationComplete_t m_OnSimulationComplete;
+  OnMakeMarketImpact_t m_OnMakeMarketImpact;
 
+  SliceReader* ReadAhead( void );  // null when series aren't read ahead
   void Merge( void );  // the background thread
+  void HandleWarmedUp( void );
 
   void HandleExecution( Order::idOrder_t orderId, const Execution &exec );
   void HandleCommission( Order::idOrder_t orderId, double commission );
@@ -14,21 +14,145 @@
 
 #include "stdafx.h"
 
+#include <iostream>
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
 #include "SimulationSymbol.h"
 
+#include "TFTimeSeries/TickStoreContainer.h"
+
 #include "TFHDF5TimeSeries/HDF5TimeSeriesContainer.h"
 #include "TFHDF5TimeSeries/HDF5IterateGroups.h"
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
 
+namespace {
+
+  // index of the first datum at or after dt, by hand as the hdf5 iterator doesn't decrement
+  template<class DD>
+  hsize_t LowerBound( HDF5TimeSeriesContainer<DD>& repository, ptime dt ) {
+    hsize_t ixFirst( 0 );
+    hsize_t cnt( repository.size() );
+    typename HDF5TimeSeriesContainer<DD>::iterator begin( repository.begin() );
+    while ( 0 < cnt ) {
+      hsize_t step( cnt / 2 );
+      typename HDF5TimeSeriesContainer<DD>::iterator mid( begin );
+      mid += ixFirst + step;
+      if ( (*mid).DateTime() < dt ) {
+        ixFirst += step + 1;
+        cnt -= step + 1;
+      }
+      else {
+        cnt = step;
+      }
+    }
+    return ixFirst;
+  }
+
+  // the tick store searches its block index
+  template<class DD>
+  hsize_t LowerBound( TickStoreContainer<DD>& store, ptime dt ) {
+    return store.LowerBound( dt );
+  }
+
+  // whole series, from dtBegin when it is set
+  template<class Container, class DD>
+  void LoadSeries( Container& repository, ptime dtBegin, TimeSeries<DD>& series ) {
+    typename Container::iterator begin, end;
+    begin = repository.begin();
+    end = repository.end();
+    if ( !dtBegin.is_not_a_date_time() ) {
+      begin += LowerBound( repository, dtBegin );
+    }
+    series.Resize( end - begin );
+    if ( 0 != series.Size() ) {
+      repository.Read( begin, end, &series );
+    }
+  }
+
+  template<class DD>
+  void LoadSeries( const std::string& sPath, bool bTickStore, ptime dtBegin, TimeSeries<DD>& series ) {
+    if ( bTickStore ) {
+      TickStoreContainer<DD> store( sPath );
+      LoadSeries( store, dtBegin, series );
+    }
+    else {
+      HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );  // read aheads of paged symbols may be running
+      ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
+      HDF5TimeSeriesContainer<DD> repository( dm, sPath );
+      LoadSeries( repository, dtBegin, series );
+    }
+  }
+
+  // next block from ixNext, cut at the container's chunk boundaries (nBlock datums when not chunked), zero when none remain
+  template<class Container, class DD>
+  size_t ReadBlock( Container& repository, size_t ixNext, size_t nBlock, TimeSeries<DD>& block ) {
+    typename Container::iterator begin, end;
+    begin = repository.begin();
+    end = repository.end();
+    size_t nRemaining( end - begin );
+    if ( nRemaining <= ixNext ) return 0;
+    size_t nChunk( repository.ChunkSize() );
+    if ( 0 == nChunk ) nChunk = nBlock;
+    size_t n( std::min( nChunk - ( ixNext % nChunk ), nRemaining - ixNext ) );
+    begin += ixNext;
+    end = begin;
+    end += n;
+    block.Clear();
+    block.Resize( n );
+    repository.Read( begin, end, &block );
+    return n;
+  }
+
+} // namespace anonymous
+
+SliceReader::SliceReader( void ): m_bStop( false ) {
+  m_thread = boost::thread( boost::bind( &SliceReader::Work, this ) );
+}
+
+SliceReader::~SliceReader( void ) {
+  {
+    boost::mutex::scoped_lock lock( m_mutex );
+    m_bStop = true;
+  }
+  m_cvJob.notify_one();
+  m_thread.join();
+}
+
+void SliceReader::Queue( job_t job ) {
+  {
+    boost::mutex::scoped_lock lock( m_mutex );
+    m_dqJob.push_back( job );
+  }
+  m_cvJob.notify_one();
+}
+
+void SliceReader::Work( void ) {
+  while ( true ) {
+    job_t job;
+    {
+      boost::mutex::scoped_lock lock( m_mutex );
+      while ( m_dqJob.empty() && !m_bStop ) {
+        m_cvJob.wait( lock );
+      }
+      if ( m_dqJob.empty() ) break;  // stopping, and nothing left to read
+      job = m_dqJob.front();
+      m_dqJob.pop_front();
+    }
+    job();
+  }
+}
+
 // sDirectory needs to be available on instantiation to enable signal availability
 SimulationSymbol::SimulationSymbol( 
   const std::string &sSymbol, 
   pInstrument_cref pInstrument, 
   const std::string &sGroup
   ) 
-: Symbol<SimulationSymbol>(pInstrument), m_sDirectory( sGroup )
+: Symbol<SimulationSymbol>(pInstrument), m_sDirectory( sGroup ), m_tdSlice( 0, 0, 0 ), m_dtBegin( not_a_date_time ), m_dayTickStore( not_a_date_time )
 {
   // this is dealt with in the SimulationProvider, but we don't have a .Remove
   //m_OnTrade.Add( MakeDelegate( &m_simExec, &CSimulateOrderExecution::NewTrade ) );
@@ -40,17 +164,200 @@ SimulationSymbol::~SimulationSymbol(void) {
 
 }
 
+template<class DD>
+SimulationSymbol::Pager<DD>::Pager( void )
+: m_ixBlock( 0 ), m_ixNext( 0 ), m_bDone( false ), m_cntLoads( 0 ),
+  m_bTickStore( false ), m_dtBegin( not_a_date_time ), m_tdSlice( 0, 0, 0 ),
+  m_pReader( 0 ), m_bNext( false ), m_bPending( false )
+{
+}
+
+template<class DD>
+SimulationSymbol::Pager<DD>::~Pager( void ) {
+  Wait();
+  Release();
+}
+
+template<class DD>
+void SimulationSymbol::Pager<DD>::Release( void ) {
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );  // the reader may be in hdf5 for another series
+  m_pStore.reset();
+  m_pRepository.reset();  // before the data manager
+  m_pdm.reset();
+}
+
+template<class DD>
+void SimulationSymbol::Pager<DD>::Wait( void ) {
+  boost::mutex::scoped_lock lock( m_mutex );
+  while ( m_bPending ) {
+    m_cvPending.wait( lock );
+  }
+}
+
+template<class DD>
+void SimulationSymbol::Pager<DD>::Reset( void ) {
+  Wait();
+  m_next.Clear();
+  m_bNext = false;
+  m_block.Clear();
+  m_ixBlock = 0;
+  m_ixNext = 0;
+  m_bDone = false;
+  m_cntLoads = 0;
+  m_sFailure.clear();
+  Release();
+}
+
+template<class DD>
+bool SimulationSymbol::Pager<DD>::Load( const std::string& sPath, bool bTickStore, ptime dtBegin, time_duration tdSlice, TimeSeries<DD>& series ) {
+  Wait();
+  m_sPath = sPath;
+  m_bTickStore = bTickStore;
+  m_dtBegin = dtBegin;
+  m_tdSlice = tdSlice;
+  ++m_cntLoads;
+  if ( m_bNext ) {
+    series.Swap( m_next );
+    m_next.Clear();
+    m_bNext = false;
+  }
+  else {
+    Read( series );
+  }
+  if ( !m_sFailure.empty() ) {  // from this read, or the one ahead
+    std::cout << "SimulationSymbol " << m_sPath << " read failed: " << m_sFailure << std::endl;
+    m_sFailure.clear();
+  }
+  bool bLoaded( 0 != series.Size() );
+  if ( bLoaded && ( 0 != m_pReader ) ) {
+    {
+      boost::mutex::scoped_lock lock( m_mutex );
+      m_bPending = true;
+    }
+    m_pReader->Queue( MakeDelegate( this, &Pager<DD>::ReadAhead ) );
+  }
+  return bLoaded;
+}
+
+template<class DD>
+void SimulationSymbol::Pager<DD>::ReadAhead( void ) {
+  Read( m_next );
+  {
+    boost::mutex::scoped_lock lock( m_mutex );
+    m_bNext = true;
+    m_bPending = false;
+  }
+  m_cvPending.notify_all();
+}
+
+template<class DD>
+void SimulationSymbol::Pager<DD>::Rewind( const std::string& sPath, bool bTickStore, ptime dtBegin, time_duration tdSlice, TimeSeries<DD>& series ) {
+  // after a single load, the series still holds the first slice
+  if ( 1 < m_cntLoads ) {
+    Reset();
+    Load( sPath, bTickStore, dtBegin, tdSlice, series );
+  }
+}
+
+template<class DD>
+bool SimulationSymbol::Pager<DD>::Read( TimeSeries<DD>& series ) {
+  // the slice starts at the first datum not yet handed out, so is never empty while data remains
+  // the file is read sequentially in blocks, the slice boundary is found in memory
+  // blocks follow the chunks on disk, so with the chunk cache off, each chunk is decompressed once
+  series.Clear();
+  if ( m_bDone ) return false;
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex(), boost::defer_lock );  // the tick store doesn't use hdf5
+  if ( !m_bTickStore ) lock.lock();
+  try {
+    if ( ( 0 == m_pRepository.get() ) && ( 0 == m_pStore.get() ) ) {
+      if ( m_bTickStore ) {
+        m_pStore.reset( new TickStoreContainer<DD>( m_sPath ) );
+      }
+      else {
+        m_pdm.reset( new HDF5DataManager( HDF5DataManager::RO ) );
+        m_pRepository.reset( new HDF5TimeSeriesContainer<DD>( *m_pdm, m_sPath, false ) );
+      }
+      if ( !m_dtBegin.is_not_a_date_time() ) {
+        m_ixNext = m_bTickStore ? LowerBound( *m_pStore, m_dtBegin ) : LowerBound( *m_pRepository, m_dtBegin );
+      }
+    }
+    ptime dtEnd( not_a_date_time );
+    while ( true ) {
+      if ( m_block.Size() == m_ixBlock ) {
+        size_t n( ( 0 != m_pStore.get() ) ? ReadBlock( *m_pStore, m_ixNext, nBlock, m_block ) : ReadBlock( *m_pRepository, m_ixNext, nBlock, m_block ) );
+        if ( 0 == n ) break;
+        m_ixNext += n;
+        m_ixBlock = 0;
+      }
+      const DD& datum( m_block.At( m_ixBlock ) );
+      if ( dtEnd.is_not_a_date_time() ) {
+        dtEnd = datum.DateTime() + m_tdSlice;
+      }
+      else {
+        if ( datum.DateTime() >= dtEnd ) break;
+      }
+      series.Append( datum );
+      ++m_ixBlock;
+    }
+  }
+  catch ( std::runtime_error& e ) {
+    m_sFailure = e.what();
+  }
+  catch ( H5::Exception& e ) {
+    m_sFailure = e.getDetailMsg();
+  }
+  if ( !m_sFailure.empty() ) series.Clear();  // the series ends at the failure
+  if ( 0 == series.Size() ) {
+    m_bDone = true;  // release the file
+    m_block.Clear();
+    Release();
+  }
+  return 0 != series.Size();
+}
+
+std::string SimulationSymbol::SeriesPath( const std::string& sKind ) {
+  if ( IsTickStore() ) return TickStore::SegmentPath( m_sTickStore, GetId(), m_dayTickStore, sKind );
+  return m_sDirectory + "/" + sKind + "/" + GetId();
+}
+
+void SimulationSymbol::SetReadAhead( SliceReader* pReader ) {
+  m_pagerQuotes.SetReader( pReader );
+  m_pagerTrades.SetReader( pReader );
+  m_pagerGreeks.SetReader( pReader );
+  m_pagerDepths.SetReader( pReader );
+}
+
+void SimulationSymbol::RewindSlices( void ) {
+  if ( !IsPaged() ) return;
+  m_pagerQuotes.Rewind( SeriesPath( "quotes" ), IsTickStore(), m_dtBegin, m_tdSlice, m_quotes );
+  m_pagerTrades.Rewind( SeriesPath( "trades" ), IsTickStore(), m_dtBegin, m_tdSlice, m_trades );
+  m_pagerGreeks.Rewind( SeriesPath( "greeks" ), IsTickStore(), m_dtBegin, m_tdSlice, m_greeks );
+  m_pagerDepths.Rewind( SeriesPath( "depths" ), IsTickStore(), m_dtBegin, m_tdSlice, m_depths );
+}
+
+bool SimulationSymbol::LoadQuoteSlice( void ) {
+  return m_pagerQuotes.Load( SeriesPath( "quotes" ), IsTickStore(), m_dtBegin, m_tdSlice, m_quotes );
+}
+
+bool SimulationSymbol::LoadTradeSlice( void ) {
+  return m_pagerTrades.Load( SeriesPath( "trades" ), IsTickStore(), m_dtBegin, m_tdSlice, m_trades );
+}
+
+bool SimulationSymbol::LoadGreekSlice( void ) {
+  return m_pagerGreeks.Load( SeriesPath( "greeks" ), IsTickStore(), m_dtBegin, m_tdSlice, m_greeks );
+}
+
+bool SimulationSymbol::LoadDepthSlice( void ) {
+  return m_pagerDepths.Load( SeriesPath( "depths" ), IsTickStore(), m_dtBegin, m_tdSlice, m_depths );
+}
+
 void SimulationSymbol::StartTradeWatch( void ) {
-  if ( 0 == m_trades.Size() ) {
+  if ( ( 0 == m_trades.Size() ) && IsPaged() ) {
+    LoadTradeSlice();
+  }
+  if ( ( 0 == m_trades.Size() ) && !IsPaged() ) {
     try {
-      std::string sPath( m_sDirectory + "/trades/" + GetId() );
-      ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
-      HDF5TimeSeriesContainer<Trade> tradeRepository( dm, sPath );
-      HDF5TimeSeriesContainer<Trade>::iterator begin, end;
-      begin = tradeRepository.begin();
-      end = tradeRepository.end();
-      m_trades.Resize( end - begin );
-      tradeRepository.Read( begin, end, &m_trades );
+      LoadSeries( SeriesPath( "trades" ), IsTickStore(), m_dtBegin, m_trades );
     }
     catch ( std::runtime_error &e ) {
       // couldn't do read, so leave as empty
@@ -62,16 +369,12 @@ void SimulationSymbol::StopTradeWatch( void ) {
 }
 
 void SimulationSymbol::StartQuoteWatch( void ) {
-  if ( 0 == m_quotes.Size() ) {
+  if ( ( 0 == m_quotes.Size() ) && IsPaged() ) {
+    LoadQuoteSlice();
+  }
+  if ( ( 0 == m_quotes.Size() ) && !IsPaged() ) {
     try {
-      std::string sPath( m_sDirectory + "/quotes/" + GetId() );
-      ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
-      HDF5TimeSeriesContainer<Quote> quoteRepository( dm, sPath );
-      HDF5TimeSeriesContainer<Quote>::iterator begin, end;
-      begin = quoteRepository.begin();
-      end = quoteRepository.end();
-      m_quotes.Resize( end - begin );
-      quoteRepository.Read( begin, end, &m_quotes );
+      LoadSeries( SeriesPath( "quotes" ), IsTickStore(), m_dtBegin, m_quotes );
     }
     catch ( std::runtime_error &e ) {
       // couldn't do read, so leave as empty
@@ -83,16 +386,12 @@ void SimulationSymbol::StopQuoteWatch( void ) {
 }
 
 void SimulationSymbol::StartGreekWatch( void ) {
-  if ( ( 0 == m_greeks.Size() ) && ( m_pInstrument->IsOption() ) )  {
+  if ( ( 0 == m_greeks.Size() ) && ( m_pInstrument->IsOption() ) && IsPaged() ) {
+    LoadGreekSlice();
+  }
+  if ( ( 0 == m_greeks.Size() ) && ( m_pInstrument->IsOption() ) && !IsPaged() )  {
     try {
-      std::string sPath( m_sDirectory + "/greeks/" + GetId() );
-      ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RO );
-      HDF5TimeSeriesContainer<Greek> greekRepository( dm, sPath );
-      HDF5TimeSeriesContainer<Greek>::iterator begin, end;
-      begin = greekRepository.begin();
-      end = greekRepository.end();
-      m_greeks.Resize( end - begin );
-      greekRepository.Read( begin, end, &m_greeks );
+      LoadSeries( SeriesPath( "greeks" ), IsTickStore(), m_dtBegin, m_greeks );
     }
     catch ( std::runtime_error &e ) {
       // couldn't do read, so leave as empty
@@ -104,6 +403,17 @@ void SimulationSymbol::StopGreekWatch( void ) {
 }
 
 void SimulationSymbol::StartDepthWatch( void ) {
+  if ( ( 0 == m_depths.Size() ) && IsPaged() ) {
+    LoadDepthSlice();
+  }
+  if ( ( 0 == m_depths.Size() ) && !IsPaged() ) {
+    try {
+      LoadSeries( SeriesPath( "depths" ), IsTickStore(), m_dtBegin, m_depths );
+    }
+    catch ( std::runtime_error &e ) {
+      // couldn't do read, so leave as empty
+    }
+  }
 }
 
 void SimulationSymbol::StopDepthWatch( void ) {
@@ -121,5 +431,9 @@ void SimulationSymbol::HandleGreekEvent( const DatedDatum &datum ) {
   m_OnGreek( dynamic_cast<const Greek &>( datum ) );  
 }
 
+void SimulationSymbol::HandleDepthEvent( const DatedDatum &datum ) {
+  m_OnDepth( dynamic_cast<const MarketDepth &>( datum ) );
+}
+
 } // namespace tf
 } // namespace ou
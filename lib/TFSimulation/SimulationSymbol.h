@@ -14,9 +14,14 @@
 
 #pragma once
 
+#include <deque>
 #include <string>
 
 #include <boost/detail/atomic_count.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 #include "TFTimeSeries/TimeSeries.h"
 #include "TFTrading/Symbol.h"
@@ -26,6 +31,27 @@
 namespace ou { // One Unified
 namespace tf { // TradeFrame
 
+class HDF5DataManager;
+template<class DD> class HDF5TimeSeriesContainer;
+template<class DD> class TickStoreContainer;
+
+// reads ahead for paged series on a thread of its own, one slice at a time, in the order they were queued
+class SliceReader {
+public:
+  typedef FastDelegate0<> job_t;
+  SliceReader( void );
+  ~SliceReader( void );  // reads what is queued, then stops
+  void Queue( job_t job );
+protected:
+private:
+  boost::mutex m_mutex;
+  boost::condition_variable m_cvJob;
+  std::deque<job_t> m_dqJob;
+  bool m_bStop;
+  boost::thread m_thread;  // after the rest, started in the constructor
+  void Work( void );
+};
+
 class SimulationSymbol: public Symbol<SimulationSymbol> {
   friend class SimulationProvider;
 public:
@@ -36,12 +62,29 @@ public:
   typedef inherited_t::trade_t trade_t;
   typedef inherited_t::quote_t quote_t;
   typedef inherited_t::greek_t greek_t;
+  typedef inherited_t::depth_t depth_t;
   
   SimulationSymbol( const std::string& sSymbol, 
                      pInstrument_cref pInstrument, 
-                     const std::string& sGroup ); // base with trades/ quotes/, greeks/
+                     const std::string& sGroup ); // base with trades/ quotes/, greeks/, depths/
   ~SimulationSymbol(void);
 
+  // zero (default): each series is read completely when its watch starts
+  // otherwise: series hold one slice of this duration at a time, the next slice is read as the merge consumes the current one
+  void SetSliceDuration( time_duration td ) { m_tdSlice = td; };
+  // with a reader, the next slice is read while the merge works through the current one, null (default) reads it on the refill
+  void SetReadAhead( SliceReader* pReader );
+  bool IsPaged( void ) const { return time_duration( 0, 0, 0 ) != m_tdSlice; };
+
+  // not_a_date_time (default): series start with their first datum
+  // otherwise: series start with the first datum at or after dt, set before the watches start
+  void SetBegin( ptime dt ) { m_dtBegin = dt; };
+
+  // empty root (default): series are read from the hdf5 group
+  // otherwise: series are read from the day's segments in the tick store at sRoot (see TFTimeSeries/TickStore.h)
+  void SetTickStore( const std::string& sRoot, boost::gregorian::date day ) { m_sTickStore = sRoot; m_dayTickStore = day; };
+  bool IsTickStore( void ) const { return !m_sTickStore.empty(); };
+
 protected:
 
   void StartTradeWatch( void );
@@ -56,17 +99,78 @@ protected:
   void HandleTradeEvent( const DatedDatum &datum );
   void HandleQuoteEvent( const DatedDatum &datum );
   void HandleGreekEvent( const DatedDatum &datum );
+  void HandleDepthEvent( const DatedDatum &datum );
 
   std::string m_sDirectory;
 
   Quotes m_quotes;
   Trades m_trades;
   Greeks m_greeks;
+  MarketDepths m_depths;
 
   SimulateOrderExecution m_simExec;
 
+  // refill handlers for MergeDatedDatums, true when the series holds the next slice
+  bool LoadQuoteSlice( void );
+  bool LoadTradeSlice( void );
+  bool LoadGreekSlice( void );
+  bool LoadDepthSlice( void );
+
+  std::string SeriesPath( const std::string& sKind );  // sKind: quotes, trades, greeks, depths
+
+  void RewindSlices( void );  // before a run, paged series which a previous run moved on go back to their first slice
+
 private:
 
+  // keeps the repository open between slices, and the position of the next slice
+  // with a reader, each slice handed out queues the read of the one after, which Load then swaps in
+  template<class DD>
+  class Pager {
+  public:
+    Pager( void );
+    ~Pager( void );  // waits for a read ahead in flight
+    void SetReader( SliceReader* pReader ) { m_pReader = pReader; };
+    bool Load( const std::string& sPath, bool bTickStore, ptime dtBegin, time_duration tdSlice, TimeSeries<DD>& series );  // false when nothing remains
+    void Rewind( const std::string& sPath, bool bTickStore, ptime dtBegin, time_duration tdSlice, TimeSeries<DD>& series );  // first slice again, once past it
+  private:
+    boost::scoped_ptr<HDF5DataManager> m_pdm;
+    boost::scoped_ptr<HDF5TimeSeriesContainer<DD> > m_pRepository;
+    boost::scoped_ptr<TickStoreContainer<DD> > m_pStore;  // in place of m_pRepository
+    static const size_t nBlock = 1024;  // datums per read when the dataset isn't chunked
+    TimeSeries<DD> m_block;  // last block read, the part not yet handed out carries into the next slice
+    size_t m_ixBlock;  // first datum in m_block not yet handed out
+    size_t m_ixNext;  // first datum in the file not yet read
+    bool m_bDone;
+    size_t m_cntLoads;  // since the last rewind
+    std::string m_sPath;  // from the last Load, for the read ahead
+    bool m_bTickStore;
+    ptime m_dtBegin;
+    time_duration m_tdSlice;
+    SliceReader* m_pReader;
+    TimeSeries<DD> m_next;  // slice read ahead
+    bool m_bNext;  // m_next holds the next slice, empty when nothing remains
+    bool m_bPending;  // read ahead queued or in progress, m_mutex guards it and m_bNext
+    boost::mutex m_mutex;
+    boost::condition_variable m_cvPending;
+    std::string m_sFailure;  // why a read failed, on either thread, reported by the Load handing out the slice
+    bool Read( TimeSeries<DD>& series );  // next slice from the file, hdf5 calls under HDF5DataManager::Mutex
+    void ReadAhead( void );  // on the reader's thread
+    void Wait( void );  // till no read ahead is in flight
+    void Release( void );  // file closed
+    void Reset( void );  // file released, the next read starts over
+  };
+
+  time_duration m_tdSlice;
+  ptime m_dtBegin;
+
+  std::string m_sTickStore;
+  boost::gregorian::date m_dayTickStore;
+
+  Pager<Quote> m_pagerQuotes;
+  Pager<Trade> m_pagerTrades;
+  Pager<Greek> m_pagerGreeks;
+  Pager<MarketDepth> m_pagerDepths;
+
 };
 
 } // namespace tf
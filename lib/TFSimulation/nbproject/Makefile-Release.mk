@@ -35,6 +35,10 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/BacktestRunner.o \
+	${OBJECTDIR}/MarketImpact.o \
+	${OBJECTDIR}/PaperTradingProvider.o \
+	${OBJECTDIR}/PaperTradingSymbol.o \
 	${OBJECTDIR}/SimulateOrderExecution.o \
 	${OBJECTDIR}/SimulationProvider.o \
 	${OBJECTDIR}/SimulationSymbol.o \
@@ -67,6 +71,26 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/libtfsimulation.a: ${OBJECTFILES}
 	${AR} -rv ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/libtfsimulation.a ${OBJECTFILES} 
 	$(RANLIB) ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/libtfsimulation.a
 
+${OBJECTDIR}/BacktestRunner.o: BacktestRunner.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/BacktestRunner.o BacktestRunner.cpp
+
+${OBJECTDIR}/MarketImpact.o: MarketImpact.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/MarketImpact.o MarketImpact.cpp
+
+${OBJECTDIR}/PaperTradingProvider.o: PaperTradingProvider.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/PaperTradingProvider.o PaperTradingProvider.cpp
+
+${OBJECTDIR}/PaperTradingSymbol.o: PaperTradingSymbol.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/PaperTradingSymbol.o PaperTradingSymbol.cpp
+
 ${OBJECTDIR}/SimulateOrderExecution.o: SimulateOrderExecution.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -227,6 +227,14 @@ DatedDatum( dt ) {
 MarketDepth::~MarketDepth() {
 }
 
+MarketDepth::MMID_t MarketDepth::PackMMID( const std::string& mmid ) {
+  unionMMID u;
+  for ( std::string::size_type ix = 0; ( ix < 4 ) && ( ix < mmid.size() ); ++ix ) {
+    u.rch[ ix ] = mmid[ ix ];
+  }
+  return u.mmid;
+}
+
 H5::CompType* MarketDepth::DefineDataType( H5::CompType* pComp ) {
   if ( NULL == pComp ) pComp = new H5::CompType( sizeof( MarketDepth ) );
   DatedDatum::DefineDataType( pComp );
@@ -201,6 +201,8 @@ public:
   ESide m_eSide; 
   const char& MMIDStr( void ) const { return *m_uMMID.rch; };
 
+  static MMID_t PackMMID( const std::string& mmid );  // up to four characters, as stored in the union
+
   static H5::CompType* DefineDataType( H5::CompType* pType = NULL );
   static boost::uint64_t Signature( void ) { return DatedDatum::Signature() * 10000000 + 3188888; };
 
@@ -20,12 +20,20 @@
 using namespace fastdelegate;
 
 #include <OUCommon/TimeSource.h>
+#include <OUCommon/Checksum.h>
+
+#ifdef OU_PROFILE
+#include <OUCommon/Profiler.h>
+#endif
 
 #include "TimeSeries.h"
 
 // Each carrier holds a TimeSeries.  The carrier holds an index to the current DatedDatum in each TimeSeries.
 // The current DatedDatum timestamp is maintained for the merge process to figure out which DatedDatum to 
 // send into the merge process
+// An optional refill handler lets the owner of the series swap in the next slice of data once the 
+// current one is consumed, so the whole series needn't be resident (see SimulationSymbol paging)
+// Carriers are numbered as they are added, datums with the same timestamp are merged in that order
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
@@ -34,44 +42,98 @@ class MergeCarrierBase {
   friend class MergeDatedDatums;
 public:
   typedef FastDelegate1<const DatedDatum &> OnDatumHandler;
-  MergeCarrierBase( void ) {};
+  typedef FastDelegate0<bool> OnRefillHandler;  // true when the series has been reloaded with more datums
+  MergeCarrierBase( void ): m_nSeq( 0 ) {};
   virtual ~MergeCarrierBase( void ) {};
   virtual void ProcessDatum( void ) 
     { throw std::runtime_error( "ProcessDatum not defined" ); };
   virtual void Reset( void ) 
     { throw std::runtime_error( "Reset not defined" ); };
+  virtual void AddToChecksum( ou::Checksum& ) const
+    { throw std::runtime_error( "AddToChecksum not defined" ); };
   inline const ptime &GetDateTime( void ) { return m_dt; };
   const DatedDatum* GetDatedDatum( void ) const { return m_pDatum; };
-  bool operator<( const MergeCarrierBase& other ) const { return m_dt < other.m_dt; };
-  bool operator<( const MergeCarrierBase* pOther ) const { return m_dt < pOther->m_dt; };
-  static bool lt( MergeCarrierBase* plhs, MergeCarrierBase *prhs ) { return plhs->m_dt < prhs->m_dt; };
+  bool operator<( const MergeCarrierBase& other ) const { return lt( this, &other ); };
+  bool operator<( const MergeCarrierBase* pOther ) const { return lt( this, pOther ); };
+  static bool lt( const MergeCarrierBase* plhs, const MergeCarrierBase *prhs ) { 
+    return ( plhs->m_dt < prhs->m_dt ) || ( ( plhs->m_dt == prhs->m_dt ) && ( plhs->m_nSeq < prhs->m_nSeq ) ); 
+  };
 protected:
   ptime m_dt;  // datetime of datum to be merged (used in comparison)
+  size_t m_nSeq;  // order in which the carrier was added (tie break in comparison)
   const DatedDatum* m_pDatum;
   OnDatumHandler OnDatum;
+  OnRefillHandler OnRefill;
+#ifdef OU_PROFILE
+  ou::Profiler::Probe* m_pProbe;
+#endif
 private:
 };
 
+// the fields of each datum type, for the merge checksum (see MergeDatedDatums::SetDeterministic)
+inline void ChecksumDatum( ou::Checksum& checksum, const Quote& quote ) {
+  checksum.Add( quote.DateTime() );
+  checksum.Add( quote.Bid() );
+  checksum.Add( quote.Ask() );
+  checksum.Add( ( (boost::uint64_t) quote.BidSize() << 32 ) ^ quote.AskSize() );
+}
+
+inline void ChecksumDatum( ou::Checksum& checksum, const Trade& trade ) {
+  checksum.Add( trade.DateTime() );
+  checksum.Add( trade.Price() );
+  checksum.Add( (boost::uint64_t) trade.Volume() );
+}
+
+inline void ChecksumDatum( ou::Checksum& checksum, const Bar& bar ) {
+  checksum.Add( bar.DateTime() );
+  checksum.Add( bar.Open() );
+  checksum.Add( bar.High() );
+  checksum.Add( bar.Low() );
+  checksum.Add( bar.Close() );
+  checksum.Add( (boost::uint64_t) bar.Volume() );
+}
+
+inline void ChecksumDatum( ou::Checksum& checksum, const Greek& greek ) {
+  checksum.Add( greek.DateTime() );
+  checksum.Add( greek.ImpliedVolatility() );
+  checksum.Add( greek.Delta() );
+  checksum.Add( greek.Gamma() );
+  checksum.Add( greek.Theta() );
+  checksum.Add( greek.Vega() );
+  checksum.Add( greek.Rho() );
+}
+
+inline void ChecksumDatum( ou::Checksum& checksum, const MarketDepth& depth ) {
+  checksum.Add( depth.DateTime() );
+  checksum.Add( depth.Price() );
+  checksum.Add( ( (boost::uint64_t) depth.Volume() << 32 ) ^ ( (boost::uint64_t) depth.m_eSide << 24 ) ^ depth.MMID() );
+}
+
 template<class T> 
 class MergeCarrier: public MergeCarrierBase {
   // T is a DatedDatum type
   friend class MergeDatedDatums;
 public:
-  MergeCarrier<T>( TimeSeries<T>& series, OnDatumHandler function );
+  MergeCarrier<T>( TimeSeries<T>& series, OnDatumHandler function, OnRefillHandler refill = OnRefillHandler() );
   virtual ~MergeCarrier<T>( void );
   void ProcessDatum( void );
   void Reset( void );
+  void AddToChecksum( ou::Checksum& checksum ) const { ChecksumDatum( checksum, *static_cast<const T*>( m_pDatum ) ); };
 protected:
   TimeSeries<T>& m_series;  // series from which a datum is to be merged to output
 private:
 };
 
 template<class T> 
-MergeCarrier<T>::MergeCarrier( TimeSeries<T>& series, OnDatumHandler function ) 
+MergeCarrier<T>::MergeCarrier( TimeSeries<T>& series, OnDatumHandler function, OnRefillHandler refill ) 
   : MergeCarrierBase(), m_series( series )
 {
   assert( 0 != m_series.Size() );
   OnDatum = function;
+  OnRefill = refill;
+#ifdef OU_PROFILE
+  m_pProbe = ou::Profiler::Instance().Find( "MergeCarrier", function );
+#endif
   m_pDatum = m_series.First();  // preload with first datum so we have it's time available for comparison
   m_dt = ( 0 == m_pDatum ) 
     ? boost::date_time::special_values::not_a_date_time 
@@ -87,9 +149,18 @@ void MergeCarrier<T>::ProcessDatum(void) {
   if ( ou::TimeSource::LocalCommonInstance().GetSimulationMode() ) {
     ou::TimeSource::LocalCommonInstance().SetSimulationTime( m_pDatum->DateTime() );
   }
-  if ( 0 != OnDatum ) 
+  if ( 0 != OnDatum ) {
+#ifdef OU_PROFILE
+    ou::Profiler::Scope scope( m_pProbe );
+#endif
     OnDatum( *m_pDatum );
+  }
   m_pDatum = m_series.Next();
+  if ( ( NULL == m_pDatum ) && ( 0 != OnRefill ) ) {
+    if ( OnRefill() ) {
+      m_pDatum = m_series.First();
+    }
+  }
   m_dt = ( NULL == m_pDatum ) 
     ? boost::date_time::special_values::not_a_date_time 
     : m_pDatum->DateTime();
@@ -16,6 +16,17 @@
 
 //#include "LibCommon/Log.h"
 
+#include <cassert>
+#include <algorithm>
+
+#include <boost/thread/thread.hpp>
+
+#include <OUCommon/TimerWheel.h>
+
+#ifdef OU_PROFILE
+#include <OUCommon/Profiler.h>
+#endif
+
 #include "MergeDatedDatums.h"
 
 namespace ou { // One Unified
@@ -25,8 +36,15 @@ namespace tf { // TradeFrame
 // MergeDatedDatums
 //
 
+const MergeDatedDatums::wallclock_t::duration MergeDatedDatums::tdSpinMin = boost::chrono::microseconds( 200 );
+const MergeDatedDatums::wallclock_t::duration MergeDatedDatums::tdSpinMax = boost::chrono::milliseconds( 2 );
+const MergeDatedDatums::wallclock_t::duration MergeDatedDatums::tdSleep = boost::chrono::milliseconds( 50 );
+
 MergeDatedDatums::MergeDatedDatums(void) 
-: m_state( eInit ), m_request( eUnknown )
+: m_state( eInit ), m_request( eUnknown ), m_dtMark( not_a_date_time ), m_pTimers( 0 ), m_bDeterministic( false ),
+  m_bControl( false ), m_bStep( false ), m_dblPace( 0.0 ),
+  m_dblPaceRun( 0.0 ), m_bStepping( false ), m_bAnchored( false ), m_tdSpin( boost::chrono::milliseconds( 1 ) ),
+  m_tdLagThreshold( pos_infin ), m_bLagging( false ), m_nLag( 0 ), m_nLagMax( 0 )
 {
 }
 
@@ -37,24 +55,51 @@ MergeDatedDatums::~MergeDatedDatums(void) {
   }
 }
 
-void MergeDatedDatums::Add( TimeSeries<Quote>& series, MergeDatedDatums::OnDatumHandler function) {
-  m_mhCarriers.Append( new MergeCarrier<Quote>( series, function ) );
+void MergeDatedDatums::Add( TimeSeries<Quote>& series, MergeDatedDatums::OnDatumHandler function, OnRefillHandler refill ) {
+  Append( new MergeCarrier<Quote>( series, function, refill ) );
+}
+
+void MergeDatedDatums::Add( TimeSeries<Trade>& series, MergeDatedDatums::OnDatumHandler function, OnRefillHandler refill ) {
+  Append( new MergeCarrier<Trade>( series, function, refill ) );
+}
+
+void MergeDatedDatums::Add( TimeSeries<Bar>& series, MergeDatedDatums::OnDatumHandler function, OnRefillHandler refill ) {
+  Append( new MergeCarrier<Bar>( series, function, refill ) );
 }
 
-void MergeDatedDatums::Add( TimeSeries<Trade>& series, MergeDatedDatums::OnDatumHandler function) {
-  m_mhCarriers.Append( new MergeCarrier<Trade>( series, function ) );
+void MergeDatedDatums::Add( TimeSeries<Greek>& series, MergeDatedDatums::OnDatumHandler function, OnRefillHandler refill ) {
+  Append( new MergeCarrier<Greek>( series, function, refill ) );
 }
 
-void MergeDatedDatums::Add( TimeSeries<Bar>& series, MergeDatedDatums::OnDatumHandler function) {
-  m_mhCarriers.Append( new MergeCarrier<Bar>( series, function ) );
+void MergeDatedDatums::Add( TimeSeries<MarketDepth>& series, MergeDatedDatums::OnDatumHandler function, OnRefillHandler refill ) {
+  Append( new MergeCarrier<MarketDepth>( series, function, refill ) );
 }
 
-void MergeDatedDatums::Add( TimeSeries<Greek>& series, MergeDatedDatums::OnDatumHandler function) {
-  m_mhCarriers.Append( new MergeCarrier<Greek>( series, function ) );
+void MergeDatedDatums::Append( MergeCarrierBase* pCarrier ) {
+  pCarrier->m_nSeq = m_mhCarriers.Size();
+  m_mhCarriers.Append( pCarrier );
 }
 
-void MergeDatedDatums::Add( TimeSeries<MarketDepth>& series, MergeDatedDatums::OnDatumHandler function) {
-  m_mhCarriers.Append( new MergeCarrier<MarketDepth>( series, function ) );
+void MergeDatedDatums::SetMark( ptime dt, OnMarkHandler function ) {
+  m_dtMark = dt;
+  m_OnMark = function;
+}
+
+void MergeDatedDatums::SetPace( double dblPace ) {
+  assert( 0.0 <= dblPace );
+  boost::mutex::scoped_lock lock( m_mutexControl );
+  m_dblPace = dblPace;
+  m_bControl = true;
+}
+
+double MergeDatedDatums::GetPace( void ) {
+  boost::mutex::scoped_lock lock( m_mutexControl );
+  return m_dblPace;
+}
+
+void MergeDatedDatums::SetOnLag( time_duration tdThreshold, OnLagHandler function ) {
+  m_tdLagThreshold = tdThreshold;
+  m_OnLag = function;
 }
 
 // http://www.codeguru.com/forum/archive/index.php/t-344661.html
@@ -73,14 +118,59 @@ protected:
 // the thread is not created in this class 
 // for example, see CSimulationProvider
 void MergeDatedDatums::Run() {
-  m_request = eRun;
+  {
+    boost::mutex::scoped_lock lock( m_mutexControl );
+    if ( eStop == m_request ) {  // stopped before it started
+      m_state = eStopped;
+      return;
+    }
+    m_request = eRun;
+    m_bControl = true;  // picks up the pace
+  }
   size_t cntCarriers = m_mhCarriers.Size();
 //  LOG << "#carriers: " << cntCarriers;  // need cross thread writing 
   MergeCarrierBase *pCarrier;
   m_cntProcessedDatums = 0;
+  m_nLag = 0;
+  m_nLagMax = 0;
+  m_bLagging = false;
+  m_checksum.Reset();
   m_state = eRunning;
-  while ( ( 0 != cntCarriers ) && ( eRun == m_request ) ) {  // once all series have been depleted, end of run
+  bool bMark( !m_dtMark.is_not_a_date_time() && ( 0 != m_OnMark ) );
+#ifdef OU_PROFILE
+  // self time of this probe is the merge's own: ordering, timer wheel upkeep, pacing
+  ou::Profiler::Probe* pProbe( ou::Profiler::Instance().Find( "MergeDatedDatums::Run" ) );
+#endif
+  while ( 0 != cntCarriers ) {  // once all series have been depleted, end of run
+#ifdef OU_PROFILE
+    ou::Profiler::Scope scope( pProbe );
+#endif
+    if ( m_bControl ) {
+      if ( !Control() ) break;
+    }
     pCarrier = m_mhCarriers.GetRoot();
+    ptime dtNext( pCarrier->GetDateTime() );
+    if ( bMark && ( m_dtMark <= dtNext ) ) {
+      if ( 0 != m_pTimers ) m_pTimers->Advance( m_dtMark - time_duration( 0, 0, 0, 1 ) );  // those before the mark
+      bMark = false;
+      m_OnMark();
+    }
+    if ( ( 0.0 < m_dblPaceRun ) && !bMark && !m_bStepping ) {
+      // timers are paced too, wait for whichever is first
+      ptime dtTimer( ( 0 == m_pTimers ) ? ptime( not_a_date_time ) : m_pTimers->NextTime() );
+      if ( !dtTimer.is_not_a_date_time() && ( dtTimer < dtNext ) ) {
+        if ( Wait( dtTimer ) ) m_pTimers->Advance( dtTimer );
+        continue;
+      }
+      if ( !Wait( dtNext ) ) continue;  // commands first
+    }
+    if ( 0 != m_pTimers ) {
+      m_pTimers->Advance( dtNext );
+      if ( m_bControl ) {  // a timer may stop or pause the run
+        if ( !Control() ) break;
+      }
+    }
+    if ( m_bDeterministic ) pCarrier->AddToChecksum( m_checksum );
     pCarrier->ProcessDatum();  // automatically loads next datum when done
     ++m_cntProcessedDatums;
     if ( NULL == pCarrier->GetDatedDatum() ) {
@@ -97,8 +187,103 @@ void MergeDatedDatums::Run() {
 //  LOG << "Merge stats: " << m_cntProcessedDatums << ", " << m_cntReorders;
 }
 
+// commands are taken up between datums
+bool MergeDatedDatums::Control( void ) {
+  boost::mutex::scoped_lock lock( m_mutexControl );
+  m_bControl = false;
+  m_bStepping = false;
+  while ( ( ePause == m_request ) && !m_bStep ) {
+    m_state = ePaused;
+    m_cvControl.wait( lock );
+  }
+  if ( eStop == m_request ) return false;
+  m_state = eRunning;
+  if ( m_bStep ) {
+    m_bStep = false;
+    m_bStepping = true;  // emitted without waiting
+    m_bControl = true;  // back here to pause after the one datum
+  }
+  m_dblPaceRun = m_bDeterministic ? 0.0 : m_dblPace;
+  m_bAnchored = false;
+  return true;
+}
+
+bool MergeDatedDatums::Wait( ptime dt ) {
+  wallclock_t::time_point tpNow( wallclock_t::now() );
+  if ( !m_bAnchored ) {
+    m_dtAnchor = dt;
+    m_tpAnchor = tpNow;
+    m_bAnchored = true;
+    return true;
+  }
+  const wallclock_t::time_point tpDue( m_tpAnchor + boost::chrono::duration_cast<wallclock_t::duration>(
+    boost::chrono::duration<double, boost::micro>( ( dt - m_dtAnchor ).total_microseconds() / m_dblPaceRun ) ) );
+  while ( tpNow < tpDue ) {
+    if ( m_bControl ) return false;
+    const wallclock_t::duration tdRemaining( tpDue - tpNow );
+    if ( m_tdSpin < tdRemaining ) {
+      const wallclock_t::duration tdRequested( std::min( tdRemaining - m_tdSpin, tdSleep ) );
+      boost::this_thread::sleep_for( tdRequested );
+      const wallclock_t::time_point tpWoke( wallclock_t::now() );
+      // spin margin: half again the overshoot when it grows, otherwise eases down by 1/64 per sleep
+      const wallclock_t::duration tdOvershoot( ( tpWoke - tpNow ) - tdRequested );
+      m_tdSpin = std::max( m_tdSpin - m_tdSpin / 64, tdOvershoot + tdOvershoot / 2 );
+      m_tdSpin = std::min( std::max( m_tdSpin, tdSpinMin ), tdSpinMax );
+      tpNow = tpWoke;
+    }
+    else {
+      tpNow = wallclock_t::now();
+    }
+  }
+  const boost::int64_t nLag( boost::chrono::duration_cast<boost::chrono::microseconds>( tpNow - tpDue ).count() );
+  m_nLag = nLag;
+  if ( m_nLagMax < nLag ) m_nLagMax = nLag;
+  if ( 0 != m_OnLag ) {
+    const time_duration tdLag = microseconds( nLag );
+    if ( m_bLagging ) {
+      if ( tdLag < m_tdLagThreshold ) m_bLagging = false;
+    }
+    else {
+      if ( m_tdLagThreshold < tdLag ) {
+        m_bLagging = true;
+        m_OnLag( tdLag );
+      }
+    }
+  }
+  return true;
+}
+
 void MergeDatedDatums::Stop( void ) {
+  boost::mutex::scoped_lock lock( m_mutexControl );
   m_request = eStop;
+  m_bControl = true;
+  m_cvControl.notify_all();
+}
+
+void MergeDatedDatums::Pause( void ) {
+  boost::mutex::scoped_lock lock( m_mutexControl );
+  if ( eRun == m_request ) {
+    m_request = ePause;
+    m_bControl = true;
+  }
+}
+
+void MergeDatedDatums::Resume( void ) {
+  boost::mutex::scoped_lock lock( m_mutexControl );
+  if ( ePause == m_request ) {
+    m_request = eRun;
+    m_bControl = true;
+    m_cvControl.notify_all();
+  }
+}
+
+void MergeDatedDatums::Step( void ) {
+  boost::mutex::scoped_lock lock( m_mutexControl );
+  if ( ePause == m_request ) {
+    m_bStep = true;
+    m_bControl = true;
+    m_cvControl.notify_all();
+  }
 }
 
 } // namespace tf
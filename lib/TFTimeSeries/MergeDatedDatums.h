@@ -16,16 +16,26 @@
 
 #include <vector>
 
+#include <boost/atomic.hpp>
+#include <boost/chrono/chrono.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
 // 2012/08/12 could try using std:priority_queue instead or boost::max_heap
 #include <OUCommon/MinHeap.h>
 
 #include <OUCommon/FastDelegate.h>
 using namespace fastdelegate;
 
+#include <OUCommon/Checksum.h>
+
 #include "TimeSeries.h"
 #include "MergeDatedDatumCarrier.h"
 
 namespace ou { // One Unified
+
+class TimerWheel;
+
 namespace tf { // TradeFrame
 
 class MergeDatedDatums {
@@ -37,14 +47,51 @@ public:
   virtual ~MergeDatedDatums(void);
 
   typedef FastDelegate1<const DatedDatum &> OnDatumHandler;
+  typedef MergeCarrierBase::OnRefillHandler OnRefillHandler;
+
+  // the refill handler is called when the series is exhausted, to load its next slice
+  // datums with the same timestamp are emitted in the order their series were added
+  void Add( TimeSeries<Quote>& series, OnDatumHandler, OnRefillHandler = OnRefillHandler() );
+  void Add( TimeSeries<Trade>& series, OnDatumHandler, OnRefillHandler = OnRefillHandler() );
+  void Add( TimeSeries<Bar>& series, OnDatumHandler, OnRefillHandler = OnRefillHandler() );
+  void Add( TimeSeries<Greek>& series, OnDatumHandler, OnRefillHandler = OnRefillHandler() );
+  void Add( TimeSeries<MarketDepth>& series, OnDatumHandler, OnRefillHandler = OnRefillHandler() );
+  typedef FastDelegate0<> OnMarkHandler;
+  // called once, before the first datum at or after dt, not called if all series end before dt
+  void SetMark( ptime dt, OnMarkHandler );
+
+  // timers due at or before a datum fire ahead of it, timers after the last datum don't fire
+  void SetTimers( ou::TimerWheel* pTimers ) { m_pTimers = pTimers; };
+
+  // pacing: dblPace is simulated seconds per wall clock second, 1.0 replays in real time, 10.0 ten times as fast
+  //   0.0 (default) emits as fast as the handlers take them
+  //   each datum, and each timer, is held back till its wall clock time: a sleep, then a spin for the last stretch
+  //     the spin covers the worst the sleeps have recently overshot by, so is short on a quiet machine
+  //   pacing starts over from the next datum after a change of pace, a pause, or a step
+  //   with a mark set, the warm up runs unpaced, pacing starts at the mark
+  void SetPace( double dblPace );  // may be called while running
+  double GetPace( void );
+
+  // deterministic: the run depends on nothing but the series, the timers and what the handlers do with them
+  //   pacing is off (SetPace is ignored, as is OnLag), the wall clock is not looked at
+  //   a checksum is kept over every datum emitted, the same series and handlers give the same checksum run after run
+  void SetDeterministic( bool bDeterministic = true ) { m_bDeterministic = bDeterministic; };
+  bool GetDeterministic( void ) const { return m_bDeterministic; };
+  const ou::Checksum& GetChecksum( void ) const { return m_checksum; };  // after the run, or from a handler
+
+  // lag: how far behind its wall clock time the latest datum was emitted, when the handlers can't keep up
+  //   OnLag is called in the run thread when lag goes over tdThreshold, once per excursion
+  typedef FastDelegate1<time_duration> OnLagHandler;
+  void SetOnLag( time_duration tdThreshold, OnLagHandler );
+  time_duration GetLag( void ) const { return microseconds( m_nLag.load() ); };
+  time_duration GetMaxLag( void ) const { return microseconds( m_nLagMax.load() ); };
 
-  void Add( TimeSeries<Quote>& series, OnDatumHandler );
-  void Add( TimeSeries<Trade>& series, OnDatumHandler );
-  void Add( TimeSeries<Bar>& series, OnDatumHandler );
-  void Add( TimeSeries<Greek>& series, OnDatumHandler );
-  void Add( TimeSeries<MarketDepth>& series, OnDatumHandler );
   void Run( void );
+  // may be called from another thread, or from a handler
   void Stop( void );
+  void Pause( void );  // after the datum in progress
+  void Resume( void );
+  void Step( void );  // while paused: emits one datum (and the timers before it), then pauses again
 
   enumMergingState GetState( void ) const { return m_state; };
 
@@ -62,8 +109,47 @@ protected:
 
   unsigned long m_cntProcessedDatums;
 
+  ptime m_dtMark;
+  OnMarkHandler m_OnMark;
+
+  ou::TimerWheel* m_pTimers;
+
+  bool m_bDeterministic;
+  ou::Checksum m_checksum;
+
 private:
 
+  typedef boost::chrono::steady_clock wallclock_t;
+
+  static const wallclock_t::duration tdSpinMin;
+  static const wallclock_t::duration tdSpinMax;
+  static const wallclock_t::duration tdSleep;  // longest sleep, so commands are seen while waiting
+
+  boost::mutex m_mutexControl;
+  boost::condition_variable m_cvControl;
+  boost::atomic<bool> m_bControl;  // a command is waiting for the run thread
+  bool m_bStep;
+  double m_dblPace;  // as last set
+
+  // run thread only
+  double m_dblPaceRun;
+  bool m_bStepping;
+  bool m_bAnchored;
+  wallclock_t::duration m_tdSpin;  // waits closer than this are spun out
+  ptime m_dtAnchor;  // simulated time which maps to
+  wallclock_t::time_point m_tpAnchor;  //   this wall clock time
+
+  time_duration m_tdLagThreshold;
+  OnLagHandler m_OnLag;
+  bool m_bLagging;
+  boost::atomic<boost::int64_t> m_nLag;  // microseconds
+  boost::atomic<boost::int64_t> m_nLagMax;
+
+  void Append( MergeCarrierBase* pCarrier );
+
+  bool Control( void );  // false when stopped
+  bool Wait( ptime dt );  // false when a command arrived first
+
 };
 
 } // namespace tf
@@ -0,0 +1,93 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <algorithm>
+
+#include "MultiBarFactory.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+MultiBarFactory::MultiBarFactory( const vWidth_t& vWidth )
+: m_vWidth( vWidth ), m_vBar( vWidth.size() ), m_vOpen( vWidth.size(), false )
+{
+  assert( !m_vWidth.empty() );
+  for ( size_t ix = 0; ix < m_vWidth.size(); ++ix ) {
+    assert( 0 < m_vWidth[ ix ] );
+    assert( 0 == ( 86400 % m_vWidth[ ix ] ) );
+    if ( 0 < ix ) {
+      assert( m_vWidth[ ix - 1 ] < m_vWidth[ ix ] );
+      assert( 0 == ( m_vWidth[ ix ] % m_vWidth[ ix - 1 ] ) );  // bars fold into the next width only, so each nests in it
+    }
+  }
+}
+
+MultiBarFactory::~MultiBarFactory( void ) {
+  OnBarComplete = NULL;
+}
+
+ptime MultiBarFactory::BarStart( const ptime& dt, duration_t nWidth ) const {
+  const duration_t seconds( dt.time_of_day().total_seconds() );
+  return ptime( dt.date(), time_duration( 0, 0, ( seconds / nWidth ) * nWidth, 0 ) );
+}
+
+void MultiBarFactory::Add( const ptime& dt, price_t price, volume_t volume ) {
+  const ptime dtStart( BarStart( dt, m_vWidth[ 0 ] ) );
+  Bar& bar( m_vBar[ 0 ] );
+  if ( m_vOpen[ 0 ] && ( dtStart == bar.DateTime() ) ) {
+    bar.Close( price );
+    bar.High( std::max( bar.High(), price ) );
+    bar.Low( std::min( bar.Low(), price ) );
+    bar.Volume( bar.Volume() + volume );
+  }
+  else {
+    if ( m_vOpen[ 0 ] ) Complete( 0 );
+    bar = Bar( dtStart, price, price, price, price, volume );
+    m_vOpen[ 0 ] = true;
+  }
+}
+
+void MultiBarFactory::Fold( size_t ix, const Bar& narrower ) {
+  const ptime dtStart( BarStart( narrower.DateTime(), m_vWidth[ ix ] ) );
+  Bar& bar( m_vBar[ ix ] );
+  if ( m_vOpen[ ix ] && ( dtStart == bar.DateTime() ) ) {
+    bar.Close( narrower.Close() );
+    bar.High( std::max( bar.High(), narrower.High() ) );
+    bar.Low( std::min( bar.Low(), narrower.Low() ) );
+    bar.Volume( bar.Volume() + narrower.Volume() );
+  }
+  else {
+    if ( m_vOpen[ ix ] ) Complete( ix );
+    bar = Bar( dtStart, narrower.Open(), narrower.High(), narrower.Low(), narrower.Close(), narrower.Volume() );
+    m_vOpen[ ix ] = true;
+  }
+}
+
+void MultiBarFactory::Complete( size_t ix ) {
+  // the wider bars take the bar before it is reported, so they are current when it is
+  if ( ( ix + 1 ) < m_vWidth.size() ) Fold( ix + 1, m_vBar[ ix ] );
+  m_vOpen[ ix ] = false;
+  if ( 0 != OnBarComplete ) OnBarComplete( ix, m_vBar[ ix ] );
+}
+
+void MultiBarFactory::Close( void ) {
+  for ( size_t ix = 0; ix < m_vWidth.size(); ++ix ) {  // narrowest first, each folds into the next before that completes
+    if ( m_vOpen[ ix ] ) Complete( ix );
+  }
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,73 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// bars of several widths from one pass over the trades, eg 60, 300, 3600, 86400 seconds
+//   trades build the narrowest bar, each completed narrowest bar is folded into the wider ones
+//   widths are ascending, each a multiple of the one before, and each divides a day
+//   bars start on multiples of their width from midnight, as BarFactory, but a bar also ends with its day,
+//   so trades days apart at the same time of day don't share a bar
+// trades are in time order; Close completes the bars in progress, at the end of the trades, or of a day
+
+#include <vector>
+
+#include "DatedDatum.h"
+
+#include <OUCommon/FastDelegate.h>
+using namespace fastdelegate;
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class MultiBarFactory {
+public:
+
+  typedef unsigned long duration_t;  // seconds
+  typedef Bar::volume_t volume_t;
+  typedef Bar::price_t price_t;
+  typedef std::vector<duration_t> vWidth_t;
+
+  explicit MultiBarFactory( const vWidth_t& vWidth );
+  ~MultiBarFactory( void );
+
+  void Add( const ptime& dt, price_t price, volume_t volume );
+  void Add( const Trade& trade ) { Add( trade.DateTime(), trade.Price(), trade.Volume() ); };
+  void Close( void );
+
+  size_t Widths( void ) const { return m_vWidth.size(); };
+  duration_t GetWidth( size_t ix ) const { return m_vWidth[ ix ]; };
+
+  typedef FastDelegate2<size_t, const Bar&> OnBarCompleteHandler;  // index of the width, the bar
+  void SetOnBarComplete( OnBarCompleteHandler function ) {
+    OnBarComplete = function;
+  }
+
+protected:
+private:
+
+  vWidth_t m_vWidth;
+  std::vector<Bar> m_vBar;  // in progress, by width
+  std::vector<bool> m_vOpen;  // whether m_vBar holds a bar in progress
+
+  OnBarCompleteHandler OnBarComplete;
+
+  ptime BarStart( const ptime& dt, duration_t nWidth ) const;
+  void Fold( size_t ix, const Bar& bar );  // a completed narrower bar into width ix
+  void Complete( size_t ix );
+
+};
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,338 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "OrderBook.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+const OrderBook::tick_t OrderBook::nNoTick = std::numeric_limits<OrderBook::tick_t>::min();
+
+OrderBook::OrderBook( price_t dblTickSize, unsigned int nWindow, unsigned int nMaxRows )
+  : m_dblTickSize( dblTickSize ), m_dblTicksPerUnit( 1.0 / dblTickSize ),
+  m_tickBase( nNoTick ), m_nWindow( nWindow ), m_dtLast( not_a_date_time )
+{
+  assert( 0.0 < dblTickSize );
+  assert( 0 < nWindow );
+  for ( int ix = 0; ix < 2; ++ix ) {
+    m_side[ ix ].vLevels.resize( nWindow, 0 );
+    m_side[ ix ].vRows.resize( nMaxRows );
+  }
+}
+
+OrderBook::~OrderBook( void ) {
+}
+
+void OrderBook::Clear( void ) {
+  for ( int ix = 0; ix < 2; ++ix ) {
+    Side& side( m_side[ ix ] );
+    std::fill( side.vLevels.begin(), side.vLevels.end(), 0 );
+    side.mapSparse.clear();
+    side.ixBest = nNoTick;
+    side.cntRows = 0;
+    side.mapMMID.clear();
+  }
+  m_tickBase = nNoTick;
+}
+
+OrderBook::tick_t OrderBook::Tick( price_t price ) const {
+  return static_cast<tick_t>( std::floor( price * m_dblTicksPerUnit + 0.5 ) );
+}
+
+OrderBook::volume_t OrderBook::LevelVolume( const Side& side, tick_t tick ) const {
+  if ( InWindow( tick ) ) return side.vLevels[ tick - m_tickBase ];
+  mapSparse_t::const_iterator iter = side.mapSparse.find( tick );
+  return ( side.mapSparse.end() == iter ) ? 0 : iter->second;
+}
+
+OrderBook::volume_t OrderBook::BestBidVolume( void ) const {
+  const Side& side( m_side[ MarketDepth::Bid ] );
+  return side.HasBest() ? LevelVolume( side, side.ixBest ) : 0;
+}
+
+OrderBook::volume_t OrderBook::BestAskVolume( void ) const {
+  const Side& side( m_side[ MarketDepth::Ask ] );
+  return side.HasBest() ? LevelVolume( side, side.ixBest ) : 0;
+}
+
+OrderBook::volume_t OrderBook::VolumeAt( ESide eSide, price_t price ) const {
+  assert( MarketDepth::None != eSide );
+  return LevelVolume( m_side[ eSide ], Tick( price ) );
+}
+
+void OrderBook::SetVolume( ESide eSide, tick_t tick, volume_t volume ) {
+  AddVolume( eSide, tick, (long long) volume - (long long) LevelVolume( m_side[ eSide ], tick ) );
+}
+
+void OrderBook::AddVolume( ESide eSide, tick_t tick, long long delta ) {
+
+  if ( 0 == delta ) return;
+
+  if ( nNoTick == m_tickBase ) {
+    m_tickBase = tick - m_nWindow / 2;
+  }
+
+  Side& side( m_side[ eSide ] );
+  volume_t volume;
+  if ( InWindow( tick ) ) {
+    volume_t& level( side.vLevels[ tick - m_tickBase ] );
+    assert( ( 0 <= delta ) || ( (volume_t) -delta <= level ) );
+    level += delta;
+    volume = level;
+  }
+  else {
+    mapSparse_t::iterator iter = side.mapSparse.find( tick );
+    if ( side.mapSparse.end() == iter ) {
+      assert( 0 < delta );
+      iter = side.mapSparse.insert( mapSparse_t::value_type( tick, 0 ) ).first;
+    }
+    iter->second += delta;
+    volume = iter->second;
+    if ( 0 == volume ) side.mapSparse.erase( iter );
+  }
+
+  if ( 0 != volume ) {
+    bool bBetter = !side.HasBest()
+      || ( ( MarketDepth::Bid == eSide ) ? ( tick > side.ixBest ) : ( tick < side.ixBest ) );
+    if ( bBetter ) {
+      side.ixBest = tick;
+      if ( !InWindow( tick ) ) Recentre( tick );
+    }
+  }
+  else {
+    if ( tick == side.ixBest ) FindBest( eSide );
+  }
+}
+
+void OrderBook::FindBest( ESide eSide ) {
+  // next level away from the emptied touch, from the window or from the outliers, whichever is better
+  Side& side( m_side[ eSide ] );
+  const tick_t ixFrom( side.ixBest );
+  tick_t ixWindow( nNoTick );
+  tick_t ixSparse( nNoTick );
+  if ( MarketDepth::Bid == eSide ) {
+    for ( tick_t ix = std::min<tick_t>( ixFrom - m_tickBase, m_nWindow ) - 1; ix >= 0; --ix ) {
+      if ( 0 != side.vLevels[ ix ] ) {
+        ixWindow = m_tickBase + ix;
+        break;
+      }
+    }
+    mapSparse_t::iterator iter = side.mapSparse.lower_bound( ixFrom );
+    if ( side.mapSparse.begin() != iter ) ixSparse = (--iter)->first;
+    side.ixBest = std::max<tick_t>( ixWindow, ixSparse );  // nNoTick is the minimum
+  }
+  else {
+    for ( tick_t ix = std::max<tick_t>( ixFrom - m_tickBase, -1 ) + 1; ix < m_nWindow; ++ix ) {
+      if ( 0 != side.vLevels[ ix ] ) {
+        ixWindow = m_tickBase + ix;
+        break;
+      }
+    }
+    mapSparse_t::iterator iter = side.mapSparse.upper_bound( ixFrom );
+    if ( side.mapSparse.end() != iter ) ixSparse = iter->first;
+    if ( nNoTick == ixWindow ) side.ixBest = ixSparse;
+    else if ( nNoTick == ixSparse ) side.ixBest = ixWindow;
+    else side.ixBest = std::min<tick_t>( ixWindow, ixSparse );
+  }
+  if ( side.HasBest() && !InWindow( side.ixBest ) ) Recentre( side.ixBest );
+}
+
+void OrderBook::Recentre( tick_t tickCentre ) {
+  // move the window so the touch is in the middle, levels migrate between the array and the sparse map
+  // infrequent, the cost is proportional to the window width
+  const tick_t tickBaseNew( tickCentre - m_nWindow / 2 );
+  if ( tickBaseNew == m_tickBase ) return;
+  const tick_t tickBaseOld( m_tickBase );
+  for ( int ix = 0; ix < 2; ++ix ) {
+    Side& side( m_side[ ix ] );
+    for ( tick_t ixOld = 0; ixOld < m_nWindow; ++ixOld ) {
+      volume_t& level( side.vLevels[ ixOld ] );
+      if ( 0 != level ) {
+        side.mapSparse[ tickBaseOld + ixOld ] = level;
+        level = 0;
+      }
+    }
+    mapSparse_t::iterator iter = side.mapSparse.lower_bound( tickBaseNew );
+    while ( ( side.mapSparse.end() != iter ) && ( iter->first < ( tickBaseNew + m_nWindow ) ) ) {
+      side.vLevels[ iter->first - tickBaseNew ] = iter->second;
+      iter = side.mapSparse.erase( iter );
+    }
+  }
+  m_tickBase = tickBaseNew;
+}
+
+template<typename F>
+size_t OrderBook::Walk( ESide eSide, size_t nLevels, F& f ) const {
+  // visits up to nLevels non-empty levels, best first:  outliers beyond the window on the near side,
+  //   then the window, then the outliers on the far side
+  const Side& side( m_side[ eSide ] );
+  const tick_t tickTop( m_tickBase + m_nWindow );
+  size_t cnt( 0 );
+  if ( !side.HasBest() ) return cnt;
+  if ( MarketDepth::Bid == eSide ) {
+    mapSparse_t::const_reverse_iterator iter( side.mapSparse.rbegin() );
+    for ( ; ( side.mapSparse.rend() != iter ) && ( iter->first >= tickTop ) && ( cnt < nLevels ); ++iter, ++cnt ) {
+      f( Price( iter->first ), iter->second );
+    }
+    for ( tick_t ix = std::min<tick_t>( side.ixBest - m_tickBase, m_nWindow - 1 ); ( ix >= 0 ) && ( cnt < nLevels ); --ix ) {
+      if ( 0 != side.vLevels[ ix ] ) {
+        f( Price( m_tickBase + ix ), side.vLevels[ ix ] );
+        ++cnt;
+      }
+    }
+    for ( ; ( side.mapSparse.rend() != iter ) && ( cnt < nLevels ); ++iter, ++cnt ) {
+      f( Price( iter->first ), iter->second );
+    }
+  }
+  else {
+    mapSparse_t::const_iterator iter( side.mapSparse.begin() );
+    for ( ; ( side.mapSparse.end() != iter ) && ( iter->first < m_tickBase ) && ( cnt < nLevels ); ++iter, ++cnt ) {
+      f( Price( iter->first ), iter->second );
+    }
+    for ( tick_t ix = std::max<tick_t>( side.ixBest - m_tickBase, 0 ); ( ix < m_nWindow ) && ( cnt < nLevels ); ++ix ) {
+      if ( 0 != side.vLevels[ ix ] ) {
+        f( Price( m_tickBase + ix ), side.vLevels[ ix ] );
+        ++cnt;
+      }
+    }
+    for ( ; ( side.mapSparse.end() != iter ) && ( cnt < nLevels ); ++iter, ++cnt ) {
+      f( Price( iter->first ), iter->second );
+    }
+  }
+  return cnt;
+}
+
+namespace {
+
+struct FillLevels {
+  OrderBook::Level* p;
+  FillLevels( OrderBook::Level* p_ ): p( p_ ) {};
+  void operator()( OrderBook::price_t price, OrderBook::volume_t volume ) {
+    p->price = price;
+    p->volume = volume;
+    ++p;
+  }
+};
+
+struct SumVolume {
+  double sum;
+  SumVolume( void ): sum( 0.0 ) {};
+  void operator()( OrderBook::price_t, OrderBook::volume_t volume ) { sum += volume; };
+};
+
+} // namespace anonymous
+
+size_t OrderBook::Top( ESide eSide, Level* rLevels, size_t nLevels ) const {
+  assert( MarketDepth::None != eSide );
+  FillLevels fill( rLevels );
+  return Walk( eSide, nLevels, fill );
+}
+
+double OrderBook::Imbalance( size_t nLevels ) const {
+  SumVolume bid, ask;
+  Walk( MarketDepth::Bid, nLevels, bid );
+  Walk( MarketDepth::Ask, nLevels, ask );
+  double total( bid.sum + ask.sum );
+  return ( 0.0 == total ) ? 0.0 : ( bid.sum - ask.sum ) / total;
+}
+
+void OrderBook::Changed( const ptime& dt ) {
+  m_dtLast = dt;
+  OnChanged( *this );
+}
+
+void OrderBook::Apply( const MarketDepth& md ) {
+  const ESide eSide( md.m_eSide );
+  if ( MarketDepth::None == eSide ) return;
+  const MMID_t mmid( md.MMID() );
+  if ( 0 == mmid ) {
+    SetVolume( eSide, Tick( md.Price() ), md.Volume() );
+  }
+  else {
+    mapMMID_t& map( m_side[ eSide ].mapMMID );
+    mapMMID_t::iterator iter = map.find( mmid );
+    if ( map.end() != iter ) {  // withdraw the previous quote
+      AddVolume( eSide, Tick( iter->second.price ), -(long long) iter->second.volume );
+      if ( 0 == md.Volume() ) {
+        map.erase( iter );
+      }
+      else {
+        iter->second.price = md.Price();
+        iter->second.volume = md.Volume();
+      }
+    }
+    else {
+      if ( 0 != md.Volume() ) {
+        map.insert( mapMMID_t::value_type( mmid, Row( md.Price(), md.Volume(), mmid ) ) );
+      }
+    }
+    if ( 0 != md.Volume() ) {
+      AddVolume( eSide, Tick( md.Price() ), md.Volume() );
+    }
+  }
+  Changed( md.DateTime() );
+}
+
+void OrderBook::Insert( const ptime& dt, ESide eSide, size_t ixPosition, price_t price, volume_t volume, MMID_t mmid ) {
+  assert( MarketDepth::None != eSide );
+  Side& side( m_side[ eSide ] );
+  if ( ixPosition > side.cntRows ) ixPosition = side.cntRows;  // no gaps
+  if ( ixPosition >= side.vRows.size() ) return;  // below the deepest row of a full book, not kept
+  if ( side.vRows.size() == side.cntRows ) {  // full, last row falls off
+    const Row& row( side.vRows[ side.cntRows - 1 ] );
+    AddVolume( eSide, Tick( row.price ), -(long long) row.volume );
+    --side.cntRows;
+  }
+  std::copy_backward( side.vRows.begin() + ixPosition, side.vRows.begin() + side.cntRows, side.vRows.begin() + side.cntRows + 1 );
+  side.vRows[ ixPosition ] = Row( price, volume, mmid );
+  ++side.cntRows;
+  AddVolume( eSide, Tick( price ), volume );
+  Changed( dt );
+}
+
+void OrderBook::Update( const ptime& dt, ESide eSide, size_t ixPosition, price_t price, volume_t volume, MMID_t mmid ) {
+  assert( MarketDepth::None != eSide );
+  Side& side( m_side[ eSide ] );
+  if ( ixPosition >= side.cntRows ) {  // update of an unseen row, treat as an insert
+    Insert( dt, eSide, ixPosition, price, volume, mmid );
+  }
+  else {
+    Row& row( side.vRows[ ixPosition ] );
+    AddVolume( eSide, Tick( row.price ), -(long long) row.volume );
+    row = Row( price, volume, mmid );
+    AddVolume( eSide, Tick( price ), volume );
+    Changed( dt );
+  }
+}
+
+void OrderBook::Delete( const ptime& dt, ESide eSide, size_t ixPosition ) {
+  assert( MarketDepth::None != eSide );
+  Side& side( m_side[ eSide ] );
+  if ( ixPosition < side.cntRows ) {
+    const Row& row( side.vRows[ ixPosition ] );
+    AddVolume( eSide, Tick( row.price ), -(long long) row.volume );
+    std::copy( side.vRows.begin() + ixPosition + 1, side.vRows.begin() + side.cntRows, side.vRows.begin() + ixPosition );
+    --side.cntRows;
+    Changed( dt );
+  }
+}
+
+} // namespace tf
+} // namespace ou
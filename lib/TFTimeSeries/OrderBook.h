@@ -0,0 +1,135 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// level 2 order book built from MarketDepth events or from positional row updates
+// aggregate volume per price is kept in a flat array indexed by tick, in a window around the touch,
+//   levels outside the window fall back to a sparse map, the window is re-centred when the touch leaves it
+// per market maker quotes (IQFeed level 2) are keyed by mmid, one quote per mmid and side
+// positional rows (IB updateMktDepth/updateMktDepthL2) are held in a small fixed array per side
+// Top and Imbalance write to caller supplied storage, so the book doesn't allocate once warmed up
+
+#include <map>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+#include <OUCommon/Delegate.h>
+
+#include "DatedDatum.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class OrderBook {
+public:
+
+  typedef MarketDepth::ESide ESide;
+  typedef MarketDepth::MMID_t MMID_t;
+  typedef DatedDatum::price_t price_t;
+  typedef DatedDatum::volume_t volume_t;
+
+  struct Level {
+    price_t price;
+    volume_t volume;
+    Level( void ): price( 0.0 ), volume( 0 ) {};
+  };
+
+  struct Row {
+    price_t price;
+    volume_t volume;
+    MMID_t mmid;
+    Row( void ): price( 0.0 ), volume( 0 ), mmid( 0 ) {};
+    Row( price_t price_, volume_t volume_, MMID_t mmid_ ): price( price_ ), volume( volume_ ), mmid( mmid_ ) {};
+  };
+
+  OrderBook( price_t dblTickSize = 0.01, unsigned int nWindow = 1024, unsigned int nMaxRows = 64 );
+  virtual ~OrderBook( void );
+
+  void Clear( void );
+
+  // market maker quote:  replaces the previous quote for the mmid/side, zero volume removes it
+  // an mmid of 0 sets the aggregate volume at the price directly
+  void Apply( const MarketDepth& );
+
+  // positional rows, row ix shifts down on Insert, up on Delete
+  // on a full book the last row falls off an Insert, an Insert past the last row is ignored
+  // dt is the update's time, it becomes the book's DateTime
+  void Insert( const ptime& dt, ESide, size_t ixPosition, price_t, volume_t, MMID_t mmid = 0 );
+  void Update( const ptime& dt, ESide, size_t ixPosition, price_t, volume_t, MMID_t mmid = 0 );
+  void Delete( const ptime& dt, ESide, size_t ixPosition );
+  size_t Rows( ESide eSide ) const { return m_side[ eSide ].cntRows; };
+  const Row& RowAt( ESide eSide, size_t ix ) const { assert( ix < m_side[ eSide ].cntRows ); return m_side[ eSide ].vRows[ ix ]; };
+
+  bool HasBid( void ) const { return m_side[ MarketDepth::Bid ].HasBest(); };
+  bool HasAsk( void ) const { return m_side[ MarketDepth::Ask ].HasBest(); };
+  price_t BestBid( void ) const { return Price( m_side[ MarketDepth::Bid ].ixBest ); };
+  price_t BestAsk( void ) const { return Price( m_side[ MarketDepth::Ask ].ixBest ); };
+  volume_t BestBidVolume( void ) const;
+  volume_t BestAskVolume( void ) const;
+  volume_t VolumeAt( ESide, price_t ) const;
+
+  size_t Top( ESide, Level* rLevels, size_t nLevels ) const;  // best first, returns count filled
+  double Imbalance( size_t nLevels ) const;  // ( bid - ask ) / ( bid + ask ) over the top n levels per side
+
+  const ptime& DateTime( void ) const { return m_dtLast; };
+
+  ou::Delegate<const OrderBook&> OnChanged;  // after each applied event
+
+protected:
+private:
+
+  typedef long long tick_t;
+  typedef std::map<tick_t,volume_t> mapSparse_t;
+  typedef boost::unordered_map<MMID_t,Row> mapMMID_t;
+
+  static const tick_t nNoTick;
+
+  struct Side {
+    std::vector<volume_t> vLevels;  // flat, index is tick - m_tickBase
+    mapSparse_t mapSparse;  // levels outside the window
+    tick_t ixBest;  // absolute tick of best level, nNoTick when side is empty
+    std::vector<Row> vRows;  // positional view, capacity fixed at construction
+    size_t cntRows;
+    mapMMID_t mapMMID;  // market maker view
+    Side( void ): ixBest( nNoTick ), cntRows( 0 ) {};
+    bool HasBest( void ) const { return nNoTick != ixBest; };
+  };
+
+  price_t m_dblTickSize;
+  double m_dblTicksPerUnit;
+  tick_t m_tickBase;  // tick of window index 0, shared by both sides
+  tick_t m_nWindow;
+  Side m_side[ 2 ];  // indexed by MarketDepth::Bid, MarketDepth::Ask
+
+  ptime m_dtLast;
+
+  tick_t Tick( price_t price ) const;
+  price_t Price( tick_t tick ) const { return tick * m_dblTickSize; };
+  bool InWindow( tick_t tick ) const { return ( tick >= m_tickBase ) && ( tick < ( m_tickBase + m_nWindow ) ); };
+
+  volume_t LevelVolume( const Side&, tick_t ) const;
+  void AddVolume( ESide, tick_t, long long delta );  // keeps ixBest current
+  void SetVolume( ESide, tick_t, volume_t );
+  void FindBest( ESide );  // after the best level emptied
+  void Recentre( tick_t tickCentre );
+
+  template<typename F> size_t Walk( ESide, size_t nLevels, F& f ) const;
+
+  void Changed( const ptime& dt );
+};
+
+} // namespace tf
+} // namespace ou
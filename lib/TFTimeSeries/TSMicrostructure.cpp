@@ -13,10 +13,151 @@
  ************************************************************************/
 
 #include "stdafx.h"
+
+#include <cmath>
+
 #include "TSMicrostructure.h"
 
-TSMicrostructure::TSMicrostructure(void) { 
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+TSMicrostructure::TSMicrostructure( Quotes& quotes, Trades& trades, const Parameters& parameters )
+  : m_quotes( quotes ), m_trades( trades ), m_parameters( parameters ),
+  m_rsEffectiveSpread( parameters.nTradeWindow ), m_rsRealizedSpread( parameters.nTradeWindow ),
+  m_rsOrderFlowImbalance( parameters.nQuoteWindow ), m_rsBucketImbalance( parameters.nBuckets )
+{
+  assert( 0 < m_parameters.nBucketVolume );
+  assert( 0 < m_parameters.nBuckets );
+  Reset();
+  m_quotes.OnAppend.Add( MakeDelegate( this, &TSMicrostructure::HandleQuote ) );
+  m_trades.OnAppend.Add( MakeDelegate( this, &TSMicrostructure::HandleTrade ) );
+}
+
+TSMicrostructure::~TSMicrostructure( void ) {
+  m_trades.OnAppend.Remove( MakeDelegate( this, &TSMicrostructure::HandleTrade ) );
+  m_quotes.OnAppend.Remove( MakeDelegate( this, &TSMicrostructure::HandleQuote ) );
+}
+
+void TSMicrostructure::Reset( void ) {
+  m_bHaveQuote = false;
+  m_dblMidPoint = 0.0;
+  m_dblTradePrevious = 0.0;
+  m_nSignLeeReady = m_nSignTickRule = 0;
+  m_dblSignedVolume = 0.0;
+  m_rsEffectiveSpread.Reset();
+  m_rsRealizedSpread.Reset();
+  m_rsOrderFlowImbalance.Reset();
+  m_dequePending.clear();
+  m_dblBucketBuy = m_dblBucketSell = 0.0;
+  m_rsBucketImbalance.Reset();
+  m_dblVPIN = 0.0;
+}
+
+void TSMicrostructure::ResolvePending( const ptime& dt ) { // resolve trades whose horizon has passed, using the prevailing midpoint
+  while ( !m_dequePending.empty() ) {
+    const PendingTrade& pending( m_dequePending.front() );
+    if ( pending.dtResolve >= dt ) break;
+    m_rsRealizedSpread.Add( 2.0 * pending.nSign * ( pending.dblPrice - m_dblMidPoint ) );
+    m_pricesRealizedSpread.Append( Price( pending.dtResolve, m_rsRealizedSpread.Mean() ) );
+    m_dequePending.pop_front();
+  }
+}
+
+void TSMicrostructure::HandleQuote( const Quote& quote ) {
+
+  if ( !quote.IsValid() || quote.CrossedQuote() ) return;
+
+  const ptime& dt( quote.DateTime() );
+
+  if ( m_bHaveQuote ) {
+
+    ResolvePending( dt );
+
+    // order flow imbalance contribution, eq 10 in Cont, Kukanov & Stoikov
+    const Quote& prv( m_quotePrevious );
+    double e( 0.0 );
+    if ( quote.Bid() >= prv.Bid() ) e += quote.BidSize();
+    if ( quote.Bid() <= prv.Bid() ) e -= prv.BidSize();
+    if ( quote.Ask() <= prv.Ask() ) e -= quote.AskSize();
+    if ( quote.Ask() >= prv.Ask() ) e += prv.AskSize();
+    m_rsOrderFlowImbalance.Add( e );
+    m_pricesOrderFlowImbalance.Append( Price( dt, m_rsOrderFlowImbalance.Sum() ) );
+  }
+
+  m_quotePrevious = quote;
+  m_dblMidPoint = quote.Midpoint();
+  m_bHaveQuote = true;
+
+  // pending trades resolving at exactly this timestamp see this quote
+  ResolvePending( dt + microseconds( 1 ) );
 }
 
-TSMicrostructure::~TSMicrostructure(void) {
+void TSMicrostructure::HandleTrade( const Trade& trade ) {
+
+  const double price( trade.Price() );
+  const double volume( trade.Volume() );
+  if ( ( 0.0 >= price ) || ( 0.0 == volume ) ) return;
+
+  const ptime& dt( trade.DateTime() );
+
+  if ( m_bHaveQuote ) ResolvePending( dt );
+
+  // tick rule: zero ticks inherit the previous sign
+  if ( 0.0 != m_dblTradePrevious ) {
+    if ( price > m_dblTradePrevious ) m_nSignTickRule = 1;
+    else if ( price < m_dblTradePrevious ) m_nSignTickRule = -1;
+  }
+  m_dblTradePrevious = price;
+
+  // quote rule, falling back to the tick rule at the midpoint or when no quote is available
+  if ( m_bHaveQuote && ( price > m_dblMidPoint ) ) m_nSignLeeReady = 1;
+  else if ( m_bHaveQuote && ( price < m_dblMidPoint ) ) m_nSignLeeReady = -1;
+  else m_nSignLeeReady = m_nSignTickRule;
+
+  const int nSign( ( LeeReady == m_parameters.eClassifier ) ? m_nSignLeeReady : m_nSignTickRule );
+  m_pricesTradeSign.Append( Price( dt, nSign ) );
+
+  m_dblSignedVolume += nSign * volume;
+  m_pricesSignedVolume.Append( Price( dt, m_dblSignedVolume ) );
+
+  if ( m_bHaveQuote ) {
+    m_rsEffectiveSpread.Add( 2.0 * std::abs( price - m_dblMidPoint ) );
+    m_pricesEffectiveSpread.Append( Price( dt, m_rsEffectiveSpread.Mean() ) );
+    if ( 0 != nSign ) {
+      m_dequePending.push_back( PendingTrade( dt + m_parameters.tdRealizedHorizon, price, nSign ) );
+    }
+  }
+
+  AddToBuckets( dt, nSign, volume );
 }
+
+void TSMicrostructure::AddToBuckets( const ptime& dt, int nSign, double dblVolume ) {
+  const double dblBucketVolume( m_parameters.nBucketVolume );
+  while ( 0.0 < dblVolume ) {
+    double dblFill = std::min<double>( dblVolume, dblBucketVolume - ( m_dblBucketBuy + m_dblBucketSell ) );
+    switch ( nSign ) {
+      case 1:
+        m_dblBucketBuy += dblFill;
+        break;
+      case -1:
+        m_dblBucketSell += dblFill;
+        break;
+      default:  // unclassified volume is split evenly
+        m_dblBucketBuy += dblFill / 2.0;
+        m_dblBucketSell += dblFill / 2.0;
+        break;
+    }
+    dblVolume -= dblFill;
+    if ( dblBucketVolume <= ( m_dblBucketBuy + m_dblBucketSell ) ) {
+      m_rsBucketImbalance.Add( std::abs( m_dblBucketBuy - m_dblBucketSell ) );
+      m_dblBucketBuy = m_dblBucketSell = 0.0;
+      if ( m_rsBucketImbalance.Full() ) {
+        m_dblVPIN = m_rsBucketImbalance.Sum() / ( m_parameters.nBuckets * dblBucketVolume );
+        m_pricesVPIN.Append( Price( dt, m_dblVPIN ) );
+      }
+    }
+  }
+}
+
+} // namespace tf
+} // namespace ou
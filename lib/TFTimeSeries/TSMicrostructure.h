@@ -13,11 +13,134 @@
  ************************************************************************/
 
 #pragma once
+
+// incremental market microstructure statistics, built from a quote series and a trade series
+// attaches to the OnAppend events of both series, so when fed in timestamp order
+//   (as from MergeDatedDatums or a live Watch), each event is processed in O(1)
+// results are published as Prices series, usable by charts and by the TFGP terminals
+
+// trade signing:  Lee & Ready (1991) quote rule, with the tick rule for trades at the midpoint
+// effective spread: 2 * |P - M|, rolling mean over the last n trades
+// realized spread: 2 * sign * ( P - M(t+delta) ), resolved as quotes arrive after the horizon
+// order flow imbalance:  Cont, Kukanov & Stoikov (2011), rolling sum over the last n quotes
+// vpin:  Easley, Lopez de Prado & O'Hara (2012), volume buckets, trades split across bucket boundaries
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "TimeSeries.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
 class TSMicrostructure {
 public:
-  TSMicrostructure(void);
-  virtual ~TSMicrostructure(void);
+
+  enum EClassifier { LeeReady, TickRule };  // which sign drives signed volume, spreads and vpin
+
+  struct Parameters {
+    EClassifier eClassifier;
+    unsigned int nTradeWindow;    // trades in rolling effective spread
+    unsigned int nQuoteWindow;    // quotes in rolling order flow imbalance
+    time_duration tdRealizedHorizon;  // delay for the realized spread midpoint
+    DatedDatum::volume_t nBucketVolume;  // shares per vpin bucket
+    unsigned int nBuckets;        // buckets in the vpin window
+    Parameters( void )
+      : eClassifier( LeeReady ), nTradeWindow( 100 ), nQuoteWindow( 100 ),
+        tdRealizedHorizon( seconds( 5 ) ), nBucketVolume( 10000 ), nBuckets( 50 ) {};
+  };
+
+  TSMicrostructure( Quotes& quotes, Trades& trades, const Parameters& parameters = Parameters() );
+  virtual ~TSMicrostructure( void );
+
+  void Reset( void );
+
+  int LeeReadySign( void ) const { return m_nSignLeeReady; };  // last trade: +1 buy, -1 sell, 0 unknown
+  int TickRuleSign( void ) const { return m_nSignTickRule; };
+  double EffectiveSpread( void ) const { return m_rsEffectiveSpread.Mean(); };
+  double RealizedSpread( void ) const { return m_rsRealizedSpread.Mean(); };
+  double SignedVolume( void ) const { return m_dblSignedVolume; };  // cumulative
+  double OrderFlowImbalance( void ) const { return m_rsOrderFlowImbalance.Sum(); };
+  double VPIN( void ) const { return m_dblVPIN; };
+
+  // published series, one element per contributing event
+  Prices& TradeSign( void ) { return m_pricesTradeSign; };
+  Prices& EffectiveSpreadSeries( void ) { return m_pricesEffectiveSpread; };
+  Prices& RealizedSpreadSeries( void ) { return m_pricesRealizedSpread; };
+  Prices& SignedVolumeSeries( void ) { return m_pricesSignedVolume; };
+  Prices& OrderFlowImbalanceSeries( void ) { return m_pricesOrderFlowImbalance; };
+  Prices& VPINSeries( void ) { return m_pricesVPIN; };  // one element per completed bucket
+
 protected:
 private:
+
+  // fixed size ring with running sum, storage is allocated once
+  class RollingSum {
+  public:
+    RollingSum( unsigned int nWindow ): m_v( nWindow ? nWindow : 1, 0.0 ), m_ix( 0 ), m_cnt( 0 ), m_dblSum( 0.0 ) {};
+    void Add( double dbl ) {
+      if ( m_cnt == m_v.size() ) m_dblSum -= m_v[ m_ix ];
+      else ++m_cnt;
+      m_v[ m_ix ] = dbl;
+      m_dblSum += dbl;
+      if ( m_v.size() == ++m_ix ) m_ix = 0;
+    }
+    void Reset( void ) { std::fill( m_v.begin(), m_v.end(), 0.0 ); m_ix = m_cnt = 0; m_dblSum = 0.0; };
+    double Sum( void ) const { return m_dblSum; };
+    double Mean( void ) const { return ( 0 == m_cnt ) ? 0.0 : m_dblSum / m_cnt; };
+    bool Full( void ) const { return m_cnt == m_v.size(); };
+  private:
+    std::vector<double> m_v;
+    std::vector<double>::size_type m_ix;
+    std::vector<double>::size_type m_cnt;
+    double m_dblSum;
+  };
+
+  struct PendingTrade {  // awaiting the midpoint at trade time + horizon
+    ptime dtResolve;
+    double dblPrice;
+    int nSign;
+    PendingTrade( const ptime& dt, double price, int sign ): dtResolve( dt ), dblPrice( price ), nSign( sign ) {};
+  };
+
+  Quotes& m_quotes;
+  Trades& m_trades;
+  Parameters m_parameters;
+
+  Quote m_quotePrevious;
+  bool m_bHaveQuote;
+  double m_dblMidPoint;
+
+  double m_dblTradePrevious;  // for the tick rule
+  int m_nSignLeeReady;
+  int m_nSignTickRule;
+
+  double m_dblSignedVolume;
+
+  RollingSum m_rsEffectiveSpread;
+  RollingSum m_rsRealizedSpread;
+  RollingSum m_rsOrderFlowImbalance;
+  std::deque<PendingTrade> m_dequePending;
+
+  double m_dblBucketBuy;
+  double m_dblBucketSell;
+  RollingSum m_rsBucketImbalance;
+  double m_dblVPIN;
+
+  Prices m_pricesTradeSign;
+  Prices m_pricesEffectiveSpread;
+  Prices m_pricesRealizedSpread;
+  Prices m_pricesSignedVolume;
+  Prices m_pricesOrderFlowImbalance;
+  Prices m_pricesVPIN;
+
+  void HandleQuote( const Quote& );
+  void HandleTrade( const Trade& );
+
+  void ResolvePending( const ptime& dt );
+  void AddToBuckets( const ptime& dt, int nSign, double dblVolume );
 };
 
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,219 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "TickCleaner.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+namespace {
+  const char* rszFlagName[] = { "backwards", "collision", "crossed", "locked", "badprice", "size", "spread", "band" };
+
+  inline double Priced( const Quote& quote ) { return ( quote.Bid() + quote.Ask() ) * 0.5; };
+  inline double Priced( const Trade& trade ) { return trade.Price(); };
+
+  inline boost::int64_t Ticks( const ptime& dt ) {  // the representation, as kept in hdf5, see DatedDatum::DefineDataType
+    return *reinterpret_cast<const boost::int64_t*>( &dt );
+  }
+
+  // before the latest in order time, or, a stamp out ahead, after the next one when that one is in order
+  //   so a lone outlier is flagged itself, and neither it nor its neighbours move nLatest on for the datums after
+  inline bool OutOfOrder( boost::int64_t nTime, boost::int64_t nNext, boost::int64_t nLatest ) {
+    return ( nTime < nLatest ) | ( ( nNext < nTime ) & ( nLatest <= nNext ) );
+  }
+}
+
+const char* TickCleaner::FlagName( unsigned int ixBit ) {
+  assert( ixBit < nFlags );
+  return rszFlagName[ ixBit ];
+}
+
+TickCleaner::Rules::Rules( void )
+: bDrop( true ), maskDrop( ~static_cast<flag_t>( Collision ) ),
+  dblBand( 0.10 ), nBlock( 1024 ), nMedianSamples( 64 ),
+  dblMaxSpread( 0.0 ), dblMaxSpreadFraction( 0.05 ),
+  nMinSize( 1 ), nMaxSize( std::numeric_limits<DatedDatum::volume_t>::max() )
+{
+}
+
+TickCleaner::Report::Report( void ): nDatums( 0 ), nFlagged( 0 ), nDropped( 0 ) {
+  std::fill( rCount, rCount + nFlags, 0 );
+}
+
+void TickCleaner::Report::Emit( std::ostream& os ) const {
+  os << sName << ": " << nDatums << " datums, " << nFlagged << " flagged, " << nDropped << " dropped";
+  for ( unsigned int ix = 0; ix < nFlags; ++ix ) {
+    if ( 0 != rCount[ ix ] ) os << ", " << FlagName( ix ) << " " << rCount[ ix ];
+  }
+  os << std::endl;
+}
+
+TickCleaner::TickCleaner( const Rules& rules )
+: m_rules( rules ), m_nTicksMicrosecond( boost::posix_time::microseconds( 1 ).ticks() )
+{
+  assert( 0 < m_rules.nBlock );
+  assert( 0 < m_rules.nMedianSamples );
+  m_rules.nMedianSamples = std::min( m_rules.nMedianSamples, m_rules.nBlock );
+  m_vSample.resize( m_rules.nMedianSamples );
+}
+
+TickCleaner::~TickCleaner( void ) {
+}
+
+template<class DD>
+void TickCleaner::Median( const DD* pDatum, size_t n, double& dblMedian, double& dblBand ) {
+  // the median of samples spread through the block, those with a bad price are skipped by advancing the count only for good ones
+  double* pSample( &m_vSample[ 0 ] );
+  const size_t nStep( ( n + m_rules.nMedianSamples - 1 ) / m_rules.nMedianSamples );  // at most nMedianSamples
+  size_t nSamples( 0 );
+  for ( size_t ix = 0; ix < n; ix += nStep ) {
+    const double dblPrice( Priced( pDatum[ ix ] ) );
+    pSample[ nSamples ] = dblPrice;
+    nSamples += ( 0.0 < dblPrice );
+  }
+  if ( 0 == nSamples ) {  // nothing priced to compare with
+    dblMedian = 0.0;
+    dblBand = std::numeric_limits<double>::max();
+  }
+  else {
+    std::nth_element( pSample, pSample + nSamples / 2, pSample + nSamples );
+    dblMedian = pSample[ nSamples / 2 ];
+    dblBand = m_rules.dblBand * dblMedian;
+  }
+}
+
+// the datums of a block are read once, after the block's median is taken from its samples,
+//   each rule a comparison turned into its bit, no branches, the latest in order time and the preceding time
+//   the only state from one datum to the next, the following datum's time looked at for an outlier ahead
+
+void TickCleaner::Clean( Quotes& quotes, Report& report, vFlag_t* pvFlag ) {
+  vFlag_t vFlagLocal;
+  vFlag_t& vFlag( 0 == pvFlag ? vFlagLocal : *pvFlag );
+  const size_t nDatums( quotes.Size() );
+  vFlag.assign( nDatums, 0 );
+  report = Report();
+  report.sName = quotes.GetName();
+  report.nDatums = nDatums;
+  if ( 0 == nDatums ) return;
+  const double dblMaxSpread( 0.0 == m_rules.dblMaxSpread ? std::numeric_limits<double>::max() : m_rules.dblMaxSpread );
+  const double dblMaxSpreadFraction( 0.0 == m_rules.dblMaxSpreadFraction ? std::numeric_limits<double>::max() : m_rules.dblMaxSpreadFraction );
+  const DatedDatum::volume_t nMinSize( m_rules.nMinSize );
+  const DatedDatum::volume_t nMaxSize( m_rules.nMaxSize );
+  const boost::int64_t nTicksMicrosecond( m_nTicksMicrosecond );
+  const Quote* pQuote( quotes.First() );
+  boost::int64_t nLatest( Ticks( pQuote->DateTime() ) );
+  boost::int64_t nPrevious( nLatest - 2 * nTicksMicrosecond );
+  for ( size_t ixBlock = 0; ixBlock < nDatums; ixBlock += m_rules.nBlock ) {
+    const size_t n( std::min<size_t>( m_rules.nBlock, nDatums - ixBlock ) );
+    flag_t* pFlag( &vFlag[ ixBlock ] );
+    double dblMedian, dblBand;
+    Median( pQuote, n, dblMedian, dblBand );
+    for ( size_t ix = 0; ix < n; ++ix, ++pQuote ) {
+      const boost::int64_t nTime( Ticks( pQuote->DateTime() ) );
+      const boost::int64_t nNext( ( ixBlock + ix + 1 ) < nDatums ? Ticks( pQuote[ 1 ].DateTime() ) : nTime );
+      const bool bBackwards( OutOfOrder( nTime, nNext, nLatest ) );
+      const double dblBid( pQuote->Bid() );
+      const double dblAsk( pQuote->Ask() );
+      const DatedDatum::volume_t nBidSize( pQuote->BidSize() );
+      const DatedDatum::volume_t nAskSize( pQuote->AskSize() );
+      const double dblSpread( dblAsk - dblBid );
+      const double dblMid( ( dblAsk + dblBid ) * 0.5 );
+      pFlag[ ix ] =
+          ( Backwards & -static_cast<flag_t>( bBackwards ) )
+        | ( Collision & -static_cast<flag_t>( nTicksMicrosecond == ( nTime - nPrevious ) ) )
+        | ( Crossed   & -static_cast<flag_t>( dblSpread < 0.0 ) )
+        | ( Locked    & -static_cast<flag_t>( dblSpread == 0.0 ) )
+        | ( BadPrice  & -static_cast<flag_t>( ( dblBid <= 0.0 ) | ( dblAsk <= 0.0 ) ) )
+        | ( Size      & -static_cast<flag_t>( ( nBidSize < nMinSize ) | ( nBidSize > nMaxSize ) | ( nAskSize < nMinSize ) | ( nAskSize > nMaxSize ) ) )
+        | ( Spread    & -static_cast<flag_t>( ( dblSpread > dblMaxSpread ) | ( dblSpread > ( dblMaxSpreadFraction * dblMid ) ) ) )
+        | ( Band      & -static_cast<flag_t>( std::fabs( dblMid - dblMedian ) > dblBand ) );
+      nLatest = bBackwards ? nLatest : nTime;  // in order, so no earlier than nLatest
+      nPrevious = nTime;
+    }
+    Count( pFlag, n, report );
+  }
+  Drop( quotes, vFlag, report );
+}
+
+void TickCleaner::Clean( Trades& trades, Report& report, vFlag_t* pvFlag ) {
+  vFlag_t vFlagLocal;
+  vFlag_t& vFlag( 0 == pvFlag ? vFlagLocal : *pvFlag );
+  const size_t nDatums( trades.Size() );
+  vFlag.assign( nDatums, 0 );
+  report = Report();
+  report.sName = trades.GetName();
+  report.nDatums = nDatums;
+  if ( 0 == nDatums ) return;
+  const DatedDatum::volume_t nMinSize( m_rules.nMinSize );
+  const DatedDatum::volume_t nMaxSize( m_rules.nMaxSize );
+  const boost::int64_t nTicksMicrosecond( m_nTicksMicrosecond );
+  const Trade* pTrade( trades.First() );
+  boost::int64_t nLatest( Ticks( pTrade->DateTime() ) );
+  boost::int64_t nPrevious( nLatest - 2 * nTicksMicrosecond );
+  for ( size_t ixBlock = 0; ixBlock < nDatums; ixBlock += m_rules.nBlock ) {
+    const size_t n( std::min<size_t>( m_rules.nBlock, nDatums - ixBlock ) );
+    flag_t* pFlag( &vFlag[ ixBlock ] );
+    double dblMedian, dblBand;
+    Median( pTrade, n, dblMedian, dblBand );
+    for ( size_t ix = 0; ix < n; ++ix, ++pTrade ) {
+      const boost::int64_t nTime( Ticks( pTrade->DateTime() ) );
+      const boost::int64_t nNext( ( ixBlock + ix + 1 ) < nDatums ? Ticks( pTrade[ 1 ].DateTime() ) : nTime );
+      const bool bBackwards( OutOfOrder( nTime, nNext, nLatest ) );
+      const double dblPrice( pTrade->Price() );
+      const DatedDatum::volume_t nVolume( pTrade->Volume() );
+      pFlag[ ix ] =
+          ( Backwards & -static_cast<flag_t>( bBackwards ) )
+        | ( Collision & -static_cast<flag_t>( nTicksMicrosecond == ( nTime - nPrevious ) ) )
+        | ( BadPrice  & -static_cast<flag_t>( dblPrice <= 0.0 ) )
+        | ( Size      & -static_cast<flag_t>( ( nVolume < nMinSize ) | ( nVolume > nMaxSize ) ) )
+        | ( Band      & -static_cast<flag_t>( std::fabs( dblPrice - dblMedian ) > dblBand ) );
+      nLatest = bBackwards ? nLatest : nTime;
+      nPrevious = nTime;
+    }
+    Count( pFlag, n, report );
+  }
+  Drop( trades, vFlag, report );
+}
+
+void TickCleaner::Count( const flag_t* pFlag, size_t n, Report& report ) {
+  flag_t any( 0 );
+  for ( size_t ix = 0; ix < n; ++ix ) any |= pFlag[ ix ];
+  if ( 0 == any ) return;  // the usual block, nothing to count
+  size_t nFlagged( 0 );
+  for ( size_t ix = 0; ix < n; ++ix ) nFlagged += ( 0 != pFlag[ ix ] );
+  report.nFlagged += nFlagged;
+  for ( unsigned int ixBit = 0; ixBit < nFlags; ++ixBit ) {
+    if ( 0 != ( any & ( 1 << ixBit ) ) ) {
+      size_t nCount( 0 );
+      for ( size_t ix = 0; ix < n; ++ix ) nCount += ( pFlag[ ix ] >> ixBit ) & 1;
+      report.rCount[ ixBit ] += nCount;
+    }
+  }
+}
+
+template<class TS>
+void TickCleaner::Drop( TS& series, const vFlag_t& vFlag, Report& report ) {
+  if ( m_rules.bDrop && ( 0 != m_rules.maskDrop ) ) {
+    report.nDropped = series.Remove( vFlag, m_rules.maskDrop );
+  }
+}
+
+} // namespace tf
+} // namespace ou
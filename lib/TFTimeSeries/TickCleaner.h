@@ -0,0 +1,114 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// validates, and cleans, whole Quotes or Trades buffers, straight after an hdf5 read or a history download
+//   each rule sets a bit in a flag per datum; a block of datums at a time, its median taken first from samples,
+//   then the block in one pass, each rule's comparison turned into its bit rather than a branch
+// rules:
+//   Backwards: timestamp before the latest in order one preceding it, or ahead of the next one when that one is in order,
+//     an outlier is flagged without the later datums being flagged against it
+//   Collision: timestamp 1us after the preceding one, the TimeSource monotonic fudge, reported but not dropped by default
+//   Crossed, Locked: quote with the bid above, or at, the ask
+//   BadPrice: price (bid or ask) zero or negative
+//   Size: size (bid or ask size) outside nMinSize..nMaxSize, eg zero size prints
+//   Spread: quote spread wider than dblMaxSpread, or dblMaxSpreadFraction of the midpoint, either limit off when zero
+//   Band: price (quote midpoint) further than dblBand, a fraction, from the median of its block of nBlock datums,
+//     the median being of nMedianSamples spread through the block
+// Clean drops the datums flagged with a bit in maskDrop, when bDrop, and fills in the series' Report
+// How to Use:
+/*
+  ou::tf::Quotes quotes;  // read from hdf5
+  ou::tf::TickCleaner cleaner;
+  ou::tf::TickCleaner::Report report;
+  cleaner.Clean( quotes, report );
+  report.Emit( std::cout );
+*/
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <boost/cstdint.hpp>
+
+#include "TimeSeries.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class TickCleaner {
+public:
+
+  typedef boost::uint8_t flag_t;
+  typedef std::vector<flag_t> vFlag_t;
+
+  enum EFlag {
+    Backwards = 0x01, Collision = 0x02, Crossed = 0x04, Locked = 0x08,
+    BadPrice = 0x10, Size = 0x20, Spread = 0x40, Band = 0x80
+  };
+  static const unsigned int nFlags = 8;
+  static const char* FlagName( unsigned int ixBit );
+
+  struct Rules {
+    bool bDrop;  // false: flag and report only
+    flag_t maskDrop;
+    double dblBand;
+    unsigned int nBlock;  // datums
+    unsigned int nMedianSamples;
+    double dblMaxSpread;
+    double dblMaxSpreadFraction;
+    DatedDatum::volume_t nMinSize;
+    DatedDatum::volume_t nMaxSize;
+    Rules( void );  // all but Collision dropped, band 10%, blocks of 1024 with 64 samples, spread 5%, sizes 1 and up
+  };
+
+  struct Report {
+    std::string sName;
+    size_t nDatums;
+    size_t nFlagged;  // with any bit
+    size_t nDropped;
+    size_t rCount[ nFlags ];  // by bit
+    Report( void );
+    void Emit( std::ostream& os ) const;  // a line
+  };
+
+  explicit TickCleaner( const Rules& rules = Rules() );
+  ~TickCleaner( void );
+
+  const Rules& GetRules( void ) const { return m_rules; };
+
+  // pvFlag, when given, receives the flags of the datums as they were before any were dropped
+  void Clean( Quotes& quotes, Report& report, vFlag_t* pvFlag = 0 );
+  void Clean( Trades& trades, Report& report, vFlag_t* pvFlag = 0 );
+
+protected:
+private:
+
+  Rules m_rules;
+  boost::int64_t m_nTicksMicrosecond;
+
+  std::vector<double> m_vSample;  // prices, midpoints for quotes, for a block's median
+
+  template<class DD>
+  void Median( const DD* pDatum, size_t n, double& dblMedian, double& dblBand );
+  void Count( const flag_t* pFlag, size_t n, Report& report );
+
+  template<class TS>
+  void Drop( TS& series, const vFlag_t& vFlag, Report& report );
+
+};
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,238 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <cassert>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "TickStore.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+//
+// TickStore
+//
+
+const char TickStore::rchMagicHeader[ 8 ] = { 'O', 'U', 'T', 'I', 'C', 'K', 'S', '1' };
+const char TickStore::rchMagicTrailer[ 8 ] = { 'O', 'U', 'T', 'I', 'C', 'K', 'I', 'X' };
+const ptime TickStore::m_dtEpoch( boost::gregorian::date( 1970, 1, 1 ) );
+
+std::string TickStore::SegmentPath( const std::string& sRoot, const std::string& sSymbol, boost::gregorian::date day, const std::string& sKind ) {
+  return sRoot + "/" + sSymbol + "/" + boost::gregorian::to_iso_string( day ) + "." + sKind;
+}
+
+//
+// TickStoreSegment
+//
+
+namespace {
+  bool ByFirstDatum( boost::uint64_t ix, const TickStore::IndexEntry& entry ) { return ix < entry.ixFirst; };
+  bool ByFirstTime( const TickStore::IndexEntry& entry, boost::int64_t n ) { return entry.nFirst < n; };
+}
+
+TickStoreSegment::TickStoreSegment( const std::string& sPath, boost::uint64_t nSignature, size_t nDoubles, size_t nWords )
+: m_sPath( sPath ), m_pBase( 0 ), m_nDoubles( nDoubles ), m_nWords( nWords ), m_nDatums( 0 ), m_nBlocksEnd( 0 ), m_bTrailer( false )
+{
+  boost::system::error_code ec;
+  const boost::uintmax_t nFileBytes( boost::filesystem::file_size( sPath, ec ) );
+  if ( ec ) throw std::runtime_error( "TickStoreSegment: can't find " + sPath );
+  if ( sizeof( TickStore::Header ) > nFileBytes ) throw std::runtime_error( "TickStoreSegment: no header in " + sPath );
+  try {
+    m_pMapping.reset( new boost::interprocess::file_mapping( sPath.c_str(), boost::interprocess::read_only ) );
+    m_pRegion.reset( new boost::interprocess::mapped_region( *m_pMapping, boost::interprocess::read_only, 0, (size_t) nFileBytes ) );
+  }
+  catch ( boost::interprocess::interprocess_exception& e ) {
+    throw std::runtime_error( "TickStoreSegment: can't map " + sPath + ": " + e.what() );
+  }
+  m_pBase = static_cast<const char*>( m_pRegion->get_address() );
+  m_pRegion->advise( boost::interprocess::mapped_region::advice_sequential );  // replay reads front to back
+
+  TickStore::Header header;
+  std::memcpy( &header, m_pBase, sizeof( header ) );
+  if ( 0 != std::memcmp( header.rchMagic, TickStore::rchMagicHeader, sizeof( header.rchMagic ) ) )
+    throw std::runtime_error( "TickStoreSegment: not a segment " + sPath );
+  if ( ( nSignature != header.nSignature ) || ( nDoubles != header.nDoubles ) || ( nWords != header.nWords ) )
+    throw std::runtime_error( "TickStoreSegment: wrong datum type in " + sPath );
+
+  // the index is at the end, after the blocks, when the writer closed
+  const size_t nBytes( (size_t) nFileBytes );
+  if ( sizeof( TickStore::Header ) + sizeof( TickStore::Trailer ) <= nBytes ) {
+    TickStore::Trailer trailer;
+    std::memcpy( &trailer, m_pBase + nBytes - sizeof( trailer ), sizeof( trailer ) );
+    if ( ( 0 == std::memcmp( trailer.rchMagic, TickStore::rchMagicTrailer, sizeof( trailer.rchMagic ) ) )
+      && ( trailer.nBlocks <= ( nBytes - sizeof( TickStore::Header ) - sizeof( trailer ) ) / sizeof( IndexEntry ) ) ) {
+      m_bTrailer = true;
+      m_nBlocksEnd = nBytes - sizeof( trailer ) - trailer.nBlocks * sizeof( IndexEntry );
+      m_vIndex.resize( (size_t) trailer.nBlocks );
+      if ( 0 != trailer.nBlocks ) std::memcpy( &m_vIndex[ 0 ], m_pBase + m_nBlocksEnd, (size_t) trailer.nBlocks * sizeof( IndexEntry ) );
+      m_nDatums = trailer.nDatums;
+    }
+  }
+  if ( !m_bTrailer ) {
+    Scan( nBytes );
+  }
+}
+
+TickStoreSegment::~TickStoreSegment( void ) {
+  m_pRegion.reset();  // before the mapping
+  m_pMapping.reset();
+}
+
+void TickStoreSegment::Scan( size_t nFileBytes ) {
+  // walk the block headers, stopping at the first block not completely written
+  size_t nOffset( sizeof( TickStore::Header ) );
+  m_vIndex.clear();
+  m_nDatums = 0;
+  while ( sizeof( TickStore::BlockHeader ) <= ( nFileBytes - nOffset ) ) {
+    TickStore::BlockHeader header;
+    std::memcpy( &header, m_pBase + nOffset, sizeof( header ) );
+    if ( ( 0 == header.nCount ) || ( TickStore::nBlockDatums < header.nCount ) ) break;
+    if ( TickStore::BlockBytes( header.nCount, m_nDoubles, m_nWords ) != header.nBytes ) break;
+    if ( ( nFileBytes - nOffset ) < header.nBytes ) break;
+    IndexEntry entry;
+    entry.nFirst = header.nFirst;
+    entry.nOffset = nOffset;
+    entry.ixFirst = m_nDatums;
+    m_vIndex.push_back( entry );
+    m_nDatums += header.nCount;
+    nOffset += header.nBytes;
+  }
+  m_nBlocksEnd = nOffset;
+}
+
+boost::uint32_t TickStoreSegment::BlockCount( size_t ixBlock ) const {
+  TickStore::BlockHeader header;
+  std::memcpy( &header, Block( ixBlock ), sizeof( header ) );
+  return header.nCount;
+}
+
+size_t TickStoreSegment::FindBlock( boost::uint64_t ix ) const {
+  assert( ix < m_nDatums );
+  vIndex_t::const_iterator iter = std::upper_bound( m_vIndex.begin(), m_vIndex.end(), ix, ByFirstDatum );
+  return ( iter - m_vIndex.begin() ) - 1;
+}
+
+boost::uint64_t TickStoreSegment::LowerBound( const ptime& dt ) const {
+  // the first block starting at or after dt, the answer is in the block before it, or is its first datum
+  const boost::int64_t n( TickStore::ToMicroseconds( dt ) );
+  vIndex_t::const_iterator iter = std::lower_bound( m_vIndex.begin(), m_vIndex.end(), n, ByFirstTime );
+  if ( m_vIndex.begin() == iter ) return 0;
+  const size_t ixBlock( ( iter - m_vIndex.begin() ) - 1 );
+  const IndexEntry& entry( m_vIndex[ ixBlock ] );
+  const boost::uint32_t* pOffset( reinterpret_cast<const boost::uint32_t*>( Block( ixBlock ) + sizeof( TickStore::BlockHeader ) ) );
+  const boost::uint32_t* pEnd( pOffset + BlockCount( ixBlock ) );
+  const boost::int64_t nOffset( n - entry.nFirst );  // positive, as the block starts before dt
+  if ( nOffset <= 0xffffffffll ) {
+    const boost::uint32_t* p( std::lower_bound( pOffset, pEnd, (boost::uint32_t) nOffset ) );
+    if ( pEnd != p ) return entry.ixFirst + ( p - pOffset );
+  }
+  return ( m_vIndex.end() == iter ) ? m_nDatums : iter->ixFirst;
+}
+
+ptime TickStoreSegment::LastDateTime( void ) const {
+  if ( m_vIndex.empty() ) return ptime( not_a_date_time );
+  const size_t ixBlock( m_vIndex.size() - 1 );
+  const boost::uint32_t* pOffset( reinterpret_cast<const boost::uint32_t*>( Block( ixBlock ) + sizeof( TickStore::BlockHeader ) ) );
+  return TickStore::FromMicroseconds( m_vIndex[ ixBlock ].nFirst + pOffset[ BlockCount( ixBlock ) - 1 ] );
+}
+
+//
+// TickStoreAppender
+//
+
+TickStoreAppender::TickStoreAppender( const std::string& sPath, boost::uint64_t nSignature, size_t nDoubles, size_t nWords )
+: m_sPath( sPath ), m_pFile( 0 ), m_nOffset( 0 ), m_nDatums( 0 ), m_dtLast( not_a_date_time )
+{
+  boost::system::error_code ec;
+  const boost::filesystem::path path( sPath );
+  if ( path.has_parent_path() ) boost::filesystem::create_directories( path.parent_path(), ec );
+  if ( boost::filesystem::exists( path, ec ) && ( 0 != boost::filesystem::file_size( path, ec ) ) ) {
+    {
+      TickStoreSegment segment( sPath, nSignature, nDoubles, nWords );
+      m_vIndex = segment.Index();
+      m_nOffset = segment.BlocksEnd();
+      m_nDatums = segment.size();
+      m_dtLast = segment.LastDateTime();
+    }
+    // drop the index, or a partly written block, appends carry on from the last complete block
+    boost::filesystem::resize_file( path, m_nOffset, ec );
+    if ( ec ) throw std::runtime_error( "TickStoreAppender: can't truncate " + sPath );
+    m_pFile = std::fopen( sPath.c_str(), "r+b" );
+    if ( 0 == m_pFile ) throw std::runtime_error( "TickStoreAppender: can't open " + sPath );
+    std::fseek( m_pFile, 0, SEEK_END );
+  }
+  else {
+    m_pFile = std::fopen( sPath.c_str(), "wb" );
+    if ( 0 == m_pFile ) throw std::runtime_error( "TickStoreAppender: can't create " + sPath );
+    TickStore::Header header;
+    std::memset( &header, 0, sizeof( header ) );
+    std::memcpy( header.rchMagic, TickStore::rchMagicHeader, sizeof( header.rchMagic ) );
+    header.nSignature = nSignature;
+    header.nBlockDatums = TickStore::nBlockDatums;
+    header.nDoubles = (boost::uint32_t) nDoubles;
+    header.nWords = (boost::uint32_t) nWords;
+    if ( 1 != std::fwrite( &header, sizeof( header ), 1, m_pFile ) ) throw std::runtime_error( "TickStoreAppender: can't write " + sPath );
+    m_nOffset = sizeof( header );
+  }
+}
+
+TickStoreAppender::~TickStoreAppender( void ) {
+  try {
+    Close();
+  }
+  catch ( std::runtime_error& e ) {
+  }
+}
+
+void TickStoreAppender::Append( const char* pBlock, size_t nBytes, boost::int64_t nFirst, boost::uint32_t nCount, const ptime& dtLast ) {
+  if ( 0 == m_pFile ) throw std::runtime_error( "TickStoreAppender::Append: closed " + m_sPath );
+  if ( 1 != std::fwrite( pBlock, nBytes, 1, m_pFile ) ) throw std::runtime_error( "TickStoreAppender::Append: can't write " + m_sPath );
+  TickStore::IndexEntry entry;
+  entry.nFirst = nFirst;
+  entry.nOffset = m_nOffset;
+  entry.ixFirst = m_nDatums;
+  m_vIndex.push_back( entry );
+  m_nOffset += nBytes;
+  m_nDatums += nCount;
+  m_dtLast = dtLast;
+}
+
+void TickStoreAppender::Flush( void ) {
+  if ( 0 != m_pFile ) std::fflush( m_pFile );
+}
+
+void TickStoreAppender::Close( void ) {
+  if ( 0 != m_pFile ) {
+    std::FILE* pFile( m_pFile );
+    m_pFile = 0;
+    TickStore::Trailer trailer;
+    trailer.nBlocks = m_vIndex.size();
+    trailer.nDatums = m_nDatums;
+    std::memcpy( trailer.rchMagic, TickStore::rchMagicTrailer, sizeof( trailer.rchMagic ) );
+    bool bOk( true );
+    if ( !m_vIndex.empty() ) bOk = ( 1 == std::fwrite( &m_vIndex[ 0 ], m_vIndex.size() * sizeof( TickStore::IndexEntry ), 1, pFile ) );
+    bOk = bOk && ( 1 == std::fwrite( &trailer, sizeof( trailer ), 1, pFile ) );
+    bOk = ( 0 == std::fclose( pFile ) ) && bOk;
+    if ( !bOk ) throw std::runtime_error( "TickStoreAppender::Close: can't write index " + m_sPath );  // rebuilt when next opened
+  }
+}
+
+} // namespace tf
+} // namespace ou
@@ -0,0 +1,324 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// tick store: append only, memory mapped, columnar files of ticks, an alternative to the hdf5 file for replay
+//   a segment file per symbol per day per datum type: <root>/<symbol>/<yyyymmdd>.<kind>, kind is quotes, trades, greeks or depths
+//   the file is a Header, then blocks, then an index of the blocks
+//   a block holds up to nBlockDatums datums as columns:
+//     timestamps, as uint32 microseconds from the block's first timestamp (a datum too far from it starts a new block),
+//     then a column of doubles per price-like field, then a column of uint32 per size-like field
+//   the index (first timestamp, offset, first datum of each block) is written when the writer closes,
+//     a segment left without one (writer killed) has it rebuilt from the block headers when opened, a partly written last block is dropped
+//   values are native byte order
+// reading: see TickStoreContainer.h, writing: TickStoreWriter below, importing from hdf5: TFHDF5TimeSeries/HDF5TickStoreImport.h
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+
+#include "DatedDatum.h"
+
+namespace boost { // mapping is kept out of the header
+namespace interprocess {
+  class file_mapping;
+  class mapped_region;
+} }
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+// the fields of each datum type other than its timestamp, as columns
+template<class DD> struct TickStoreColumns;
+
+template<> struct TickStoreColumns<Quote> {
+  static const char* Kind( void ) { return "quotes"; };
+  enum { nDoubles = 2, nWords = 2 };
+  static void Split( const Quote& quote, double* rDouble, boost::uint32_t* rWord ) {
+    rDouble[ 0 ] = quote.Bid();
+    rDouble[ 1 ] = quote.Ask();
+    rWord[ 0 ] = quote.BidSize();
+    rWord[ 1 ] = quote.AskSize();
+  };
+  static Quote Join( const ptime& dt, const double* rDouble, const boost::uint32_t* rWord ) {
+    return Quote( dt, rDouble[ 0 ], rWord[ 0 ], rDouble[ 1 ], rWord[ 1 ] );
+  };
+};
+
+template<> struct TickStoreColumns<Trade> {
+  static const char* Kind( void ) { return "trades"; };
+  enum { nDoubles = 1, nWords = 1 };
+  static void Split( const Trade& trade, double* rDouble, boost::uint32_t* rWord ) {
+    rDouble[ 0 ] = trade.Price();
+    rWord[ 0 ] = trade.Volume();
+  };
+  static Trade Join( const ptime& dt, const double* rDouble, const boost::uint32_t* rWord ) {
+    return Trade( dt, rDouble[ 0 ], rWord[ 0 ] );
+  };
+};
+
+template<> struct TickStoreColumns<Greek> {
+  static const char* Kind( void ) { return "greeks"; };
+  enum { nDoubles = 6, nWords = 0 };
+  static void Split( const Greek& greek, double* rDouble, boost::uint32_t* ) {
+    rDouble[ 0 ] = greek.ImpliedVolatility();
+    rDouble[ 1 ] = greek.Delta();
+    rDouble[ 2 ] = greek.Gamma();
+    rDouble[ 3 ] = greek.Theta();
+    rDouble[ 4 ] = greek.Vega();
+    rDouble[ 5 ] = greek.Rho();
+  };
+  static Greek Join( const ptime& dt, const double* rDouble, const boost::uint32_t* ) {
+    return Greek( dt, rDouble[ 0 ], rDouble[ 1 ], rDouble[ 2 ], rDouble[ 3 ], rDouble[ 4 ], rDouble[ 5 ] );
+  };
+};
+
+template<> struct TickStoreColumns<MarketDepth> {
+  static const char* Kind( void ) { return "depths"; };
+  enum { nDoubles = 1, nWords = 3 };
+  static void Split( const MarketDepth& depth, double* rDouble, boost::uint32_t* rWord ) {
+    rDouble[ 0 ] = depth.Price();
+    rWord[ 0 ] = depth.Volume();
+    rWord[ 1 ] = ( MarketDepth::Bid == depth.m_eSide ) ? 'B' : ( ( MarketDepth::Ask == depth.m_eSide ) ? 'S' : ' ' );
+    rWord[ 2 ] = (boost::uint32_t) depth.MMID();  // four characters
+  };
+  static MarketDepth Join( const ptime& dt, const double* rDouble, const boost::uint32_t* rWord ) {
+    return MarketDepth( dt, (char) rWord[ 1 ], rWord[ 0 ], rDouble[ 0 ], rWord[ 2 ] );
+  };
+};
+
+class TickStore {
+public:
+
+  static const boost::uint32_t nBlockDatums = 1024;
+
+  static std::string SegmentPath( const std::string& sRoot, const std::string& sSymbol, boost::gregorian::date day, const std::string& sKind );
+  template<class DD>
+  static std::string SegmentPath( const std::string& sRoot, const std::string& sSymbol, boost::gregorian::date day ) {
+    return SegmentPath( sRoot, sSymbol, day, TickStoreColumns<DD>::Kind() );
+  };
+
+  static boost::int64_t ToMicroseconds( const ptime& dt ) { return ( dt - m_dtEpoch ).total_microseconds(); };
+  static ptime FromMicroseconds( boost::int64_t n ) { return m_dtEpoch + microseconds( n ); };
+
+  // file layout
+  struct Header {
+    char rchMagic[ 8 ];
+    boost::uint64_t nSignature;  // DD::Signature()
+    boost::uint32_t nBlockDatums;
+    boost::uint32_t nDoubles;
+    boost::uint32_t nWords;
+    boost::uint32_t nReserved;
+  };
+  struct BlockHeader {
+    boost::int64_t nFirst;  // microseconds since 1970, the offsets count from here
+    boost::uint32_t nCount;
+    boost::uint32_t nBytes;  // whole block, header included
+  };
+  struct IndexEntry {
+    boost::int64_t nFirst;
+    boost::uint64_t nOffset;
+    boost::uint64_t ixFirst;  // datum number of the block's first datum
+  };
+  struct Trailer {
+    boost::uint64_t nBlocks;
+    boost::uint64_t nDatums;
+    char rchMagic[ 8 ];
+  };
+
+  static const char rchMagicHeader[ 8 ];
+  static const char rchMagicTrailer[ 8 ];
+
+  // byte offsets of the columns within a block of nCount datums
+  static size_t OffsetDoubles( size_t nCount ) { return Align( sizeof( BlockHeader ) + nCount * sizeof( boost::uint32_t ) ); };
+  static size_t OffsetWords( size_t nCount, size_t nDoubles ) { return OffsetDoubles( nCount ) + nDoubles * nCount * sizeof( double ); };
+  static size_t BlockBytes( size_t nCount, size_t nDoubles, size_t nWords ) { return Align( OffsetWords( nCount, nDoubles ) + nWords * nCount * sizeof( boost::uint32_t ) ); };
+
+protected:
+private:
+  static const ptime m_dtEpoch;
+  static size_t Align( size_t n ) { return ( n + 7 ) & ~(size_t) 7; };
+};
+
+// a segment mapped read only, with its block index
+class TickStoreSegment {
+public:
+
+  typedef TickStore::IndexEntry IndexEntry;
+  typedef std::vector<IndexEntry> vIndex_t;
+
+  TickStoreSegment( const std::string& sPath, boost::uint64_t nSignature, size_t nDoubles, size_t nWords );  // throws std::runtime_error
+  ~TickStoreSegment( void );
+
+  boost::uint64_t size( void ) const { return m_nDatums; };
+  const vIndex_t& Index( void ) const { return m_vIndex; };
+  boost::uint64_t BlocksEnd( void ) const { return m_nBlocksEnd; };  // file offset past the last complete block
+  bool HasTrailer( void ) const { return m_bTrailer; };
+
+  size_t FindBlock( boost::uint64_t ix ) const;  // block holding datum ix
+  const char* Block( size_t ixBlock ) const { return m_pBase + m_vIndex[ ixBlock ].nOffset; };
+  boost::uint32_t BlockCount( size_t ixBlock ) const;
+
+  boost::uint64_t LowerBound( const ptime& dt ) const;  // first datum at or after dt, size() when none
+  ptime LastDateTime( void ) const;  // not_a_date_time when empty
+
+protected:
+private:
+  std::string m_sPath;
+  boost::scoped_ptr<boost::interprocess::file_mapping> m_pMapping;
+  boost::scoped_ptr<boost::interprocess::mapped_region> m_pRegion;
+  const char* m_pBase;
+  size_t m_nDoubles;
+  size_t m_nWords;
+  vIndex_t m_vIndex;
+  boost::uint64_t m_nDatums;
+  boost::uint64_t m_nBlocksEnd;
+  bool m_bTrailer;
+  void Scan( size_t nFileBytes );
+};
+
+// untyped side of the writer: the file, its index, recovery of a segment left open
+class TickStoreAppender {
+public:
+  TickStoreAppender( const std::string& sPath, boost::uint64_t nSignature, size_t nDoubles, size_t nWords );  // creates directories and file as needed
+  ~TickStoreAppender( void );
+  ptime LastDateTime( void ) const { return m_dtLast; };
+  boost::uint64_t size( void ) const { return m_nDatums; };
+  void Append( const char* pBlock, size_t nBytes, boost::int64_t nFirst, boost::uint32_t nCount, const ptime& dtLast );
+  void Flush( void );  // to the operating system, so survives the process
+  void Close( void );  // writes the index
+protected:
+private:
+  std::string m_sPath;
+  std::FILE* m_pFile;
+  TickStoreSegment::vIndex_t m_vIndex;
+  boost::uint64_t m_nOffset;  // where the next block goes
+  boost::uint64_t m_nDatums;
+  ptime m_dtLast;
+};
+
+// appends datums, in time order, to a segment
+//   datums are held till a block fills, Flush writes out a partial block
+//   reopening a segment carries on after its last datum, datums earlier than that are refused
+template<class DD>
+class TickStoreWriter {
+public:
+
+  typedef TickStoreColumns<DD> columns_t;
+
+  explicit TickStoreWriter( const std::string& sPath );
+  ~TickStoreWriter( void );
+
+  void Append( const DD& datum );  // throws std::runtime_error when out of order
+  template<typename Iter>
+  void Append( Iter begin, Iter end ) { for ( ; end != begin; ++begin ) Append( *begin ); };
+
+  boost::uint64_t size( void ) const { return m_appender.size() + m_vPending.size(); };
+
+  void Flush( void );
+  void Close( void );
+
+protected:
+private:
+  TickStoreAppender m_appender;
+  std::vector<DD> m_vPending;  // the block being filled
+  boost::int64_t m_nPendingFirst;
+  std::vector<char> m_vBuffer;
+  bool m_bClosed;
+  void WriteBlock( void );
+};
+
+template<class DD>
+TickStoreWriter<DD>::TickStoreWriter( const std::string& sPath )
+: m_appender( sPath, DD::Signature(), columns_t::nDoubles, columns_t::nWords ), m_nPendingFirst( 0 ), m_bClosed( false )
+{
+  m_vPending.reserve( TickStore::nBlockDatums );
+}
+
+template<class DD>
+TickStoreWriter<DD>::~TickStoreWriter( void ) {
+  try {
+    Close();
+  }
+  catch ( std::runtime_error& e ) {
+    // nothing to be done from a destructor, the segment is recovered when next opened
+  }
+}
+
+template<class DD>
+void TickStoreWriter<DD>::Append( const DD& datum ) {
+  const ptime& dt( datum.DateTime() );
+  if ( m_bClosed ) throw std::runtime_error( "TickStoreWriter::Append: closed" );
+  if ( dt.is_special() ) throw std::runtime_error( "TickStoreWriter::Append: no timestamp" );
+  const ptime& dtLast( m_vPending.empty() ? m_appender.LastDateTime() : m_vPending.back().DateTime() );
+  if ( !dtLast.is_not_a_date_time() && ( dt < dtLast ) ) throw std::runtime_error( "TickStoreWriter::Append: out of order" );
+  const boost::int64_t n( TickStore::ToMicroseconds( dt ) );
+  if ( !m_vPending.empty() ) {
+    if ( ( TickStore::nBlockDatums == m_vPending.size() ) || ( 0xffffffffll < ( n - m_nPendingFirst ) ) ) WriteBlock();
+  }
+  if ( m_vPending.empty() ) m_nPendingFirst = n;
+  m_vPending.push_back( datum );
+}
+
+template<class DD>
+void TickStoreWriter<DD>::WriteBlock( void ) {
+  const size_t nCount( m_vPending.size() );
+  if ( 0 == nCount ) return;
+  m_vBuffer.assign( TickStore::BlockBytes( nCount, columns_t::nDoubles, columns_t::nWords ), 0 );
+  char* pBlock( &m_vBuffer[ 0 ] );
+  TickStore::BlockHeader header;
+  header.nFirst = m_nPendingFirst;
+  header.nCount = (boost::uint32_t) nCount;
+  header.nBytes = (boost::uint32_t) m_vBuffer.size();
+  std::memcpy( pBlock, &header, sizeof( header ) );
+  boost::uint32_t* pOffset( reinterpret_cast<boost::uint32_t*>( pBlock + sizeof( header ) ) );
+  double* pDouble( reinterpret_cast<double*>( pBlock + TickStore::OffsetDoubles( nCount ) ) );
+  boost::uint32_t* pWord( reinterpret_cast<boost::uint32_t*>( pBlock + TickStore::OffsetWords( nCount, columns_t::nDoubles ) ) );
+  double rDouble[ columns_t::nDoubles + 1 ];
+  boost::uint32_t rWord[ columns_t::nWords + 1 ];
+  for ( size_t ix = 0; ix < nCount; ++ix ) {
+    const DD& datum( m_vPending[ ix ] );
+    pOffset[ ix ] = (boost::uint32_t) ( TickStore::ToMicroseconds( datum.DateTime() ) - m_nPendingFirst );
+    columns_t::Split( datum, rDouble, rWord );
+    for ( size_t col = 0; col < columns_t::nDoubles; ++col ) pDouble[ col * nCount + ix ] = rDouble[ col ];
+    for ( size_t col = 0; col < columns_t::nWords; ++col ) pWord[ col * nCount + ix ] = rWord[ col ];
+  }
+  m_appender.Append( pBlock, m_vBuffer.size(), m_nPendingFirst, (boost::uint32_t) nCount, m_vPending.back().DateTime() );
+  m_vPending.clear();
+}
+
+template<class DD>
+void TickStoreWriter<DD>::Flush( void ) {
+  WriteBlock();
+  m_appender.Flush();
+}
+
+template<class DD>
+void TickStoreWriter<DD>::Close( void ) {
+  if ( !m_bClosed ) {
+    m_bClosed = true;
+    WriteBlock();
+    m_appender.Close();
+  }
+}
+
+} // namespace tf
+} // namespace ou
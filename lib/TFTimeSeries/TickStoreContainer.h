@@ -0,0 +1,168 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// reads a tick store segment (see TickStore.h) with the same shape as HDF5TimeSeriesContainer / HDF5TimeSeriesIterator:
+//   begin(), end(), iterator arithmetic, *iter, Read( begin, end, &series ), size(), ChunkSize()
+// so code templated on the container reads either
+// the container keeps the block last touched, sequential access decodes each datum once,
+//   random access costs a search of the block index, LowerBound searches the index then the block's timestamps
+
+#include <iterator>
+#include <cassert>
+#include <algorithm>
+
+#include "TimeSeries.h"
+#include "TickStore.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+template<class DD> class TickStoreContainer;
+
+template<class DD> class TickStoreIterator:
+  public std::iterator<std::random_access_iterator_tag, DD, boost::uint64_t> {
+    friend class TickStoreContainer<DD>;
+public:
+
+  typedef std::iterator<std::random_access_iterator_tag, DD, boost::uint64_t> base_iterator;
+
+  TickStoreIterator( void ): m_pContainer( 0 ), m_ix( 0 ) {};
+  TickStoreIterator( TickStoreContainer<DD>* pContainer, boost::uint64_t ix ): m_pContainer( pContainer ), m_ix( ix ) {
+    assert( ix <= pContainer->size() );
+  };
+  TickStoreIterator& operator++() { ++m_ix; return *this; };
+  TickStoreIterator operator++( int ) { TickStoreIterator result( *this ); ++m_ix; return result; };
+  TickStoreIterator& operator+=( const boost::uint64_t inc ) { m_ix += inc; assert( m_ix <= m_pContainer->size() ); return *this; };
+  TickStoreIterator& operator-=( const boost::uint64_t inc ) { assert( inc <= m_ix ); m_ix -= inc; return *this; };
+  TickStoreIterator operator-( const boost::uint64_t val ) const { TickStoreIterator result( *this ); result -= val; return result; };
+  boost::uint64_t operator-( const TickStoreIterator& other ) const { return m_ix - other.m_ix; };
+  bool operator<( const TickStoreIterator& other ) const { assert( m_pContainer == other.m_pContainer ); return m_ix < other.m_ix; };
+  bool operator==( const TickStoreIterator& other ) const { assert( m_pContainer == other.m_pContainer ); return m_ix == other.m_ix; };
+  bool operator!=( const TickStoreIterator& other ) const { return !( *this == other ); };
+  typename base_iterator::reference operator*() {
+    assert( m_ix < m_pContainer->size() );
+    m_pContainer->Read( m_ix, &m_DD );
+    return m_DD;
+  };
+protected:
+  TickStoreContainer<DD>* m_pContainer;
+  boost::uint64_t m_ix;
+  DD m_DD;  // the datum last retrieved
+private:
+};
+
+template<class DD> class TickStoreContainer {
+public:
+
+  typedef TickStoreIterator<DD> iterator;
+  typedef boost::uint64_t size_type;
+  typedef TickStoreColumns<DD> columns_t;
+
+  explicit TickStoreContainer( const std::string& sPath );  // throws std::runtime_error when missing or not of type DD
+  ~TickStoreContainer( void ) {};
+
+  size_type size( void ) const { return m_segment.size(); };
+  size_type ChunkSize( void ) const { return TickStore::nBlockDatums; };  // datums per block, at most
+
+  iterator begin( void ) { return iterator( this, 0 ); };
+  const iterator& end( void ) { return m_end; };
+
+  size_type LowerBound( const ptime& dt ) const { return m_segment.LowerBound( dt ); };
+  iterator lower_bound( const ptime& dt ) { return iterator( this, LowerBound( dt ) ); };
+
+  void Read( size_type ix, DD* pDatum );
+  void Read( iterator& begin, iterator& end, TimeSeries<DD>* pSeries );  // pSeries already sized to end - begin, as for hdf5
+
+protected:
+private:
+
+  TickStoreSegment m_segment;
+  iterator m_end;
+
+  // the block last touched
+  size_t m_ixBlock;
+  size_type m_ixBlockFirst;
+  size_type m_nBlockCount;
+  boost::int64_t m_nBlockTime;
+  const boost::uint32_t* m_pOffset;
+  const double* m_pDouble;
+  const boost::uint32_t* m_pWord;
+
+  void Select( size_type ix ) {
+    if ( ( ix - m_ixBlockFirst ) >= m_nBlockCount ) {  // unsigned, so also when before the block
+      SelectBlock( m_segment.FindBlock( ix ) );
+    }
+  };
+  void SelectBlock( size_t ixBlock );
+  DD Decode( size_t ixInBlock ) const;
+
+};
+
+template<class DD>
+TickStoreContainer<DD>::TickStoreContainer( const std::string& sPath )
+: m_segment( sPath, DD::Signature(), columns_t::nDoubles, columns_t::nWords ),
+  m_ixBlock( 0 ), m_ixBlockFirst( 0 ), m_nBlockCount( 0 ), m_nBlockTime( 0 ), m_pOffset( 0 ), m_pDouble( 0 ), m_pWord( 0 )
+{
+  m_end = iterator( this, m_segment.size() );
+}
+
+template<class DD>
+void TickStoreContainer<DD>::SelectBlock( size_t ixBlock ) {
+  const TickStore::IndexEntry& entry( m_segment.Index()[ ixBlock ] );
+  const char* pBlock( m_segment.Block( ixBlock ) );
+  m_ixBlock = ixBlock;
+  m_ixBlockFirst = entry.ixFirst;
+  m_nBlockCount = m_segment.BlockCount( ixBlock );
+  m_nBlockTime = entry.nFirst;
+  m_pOffset = reinterpret_cast<const boost::uint32_t*>( pBlock + sizeof( TickStore::BlockHeader ) );
+  m_pDouble = reinterpret_cast<const double*>( pBlock + TickStore::OffsetDoubles( (size_t) m_nBlockCount ) );
+  m_pWord = reinterpret_cast<const boost::uint32_t*>( pBlock + TickStore::OffsetWords( (size_t) m_nBlockCount, columns_t::nDoubles ) );
+}
+
+template<class DD>
+DD TickStoreContainer<DD>::Decode( size_t ixInBlock ) const {
+  double rDouble[ columns_t::nDoubles + 1 ];
+  boost::uint32_t rWord[ columns_t::nWords + 1 ];
+  const size_t nCount( (size_t) m_nBlockCount );
+  for ( size_t col = 0; col < columns_t::nDoubles; ++col ) rDouble[ col ] = m_pDouble[ col * nCount + ixInBlock ];
+  for ( size_t col = 0; col < columns_t::nWords; ++col ) rWord[ col ] = m_pWord[ col * nCount + ixInBlock ];
+  return columns_t::Join( TickStore::FromMicroseconds( m_nBlockTime + m_pOffset[ ixInBlock ] ), rDouble, rWord );
+}
+
+template<class DD>
+void TickStoreContainer<DD>::Read( size_type ix, DD* pDatum ) {
+  Select( ix );
+  *pDatum = Decode( (size_t) ( ix - m_ixBlockFirst ) );
+}
+
+template<class DD>
+void TickStoreContainer<DD>::Read( iterator& begin, iterator& end, TimeSeries<DD>* pSeries ) {
+  size_type ix( begin.m_ix );
+  const size_type ixEnd( end.m_ix );
+  if ( ix >= ixEnd ) return;
+  assert( pSeries->Size() >= ixEnd - ix );
+  DD* pDatum( const_cast<DD*>( pSeries->First() ) );
+  while ( ix < ixEnd ) {
+    Select( ix );
+    const size_type ixBlockEnd( std::min( ixEnd, m_ixBlockFirst + m_nBlockCount ) );
+    for ( size_t ixInBlock = (size_t) ( ix - m_ixBlockFirst ); ix < ixBlockEnd; ++ix, ++ixInBlock ) {
+      *pDatum++ = Decode( ixInBlock );
+    }
+  }
+}
+
+} // namespace tf
+} // namespace ou
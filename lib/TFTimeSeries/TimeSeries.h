@@ -69,6 +69,7 @@ public:
   void Insert( const ptime& time, const T& datum );  // time overrides datum.time?
   void Insert( const T& datum );
   void Resize( size_type Size ) { m_vSeries.resize( Size );  }; 
+  void Swap( TimeSeries<T>& series ) { m_vSeries.swap( series.m_vSeries ); };  // datums only, call First before Next on either
 
   void Sort( void ); // use when loaded from external data
   void Flip( void ) { reverse( m_vSeries.begin(), m_vSeries.end() ); };
@@ -105,6 +106,10 @@ public:
 
   void Reserve( size_type n ) { m_vSeries.reserve( n ); };
 
+  // removes, in place, the datums whose flag has a bit of mask set, the others keep their order, see TickCleaner
+  template<typename F>
+  size_type Remove( const std::vector<F>& vFlag, F mask );
+
   bool& AppendEnabled( void ) { return m_bAppendToVector; };  // affects Append(...) only
 
   template<typename Functor>
@@ -190,6 +195,22 @@ void TimeSeries<T>::Insert( const T& datum ) {
   }
 }
 
+template<typename T> template<typename F>
+typename TimeSeries<T>::size_type TimeSeries<T>::Remove( const std::vector<F>& vFlag, F mask ) {
+  assert( vFlag.size() == m_vSeries.size() );
+  size_type ixTo( 0 );
+  for ( size_type ixFrom = 0; ixFrom < m_vSeries.size(); ++ixFrom ) {
+    if ( 0 == ( vFlag[ ixFrom ] & mask ) ) {
+      if ( ixTo != ixFrom ) m_vSeries[ ixTo ] = m_vSeries[ ixFrom ];
+      ++ixTo;
+    }
+  }
+  const size_type nRemoved( m_vSeries.size() - ixTo );
+  m_vSeries.resize( ixTo );
+  m_vIterator = m_vSeries.end();
+  return nRemoved;
+}
+
 template<typename T> 
 void TimeSeries<T>::Clear( void ) {
   m_vSeries.clear();
@@ -39,7 +39,11 @@ OBJECTFILES= \
 	${OBJECTDIR}/DatedDatum.o \
 	${OBJECTDIR}/ExchangeHolidays.o \
 	${OBJECTDIR}/MergeDatedDatums.o \
+	${OBJECTDIR}/MultiBarFactory.o \
+	${OBJECTDIR}/OrderBook.o \
 	${OBJECTDIR}/TSMicrostructure.o \
+	${OBJECTDIR}/TickCleaner.o \
+	${OBJECTDIR}/TickStore.o \
 	${OBJECTDIR}/TimeSeries.o \
 	${OBJECTDIR}/stdafx.o
 
@@ -90,11 +94,31 @@ ${OBJECTDIR}/MergeDatedDatums.o: MergeDatedDatums.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/MergeDatedDatums.o MergeDatedDatums.cpp
 
+${OBJECTDIR}/MultiBarFactory.o: MultiBarFactory.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/MultiBarFactory.o MultiBarFactory.cpp
+
+${OBJECTDIR}/OrderBook.o: OrderBook.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/OrderBook.o OrderBook.cpp
+
 ${OBJECTDIR}/TSMicrostructure.o: TSMicrostructure.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TSMicrostructure.o TSMicrostructure.cpp
 
+${OBJECTDIR}/TickCleaner.o: TickCleaner.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TickCleaner.o TickCleaner.cpp
+
+${OBJECTDIR}/TickStore.o: TickStore.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -D_DEBUG -I../ -std=c++11 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/TickStore.o TickStore.cpp
+
 ${OBJECTDIR}/TimeSeries.o: TimeSeries.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -38,7 +38,7 @@ typedef std::string idCurrency_t;  // three character designation
 //typedef boost::uint16_t idProvider_t;  // identifies instance of a provider
 typedef idAccount_t idProvider_t;
 enum eidProvider_t {
-  EProviderUnknown=0, EProviderSimulator=100, EProviderIQF, EProviderIB, EProviderGNDT, EProviderCalc,
+  EProviderUnknown=0, EProviderSimulator=100, EProviderIQF, EProviderIB, EProviderGNDT, EProviderCalc, EProviderPaper,
   EProviderUserBase=900/*, _EProviderCount*/ };
 // PortfolioManager
 typedef std::string idPortfolio_t;
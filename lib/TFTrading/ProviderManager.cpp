@@ -20,6 +20,7 @@
 #include <TFIQFeed/IQFeedProvider.h>
 #include <TFInteractiveBrokers/IBTWS.h>
 #include <TFSimulation/SimulationProvider.h>
+#include <TFSimulation/PaperTradingProvider.h>
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
@@ -36,6 +37,9 @@ ProviderManager::pProvider_t ProviderManager::Construct( const idProvider_t& key
   case keytypes::EProviderSimulator:
     pProvider = Construct<SimulationProvider>( key );
     break;
+  case keytypes::EProviderPaper:
+    pProvider = Construct<PaperTradingProvider>( key );
+    break;
   case keytypes::EProviderGNDT:
     throw std::runtime_error( "GNDT not implemented" );
     break;
@@ -31,7 +31,7 @@ namespace tf { // TradeFrame
 Watch::Watch( pInstrument_t pInstrument, pProvider_t pDataProvider ) :
   m_pInstrument( pInstrument ), 
   m_pDataProvider( pDataProvider ), 
-  m_cntWatching( 0 )
+  m_cntWatching( 0 ), m_bRetainSeries( true )
 {
   Initialize();
 }
@@ -40,7 +40,7 @@ Watch::Watch( const Watch& rhs ) :
   m_pInstrument( rhs.m_pInstrument ),
   m_pDataProvider( rhs.m_pDataProvider ),
   m_quote( rhs.m_quote ), m_trade( rhs.m_trade ), 
-  m_cntWatching( 0 )
+  m_cntWatching( 0 ), m_bRetainSeries( rhs.m_bRetainSeries )
 {
   assert( 0 == rhs.m_cntWatching );
   Initialize();
@@ -58,6 +58,7 @@ Watch& Watch::operator=( const Watch& rhs ) {
   m_pInstrument = rhs.m_pInstrument;
   m_pDataProvider = rhs.m_pDataProvider;
   m_cntWatching = 0;
+  m_bRetainSeries = rhs.m_bRetainSeries;
   Initialize();
   return *this;
 }
@@ -122,14 +123,14 @@ void Watch::EmitValues( void ) const {
 
 void Watch::HandleQuote( const Quote& quote ) {
   m_quote = quote;
-  m_quotes.Append( quote );
+  if ( m_bRetainSeries ) m_quotes.Append( quote );
   //if ( 0 != m_OnQuote ) m_OnQuote( quote );
   OnQuote( quote );
 }
 
 void Watch::HandleTrade( const Trade& trade ) {
   m_trade = trade;
-  m_trades.Append( trade );
+  if ( m_bRetainSeries ) m_trades.Append( trade );
   //if ( 0 != m_OnTrade ) m_OnTrade( trade );
   OnTrade( trade );
 }
@@ -158,13 +159,14 @@ void Watch::SaveSeries( const std::string& sPrefix ) {
 
   std::string sPathName;
 
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );  // a WatchRecorder may be writing
   ou::tf::HDF5DataManager dm( ou::tf::HDF5DataManager::RDWR );
 
   try {
 
     if ( 0 != m_quotes.Size() ) {
       sPathName = sPrefix + "/quotes/" + m_pInstrument->GetInstrumentName();
-      HDF5WriteTimeSeries<ou::tf::Quotes> wtsQuotes( dm, true, true, 5, 256 );
+      HDF5WriteTimeSeries<ou::tf::Quotes> wtsQuotes( dm, ou::tf::HDF5Filter::LZ4 );
       wtsQuotes.Write( sPathName, &m_quotes );
       HDF5Attributes attrQuotes( dm, sPathName );
       attrQuotes.SetSignature( ou::tf::Quote::Signature() );
@@ -175,7 +177,7 @@ void Watch::SaveSeries( const std::string& sPrefix ) {
 
     if ( 0 != m_trades.Size() ) {
       sPathName = sPrefix + "/trades/" + m_pInstrument->GetInstrumentName();
-      HDF5WriteTimeSeries<ou::tf::Trades> wtsTrades( dm, true, true, 5, 256 );
+      HDF5WriteTimeSeries<ou::tf::Trades> wtsTrades( dm, ou::tf::HDF5Filter::LZ4 );
       wtsTrades.Write( sPathName, &m_trades );
       HDF5Attributes attrTrades( dm, sPathName );
       attrTrades.SetSignature( ou::tf::Trade::Signature() );
@@ -78,6 +78,11 @@ public:
   const Quotes& GetQuotes( void ) const { return m_quotes; };
   const Trades& GetTrades( void ) const { return m_trades; };
 
+  // true (default): quotes and trades are kept in GetQuotes/GetTrades for the session, for SaveSeries
+  // false: only the last of each is kept, for when a WatchRecorder has them
+  void SetRetainSeries( bool bRetainSeries ) { m_bRetainSeries = bRetainSeries; };
+  bool GetRetainSeries( void ) const { return m_bRetainSeries; };
+
   ou::Delegate<const Quote&> OnQuote;
   ou::Delegate<const Trade&> OnTrade;
 
@@ -107,6 +112,8 @@ protected:
 
   unsigned int m_cntWatching;
 
+  bool m_bRetainSeries;
+
 private:
 
   Fundamentals_t m_fundamentals;
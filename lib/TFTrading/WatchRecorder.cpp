@@ -0,0 +1,214 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#include "stdafx.h"
+
+#include <iostream>
+
+#include <boost/bind.hpp>
+
+#include <TFHDF5TimeSeries/HDF5DataManager.h>
+#include <TFHDF5TimeSeries/HDF5WriteTimeSeries.h>
+#include <TFHDF5TimeSeries/HDF5Attribute.h>
+#include <TFHDF5TimeSeries/HDF5Summary.h>
+#include <TFHDF5TimeSeries/HDF5Catalog.h>
+#include <TFHDF5TimeSeries/HDF5PathIndex.h>
+
+#include "WatchRecorder.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+template<class TS>
+void WatchRecorder::Stream<TS>::Push( const DD& datum, boost::atomic<size_t>& cntOverflow ) {
+  if ( !m_bOverflow.load( boost::memory_order_acquire ) ) {
+    if ( m_queue.push( datum ) ) return;
+  }
+  // queue full, or already spilling: stay in the overflow so the order holds, till the consumer empties both
+  boost::mutex::scoped_lock lock( m_mutexOverflow );
+  m_bOverflow.store( true, boost::memory_order_release );
+  m_vOverflow.push_back( datum );
+  cntOverflow.fetch_add( 1, boost::memory_order_relaxed );
+}
+
+template<class TS>
+size_t WatchRecorder::Stream<TS>::Drain( void ) {
+  size_t n( 0 );
+  DD datum;
+  while ( m_queue.pop( datum ) ) {
+    m_series.Append( datum );
+    ++n;
+  }
+  if ( m_bOverflow.load( boost::memory_order_acquire ) ) {
+    boost::mutex::scoped_lock lock( m_mutexOverflow );
+    while ( m_queue.pop( datum ) ) {  // pushed before the spill began, the producer is held off by the lock
+      m_series.Append( datum );
+      ++n;
+    }
+    for ( typename std::vector<DD>::const_iterator iter = m_vOverflow.begin(); m_vOverflow.end() != iter; ++iter ) {
+      m_series.Append( *iter );
+    }
+    n += m_vOverflow.size();
+    m_vOverflow.clear();
+    m_bOverflow.store( false, boost::memory_order_release );
+  }
+  return n;
+}
+
+WatchRecorder::WatchRecorder( const std::string& sPrefix, time_duration tdBatch, size_t nBatchRecords, size_t nChunkSize )
+: m_sPrefix( sPrefix ), m_tdBatch( tdBatch ), m_nBatchRecords( nBatchRecords ), m_nChunkSize( nChunkSize ), m_nWaiting( 0 ),
+  m_bRunning( false ), m_cntRecords( 0 ), m_cntBatches( 0 ), m_cntOverflow( 0 ), m_cntErrors( 0 )
+{
+  assert( 0 < nChunkSize );
+}
+
+WatchRecorder::~WatchRecorder( void ) {
+  Stop();
+}
+
+void WatchRecorder::Add( pWatch_t pWatch ) {
+  pEntry_t pEntry( new Entry( *this, pWatch ) );
+  pWatch->OnQuote.Add( MakeDelegate( pEntry.get(), &Entry::HandleQuote ) );
+  pWatch->OnTrade.Add( MakeDelegate( pEntry.get(), &Entry::HandleTrade ) );
+  boost::mutex::scoped_lock lock( m_mutexAdded );
+  pEntry->m_bSubscribed = true;
+  m_vAdded.push_back( pEntry );
+}
+
+void WatchRecorder::Start( void ) {
+  if ( 0 == m_pThread.get() ) {
+    m_bRunning.store( true, boost::memory_order_release );
+    m_pThread.reset( new boost::thread( boost::bind( &WatchRecorder::Record, this ) ) );
+  }
+}
+
+void WatchRecorder::Stop( void ) {
+  {
+    boost::mutex::scoped_lock lock( m_mutexAdded );
+    for ( vEntry_t::iterator iter = m_vAdded.begin(); m_vAdded.end() != iter; ++iter ) {
+      Entry& entry( **iter );
+      if ( entry.m_bSubscribed ) {
+        entry.m_pWatch->OnQuote.Remove( MakeDelegate( &entry, &Entry::HandleQuote ) );
+        entry.m_pWatch->OnTrade.Remove( MakeDelegate( &entry, &Entry::HandleTrade ) );
+        entry.m_bSubscribed = false;
+      }
+    }
+  }
+  if ( 0 != m_pThread.get() ) {
+    m_bRunning.store( false, boost::memory_order_release );  // the thread makes a last pass for what remains
+    m_pThread->join();
+    m_pThread.reset();
+  }
+}
+
+void WatchRecorder::Record( void ) {
+  {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    m_pdm.reset( new HDF5DataManager( HDF5DataManager::RDWR ) );
+  }
+  ptime dtBatch( boost::posix_time::microsec_clock::universal_time() );
+  bool bRunning( true );
+  while ( bRunning ) {
+    bRunning = m_bRunning.load( boost::memory_order_acquire );
+    if ( bRunning ) {
+      boost::this_thread::sleep( boost::posix_time::milliseconds( nDrainMilliseconds ) );
+    }
+    const size_t nWaiting( Drain() );
+    const ptime dtNow( boost::posix_time::microsec_clock::universal_time() );
+    if ( !bRunning || ( m_nBatchRecords <= nWaiting ) || ( m_tdBatch <= ( dtNow - dtBatch ) ) ) {
+      WriteBatch();
+      dtBatch = dtNow;
+    }
+  }
+  HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+  for ( vEntry_t::iterator iter = m_vEntry.begin(); m_vEntry.end() != iter; ++iter ) {
+    (*iter)->m_quotes.m_pRepository.reset();  // before the data manager
+    (*iter)->m_trades.m_pRepository.reset();
+  }
+  m_pdm.reset();
+}
+
+size_t WatchRecorder::Drain( void ) {
+  {
+    boost::mutex::scoped_lock lock( m_mutexAdded );
+    if ( m_vEntry.size() < m_vAdded.size() ) {
+      m_vEntry.insert( m_vEntry.end(), m_vAdded.begin() + m_vEntry.size(), m_vAdded.end() );
+    }
+  }
+  for ( vEntry_t::iterator iter = m_vEntry.begin(); m_vEntry.end() != iter; ++iter ) {
+    m_nWaiting += (*iter)->m_quotes.Drain();
+    m_nWaiting += (*iter)->m_trades.Drain();
+  }
+  return m_nWaiting;
+}
+
+void WatchRecorder::WriteBatch( void ) {
+  if ( 0 != m_nWaiting ) {
+    HDF5DataManager::lock_t lock( HDF5DataManager::Mutex() );
+    size_t nWritten( 0 );
+    for ( vEntry_t::iterator iter = m_vEntry.begin(); m_vEntry.end() != iter; ++iter ) {
+      nWritten += Write( **iter, (*iter)->m_quotes, "quotes", Quote::Signature() );
+      nWritten += Write( **iter, (*iter)->m_trades, "trades", Trade::Signature() );
+    }
+    m_pdm->Flush();  // the batch is on disk before the next is started
+    m_nWaiting = 0;
+    m_cntRecords.fetch_add( nWritten, boost::memory_order_release );
+    m_cntBatches.fetch_add( 1, boost::memory_order_release );
+  }
+}
+
+template<class TS>
+size_t WatchRecorder::Write( Entry& entry, Stream<TS>& stream, const std::string& sKind, boost::uint64_t nSignature ) {
+  typedef typename TS::datum_t DD;
+  const size_t n( stream.m_series.Size() );
+  if ( 0 == n ) return 0;
+  Watch::pInstrument_t pInstrument( entry.m_pWatch->GetInstrument() );
+  const std::string sPathName( m_sPrefix + "/" + sKind + "/" + pInstrument->GetInstrumentName() );
+  bool bWritten( false );
+  try {
+    if ( 0 == stream.m_pRepository.get() ) {
+      // first batch creates the dataset, or appends to one left by an earlier run, and sets the attributes as Watch::SaveSeries does
+      HDF5WriteTimeSeries<TS> wts( *m_pdm, false, true, 0, m_nChunkSize );  // not deflated, see WatchRecorder.h
+      wts.Write( sPathName, &stream.m_series );
+      HDF5Attributes attr( *m_pdm, sPathName );
+      attr.SetSignature( nSignature );
+      attr.SetMultiplier( pInstrument->GetMultiplier() );
+      attr.SetSignificantDigits( pInstrument->GetSignificantDigits() );
+      attr.SetProviderType( entry.m_pWatch->GetProvider()->ID() );
+      if ( pInstrument->IsOption() ) {
+        HDF5Attributes::structOption option(
+          pInstrument->GetStrike(), pInstrument->GetExpiryYear(), pInstrument->GetExpiryMonth(), pInstrument->GetExpiryDay(), pInstrument->GetOptionSide() );
+        HDF5Attributes attrOption( *m_pdm, sPathName, option );
+      }
+      stream.m_pRepository.reset( new HDF5TimeSeriesContainer<DD>( *m_pdm, sPathName ) );
+    }
+    else {
+      // later batches go on the end, no search for the insertion point, the summary is added to as HDF5WriteTimeSeries does
+      stream.m_pRepository->HDF5TimeSeriesAccessor<DD>::Write( stream.m_pRepository->size(), n, stream.m_series.First() );
+      SummariseWrite<DD>( *m_pdm, *stream.m_pRepository, sPathName, stream.m_series.First(), stream.m_series.Last() + 1 );
+      HDF5Catalog::Touch( *m_pdm );
+      HDF5PathIndex::Journal( *m_pdm, sPathName, nSignature, stream.m_pRepository->size(), ptime(), stream.m_series.Last()->DateTime() );  // an append, first is kept
+    }
+    bWritten = true;
+  }
+  catch (...) {
+    m_cntErrors.fetch_add( 1, boost::memory_order_release );
+    std::cout << "WatchRecorder::Write error: " << sPathName << std::endl;
+  }
+  stream.m_series.Clear();
+  return bWritten ? n : 0;
+}
+
+} // namespace tf
+} // namespace ou
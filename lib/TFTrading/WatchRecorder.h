@@ -0,0 +1,137 @@
+/************************************************************************
+ * Copyright(c) 2016, One Unified. All rights reserved.                 *
+ * email: info@oneunified.net                                           *
+ *                                                                      *
+ * This file is provided as is WITHOUT ANY WARRANTY                     *
+ *  without even the implied warranty of                                *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.                *
+ *                                                                      *
+ * This software may not be used nor distributed without proper license *
+ * agreement.                                                           *
+ *                                                                      *
+ * See the file LICENSE.txt for redistribution information.             *
+ ************************************************************************/
+
+#pragma once
+
+// records the quotes and trades of watches to hdf5 through the session, rather than Watch::SaveSeries at the end of it
+//   each watch's handlers push into a lock free single producer / single consumer queue, nothing else on the feed's thread
+//   a background thread drains the queues, and writes batches to extendible chunked datasets
+//     under sPrefix + "/quotes/" and "/trades/", with the attributes Watch::SaveSeries (and Option::SaveSeries) set
+//   a batch is written, with the summary attributes brought up to date (see HDF5Summary.h), and the file flushed,
+//     when tdBatch has passed since the last one, or nBatchRecords are waiting
+//   a kill: between batches, what arrived since the last flush is lost; during a batch's write, hdf5 may have rewritten
+//     some of its metadata in place and not the rest, so the file can be left unreadable, this session's recording and the
+//     series already in the file with it, so keep a copy of the file from before the session where that matters;
+//     the file isn't opened SWMR (H5F_ACC_SWMR_WRITE, libver latest), which would keep it readable,
+//     as SWMR writing can't create the datasets of the symbols added while recording
+//   datasets are chunked but not deflated: a deflated chunk moves in the file each time a batch adds to it, and hdf5 reuses
+//     the space it left, which can overwrite flushed data before the next flush; undeflated chunks are rewritten in place
+//   a queue that fills (a burst longer than the drain interval) spills, in order, into a locked overflow till the next drain
+// pair with Watch::SetRetainSeries( false ) when the series aren't otherwise needed in memory
+// the recorder's calls into hdf5 hold HDF5DataManager::Mutex, other hdf5 use in the process while recording takes it as well
+// re-recording a prefix appends to the datasets already there, so a recorder restarted after a kill between batches carries on
+
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+
+#include <TFTimeSeries/TimeSeries.h>
+
+#include <TFHDF5TimeSeries/HDF5TimeSeriesContainer.h>
+
+#include "Watch.h"
+
+namespace ou { // One Unified
+namespace tf { // TradeFrame
+
+class WatchRecorder {
+public:
+
+  typedef Watch::pWatch_t pWatch_t;
+
+  WatchRecorder( const std::string& sPrefix, time_duration tdBatch = seconds( 5 ), size_t nBatchRecords = 100000, size_t nChunkSize = 256 );
+  ~WatchRecorder( void );  // Stops
+
+  void Add( pWatch_t pWatch );  // any thread, before or after Start, the watch is to be started separately
+  void Start( void );
+  void Stop( void );  // unsubscribes, writes what remains, flushes and closes the file
+
+  // readable while recording
+  boost::uint64_t GetRecordCount( void ) const { return m_cntRecords.load( boost::memory_order_acquire ); };  // records in flushed batches
+  size_t GetBatchCount( void ) const { return m_cntBatches.load( boost::memory_order_acquire ); };
+  size_t GetOverflowCount( void ) const { return m_cntOverflow.load( boost::memory_order_acquire ); };  // records that went by the overflow
+  size_t GetErrorCount( void ) const { return m_cntErrors.load( boost::memory_order_acquire ); };  // series that failed to write, their batch is dropped
+
+protected:
+private:
+
+  static const unsigned int nQueueCapacity = 256;  // per series, a queue is allocated per series
+  static const unsigned int nDrainMilliseconds = 20;
+
+  template<class TS>  // TS: Quotes, Trades
+  class Stream {
+  public:
+    typedef typename TS::datum_t DD;
+    Stream( void ): m_bOverflow( false ) {};
+    void Push( const DD& datum, boost::atomic<size_t>& cntOverflow );  // producer
+    size_t Drain( void );  // consumer, into m_series, returns the count moved
+    TS m_series;  // drained, not yet written
+    boost::scoped_ptr<HDF5TimeSeriesContainer<DD> > m_pRepository;  // opened by the first batch
+  private:
+    typedef boost::lockfree::spsc_queue<DD, boost::lockfree::capacity<nQueueCapacity> > queue_t;
+    queue_t m_queue;
+    boost::atomic<bool> m_bOverflow;  // set: the producer goes to m_vOverflow till the consumer has caught up
+    boost::mutex m_mutexOverflow;
+    std::vector<DD> m_vOverflow;
+  };
+
+  struct Entry {
+    Entry( WatchRecorder& recorder, pWatch_t pWatch ): m_recorder( recorder ), m_pWatch( pWatch ), m_bSubscribed( false ) {};
+    WatchRecorder& m_recorder;
+    pWatch_t m_pWatch;
+    bool m_bSubscribed;
+    Stream<Quotes> m_quotes;
+    Stream<Trades> m_trades;
+    void HandleQuote( const Quote& quote ) { m_quotes.Push( quote, m_recorder.m_cntOverflow ); };
+    void HandleTrade( const Trade& trade ) { m_trades.Push( trade, m_recorder.m_cntOverflow ); };
+  };
+
+  typedef boost::shared_ptr<Entry> pEntry_t;
+  typedef std::vector<pEntry_t> vEntry_t;
+
+  std::string m_sPrefix;
+  time_duration m_tdBatch;
+  size_t m_nBatchRecords;
+  size_t m_nChunkSize;
+
+  boost::mutex m_mutexAdded;
+  vEntry_t m_vAdded;  // all subscribed, guarded by m_mutexAdded
+  vEntry_t m_vEntry;  // the thread's own copy, taken up from m_vAdded each drain
+  size_t m_nWaiting;  // drained, not yet written
+
+  boost::atomic<bool> m_bRunning;
+  boost::scoped_ptr<boost::thread> m_pThread;
+  boost::scoped_ptr<HDF5DataManager> m_pdm;
+
+  boost::atomic<boost::uint64_t> m_cntRecords;
+  boost::atomic<size_t> m_cntBatches;
+  boost::atomic<size_t> m_cntOverflow;
+  boost::atomic<size_t> m_cntErrors;
+
+  void Record( void );  // the thread
+  size_t Drain( void );  // returns records waiting
+  void WriteBatch( void );
+  template<class TS>
+  size_t Write( Entry& entry, Stream<TS>& stream, const std::string& sKind, boost::uint64_t nSignature );  // returns records written
+
+};
+
+} // namespace tf
+} // namespace ou
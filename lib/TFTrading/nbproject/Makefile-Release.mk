@@ -67,6 +67,7 @@ OBJECTFILES= \
 	${OBJECTDIR}/Symbol.o \
 	${OBJECTDIR}/TradingEnumerations.o \
 	${OBJECTDIR}/Watch.o \
+	${OBJECTDIR}/WatchRecorder.o \
 	${OBJECTDIR}/stdafx.o
 
 
@@ -256,6 +257,11 @@ ${OBJECTDIR}/Watch.o: Watch.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/Watch.o Watch.cpp
 
+${OBJECTDIR}/WatchRecorder.o: WatchRecorder.cpp 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/WatchRecorder.o WatchRecorder.cpp
+
 ${OBJECTDIR}/stdafx.o: stdafx.cpp 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -24,6 +24,7 @@
 
 #include <TFHDF5TimeSeries/HDF5DataManager.h>
 #include <TFHDF5TimeSeries/HDF5TimeSeriesContainer.h>
+#include <TFHDF5TimeSeries/HDF5ReadTimeSeries.h>
 
 namespace ou { // One Unified
 namespace tf { // TradeFrame
@@ -39,14 +40,9 @@ public:
 
     pChartDataView->SetNames( sName, sPath );
 
-    ou::tf::HDF5TimeSeriesContainer<typename TS::datum_t> tsRepository( *pdm, sPath );
-    typename ou::tf::HDF5TimeSeriesContainer<typename TS::datum_t>::iterator begin, end;
-    begin = tsRepository.begin();
-    end = tsRepository.end();
-    hsize_t cnt = end - begin;
     TS series;
-    series.Resize( cnt );
-    tsRepository.Read( begin, end, &series );
+    ou::tf::HDF5ReadTimeSeries<TS> rts( *pdm );
+    rts.Read( sPath, series );
 
     AddChartEntries( pChartDataView, series );
 
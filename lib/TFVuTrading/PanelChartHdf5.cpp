@@ -24,6 +24,7 @@
 #include <wx/splitter.h>
 
 #include <TFHDF5TimeSeries/HDF5IterateGroups.h>
+#include <TFHDF5TimeSeries/HDF5PathIndex.h>
 
 #include "PanelChartHdf5.h"
 
@@ -117,11 +118,41 @@ void PanelChartHdf5::CreateControls() {
   m_sCurrentPath = "/";  
 
   namespace args = boost::phoenix::placeholders;
-  ou::tf::hdf5::IterateGroups ig( 
-    "/", 
-    boost::phoenix::bind( &PanelChartHdf5::HandleLoadTreeHdf5Group, this, args::arg1, args::arg2 ), 
-    boost::phoenix::bind( &PanelChartHdf5::HandleLoadTreeHdf5Object, this, args::arg1, args::arg2 ) 
-    );
+  ou::tf::HDF5PathIndex index;
+  if ( index.Load() ) {  // one mapped file rather than a walk of the groups, see HDF5PathIndex.h
+    ou::tf::HDF5PathIndex::vEntry_t vEntry;
+    index.Prefix( "/", vEntry );
+    std::string sGroup;
+    CustomItemData::enumDatumType eGroupDatumType( CustomItemData::NoDatum );
+    for ( ou::tf::HDF5PathIndex::vEntry_t::const_iterator iter = vEntry.begin(); vEntry.end() != iter; ++iter ) {
+      const std::string::size_type ix( iter->sPath.rfind( '/' ) + 1 );
+      if ( ( sGroup.size() != ix ) || ( 0 != iter->sPath.compare( 0, ix, sGroup ) ) ) {  // entries are in path order, so a group's objects are together
+        sGroup = iter->sPath.substr( 0, ix );
+        m_curTreeItem = m_pHdf5Root->GetRootItem();
+        m_pdm->IteratePathParts( sGroup, boost::phoenix::bind( &PanelChartHdf5::HandleBuildTreePathParts, this, args::arg1 ) );
+        eGroupDatumType = CustomItemData::NoDatum;  // by group name as HandleLoadTreeHdf5Group does, for datasets written without a signature
+        if ( std::string::npos != sGroup.find( "/quotes/" ) ) eGroupDatumType = CustomItemData::Quotes;
+        if ( std::string::npos != sGroup.find( "/trades/" ) ) eGroupDatumType = CustomItemData::Trades;
+        if ( std::string::npos != sGroup.find( "/bar/" ) ) eGroupDatumType = CustomItemData::Bars;
+        if ( std::string::npos != sGroup.find( "/atmiv/" ) ) eGroupDatumType = CustomItemData::AtmIV;
+        if ( std::string::npos != sGroup.find( "/greeks/" ) ) eGroupDatumType = CustomItemData::Greeks;
+      }
+      m_eLatestDatumType = eGroupDatumType;
+      if ( Quote::Signature() == iter->nSignature ) m_eLatestDatumType = CustomItemData::Quotes;
+      if ( Trade::Signature() == iter->nSignature ) m_eLatestDatumType = CustomItemData::Trades;
+      if ( Bar::Signature() == iter->nSignature ) m_eLatestDatumType = CustomItemData::Bars;
+      if ( PriceIV::Signature() == iter->nSignature ) m_eLatestDatumType = CustomItemData::AtmIV;
+      if ( Greek::Signature() == iter->nSignature ) m_eLatestDatumType = CustomItemData::Greeks;
+      HandleLoadTreeHdf5Object( iter->sPath, iter->sPath.substr( ix ) );
+    }
+  }
+  else {
+    ou::tf::hdf5::IterateGroups ig( 
+      "/", 
+      boost::phoenix::bind( &PanelChartHdf5::HandleLoadTreeHdf5Group, this, args::arg1, args::arg2 ), 
+      boost::phoenix::bind( &PanelChartHdf5::HandleLoadTreeHdf5Object, this, args::arg1, args::arg2 ) 
+      );
+  }
 
   Bind( wxEVT_CLOSE_WINDOW, &PanelChartHdf5::OnClose, this );  // start close of windows and controls
 